@@ -32,6 +32,7 @@
 #include <DGAL/config.h>
 #include <DGAL/IO/Polyhedron_scan_cof.h>
 #include <DGAL/IO/Polyhedron_scan_obj.h>
+#include <DGAL/IO/Polyhedron_scan_mesh.h>
 #include <DGAL/IO/Polyhderon_outputer_cof.h>
 #include <DGAL/IO/Polyhedron_outputer_obj.h>
 #include <DGAL/UTIL/String_util.h>
@@ -65,35 +66,33 @@ public:
 		}
 
 		//////////////////////////////////
-		std::ifstream stream(filename);
-		if(!stream)
+		// off, obj, cof and ply are memory mapped and parsed by jjcao_io/mesh_loader.h
+		MeshLoader::Format format = MeshLoader::format_of(filename);
+		if ( format == MeshLoader::UNKNOWN)
 		{
-			return FAILED_TO_OPEN_FILE;
+			return UNSUPPORTED_FORMAT;
 		}
 
-		Error_code result = OK;
-		std::transform(extname.begin(), extname.end(), extname.begin(), tolower);
-		if ( extname == "cof")
+		MeshData data;
+		MeshLoader loader;
+		if ( !loader.load(filename, data))
 		{
-			Polyhedron_scan_cof<Polyhedron> bd(mesh, stream);
-			mesh.delegate(bd);
+			std::cout << loader.error() << std::endl;
+			std::ifstream stream(filename);
+			return stream ? UNKNOWN_ERROR : FAILED_TO_OPEN_FILE;
 		}
-		else if ( extname == "obj")
+
+		if ( format == MeshLoader::COF)
 		{
-			Polyhedron_scan_obj<Polyhedron::HDS> bd(stream);
+			Polyhedron_scan_cof<Polyhedron> bd(mesh, data);
 			mesh.delegate(bd);
 		}
-		else if ( extname == "off")
-		{
-			stream >> mesh;
-		}
 		else
 		{
-			result = UNSUPPORTED_FORMAT;
+			Polyhedron_scan_mesh<typename Polyhedron::HDS> bd(data);
+			mesh.delegate(bd);
 		}
-
-		stream.close();
-		return result;
+		return OK;
 	}
 
 	template<class Polyhedron>
@@ -24,11 +24,17 @@
 
 #include <CGAL/Polyhedron_incremental_builder_3.h>
 #include <DGAL/config.h>
-#include <DGAL/UTIL/String_util.h>
+#include <DGAL/IO/Polyhedron_scan_mesh.h>
 #include <fstream>
 
 DGAL_BEGIN_NAMESPACE
 
+// The file format (0-based indices)
+// v float float float
+// vt float float				uv of the vertices, in order
+// f int int int
+// cv int [float float]			a constrained vertex, and its uv
+
 template <class Polyhedron_3_>
 class Polyhedron_scan_cof : public CGAL::Modifier_base< typename Polyhedron_3_::HDS>
 {
@@ -36,157 +42,52 @@ private:
 	typedef Polyhedron_3_               Polyhedron;
 	typedef typename Polyhedron::HDS    HDS;
 	typedef typename HDS::Vertex_handle Vertex_handle;
-	typedef typename HDS::Vertex::Point Point;
-	typedef typename CGAL::Polyhedron_incremental_builder_3<HDS> 
-		                                Builder;
 private:
-	std::ifstream&                      m_stream;//alloacated outside
+	std::ifstream*                      m_stream;//alloacated outside
+	const MeshData*                     m_data;//or already parsed
 	Polyhedron&                         m_polyhedron;
-	std::vector<Vertex_handle>          m_vh; 
   
 public:
-	Polyhedron_scan_cof(Polyhedron &mesh, std::ifstream &stream):m_polyhedron(mesh),m_stream(stream)
+	Polyhedron_scan_cof(Polyhedron &mesh, std::ifstream &stream):m_stream(&stream),m_data(0),m_polyhedron(mesh)
+	{
+	}
+	Polyhedron_scan_cof(Polyhedron &mesh, const MeshData &data):m_stream(0),m_data(&data),m_polyhedron(mesh)
 	{
 	}
 	~Polyhedron_scan_cof() {}
 
 	void operator()(HDS& hds)
 	{
-		Builder builder(hds,true);
-		builder.begin_surface(3,1,6);
-			ingore_addtional_info();
-			read_vertices(builder);
-			read_para_vertices(builder);
-			read_facets(builder);
-			read_constrained_vertices(builder);
-		builder.end_surface();
+		MeshData data;
+		const MeshData* pdata = m_data;
+		if ( !pdata)
+		{
+			if ( !read_mesh_stream(*m_stream, MeshLoader::COF, data)) return;
+			pdata = &data;
+		}
+
+		Polyhedron_scan_mesh<HDS> scan(*pdata);
+		scan(hds);
+		read_constrained_vertices(*pdata, scan.vertices());
 	}
 private:
-	void ingore_addtional_info()
+	// "cv 0 0.5 0.5" or "cv 2"
+	void read_constrained_vertices(const MeshData& data, const std::vector<Vertex_handle>& vhs)
 	{
-		std::string cur_line;
-		while(std::getline(m_stream,cur_line))
-		{    
-			int line_length = (int) cur_line.size();
-			if (line_length == 0) continue;
-
-			if( get_substr(cur_line) == "v")
+		for ( size_t i = 0; i < data.constrained.size(); ++i)
+		{
+			Vertex_handle vh = vhs[data.constrained[i]];
+			double u = data.constrained_uv[2*i], v = data.constrained_uv[2*i+1];
+			if ( u == u && v == v)
 			{
-				roll_back_line(m_stream, line_length);
-				break;
+				vh->uv(u,v);
 			}
+			vh->is_constrained(true);
+			m_polyhedron.add_constrained_vertex(vh);
 		}
 	}
-	void read_vertices(Builder &builder)
-	{
-	  std::string cur_line;
-	  while(std::getline(m_stream,cur_line))
-	  {
-		  int line_length = (int) cur_line.size();
-		  if (line_length == 0) continue;
-
-		  if( get_substr(cur_line) == "v")
-		  {//v -0.00829827 0.583053 0.070454
-			  double x, y, z;
-			  x = str2double( get_substr(cur_line) );			 
-			  y = str2double( get_substr(cur_line) );
-			  z = str2double( get_substr(cur_line) );
-
-			  m_vh.push_back( builder.add_vertex( Point(x, y, z) ) );
-		  }
-		  else
-		  {
-			  roll_back_line(m_stream, line_length);
-			  break;
-		  }	  
-	  }
-	}
-
-// read parametered vertex coordinates
-void read_para_vertices(Builder &builder) 
-{
-	int i(0);
-	std::string cur_line;
-	while(std::getline(m_stream,cur_line))
-	{
-	  int line_length = (int) cur_line.size();
-	  if( get_substr(cur_line) == "vt")
-	  {//vt 1.1 2.2
-		  double u,v;
-		  u = str2double( get_substr(cur_line) );			 
-		  v = str2double( get_substr(cur_line) );
-		  m_vh[i]->uv(u,v);
-		  m_vh[i]->is_parameterized(true);
-		  ++i;
-	  }
-	  else
-	  {
-		  roll_back_line(m_stream, line_length);
-		  break;
-	  }	  
-	}
-}
-
-	// read facets and uv coordinates per halfedge
-	void read_facets(Builder &builder)
-	{
-	  std::string cur_line;
-	  while(std::getline(m_stream,cur_line))
-	  {
-		  int line_length = (int) cur_line.size();
-		  if( get_substr(cur_line) == "f")
-		  {//f 3 4 0
-			  int v1,v2,v3;
-			  v1 = str2int( get_substr(cur_line) );			 
-			  v2 = str2int( get_substr(cur_line) );	
-			  v3 = str2int( get_substr(cur_line) );	
-
-			  builder.begin_facet();
-				  builder.add_vertex_to_facet( v1);
-				  builder.add_vertex_to_facet( v2);
-				  builder.add_vertex_to_facet( v3);
-			  builder.end_facet();
-		  }
-		  else
-		  {
-			  roll_back_line(m_stream, line_length);
-			  break;
-		  }	 
-	  }
-	}
-
-	// read constrained vertex
-	void read_constrained_vertices(Builder &builder)
-	{
-	  std::string cur_line;
-	  while(std::getline(m_stream,cur_line))
-	  {
-		  int line_length = (int) cur_line.size();
-		  if ( line_length == 0) continue;
-		  if( get_substr(cur_line) == "cv")
-		  {//"cv 0 0.5 0.5" or "cv 2"
-			  int v1;
-			  v1 = str2int( get_substr(cur_line) );	
-
-			  Vertex_handle vh = m_vh[v1];
-			  if ( !cur_line.empty())
-			  {
-				  double u, v;
-				  u = str2double( get_substr(cur_line) );	
-				  v = str2double( get_substr(cur_line) );
-				  vh->uv(u,v);
-			  }
-			  vh->is_constrained(true);
-			  m_polyhedron.add_constrained_vertex(vh);
-		  }	  
-		  else
-		  {
-			  std::cout<<"unkown row in cof!"<<std::endl;
-		  }
-	  }
-	}
 };
 
 DGAL_END_NAMESPACE
 
-#endif//DGAL_BUILDER_COF_H
\ No newline at end of file
+#endif//DGAL_BUILDER_COF_H
@@ -0,0 +1,81 @@
+#ifndef DGAL_POLYHEDRON_SCAN_MESH_H
+#define DGAL_POLYHEDRON_SCAN_MESH_H
+
+#include <CGAL/Polyhedron_incremental_builder_3.h>
+#include <DGAL/config.h>
+#include "../../../../../../toolbox/jjcao_io/mesh_loader.h"
+#include <iostream>
+#include <iterator>
+#include <string>
+
+DGAL_BEGIN_NAMESPACE
+
+// parses a whole stream with the reader of jjcao_io/mesh_loader.h
+inline bool read_mesh_stream(std::istream& stream, MeshLoader::Format format, MeshData& data)
+{
+	std::string text( (std::istreambuf_iterator<char>(stream)), std::istreambuf_iterator<char>() );
+	MeshLoader loader;
+	if ( !loader.parse(text.data(), text.data() + text.size(), format, data))
+	{
+		std::cout << loader.error() << std::endl;
+		return false;
+	}
+	return true;
+}
+
+// Builds the surface of a MeshData (see jjcao_io/mesh_loader.h): the
+// vertices, with their uv if the file has them, and the facets as they
+// are. The vertex handles are kept for the callers which need them, e.g.
+// for the constrained vertices of a cof file.
+template <class HDS>
+class Polyhedron_scan_mesh : public CGAL::Modifier_base<HDS>
+{
+private:
+	typedef typename HDS::Vertex::Point Point;
+	typedef typename HDS::Vertex_handle Vertex_handle;
+	typedef typename CGAL::Polyhedron_incremental_builder_3<HDS> Builder;
+
+private:
+	const MeshData&                     m_data;//alloacated outside
+	std::vector<Vertex_handle>          m_vh;
+
+public:
+	Polyhedron_scan_mesh(const MeshData& data):m_data(data)
+	{
+	}
+	~Polyhedron_scan_mesh() {}
+
+	void operator()(HDS& hds)
+	{
+		size_t nverts = m_data.n_vertices();
+		size_t nuv = m_data.uv.size()/2;
+
+		Builder builder(hds,true);
+		builder.begin_surface(nverts, m_data.n_facets(), m_data.indices.size());
+		m_vh.resize(nverts);
+		for ( size_t i = 0; i < nverts; ++i)
+		{
+			const double* x = &m_data.positions[3*i];
+			m_vh[i] = builder.add_vertex( Point(x[0], x[1], x[2]) );
+			if ( i < nuv)
+			{
+				m_vh[i]->uv(m_data.uv[2*i], m_data.uv[2*i+1]);
+				m_vh[i]->is_parameterized(true);
+			}
+		}
+		for ( size_t f = 0; f < m_data.n_facets(); ++f)
+		{
+			builder.begin_facet();
+			for ( unsigned int k = m_data.facet_start[f]; k < m_data.facet_start[f+1]; ++k)
+				builder.add_vertex_to_facet( m_data.indices[k]);
+			builder.end_facet();
+		}
+		builder.end_surface();
+	}
+
+	const std::vector<Vertex_handle>& vertices() const { return m_vh; }
+};
+
+DGAL_END_NAMESPACE
+
+#endif//DGAL_POLYHEDRON_SCAN_MESH_H
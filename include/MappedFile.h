@@ -0,0 +1,114 @@
+/**
+ * @file MappedFile.h
+ * @brief read-only memory mapping of a whole file (Windows and POSIX)
+ *
+ * The mapping lives as long as the object, the pointer returned by data()
+ * must not be used after close() or destruction.
+ */
+
+#ifndef MAPPEDFILE_H_
+#define MAPPEDFILE_H_
+
+#include <stddef.h>
+
+#ifdef _WIN32
+	#ifndef WIN32_LEAN_AND_MEAN
+	#define WIN32_LEAN_AND_MEAN
+	#endif
+	#include <windows.h>
+#else
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <fcntl.h>
+	#include <unistd.h>
+#endif
+
+class MappedFile{
+private:
+	const char* base;   // first byte of the mapping (NULL if not open)
+	size_t      length; // size of the file in bytes
+#ifdef _WIN32
+	HANDLE file;
+	HANDLE mapping;
+#endif
+
+	// not copyable: the mapping is owned
+	MappedFile(const MappedFile&);
+	MappedFile& operator=(const MappedFile&);
+
+public:
+	MappedFile() : base(NULL), length(0){
+#ifdef _WIN32
+		file = INVALID_HANDLE_VALUE;
+		mapping = NULL;
+#endif
+	}
+	~MappedFile(){
+		close();
+	}
+
+	/// maps the whole file read-only, returns false on failure (or empty file)
+	bool open(const char* filename){
+		close();
+#ifdef _WIN32
+		file = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+		if( file == INVALID_HANDLE_VALUE )
+			return false;
+		LARGE_INTEGER filesize;
+		if( !GetFileSizeEx(file, &filesize) || filesize.QuadPart == 0 ){
+			close();
+			return false;
+		}
+		length = (size_t) filesize.QuadPart;
+		mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+		if( mapping == NULL ){
+			close();
+			return false;
+		}
+		base = (const char*) MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+		if( base == NULL ){
+			close();
+			return false;
+		}
+#else
+		int fd = ::open(filename, O_RDONLY);
+		if( fd < 0 )
+			return false;
+		struct stat st;
+		if( fstat(fd, &st) != 0 || st.st_size == 0 ){
+			::close(fd);
+			return false;
+		}
+		length = (size_t) st.st_size;
+		void* addr = mmap(NULL, length, PROT_READ, MAP_SHARED, fd, 0);
+		::close(fd); // the mapping keeps its own reference to the file
+		if( addr == MAP_FAILED ){
+			length = 0;
+			return false;
+		}
+		base = (const char*) addr;
+#endif
+		return true;
+	}
+
+	/// releases the mapping
+	void close(){
+#ifdef _WIN32
+		if( base != NULL ) UnmapViewOfFile(base);
+		if( mapping != NULL ) CloseHandle(mapping);
+		if( file != INVALID_HANDLE_VALUE ) CloseHandle(file);
+		mapping = NULL;
+		file = INVALID_HANDLE_VALUE;
+#else
+		if( base != NULL ) munmap((void*) base, length);
+#endif
+		base = NULL;
+		length = 0;
+	}
+
+	bool is_open() const { return base != NULL; }
+	const char* data() const { return base; }
+	size_t size() const { return length; }
+};
+
+#endif /* MAPPEDFILE_H_ */
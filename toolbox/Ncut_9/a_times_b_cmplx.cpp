@@ -7,8 +7,15 @@ and solve triangular systems
 CSC_CmplxVecMult_CAB_double, CSR_CmplxVecMult_CAB_double, 
 CSCsymm_CmplxVecMult_CAB_double added by Mirko Visontai (10/24/2003)
 
+CSRsymm_BlockMult_CAB_double (several vectors, diagonal scaling, OpenMP)
+
 *=================================================================*/
 # include "math.h"
+# include <vector>
+# include <algorithm>
+#ifdef _OPENMP
+# include <omp.h>
+#endif
 
 ///*c<-a'*b */
 //void scalar_product(
@@ -229,6 +236,156 @@ void CSRsymm_VecMult_CAB_double(
 }
 
 
+/* columns lo..hi-1 of CSRsymm_BlockMult_CAB_double, rows from hi on go to buf */
+static void CSRsymm_BlockMult_columns(
+                 const int lo, const int hi, const int k,
+                 const double *val, const mwIndex *indx,
+                 const mwIndex *pntrb,
+                 const double *b,
+                 double *c,
+                 double *buf
+                 )
+{
+  if (k==1) {
+    for (int j=lo; j<hi; j++) {
+      const double bj = b[j];
+      double cj = 0;
+      for (mwIndex jj=pntrb[j]; jj!=pntrb[j+1]; jj++) {
+        const int i = (int) indx[jj];
+        if (i<j)
+          continue;
+        const double v = val[jj];
+        if (i==j) {
+          cj += v * bj;
+          continue;
+        }
+        cj += v * b[i];
+        (i<hi ? c[i] : buf[i-hi]) += v * bj;
+      }
+      c[j] += cj;
+    }
+    return;
+  }
+  for (int j=lo; j<hi; j++) {
+    const double *bj = b+(size_t) j*k;
+    double *cj = c+(size_t) j*k;
+    for (mwIndex jj=pntrb[j]; jj!=pntrb[j+1]; jj++) {
+      const int i = (int) indx[jj];
+      if (i<j)
+        continue;
+      const double v = val[jj];
+      if (i==j) {
+        for (int l=0; l<k; l++)
+          cj[l] += v * bj[l];
+        continue;
+      }
+      const double *bi = b+(size_t) i*k;
+      double *ci = i<hi ? c+(size_t) i*k : buf+(size_t) (i-hi)*k;
+      for (int l=0; l<k; l++) {
+        ci[l] += v * bj[l];
+        cj[l] += v * bi[l];
+      }
+    }
+  }
+}
+
+/* C<-D*A*D*B (A is symmetric, D=diag(d), the identity if d is NULL)
+   Only the lower triangle of A is used, as in CSRsymm_VecMult_CAB_double.
+   B and C hold k vectors of size m stored by rows : b[i*k+l].
+   D*A*D is never built : B is scaled once, then C.
+   The columns are cut in one range per thread with the same number of
+   nonzeros. The rows of a range are only written by its thread, the
+   products falling below the range go to a buffer of the thread which
+   spans the rows reached from its columns (a band for image graphs), and
+   the buffers are added once all the columns are done. */
+void CSRsymm_BlockMult_CAB_double(
+                 const int m, const int k,
+                 const double *val, const mwIndex *indx,
+                 const mwIndex *pntrb,
+                 const double *d,
+                 const double *b,
+                 double *c
+                 )
+{
+  int nthreads = 1;
+#ifdef _OPENMP
+  /* not worth the threads for a small matrix */
+  if (pntrb[m] > 100000)
+    nthreads = omp_get_max_threads();
+#endif
+  std::vector<int> first;
+  std::vector<int> last;
+  std::vector< std::vector<double> > buf;
+  std::vector<double> db(d==NULL ? 0 : (size_t) m*k);
+  const double *pb = d==NULL ? b : &db[0];
+
+#ifdef _OPENMP
+  #pragma omp parallel num_threads(nthreads)
+#endif
+  {
+    int t = 0;
+#ifdef _OPENMP
+    t = omp_get_thread_num();
+    #pragma omp single nowait
+#endif
+    {
+#ifdef _OPENMP
+      nthreads = omp_get_num_threads();
+#endif
+      first.assign(nthreads+1, m);
+      last.assign(nthreads, -1);
+      buf.resize(nthreads);
+      first[0] = 0;
+      for (int s=1; s<nthreads; s++) {
+        mwIndex nz = (mwIndex) ((double) pntrb[m] * s / nthreads);
+        first[s] = (int) (std::lower_bound(pntrb, pntrb+m+1, nz) - pntrb);
+        first[s] = std::max(first[s-1], std::min(first[s], m));
+      }
+    }
+    if (d!=NULL) {
+#ifdef _OPENMP
+      #pragma omp for schedule(static)
+#endif
+      for (int i=0; i<m; i++)
+        for (int l=0; l<k; l++)
+          db[(size_t) i*k+l] = d[i] * b[(size_t) i*k+l];
+    }
+#ifdef _OPENMP
+    #pragma omp barrier
+#endif
+    const int lo = first[t], hi = first[t+1];
+    /* rows of A are sorted in each column, the last one is the lowest */
+    int r = hi-1;
+    for (int j=lo; j<hi; j++)
+      if (pntrb[j+1]>pntrb[j])
+        r = std::max(r, (int) indx[pntrb[j+1]-1]);
+    last[t] = r;
+    buf[t].assign((size_t) (r-hi+1)*k, 0.0);
+    std::fill(c+(size_t) lo*k, c+(size_t) hi*k, 0.0);
+
+    CSRsymm_BlockMult_columns(lo,hi,k,val,indx,pntrb,pb,c,
+                              buf[t].empty() ? NULL : &buf[t][0]);
+
+#ifdef _OPENMP
+    #pragma omp barrier
+    #pragma omp for schedule(static)
+#endif
+    for (int i=0; i<m; i++) {
+      double *ci = c+(size_t) i*k;
+      for (int s=0; s<nthreads && first[s+1]<=i; s++) {
+        if (i>last[s])
+          continue;
+        const double *bs = &buf[s][(size_t) (i-first[s+1])*k];
+        for (int l=0; l<k; l++)
+          ci[l] += bs[l];
+      }
+      if (d!=NULL)
+        for (int l=0; l<k; l++)
+          ci[l] *= d[i];
+    }
+  }
+}
+
 /* C<-A*b (A is symmetric and complex) */
 void CSRsymm_CmplxVecMult_CAB_double(
                  const int k,  const int m, 
@@ -0,0 +1,304 @@
+/*================================================================
+* function w = affinityic_nb(emag,ephase,nb_r,sigma,sample_rate)
+*   intervening contour affinity of the pixels of an image with their
+*   neighbours, same as
+*       [i,j] = cimgnbmap(size(emag),nb_r,sample_rate);
+*       w = affinityic(emag,ephase,i,j,sigma);
+*   without building the index pairs.
+* Input:
+*   emag = edge strength at each pixel
+*   ephase = edge phase at each pixel
+*   nb_r = neighbourhood radius, could be [r_i,r_j] for i,j
+*   sigma = sigma for IC energy, default = max(emag(:))/6
+*   sample_rate = sampling rate, default = 1
+* Output:
+*   w = sparse affinity, w(i,j) is 0 outside the neighbourhood
+*
+* The columns are computed in parallel when compiled with OpenMP.
+* The neighbours of a pixel on the same line from it, as (1,2) and (2,4),
+* share the beginning of their path, so the path is scanned once to the
+* farthest one. With sample_rate<1, a pair of pixels is kept or not from
+* a hash of the pair, so w stays symmetric; the number of neighbours is
+* not capped as in cimgnbmap.
+
+% test sequence
+f = synimg(10);
+[ex,ey,egx,egy] = quadedgep(f);
+[i,j] = cimgnbmap(size(f),2);
+a1 = affinityic(ex,ey,i,j,0.1);
+a2 = affinityic_nb(ex,ey,2,0.1);
+max(max(abs(a1-a2)))
+
+*=================================================================*/
+
+# include "mex.h"
+# include "math.h"
+# include <time.h>
+# include <vector>
+
+/* one line of neighbours : (k*di,k*dj) for k=1..kmax */
+struct Direction
+{
+    int di, dj, kmax;
+};
+
+static int gcd(int a, int b)
+{
+    while (b!=0) {
+        int t = a % b;
+        a = b;
+        b = t;
+    }
+    return a;
+}
+
+static unsigned int fmix32(unsigned int h)
+{
+    h ^= h >> 16;
+    h *= 0x85ebca6bU;
+    h ^= h >> 13;
+    h *= 0xc2b2ae35U;
+    h ^= h >> 16;
+    return h;
+}
+
+/* the pair (p,q) is sampled, the same for (q,p) */
+static bool is_sampled(int p, int q, unsigned int seed, unsigned int th_rand)
+{
+    unsigned int lo = p<q ? p : q;
+    unsigned int hi = p<q ? q : p;
+    return fmix32(lo ^ fmix32(hi ^ seed)) <= th_rand;
+}
+
+void mexFunction(
+    int nargout,
+    mxArray *out[],
+    int nargin,
+    const mxArray *in[]
+)
+{
+    /* declare variables */
+    int nr, nc, np, r_i, r_j, nb_i, nb;
+    double sigma, sample_rate, a, *dim;
+    double *emag, *ephase, *w;
+    mwIndex *ir, *jc;
+    unsigned int seed, th_rand;
+    bool no_sample;
+
+    /* check argument */
+    if (nargin<3) {
+        mexErrMsgTxt("Three input arguments required");
+    }
+    if (nargout>1) {
+        mexErrMsgTxt("Too many output arguments");
+    }
+
+    /* get edgel information */
+    nr = mxGetM(in[0]);
+    nc = mxGetN(in[0]);
+    if ( nr*nc ==0 || nr != mxGetM(in[1]) || nc != mxGetN(in[1]) ) {
+        mexErrMsgTxt("Edge magnitude and phase shall be of the same image size");
+    }
+    if (!mxIsDouble(in[0]) || !mxIsDouble(in[1])) {
+        mexErrMsgTxt("Edge magnitude and phase shall be of type double");
+    }
+    emag = mxGetPr(in[0]);
+    ephase = mxGetPr(in[1]);
+    np = nr * nc;
+
+    /* get neighbourhood size */
+    if (mxGetNumberOfElements(in[2])==0 || !mxIsDouble(in[2])) {
+        mexErrMsgTxt("Neighbourhood radius shall be a double scalar or pair");
+    }
+    dim = mxGetPr(in[2]);
+    r_i = (int)dim[0];
+    r_j = mxGetNumberOfElements(in[2])>1 ? (int)dim[1] : r_i;
+    if (r_i<0) { r_i = 0; }
+    if (r_j<0) { r_j = 0; }
+    if (r_i>=nr) { r_i = nr-1; }
+    if (r_j>=nc) { r_j = nc-1; }
+    nb_i = 2*r_i + 1;
+    nb = nb_i * (2*r_j + 1);
+
+    /* find my sigma */
+    if (nargin<4 || mxIsEmpty(in[3])) {
+        sigma = 0;
+        for (int k=0; k<np; k++) {
+            if (emag[k]>sigma) { sigma = emag[k]; }
+        }
+        sigma = sigma / 6;
+    } else {
+        sigma = mxGetScalar(in[3]);
+    }
+    a = 0.5 / (sigma * sigma);
+
+    /* get sample rate */
+    sample_rate = (nargin<5 || mxIsEmpty(in[4])) ? 1 : mxGetScalar(in[4]);
+    no_sample = sample_rate>=1;
+    seed = fmix32((unsigned int)time(NULL));
+    th_rand = no_sample ? 0xffffffffU : (unsigned int)(sample_rate * 4294967295.0);
+
+    /* lines of neighbours, from the offsets with gcd(|di|,|dj|)=1 */
+    std::vector<Direction> dirs;
+    for (int dj=-r_j; dj<=r_j; dj++) {
+        for (int di=-r_i; di<=r_i; di++) {
+            if ((di==0 && dj==0) || gcd(abs(di),abs(dj))!=1) {
+                continue;
+            }
+            Direction d;
+            d.di = di;
+            d.dj = dj;
+            d.kmax = 1;
+            while (abs((d.kmax+1)*di)<=r_i && abs((d.kmax+1)*dj)<=r_j) {
+                d.kmax++;
+            }
+            dirs.push_back(d);
+        }
+    }
+
+    /* number of neighbours of each pixel */
+    out[0] = NULL;
+    std::vector<mwIndex> count(np+1, 0);
+    #pragma omp parallel for schedule(static)
+    for (int j=0; j<np; j++) {
+        int jx = j / nr; /* col */
+        int jy = j % nr; /* row */
+        int a1 = jy-r_i < 0 ? 0 : jy-r_i;
+        int a2 = jy+r_i >= nr ? nr-1 : jy+r_i;
+        int b1 = jx-r_j < 0 ? 0 : jx-r_j;
+        int b2 = jx+r_j >= nc ? nc-1 : jx+r_j;
+        if (no_sample) {
+            count[j+1] = (mwIndex)(a2-a1+1) * (b2-b1+1);
+            continue;
+        }
+        mwIndex n = 1;
+        for (int ix=b1; ix<=b2; ix++)
+            for (int iy=a1; iy<=a2; iy++) {
+                int i = iy + ix*nr;
+                if (i!=j && is_sampled(i, j, seed, th_rand)) { n++; }
+            }
+        count[j+1] = n;
+    }
+    for (int j=0; j<np; j++) {
+        count[j+1] += count[j];
+    }
+
+    /* create output */
+    out[0] = mxCreateSparse(np,np,count[np] > 0 ? count[np] : 1,mxREAL);
+    if (out[0]==NULL) {
+        mexErrMsgTxt("Not enough memory for the output matrix");
+    }
+    w = mxGetPr(out[0]);
+    ir = mxGetIr(out[0]);
+    jc = mxGetJc(out[0]);
+    for (int j=0; j<=np; j++) {
+        jc[j] = count[j];
+    }
+
+    /* computation */
+    #pragma omp parallel
+    {
+        /* affinity and sampling of the offsets of the current pixel, indexed
+           as the window : (dj+r_j)*nb_i + di+r_i */
+        std::vector<double> val(nb);
+        std::vector<char> kept(nb);
+
+        #pragma omp for schedule(dynamic,64)
+        for (int j=0; j<np; j++) {
+            int jx = j / nr; /* col */
+            int jy = j % nr; /* row */
+
+            for (size_t d=0; d<dirs.size(); d++) {
+                const int di = dirs[d].di;
+                const int dj = dirs[d].dj;
+
+                /* farthest sampled neighbour in the image on this line */
+                int kfar = 0;
+                for (int k=1; k<=dirs[d].kmax; k++) {
+                    int iy = jy + k*di;
+                    int ix = jx + k*dj;
+                    if (iy<0 || iy>=nr || ix<0 || ix>=nc) {
+                        break;
+                    }
+                    int o = (k*dj+r_j)*nb_i + k*di+r_i;
+                    kept[o] = no_sample || is_sampled(iy+ix*nr, j, seed, th_rand);
+                    if (kept[o]) { kfar = k; }
+                }
+                if (kfar==0) {
+                    continue;
+                }
+
+                /* scan as affinityic, recording the neighbours on the way */
+                double maxori = 0., z;
+                double phase1 = ephase[j], phase2;
+                int iip1 = jy, jjp1 = jx, iip2, jjp2;
+                if (abs(di) >= abs(dj)) {
+                    /* sample in i direction */
+                    double slope = (double) dj / (double) di;
+                    int step = (di>0) ? 1 : -1;
+                    int len = kfar*abs(di);
+                    for (int ii=0; ii<len; ii++) {
+                        iip2 = iip1 + step;
+                        jjp2 = (int)(0.5 + slope*(iip2-jy) + jx);
+                        phase2 = ephase[iip2+jjp2*nr];
+                        if (phase1 != phase2) {
+                            z = (emag[iip1+jjp1*nr] + emag[iip2+jjp2*nr]);
+                            if (z > maxori) { maxori = z; }
+                        }
+                        iip1 = iip2;
+                        jjp1 = jjp2;
+                        phase1 = phase2;
+                        if ((ii+1) % abs(di) == 0) {
+                            int k = (ii+1) / abs(di);
+                            double m = 0.5 * maxori;
+                            val[(k*dj+r_j)*nb_i + k*di+r_i] = exp(-m * m * a);
+                        }
+                    }
+                } else {
+                    /* sample in j direction */
+                    double slope = (double) di / (double) dj;
+                    int step = (dj>0) ? 1 : -1;
+                    int len = kfar*abs(dj);
+                    for (int jj=0; jj<len; jj++) {
+                        jjp2 = jjp1 + step;
+                        iip2 = (int)(0.5 + slope*(jjp2-jx) + jy);
+                        phase2 = ephase[iip2+jjp2*nr];
+                        if (phase1 != phase2) {
+                            z = (emag[iip1+jjp1*nr] + emag[iip2+jjp2*nr]);
+                            if (z > maxori) { maxori = z; }
+                        }
+                        iip1 = iip2;
+                        jjp1 = jjp2;
+                        phase1 = phase2;
+                        if ((jj+1) % abs(dj) == 0) {
+                            int k = (jj+1) / abs(dj);
+                            double m = 0.5 * maxori;
+                            val[(k*dj+r_j)*nb_i + k*di+r_i] = exp(-m * m * a);
+                        }
+                    }
+                }
+            }
+
+            /* write the column, rows in increasing order */
+            int a1 = jy-r_i < 0 ? 0 : jy-r_i;
+            int a2 = jy+r_i >= nr ? nr-1 : jy+r_i;
+            int b1 = jx-r_j < 0 ? 0 : jx-r_j;
+            int b2 = jx+r_j >= nc ? nc-1 : jx+r_j;
+            mwIndex total = jc[j];
+            for (int ix=b1; ix<=b2; ix++) {
+                for (int iy=a1; iy<=a2; iy++) {
+                    int o = (ix-jx+r_j)*nb_i + iy-jy+r_i;
+                    if (iy==jy && ix==jx) {
+                        ir[total] = j;
+                        w[total] = 1;
+                        total++;
+                    } else if (kept[o]) {
+                        ir[total] = iy + ix*nr;
+                        w[total] = val[o];
+                        total++;
+                    }
+                }
+            }
+        } /* j */
+    }
+}
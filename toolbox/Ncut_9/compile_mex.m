@@ -5,6 +5,13 @@
 
 mex -largeArrayDims affinityic.cpp
 mex -largeArrayDims cimgnbmap.cpp
-mex -largeArrayDims mex_w_times_x_symmetric.cpp
+% mex_w_times_x_symmetric and affinityic_nb run on all cores when compiled with OpenMP
+if ispc
+    omp = {'COMPFLAGS="$COMPFLAGS /openmp"'};
+else
+    omp = {'CXXFLAGS="$CXXFLAGS -fopenmp"', 'LDFLAGS="$LDFLAGS -fopenmp"'};
+end
+mex('-largeArrayDims', omp{:}, 'mex_w_times_x_symmetric.cpp');
+mex('-largeArrayDims', omp{:}, 'affinityic_nb.cpp');
 mex -largeArrayDims sparsifyc.cpp
 mex -largeArrayDims spmtimesd.cpp
\ No newline at end of file
@@ -3,7 +3,6 @@ function W = computeW(imageX,dataW,emag,ephase)
 % Timothee Cour, Stella Yu, Jianbo Shi, 2004.
 [p,q] = size(imageX);
 
-[w_i,w_j] = cimgnbmap([p,q],dataW.sampleRadius,dataW.sample_rate);
-
-W = affinityic(emag,ephase,w_i,w_j,max(emag(:)) * dataW.edgeVariance);
+% same as cimgnbmap followed by affinityic, without the index pairs
+W = affinityic_nb(emag,ephase,dataW.sampleRadius,max(emag(:)) * dataW.edgeVariance,dataW.sample_rate);
 W = W/max(W(:));
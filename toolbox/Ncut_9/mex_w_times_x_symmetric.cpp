@@ -1,21 +1,32 @@
 /*================================================================
 * mex_w_times_x_symmetric.c = used by ncuthard2.m in eigensolver.
 *
-* Examples: 
-*     mex_w_times_x_c_symmetric(x,triu(A)) = A*x;     
+* Examples:
+*     mex_w_times_x_c_symmetric(x,tril(A)) = A*x;
 *     A is sparse and symmetric, but x is full
+*     mex_w_times_x_c_symmetric(X,tril(A),d) = diag(d)*A*diag(d)*X;
+*     X may hold several vectors (n x k), d is a full vector; with d the
+*     normalized matrix of ncut is applied without being built.
+*     The products run on all cores when compiled with OpenMP.
 *
 * Timothee Cour, Oct 12, 2003.
 
 % test sequence:
     m=100;
-    n=50;    
+    n=50;
     x=rand(n,1);
-    A=sprand(m,n,0.01);    
+    A=sprand(m,n,0.01);
 
-    y2 = mex_w_times_x_c_symmetric(x,triu(A));
+    y2 = mex_w_times_x_c_symmetric(x,tril(A));
     y1=A*x;
     max(abs(y1-y2))
+
+    n=10000;
+    A=sprand(n,n,0.001); A=A+A';
+    X=rand(n,8); d=rand(n,1);
+    Y2 = mex_w_times_x_symmetric(X,tril(A),d);
+    Y1 = spdiags(d,0,n,n)*A*spdiags(d,0,n,n)*X;
+    max(abs(Y1(:)-Y2(:)))
 *=================================================================*/
 
 # include "math.h"
@@ -31,27 +42,58 @@ void mexFunction(
     const mxArray *in[]
 )
 {
-    int np, nc;
+    int np, nc, k;
     mwIndex*ir, *jc;
-    double *x, *y, *pr;
-    
+    double *x, *y, *pr, *d;
+
     if (nargin < 2) {//voir
-        mexErrMsgTxt("Four input arguments required !");
+        mexErrMsgTxt("Two input arguments required !");
     }
     if (nargout>1) {
         mexErrMsgTxt("Too many output arguments.");
     }
-        
+    if (!mxIsSparse(in[1]) || mxIsComplex(in[1])) {
+        mexErrMsgTxt("Input argument #2 must be real and sparse.");
+    }
+
 	x = mxGetPr(in[0]);
         pr = mxGetPr(in[1]);
         ir = mxGetIr(in[1]);
         jc = mxGetJc(in[1]);
-   
+
     	np = mxGetM(in[1]);
     	nc = mxGetN(in[1]);
-    	    
+    	k = mxGetN(in[0]);
+
+    d = NULL;
+    if (nargin>2 && !mxIsEmpty(in[2])) {
+        if (mxIsSparse(in[2]) || mxGetNumberOfElements(in[2])!=np)
+            mexErrMsgTxt("Input argument #3 must be a full vector of size(A,1).");
+        d = mxGetPr(in[2]);
+    }
+    if (k==1 && d==NULL) {
     	out[0] = mxCreateDoubleMatrix(np,1,mxREAL);
 	y = mxGetPr(out[0]);
-	
-	CSRsymm_VecMult_CAB_double(np,nc,pr,ir,jc,x,y); 
-} 
+	CSRsymm_VecMult_CAB_double(np,nc,pr,ir,jc,x,y);
+        return;
+    }
+
+    if (np!=nc || mxGetM(in[0])!=np) {
+        mexErrMsgTxt("Dimension mismatch.");
+    }
+    out[0] = mxCreateDoubleMatrix(np,k,mxREAL);
+    y = mxGetPr(out[0]);
+    if (k==1) {
+        CSRsymm_BlockMult_CAB_double(np,1,pr,ir,jc,d,x,y);
+        return;
+    }
+    /* the k values of a row side by side, one cache line per nonzero */
+    std::vector<double> xt((size_t) np*k), yt((size_t) np*k);
+    for (int l=0; l<k; l++)
+        for (int i=0; i<np; i++)
+            xt[(size_t) i*k+l] = x[(size_t) l*np+i];
+    CSRsymm_BlockMult_CAB_double(np,k,pr,ir,jc,d,&xt[0],&yt[0]);
+    for (int l=0; l<k; l++)
+        for (int i=0; i<np; i++)
+            y[(size_t) l*np+i] = yt[(size_t) i*k+l];
+}
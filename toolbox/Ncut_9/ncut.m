@@ -59,8 +59,9 @@ dr = dr + offset;
 W = W + spdiags(dr,0,n,n);
 
 Dinvsqrt = 1./sqrt(d+eps);
-P = spmtimesd(W,Dinvsqrt,Dinvsqrt);
-clear W;
+% P = Dinvsqrt*W*Dinvsqrt is applied by mex_w_times_x_symmetric without
+% being built, only the lower triangle of W is kept
+W = tril(W);
 
 options.issym = 1;
      
@@ -72,13 +73,13 @@ end
 options.maxit = dataNcut.maxiterations;
 options.tol = dataNcut.eigsErrorTolerance;
 
-options.v0 = ones(size(P,1),1);
+options.v0 = ones(n,1);
 options.p = max(35,2*nbEigenValues); %voir
 options.p = min(options.p,n);
 
 %warning off
-[vbar,s,convergence] = eigs(@mex_w_times_x_symmetric,size(P,1),nbEigenValues,'LA',options,tril(P)); 
-% [vbar,s,convergence] = eigs_new(@mex_w_times_x_symmetric,size(P,1),nbEigenValues,'LA',options,tril(P)); 
+[vbar,s,convergence] = eigs(@(x) mex_w_times_x_symmetric(x,W,Dinvsqrt),n,nbEigenValues,'LA',options); 
+% [vbar,s,convergence] = eigs_new(@mex_w_times_x_symmetric,n,nbEigenValues,'LA',options,W,Dinvsqrt); 
 %warning on
 
 s = real(diag(s));
@@ -0,0 +1,8 @@
+% compile_mex
+%
+% vl_kdtreebuild and vl_kdtreequery, with the part of VLFeat they need
+% (mex/vl). The mex files are written next to their .m files.
+
+vl = {'mex/vl/kdtree.c', 'mex/vl/generic.c', 'mex/vl/host.c', 'mex/vl/random.c', 'mex/vl/mathop.c', 'mex/vl/mathop_sse2.c'};
+mex('-Imex', 'mex/vl_kdtreebuild.c', vl{:});
+mex('-Imex', 'mex/vl_kdtreequery.c', vl{:});
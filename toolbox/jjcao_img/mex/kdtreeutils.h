@@ -0,0 +1,225 @@
+/** @file     kdtreeutils.h
+ ** @author   Andrea Vedaldi
+ ** @brief    Conversion between VlKDForest and MATLAB structures
+ **/
+
+/* AUTORIGHTS
+Copyright (C) 2007-10 Andrea Vedaldi and Brian Fulkerson
+
+This file is part of VLFeat, available under the terms of the
+GNU GPLv2, or (at your option) any later version.
+*/
+
+#ifndef VL_KDTREEUTILS_H
+#define VL_KDTREEUTILS_H
+
+#include "mexutils.h"
+#include "vl/kdtree.h"
+
+/* The forest is given to MATLAB as
+
+     KDFOREST.dimension                  dimension of the data
+     KDFOREST.numData                    number of data points
+     KDFOREST.trees(t).lowerChild        1 x numNodes INT32
+     KDFOREST.trees(t).upperChild        1 x numNodes INT32
+     KDFOREST.trees(t).splitDimension    1 x numNodes UINT32
+     KDFOREST.trees(t).splitThreshold    1 x numNodes DOUBLE
+     KDFOREST.trees(t).dataIndex         1 x numData  UINT32
+     KDFOREST.trees(t).depth             depth of the tree
+
+   The node fields are the ones of ::VlKDTreeNode, 0-based: a node with
+   lowerChild >= 0 has children lowerChild and upperChild, a leaf holds
+   the points dataIndex(-lowerChild : -upperChild-1) (0-based). The data
+   themselves are not stored. */
+
+/** ------------------------------------------------------------------
+ ** @internal
+ ** @brief Get a field of a structure, raising an error if missing
+ **/
+
+static mxArray const *
+vlmxGetField (mxArray const * array, vl_uindex index, char const * name)
+{
+  mxArray const * field = mxGetField (array, index, name) ;
+  if (! field) {
+    vlmxError (vlmxErrInconsistentData,
+               "KDFOREST has no field '%s'.", name) ;
+  }
+  return field ;
+}
+
+/** ------------------------------------------------------------------
+ ** @internal
+ ** @brief Get a node field of a tree, checking its class and size
+ **/
+
+static void const *
+vlmxGetTreeField (mxArray const * trees, vl_uindex ti, char const * name,
+                  mxClassID classId, vl_size numElements)
+{
+  mxArray const * field = vlmxGetField (trees, ti, name) ;
+  if (mxGetClassID (field) != classId ||
+      mxGetNumberOfElements (field) != numElements) {
+    vlmxError (vlmxErrInconsistentData,
+               "KDFOREST.trees(%d).%s has the wrong class or size.",
+               (int) ti + 1, name) ;
+  }
+  return mxGetData (field) ;
+}
+
+/** ------------------------------------------------------------------
+ ** @brief Convert a KD-forest to a MATLAB structure
+ ** @param forest KD-forest (built).
+ ** @return the new MATLAB structure.
+ **/
+
+static mxArray *
+new_array_from_kdforest (VlKDForest const * forest)
+{
+  char const * fieldNames [] = {"dimension", "numData", "trees"} ;
+  char const * treeFieldNames [] = {"lowerChild", "upperChild",
+                                    "splitDimension", "splitThreshold",
+                                    "dataIndex", "depth"} ;
+  mxArray * array = mxCreateStructMatrix (1, 1, 3, fieldNames) ;
+  mxArray * trees = mxCreateStructMatrix (1, forest->numTrees, 6, treeFieldNames) ;
+  vl_uindex ti, ni, di ;
+
+  for (ti = 0 ; ti < forest->numTrees ; ++ ti) {
+    VlKDTree const * tree = forest->trees [ti] ;
+    vl_size numNodes = tree->numUsedNodes ;
+    mxArray * lowerChild = mxCreateNumericMatrix (1, numNodes, mxINT32_CLASS, mxREAL) ;
+    mxArray * upperChild = mxCreateNumericMatrix (1, numNodes, mxINT32_CLASS, mxREAL) ;
+    mxArray * splitDimension = mxCreateNumericMatrix (1, numNodes, mxUINT32_CLASS, mxREAL) ;
+    mxArray * splitThreshold = mxCreateDoubleMatrix (1, numNodes, mxREAL) ;
+    mxArray * dataIndex = mxCreateNumericMatrix (1, forest->numData, mxUINT32_CLASS, mxREAL) ;
+    vl_int32 * lc = mxGetData (lowerChild) ;
+    vl_int32 * uc = mxGetData (upperChild) ;
+    vl_uint32 * sd = mxGetData (splitDimension) ;
+    double * st = mxGetPr (splitThreshold) ;
+    vl_uint32 * dx = mxGetData (dataIndex) ;
+
+    for (ni = 0 ; ni < numNodes ; ++ ni) {
+      lc [ni] = (vl_int32) tree->nodes [ni].lowerChild ;
+      uc [ni] = (vl_int32) tree->nodes [ni].upperChild ;
+      sd [ni] = (vl_uint32) tree->nodes [ni].splitDimension ;
+      st [ni] = tree->nodes [ni].splitThreshold ;
+    }
+    for (di = 0 ; di < forest->numData ; ++ di) {
+      dx [di] = (vl_uint32) tree->dataIndex [di].index ;
+    }
+
+    mxSetField (trees, ti, "lowerChild", lowerChild) ;
+    mxSetField (trees, ti, "upperChild", upperChild) ;
+    mxSetField (trees, ti, "splitDimension", splitDimension) ;
+    mxSetField (trees, ti, "splitThreshold", splitThreshold) ;
+    mxSetField (trees, ti, "dataIndex", dataIndex) ;
+    mxSetField (trees, ti, "depth", vlmxCreatePlainScalar (tree->depth)) ;
+  }
+
+  mxSetField (array, 0, "dimension", vlmxCreatePlainScalar (forest->dimension)) ;
+  mxSetField (array, 0, "numData", vlmxCreatePlainScalar (forest->numData)) ;
+  mxSetField (array, 0, "trees", trees) ;
+  return array ;
+}
+
+/** ------------------------------------------------------------------
+ ** @brief Convert a MATLAB structure to a KD-forest
+ ** @param array MATLAB structure (from ::new_array_from_kdforest).
+ ** @param data the data the forest was built from (SINGLE or DOUBLE).
+ ** @return the new KD-forest, ready to be queried.
+ **
+ ** The structure is checked, so that a corrupted one raises an error
+ ** rather than crashing the query. As for ::vl_kdforest_build, the
+ ** forest keeps a pointer to @a data.
+ **/
+
+static VlKDForest *
+new_kdforest_from_array (mxArray const * array, mxArray const * data)
+{
+  VlKDForest * forest ;
+  mxArray const * trees ;
+  vl_size dimension, numData, numTrees ;
+  vl_type dataType = VL_TYPE_DOUBLE ;
+  vl_uindex ti, ni, di ;
+
+  if (! mxIsStruct (array) || mxGetNumberOfElements (array) != 1) {
+    vlmxError (vlmxErrInvalidArgument, "KDFOREST must be a structure.") ;
+  }
+  dimension = (vl_size) mxGetScalar (vlmxGetField (array, 0, "dimension")) ;
+  numData = (vl_size) mxGetScalar (vlmxGetField (array, 0, "numData")) ;
+  trees = vlmxGetField (array, 0, "trees") ;
+  numTrees = mxGetNumberOfElements (trees) ;
+
+  switch (mxGetClassID (data)) {
+    case mxSINGLE_CLASS : dataType = VL_TYPE_FLOAT ; break ;
+    case mxDOUBLE_CLASS : dataType = VL_TYPE_DOUBLE ; break ;
+    default :
+      vlmxError (vlmxErrInvalidArgument, "X must be either SINGLE or DOUBLE.") ;
+  }
+  if (mxGetM (data) != dimension || mxGetN (data) != numData) {
+    vlmxError (vlmxErrInconsistentData,
+               "X is not the data KDFOREST was built from (%d x %d expected).",
+               (int) dimension, (int) numData) ;
+  }
+  if (! mxIsStruct (trees) || numTrees < 1 || dimension < 1) {
+    vlmxError (vlmxErrInconsistentData, "KDFOREST is corrupted.") ;
+  }
+
+  forest = vl_kdforest_new (dataType, dimension, numTrees) ;
+  forest->numData = numData ;
+  forest->data = mxGetData (data) ;
+  forest->trees = vl_malloc (sizeof(VlKDTree*) * numTrees) ;
+
+  for (ti = 0 ; ti < numTrees ; ++ ti) {
+    VlKDTree * tree = vl_malloc (sizeof(VlKDTree)) ;
+    vl_size numNodes = mxGetNumberOfElements (vlmxGetField (trees, ti, "lowerChild")) ;
+    vl_int32 const * lc = vlmxGetTreeField (trees, ti, "lowerChild", mxINT32_CLASS, numNodes) ;
+    vl_int32 const * uc = vlmxGetTreeField (trees, ti, "upperChild", mxINT32_CLASS, numNodes) ;
+    vl_uint32 const * sd = vlmxGetTreeField (trees, ti, "splitDimension", mxUINT32_CLASS, numNodes) ;
+    double const * st = vlmxGetTreeField (trees, ti, "splitThreshold", mxDOUBLE_CLASS, numNodes) ;
+    vl_uint32 const * dx = vlmxGetTreeField (trees, ti, "dataIndex", mxUINT32_CLASS, numData) ;
+
+    forest->trees [ti] = tree ;
+    tree->numUsedNodes = numNodes ;
+    tree->numAllocatedNodes = numNodes ;
+    tree->nodes = vl_malloc (sizeof(VlKDTreeNode) * numNodes) ;
+    tree->dataIndex = vl_malloc (sizeof(VlKDTreeDataIndexEntry) * numData) ;
+    tree->depth = (unsigned int) mxGetScalar (vlmxGetField (trees, ti, "depth")) ;
+
+    for (ni = 0 ; ni < numNodes ; ++ ni) {
+      VlKDTreeNode * node = tree->nodes + ni ;
+      vl_bool ok ;
+      if (lc [ni] < 0) {
+        /* leaf: points -lowerChild-1 ... -upperChild-2 */
+        ok = uc [ni] <= lc [ni] && (vl_size) (- uc [ni] - 1) <= numData ;
+      } else {
+        /* children are allocated after their parent */
+        ok = (vl_uindex) lc [ni] > ni && (vl_size) lc [ni] < numNodes &&
+             (vl_uindex) uc [ni] > ni && (vl_size) uc [ni] < numNodes &&
+             sd [ni] < dimension ;
+      }
+      if (! ok) {
+        vlmxError (vlmxErrInconsistentData,
+                   "KDFOREST.trees(%d) is corrupted at node %d.",
+                   (int) ti + 1, (int) ni + 1) ;
+      }
+      node->parent = 0 ;
+      node->lowerChild = lc [ni] ;
+      node->upperChild = uc [ni] ;
+      node->splitDimension = sd [ni] ;
+      node->splitThreshold = st [ni] ;
+    }
+    for (di = 0 ; di < numData ; ++ di) {
+      if (dx [di] >= numData) {
+        vlmxError (vlmxErrInconsistentData,
+                   "KDFOREST.trees(%d).dataIndex is out of range.", (int) ti + 1) ;
+      }
+      tree->dataIndex [di].index = dx [di] ;
+      tree->dataIndex [di].value = 0 ;
+    }
+  }
+  return forest ;
+}
+
+/* VL_KDTREEUTILS_H */
+#endif
@@ -344,11 +344,13 @@ vl_kdforest_delete (VlKDForest * self)
 {
   vl_uindex ti ;
   if (self->searchIdBook) vl_free (self->searchIdBook) ;
+  if (self->searchHeapArray) vl_free (self->searchHeapArray) ;
   if (self->trees) {
     for (ti = 0 ; ti < self->numTrees ; ++ ti) {
       if (self->trees[ti]) {
         if (self->trees[ti]->nodes) vl_free (self->trees[ti]->nodes) ;
         if (self->trees[ti]->dataIndex) vl_free (self->trees[ti]->dataIndex) ;
+        vl_free (self->trees[ti]) ;
       }
     }
     vl_free (self->trees) ;
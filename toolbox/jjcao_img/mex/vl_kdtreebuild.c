@@ -0,0 +1,144 @@
+/** @file     vl_kdtreebuild.c
+ ** @author   Andrea Vedaldi
+ ** @brief    KD-forest building MEX driver
+ **/
+
+/* AUTORIGHTS
+Copyright (C) 2007-10 Andrea Vedaldi and Brian Fulkerson
+
+This file is part of VLFeat, available under the terms of the
+GNU GPLv2, or (at your option) any later version.
+*/
+
+#include "mexutils.h"
+#include "kdtreeutils.h"
+#include "vl/kdtree.h"
+
+enum {
+  opt_num_trees = 0,
+  opt_threshold_method,
+  opt_verbose
+} ;
+
+vlmxOption  options [] = {
+  {"NumTrees",            1,   opt_num_trees        },
+  {"ThresholdMethod",     1,   opt_threshold_method },
+  {"Verbose",             0,   opt_verbose          },
+  {0,                     0,   0                    }
+} ;
+
+/** @brief MEX entry point */
+void
+mexFunction(int nout, mxArray *out[],
+            int nin, const mxArray *in[])
+{
+  enum {IN_DATA = 0,
+        IN_END } ;
+  enum {OUT_TREE = 0} ;
+
+  int             verbose = 0 ;
+  int             opt ;
+  int             next = IN_END ;
+  mxArray const  *optarg ;
+
+  VlKDForest     *forest ;
+  void const     *data ;
+  vl_size         numData, dimension, numTrees = 1 ;
+  vl_type         dataType = VL_TYPE_DOUBLE ;
+  VlKDTreeThresholdingMethod thresholdingMethod = VL_KDTREE_MEDIAN ;
+  vl_uindex       ti ;
+  char            buf [1024] ;
+
+  VL_USE_MATLAB_ENV ;
+
+  /** -----------------------------------------------------------------
+   **                                               Check the arguments
+   ** -------------------------------------------------------------- */
+
+  if (nin < 1) {
+    mexErrMsgTxt("At least one input argument is required.") ;
+  }
+
+  if (nout > 1) {
+    mexErrMsgTxt("Too many output arguments.");
+  }
+
+  switch (mxGetClassID(IN(DATA))) {
+    case mxSINGLE_CLASS : dataType = VL_TYPE_FLOAT ; break ;
+    case mxDOUBLE_CLASS : dataType = VL_TYPE_DOUBLE ; break ;
+    default :
+      mexErrMsgTxt("X must be either SINGLE or DOUBLE.") ;
+  }
+  if (mxGetNumberOfDimensions(IN(DATA)) != 2 || mxIsComplex(IN(DATA))) {
+    mexErrMsgTxt("X must be a real matrix.") ;
+  }
+
+  data      = mxGetData(IN(DATA)) ;
+  dimension = mxGetM(IN(DATA)) ;
+  numData   = mxGetN(IN(DATA)) ;
+
+  if (dimension == 0 || numData == 0) {
+    mexErrMsgTxt("X must not be empty.") ;
+  }
+
+  while ((opt = vlmxNextOption (in, nin, options, &next, &optarg)) >= 0) {
+    switch (opt) {
+
+    case opt_verbose :
+      ++ verbose ;
+      break ;
+
+    case opt_num_trees :
+      if (!vlmxIsPlainScalar(optarg) || *mxGetPr(optarg) < 1) {
+        mexErrMsgTxt("'NumTrees' must be a positive integer.") ;
+      }
+      numTrees = (vl_size) *mxGetPr(optarg) ;
+      break ;
+
+    case opt_threshold_method :
+      if (!vlmxIsString(optarg, -1) || mxGetString(optarg, buf, sizeof(buf))) {
+        mexErrMsgTxt("'ThresholdMethod' must be a string.") ;
+      }
+      if (uStrICmp(buf, "median") == 0) {
+        thresholdingMethod = VL_KDTREE_MEDIAN ;
+      } else if (uStrICmp(buf, "mean") == 0) {
+        thresholdingMethod = VL_KDTREE_MEAN ;
+      } else {
+        mexErrMsgTxt("'ThresholdMethod' must be either 'median' or 'mean'.") ;
+      }
+      break ;
+
+    default :
+        abort() ;
+    }
+  }
+
+  /* -----------------------------------------------------------------
+   *                                                     Run algorithm
+   * -------------------------------------------------------------- */
+
+  forest = vl_kdforest_new (dataType, dimension, numTrees) ;
+  vl_kdforest_set_thresholding_method (forest, thresholdingMethod) ;
+
+  if (verbose) {
+    mexPrintf("vl_kdtreebuild: data %s [%d x %d]\n",
+              vl_get_type_name (dataType), (int) dimension, (int) numData) ;
+    mexPrintf("vl_kdtreebuild: number of trees: %d\n", (int) numTrees) ;
+    mexPrintf("vl_kdtreebuild: threshold method: %s\n",
+              thresholdingMethod == VL_KDTREE_MEDIAN ? "median" : "mean") ;
+  }
+
+  vl_kdforest_build (forest, numData, data) ;
+
+  if (verbose) {
+    for (ti = 0 ; ti < numTrees ; ++ ti) {
+      mexPrintf("vl_kdtreebuild: tree %d: depth %d, num. nodes %d\n",
+                (int) ti + 1,
+                (int) vl_kdforest_get_depth_of_tree (forest, ti),
+                (int) vl_kdforest_get_num_nodes_of_tree (forest, ti)) ;
+    }
+  }
+
+  OUT(TREE) = new_array_from_kdforest (forest) ;
+  vl_kdforest_delete (forest) ;
+}
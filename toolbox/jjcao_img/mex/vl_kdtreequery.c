@@ -0,0 +1,170 @@
+/** @file     vl_kdtreequery.c
+ ** @author   Andrea Vedaldi
+ ** @brief    KD-forest query MEX driver
+ **/
+
+/* AUTORIGHTS
+Copyright (C) 2007-10 Andrea Vedaldi and Brian Fulkerson
+
+This file is part of VLFeat, available under the terms of the
+GNU GPLv2, or (at your option) any later version.
+*/
+
+#include "mexutils.h"
+#include "kdtreeutils.h"
+#include "vl/kdtree.h"
+
+enum {
+  opt_num_neighbors = 0,
+  opt_max_comparisons,
+  opt_verbose
+} ;
+
+vlmxOption  options [] = {
+  {"NumNeighbors",        1,   opt_num_neighbors    },
+  {"MaxComparisons",      1,   opt_max_comparisons  },
+  {"MaxNumComparisons",   1,   opt_max_comparisons  },
+  {"Verbose",             0,   opt_verbose          },
+  {0,                     0,   0                    }
+} ;
+
+/** @brief MEX entry point */
+void
+mexFunction(int nout, mxArray *out[],
+            int nin, const mxArray *in[])
+{
+  enum {IN_FOREST = 0,
+        IN_DATA,
+        IN_QUERY,
+        IN_END } ;
+  enum {OUT_INDEX = 0,
+        OUT_DISTANCE } ;
+
+  int             verbose = 0 ;
+  int             opt ;
+  int             next = IN_END ;
+  mxArray const  *optarg ;
+
+  VlKDForest     *forest ;
+  VlKDForestNeighbor *neighbors ;
+  vl_size         numNeighbors = 1, maxNumComparisons = 0 ;
+  vl_size         numQueries, dimension ;
+  vl_uindex       qi, ni ;
+  double          numComparisons = 0 ;
+  vl_uint32      *index ;
+  void           *distance = 0 ;
+  vl_bool         isSingle ;
+
+  VL_USE_MATLAB_ENV ;
+
+  /** -----------------------------------------------------------------
+   **                                               Check the arguments
+   ** -------------------------------------------------------------- */
+
+  if (nin < 3) {
+    mexErrMsgTxt("At least three input arguments are required.") ;
+  }
+
+  if (nout > 2) {
+    mexErrMsgTxt("Too many output arguments.");
+  }
+
+  if (mxGetClassID(IN(DATA)) != mxGetClassID(IN(QUERY))) {
+    mexErrMsgTxt("X and Q must be of the same class.") ;
+  }
+  if (mxGetNumberOfDimensions(IN(QUERY)) != 2 || mxIsComplex(IN(QUERY))) {
+    mexErrMsgTxt("Q must be a real matrix.") ;
+  }
+
+  while ((opt = vlmxNextOption (in, nin, options, &next, &optarg)) >= 0) {
+    switch (opt) {
+
+    case opt_verbose :
+      ++ verbose ;
+      break ;
+
+    case opt_num_neighbors :
+      if (!vlmxIsPlainScalar(optarg) || *mxGetPr(optarg) < 1) {
+        mexErrMsgTxt("'NumNeighbors' must be a positive integer.") ;
+      }
+      numNeighbors = (vl_size) *mxGetPr(optarg) ;
+      break ;
+
+    case opt_max_comparisons :
+      if (!vlmxIsPlainScalar(optarg) || *mxGetPr(optarg) < 0) {
+        mexErrMsgTxt("'MaxComparisons' must be a non-negative integer.") ;
+      }
+      maxNumComparisons = (vl_size) *mxGetPr(optarg) ;
+      break ;
+
+    default :
+        abort() ;
+    }
+  }
+
+  /* the data are checked against the forest there */
+  forest = new_kdforest_from_array (IN(FOREST), IN(DATA)) ;
+  dimension = vl_kdforest_get_data_dimension (forest) ;
+  isSingle = vl_kdforest_get_data_type (forest) == VL_TYPE_FLOAT ;
+
+  if (mxGetM(IN(QUERY)) != dimension) {
+    mexErrMsgTxt("Q must have as many rows as X.") ;
+  }
+  numQueries = mxGetN(IN(QUERY)) ;
+
+  /* -----------------------------------------------------------------
+   *                                                     Run algorithm
+   * -------------------------------------------------------------- */
+
+  vl_kdforest_set_max_num_comparisons (forest, maxNumComparisons) ;
+
+  if (verbose) {
+    mexPrintf("vl_kdtreequery: number of trees: %d\n",
+              (int) vl_kdforest_get_num_trees (forest)) ;
+    mexPrintf("vl_kdtreequery: number of queries: %d\n", (int) numQueries) ;
+    mexPrintf("vl_kdtreequery: number of neighbors per query: %d\n", (int) numNeighbors) ;
+    mexPrintf("vl_kdtreequery: max num of comparisons per query: %d%s\n",
+              (int) maxNumComparisons, maxNumComparisons ? "" : " (exact search)") ;
+  }
+
+  neighbors = vl_malloc (sizeof(VlKDForestNeighbor) * numNeighbors) ;
+
+  OUT(INDEX) = mxCreateNumericMatrix (numNeighbors, numQueries, mxUINT32_CLASS, mxREAL) ;
+  index = mxGetData (OUT(INDEX)) ;
+  if (nout > 1) {
+    OUT(DISTANCE) = mxCreateNumericMatrix (numNeighbors, numQueries,
+                                           mxGetClassID(IN(DATA)), mxREAL) ;
+    distance = mxGetData (OUT(DISTANCE)) ;
+  }
+
+  for (qi = 0 ; qi < numQueries ; ++ qi) {
+    void const * query = isSingle ?
+      (void const*) ((float const*) mxGetData(IN(QUERY)) + qi * dimension) :
+      (void const*) ((double const*) mxGetData(IN(QUERY)) + qi * dimension) ;
+
+    numComparisons += vl_kdforest_query (forest, neighbors, numNeighbors, query) ;
+
+    /* neighbors not found (too few data points) have index -1, returned
+       to MATLAB as 0 as documented in vl_kdtreequery.m */
+    for (ni = 0 ; ni < numNeighbors ; ++ ni) {
+      *index++ = (vl_uint32) (neighbors [ni].index + 1) ;
+      if (distance) {
+        if (isSingle) {
+          *((float*) distance) = (float) neighbors [ni].distance ;
+          distance = (float*) distance + 1 ;
+        } else {
+          *((double*) distance) = neighbors [ni].distance ;
+          distance = (double*) distance + 1 ;
+        }
+      }
+    }
+  }
+
+  if (verbose) {
+    mexPrintf("vl_kdtreequery: avg. num of comparisons per query: %g\n",
+              numQueries ? numComparisons / numQueries : 0) ;
+  }
+
+  vl_free (neighbors) ;
+  vl_kdforest_delete (forest) ;
+}
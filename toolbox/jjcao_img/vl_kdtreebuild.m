@@ -0,0 +1,44 @@
+% VL_KDTREEBUILD  Build randomized kd-tree forest
+%   KDFOREST = VL_KDTREEBUILD(X) indexes the data X with a kd-tree for
+%   VL_KDTREEQUERY(). X is a SINGLE or DOUBLE matrix with one data
+%   point per column (e.g. 128 x N for SIFT descriptors).
+%
+%   With more than one tree the split dimension of every node is drawn
+%   among the few with largest variance, giving the randomized forest
+%   of [2,3]. The trees are searched together, so for the same number
+%   of comparisons a forest finds the exact neighbors more often than a
+%   single tree.
+%
+%   The forest does not contain the data: X must be passed again to
+%   VL_KDTREEQUERY(), unchanged.
+%
+%   VL_KDTREEBUILD(X,'Option'[,Value]...) accepts the following options
+%
+%   NumTrees:: 1
+%       Number of trees of the forest.
+%
+%   ThresholdMethod:: 'median'
+%       Split threshold of a node, either 'median' or 'mean' of the
+%       data along the split dimension.
+%
+%   Verbose::
+%       Be verbose.
+%
+%   The mex files are compiled by compile_mex.m.
+%
+%   REFERENCES
+%   [1] J. S. Beis and D. G. Lowe, "Shape indexing using approximate
+%       nearest-neighbour search in high-dimensional spaces," in
+%       Proc. CVPR, 1997.
+%   [2] C. Silpa-Anan and R. Hartley, "Optimised KD-trees for fast
+%       image descriptor matching," in Proc. CVPR, 2008.
+%   [3] M. Muja and D. G. Lowe, "Fast approximate nearest neighbors
+%       with automatic algorithmic configuration," in Proc. VISAPP, 2009.
+%
+%   See also: VL_KDTREEQUERY(), VL_HELP().
+
+% AUTORIGHTS
+% Copyright (C) 2007-10 Andrea Vedaldi and Brian Fulkerson
+%
+% This file is part of VLFeat, available under the terms of the
+% GNU GPLv2, or (at your option) any later version.
@@ -0,0 +1,38 @@
+% VL_KDTREEQUERY  Query kd-tree forest
+%   [INDEX, DISTANCE] = VL_KDTREEQUERY(KDFOREST, X, Q) returns for each
+%   column of Q the index of its nearest neighbor among the columns of
+%   X, and the squared euclidean distance to it. KDFOREST is built from
+%   X by VL_KDTREEBUILD(), Q has the class of X.
+%
+%   The cells of all the trees are searched best-bin-first [1]: in
+%   increasing order of their distance to the query. Without a limit on
+%   the number of comparisons the search is exact.
+%
+%   VL_KDTREEQUERY(KDFOREST,X,Q,'Option'[,Value]...) accepts the
+%   following options
+%
+%   NumNeighbors:: 1
+%       Number of neighbors K returned per query. INDEX and DISTANCE
+%       are then K x size(Q,2), closest neighbors first. The index of a
+%       neighbor not found is 0 and its distance NaN (when K > size(X,2)).
+%
+%   MaxComparisons:: 0
+%       Maximum number of data points compared to a query; 0 means
+%       unbounded (exact search). Bounding it gives approximate
+%       neighbors, much faster in high dimension.
+%
+%   Verbose::
+%       Be verbose (prints the average number of comparisons).
+%
+%   REFERENCES
+%   [1] J. S. Beis and D. G. Lowe, "Shape indexing using approximate
+%       nearest-neighbour search in high-dimensional spaces," in
+%       Proc. CVPR, 1997.
+%
+%   See also: VL_KDTREEBUILD(), VL_HELP().
+
+% AUTORIGHTS
+% Copyright (C) 2007-10 Andrea Vedaldi and Brian Fulkerson
+%
+% This file is part of VLFeat, available under the terms of the
+% GNU GPLv2, or (at your option) any later version.
@@ -0,0 +1,944 @@
+/*=================================================================
+% mesh_loader.h - fast reader of OFF, OBJ, PLY (ascii and binary) and COF
+%   meshes, with an optional binary cache.
+%
+%   The file is memory mapped and parsed in place: no line or token
+%   strings, numbers are read by a hand written parser (exact for the
+%   usual up to 15 digits, strtod otherwise, so the values are the same as
+%   atof/strtod give). Facets are polygons, see MeshData.
+%
+%   With a cache, the first load writes <filename>.mcache next to the file;
+%   later loads memory map it and copy the arrays out, as long as the size
+%   and the modification time of the mesh file are unchanged.
+%
+%   usage:
+%		MeshData mesh;
+%		MeshLoader loader;
+%		loader.use_cache(true);		// optional
+%		if( !loader.load(filename, mesh) )
+%			cerr << loader.error() << endl;
+%
+%   cache layout (native byte order, every array starts on 8 bytes):
+%		char[8] "JJMESH01", uint32 0x01020304, uint32 0, uint64 size, int64 mtime of the mesh file,
+%		uint64 nverts, nfacets, nindices, nnormals, nuv, nconstrained
+%		double positions[3*nverts], uint32 facet_start[nfacets+1], uint32 indices[nindices],
+%		double normals[3*nnormals], double uv[2*nuv], uint32 constrained[nconstrained],
+%		double constrained_uv[2*nconstrained]
+*=================================================================*/
+
+#ifndef MESH_LOADER_H
+#define MESH_LOADER_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <stdint.h>
+#include <math.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <string>
+#include <vector>
+#include "../../include/MappedFile.h"
+
+//----------------------------------------------------------------
+// facet f has the vertices indices[facet_start[f]] .. indices[facet_start[f+1]-1]
+struct MeshData
+{
+	std::vector<double> positions;			// x y z per vertex
+	std::vector<unsigned int> facet_start;	// nfacets+1 offsets in indices
+	std::vector<unsigned int> indices;		// 0-based vertices of the facets
+	std::vector<double> normals;			// x y z of the first normals.size()/3 vertices
+	std::vector<double> uv;					// u v of the first uv.size()/2 vertices
+	std::vector<unsigned int> constrained;	// COF 'cv' vertices
+	std::vector<double> constrained_uv;		// u v per constrained vertex, NaN if not given
+
+	size_t n_vertices() const { return positions.size()/3; }
+	size_t n_facets() const { return facet_start.empty() ? 0 : facet_start.size()-1; }
+	bool is_triangle_mesh() const { return indices.size()==3*n_facets(); }
+
+	void clear()
+	{
+		positions.clear(); facet_start.assign(1, 0); indices.clear();
+		normals.clear(); uv.clear(); constrained.clear(); constrained_uv.clear();
+	}
+
+	// splits every polygon in a fan of triangles around its first vertex
+	void triangulate()
+	{
+		if( is_triangle_mesh() )
+			return;
+		std::vector<unsigned int> tris;
+		tris.reserve(3*(indices.size() - 2*n_facets()));
+		for( size_t f=0; f<n_facets(); ++f )
+			for( unsigned int k=facet_start[f]+2; k<facet_start[f+1]; ++k )
+			{
+				tris.push_back(indices[facet_start[f]]);
+				tris.push_back(indices[k-1]);
+				tris.push_back(indices[k]);
+			}
+		indices.swap(tris);
+		facet_start.resize(indices.size()/3 + 1);
+		for( size_t f=0; f<facet_start.size(); ++f )
+			facet_start[f] = (unsigned int) (3*f);
+	}
+};
+
+class MeshLoader
+{
+public:
+	enum Format { UNKNOWN = 0, OFF, OBJ, PLY, COF };
+
+	MeshLoader() : use_cache_(false) {}
+
+	void use_cache(bool b) { use_cache_ = b; }
+	const std::string& error() const { return error_; }
+
+	//----------------------------------------------------------------
+	// the format is given by the extension (.off .obj .ply .cof) unless it is passed
+	bool load(const char* filename, MeshData& mesh, Format format = UNKNOWN)
+	{
+		error_.clear();
+		if( format==UNKNOWN )
+			format = format_of(filename);
+		if( format==UNKNOWN )
+			return fail("unknown mesh format", filename);
+
+		int64_t size = 0, mtime = 0;
+		std::string cache = std::string(filename) + ".mcache";
+		if( use_cache_ && file_stamp(filename, size, mtime) && read_cache(cache.c_str(), size, mtime, mesh) )
+			return true;
+
+		MappedFile file;
+		if( !file.open(filename) )
+			return fail("cannot open (or empty)", filename);
+		if( !parse(file.data(), file.data() + file.size(), format, mesh) )
+			return false;
+		if( use_cache_ && size>0 )
+			write_cache(cache.c_str(), size, mtime, mesh);
+		return true;
+	}
+
+	// parses a whole file already in memory
+	bool parse(const char* begin, const char* end, Format format, MeshData& mesh)
+	{
+		mesh.clear();
+		p_ = begin;
+		end_ = end;
+		bool ok = false;
+		switch( format )
+		{
+		case OFF: ok = parse_off(mesh); break;
+		case OBJ: ok = parse_obj(mesh); break;
+		case PLY: ok = parse_ply(mesh); break;
+		case COF: ok = parse_cof(mesh); break;
+		default: error_ = "unknown mesh format";
+		}
+		if( ok && !check_indices(mesh) )
+			ok = false;
+		if( !ok )
+			mesh.clear();
+		return ok;
+	}
+
+	static Format format_of(const char* filename)
+	{
+		const char* dot = strrchr(filename, '.');
+		if( dot==NULL )
+			return UNKNOWN;
+		char ext[8] = {0};
+		for( int i=0; i<7 && dot[i+1]; ++i )
+			ext[i] = (char) tolower(dot[i+1]);
+		if( strcmp(ext, "off")==0 ) return OFF;
+		if( strcmp(ext, "obj")==0 ) return OBJ;
+		if( strcmp(ext, "ply")==0 ) return PLY;
+		if( strcmp(ext, "cof")==0 ) return COF;
+		return UNKNOWN;
+	}
+
+	//----------------------------------------------------------------
+	// cache
+	static bool file_stamp(const char* filename, int64_t& size, int64_t& mtime)
+	{
+#ifdef _WIN32
+		struct _stat64 st;
+		if( _stat64(filename, &st)!=0 )
+			return false;
+#else
+		struct stat st;
+		if( stat(filename, &st)!=0 )
+			return false;
+#endif
+		size = (int64_t) st.st_size;
+		mtime = (int64_t) st.st_mtime;
+		return true;
+	}
+
+	static bool write_cache(const char* cache, int64_t size, int64_t mtime, const MeshData& mesh)
+	{
+		FILE* fp = fopen(cache, "wb");
+		if( fp==NULL )
+			return false;
+		CacheHeader h;
+		fill_header(h, size, mtime, mesh);
+		bool ok = fwrite(&h, sizeof(h), 1, fp)==1
+			&& write_array(fp, mesh.positions) && write_array(fp, mesh.facet_start)
+			&& write_array(fp, mesh.indices) && write_array(fp, mesh.normals)
+			&& write_array(fp, mesh.uv) && write_array(fp, mesh.constrained)
+			&& write_array(fp, mesh.constrained_uv);
+		ok = fclose(fp)==0 && ok;
+		if( !ok )
+			remove(cache);
+		return ok;
+	}
+
+	static bool read_cache(const char* cache, int64_t size, int64_t mtime, MeshData& mesh)
+	{
+		MappedFile file;
+		if( !file.open(cache) || file.size()<sizeof(CacheHeader) )
+			return false;
+		CacheHeader h;
+		memcpy(&h, file.data(), sizeof(h));
+		if( memcmp(h.magic, "JJMESH01", 8)!=0 || h.order!=0x01020304 || h.size!=size || h.mtime!=mtime )
+			return false;
+		if( h.nfacets>=0xffffffffu || h.nindices>=0xffffffffu )
+			return false;
+		uint64_t bytes = sizeof(h) + padded(24*h.nverts) + padded(4*(h.nfacets+1)) + padded(4*h.nindices)
+			+ padded(24*h.nnormals) + padded(16*h.nuv) + padded(4*h.nconstrained) + padded(16*h.nconstrained);
+		if( bytes!=file.size() )
+			return false;
+		const char* p = file.data() + sizeof(h);
+		read_array(p, 3*h.nverts, mesh.positions);
+		read_array(p, h.nfacets+1, mesh.facet_start);
+		read_array(p, h.nindices, mesh.indices);
+		read_array(p, 3*h.nnormals, mesh.normals);
+		read_array(p, 2*h.nuv, mesh.uv);
+		read_array(p, h.nconstrained, mesh.constrained);
+		read_array(p, 2*h.nconstrained, mesh.constrained_uv);
+		return true;
+	}
+
+	//----------------------------------------------------------------
+	// numbers, exposed for the other readers
+	static const char* parse_real(const char* p, const char* end, double& x)
+	{
+		static const double pow10[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10,
+			1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+		const char* start = p;
+		bool negative = false;
+		if( p<end && (*p=='-' || *p=='+') )
+			negative = *p++=='-';
+		uint64_t m = 0;
+		int ndigits = 0, nsignificant = 0, exp10 = 0;
+		for( ; p<end && is_digit(*p); ++p, ++ndigits )
+		{
+			if( nsignificant<19 )
+			{
+				m = 10*m + (*p-'0');
+				if( m ) ++nsignificant;
+			}
+			else
+				++exp10, ++nsignificant;
+		}
+		if( p<end && *p=='.' )
+		{
+			for( ++p; p<end && is_digit(*p); ++p, ++ndigits )
+			{
+				if( nsignificant<19 )
+				{
+					m = 10*m + (*p-'0');
+					--exp10;
+					if( m ) ++nsignificant;
+				}
+				else
+					++nsignificant;
+			}
+		}
+		if( ndigits==0 )
+			return parse_real_slow(start, end, x);
+		if( p<end && (*p=='e' || *p=='E') )
+		{
+			const char* q = p+1;
+			bool eneg = false;
+			if( q<end && (*q=='-' || *q=='+') )
+				eneg = *q++=='-';
+			if( q<end && is_digit(*q) )
+			{
+				int e = 0;
+				for( ; q<end && is_digit(*q); ++q )
+					if( e<100000 ) e = 10*e + (*q-'0');
+				exp10 += eneg ? -e : e;
+				p = q;
+			}
+		}
+		if( nsignificant>19 || m>(((uint64_t) 1)<<53) || exp10<-22 || exp10>22 )
+			return parse_real_slow(start, end, x);
+		// both m and 10^|exp10| are exact doubles: one correctly rounded operation
+		x = (double) m;
+		x = exp10<0 ? x/pow10[-exp10] : x*pow10[exp10];
+		if( negative ) x = -x;
+		return p;
+	}
+
+	// NULL as well for a value above 2^32-1: counts and indices are stored as unsigned int,
+	// a larger one must be rejected rather than wrap around to a valid index
+	static const char* parse_uint(const char* p, const char* end, unsigned long& n)
+	{
+		n = 0;
+		if( p<end && *p=='+' ) ++p;
+		const char* start = p;
+		for( ; p<end && is_digit(*p); ++p )
+		{
+			unsigned long d = *p-'0';
+			if( n>(0xFFFFFFFFul-d)/10 )
+				return NULL;
+			n = 10*n + d;
+		}
+		return p==start ? NULL : p;
+	}
+
+	static const char* parse_int(const char* p, const char* end, long& n)
+	{
+		bool negative = p<end && *p=='-';
+		if( negative ) ++p;
+		unsigned long u;
+		p = parse_uint(p, end, u);
+		n = negative ? -(long) u : (long) u;
+		return p;
+	}
+
+private:
+	struct CacheHeader
+	{
+		char magic[8];
+		uint32_t order, reserved;
+		int64_t size, mtime;
+		uint64_t nverts, nfacets, nindices, nnormals, nuv, nconstrained;
+	};
+
+	static void fill_header(CacheHeader& h, int64_t size, int64_t mtime, const MeshData& mesh)
+	{
+		memcpy(h.magic, "JJMESH01", 8);
+		h.order = 0x01020304;
+		h.reserved = 0;
+		h.size = size;
+		h.mtime = mtime;
+		h.nverts = mesh.n_vertices();
+		h.nfacets = mesh.n_facets();
+		h.nindices = mesh.indices.size();
+		h.nnormals = mesh.normals.size()/3;
+		h.nuv = mesh.uv.size()/2;
+		h.nconstrained = mesh.constrained.size();
+	}
+
+	static uint64_t padded(uint64_t bytes) { return (bytes + 7) & ~(uint64_t) 7; }
+
+	template<class T>
+	static bool write_array(FILE* fp, const std::vector<T>& a)
+	{
+		static const char zeros[8] = {0};
+		size_t bytes = a.size()*sizeof(T);
+		if( bytes && fwrite(&a[0], 1, bytes, fp)!=bytes )
+			return false;
+		size_t pad = (size_t) (padded(bytes) - bytes);
+		return pad==0 || fwrite(zeros, 1, pad, fp)==pad;
+	}
+
+	template<class T>
+	static void read_array(const char*& p, uint64_t n, std::vector<T>& a)
+	{
+		a.resize((size_t) n);
+		if( n )
+			memcpy(&a[0], p, (size_t) n*sizeof(T));
+		p += padded(n*sizeof(T));
+	}
+
+	//----------------------------------------------------------------
+	// scanning helpers, p_ is the current position
+	static bool is_digit(char c) { return c>='0' && c<='9'; }
+	static bool is_blank(char c) { return c==' ' || c=='\t' || c=='\r' || c=='\f' || c=='\v'; }
+
+	static const char* parse_real_slow(const char* p, const char* end, double& x)
+	{
+		char buf[64];
+		size_t n = 0;
+		while( p+n<end && n<sizeof(buf)-1 && !is_blank(p[n]) && p[n]!='\n' && p[n]!='/' )
+		{
+			buf[n] = p[n];
+			++n;
+		}
+		std::string big;
+		const char* s = buf;
+		if( n==sizeof(buf)-1 )	// a long token
+		{
+			while( p+n<end && !is_blank(p[n]) && p[n]!='\n' )
+				++n;
+			big.assign(p, n);
+			s = big.c_str();
+		}
+		else
+			buf[n] = 0;
+		char* stop;
+		x = strtod(s, &stop);
+		return stop==s ? NULL : p + (stop - s);
+	}
+
+	void skip_blanks() { while( p_<end_ && is_blank(*p_) ) ++p_; }
+	void skip_line()
+	{
+		const char* q = (const char*) memchr(p_, '\n', end_ - p_);
+		p_ = q ? q+1 : end_;
+	}
+	bool at_line_end() { skip_blanks(); return p_>=end_ || *p_=='\n' || *p_=='#'; }
+	// next line with something else than blanks or a comment
+	bool next_data_line()
+	{
+		for( ;; )
+		{
+			skip_blanks();
+			if( p_>=end_ )
+				return false;
+			if( *p_!='\n' && *p_!='#' )
+				return true;
+			skip_line();
+		}
+	}
+	// skips blanks, comments and line ends (OFF is free-form)
+	void skip_space()
+	{
+		for( ;; )
+		{
+			while( p_<end_ && (is_blank(*p_) || *p_=='\n') ) ++p_;
+			if( p_<end_ && *p_=='#' )
+				skip_line();
+			else
+				return;
+		}
+	}
+	bool read_real(double& x)
+	{
+		skip_blanks();
+		const char* q = p_<end_ ? parse_real(p_, end_, x) : NULL;
+		if( q==NULL )
+			return false;
+		p_ = q;
+		return true;
+	}
+	bool read_real_any(double& x) { skip_space(); return read_real(x); }
+	bool read_uint_any(unsigned long& n)
+	{
+		skip_space();
+		const char* q = parse_uint(p_, end_, n);
+		if( q==NULL )
+			return false;
+		p_ = q;
+		return true;
+	}
+	bool read_word(std::string& w)
+	{
+		skip_blanks();
+		const char* q = p_;
+		while( q<end_ && !is_blank(*q) && *q!='\n' ) ++q;
+		w.assign(p_, q);
+		p_ = q;
+		return !w.empty();
+	}
+	bool keyword(const char* k)
+	{
+		size_t n = strlen(k);
+		if( (size_t) (end_ - p_)<n || memcmp(p_, k, n)!=0 )
+			return false;
+		if( p_+n<end_ && !is_blank(p_[n]) && p_[n]!='\n' )
+			return false;
+		p_ += n;
+		return true;
+	}
+
+	bool fail(const char* what, const char* name = NULL)
+	{
+		error_ = what;
+		if( name )
+			error_ = error_ + ": " + name;
+		return false;
+	}
+
+	bool check_indices(const MeshData& mesh)
+	{
+		size_t nverts = mesh.n_vertices();
+		for( size_t i=0; i<mesh.indices.size(); ++i )
+			if( mesh.indices[i]>=nverts )
+				return fail("a facet has an invalid vertex index");
+		for( size_t i=0; i<mesh.constrained.size(); ++i )
+			if( mesh.constrained[i]>=nverts )
+				return fail("a constrained vertex has an invalid index");
+		return true;
+	}
+
+	// false if count records of at least min_bytes each cannot fit in the rest of the file
+	bool fits(unsigned long count, size_t min_bytes) const
+	{
+		return count <= (size_t) (end_ - p_)/min_bytes + 1;
+	}
+
+	//----------------------------------------------------------------
+	// [ST][C][N]OFF, the counts on the same line or the next one. The
+	// vertices are free-form (several on a line, or one split over lines)
+	// unless they have colors, whose number varies: a COFF vertex is then
+	// ended by its line, and its u v are the last two numbers of the line.
+	// The colors after the facet vertices are skipped
+	bool parse_off(MeshData& mesh)
+	{
+		skip_space();
+		std::string word;
+		read_word(word);
+		bool has_normals = false, has_uv = false, has_colors = false;
+		if( word.size()<3 || word.compare(word.size()-3, 3, "OFF")!=0 )
+			return fail("not an OFF file");
+		for( size_t i=0; i+3<word.size(); ++i )
+		{
+			if( word[i]=='N' ) has_normals = true;
+			else if( word[i]=='C' ) has_colors = true;
+			else if( word[i]=='S' && i+1<word.size() && word[i+1]=='T' ) has_uv = true;
+			else if( word[i]=='4' || word[i]=='n' ) return fail("only 3D OFF files are supported");
+		}
+		unsigned long nverts, nfacets, nedges;
+		if( !read_uint_any(nverts) || !read_uint_any(nfacets) || !read_uint_any(nedges) )
+			return fail("OFF header without the number of vertices/facets/edges");
+		// a vertex takes at least "0 0 0 " and a facet "0 ": a bad header is an error, not a huge allocation
+		if( !fits(nverts, 6) || !fits(nfacets, 2) )
+			return fail("OFF header counts more vertices/facets than the file holds");
+
+		mesh.positions.resize(3*nverts);
+		if( has_normals ) mesh.normals.resize(3*nverts);
+		if( has_uv ) mesh.uv.resize(2*nverts);
+		for( unsigned long i=0; i<nverts; ++i )
+		{
+			double* x = &mesh.positions[3*i];
+			if( !read_real_any(x[0]) || !read_real_any(x[1]) || !read_real_any(x[2]) )
+				return fail("bad OFF vertex");
+			if( has_normals && (!read_real_any(mesh.normals[3*i]) || !read_real_any(mesh.normals[3*i+1]) || !read_real_any(mesh.normals[3*i+2])) )
+				return fail("bad OFF vertex normal");
+			if( has_colors )
+			{
+				// colors then u v: the texture coordinates are the last two numbers of the line
+				double tail[2] = {0, 0};
+				int ntail = 0;
+				for( double c; !at_line_end() && read_real(c); ++ntail )
+				{
+					tail[0] = tail[1];
+					tail[1] = c;
+				}
+				if( has_uv && ntail<2 )
+					return fail("bad OFF texture coordinates");
+				if( has_uv )
+				{
+					mesh.uv[2*i] = tail[0];
+					mesh.uv[2*i+1] = tail[1];
+				}
+				skip_line();
+			}
+			else if( has_uv && (!read_real_any(mesh.uv[2*i]) || !read_real_any(mesh.uv[2*i+1])) )
+				return fail("bad OFF texture coordinates");
+		}
+		mesh.facet_start.resize(nfacets+1);
+		mesh.indices.reserve(3*nfacets);
+		for( unsigned long f=0; f<nfacets; ++f )
+		{
+			unsigned long n, v;
+			if( !read_uint_any(n) )
+				return fail("bad OFF facet");
+			for( unsigned long k=0; k<n; ++k )
+			{
+				skip_blanks();
+				const char* q = parse_uint(p_, end_, v);
+				if( q==NULL )
+					return fail("bad OFF facet");
+				p_ = q;
+				mesh.indices.push_back((unsigned int) v);
+			}
+			mesh.facet_start[f+1] = (unsigned int) mesh.indices.size();
+			skip_line();
+		}
+		return true;
+	}
+
+	//----------------------------------------------------------------
+	// v, vt, vn and f v[/vt][/vn] (1-based, negative = relative), the rest
+	// is skipped; the texture coordinates and normals of the corners are
+	// given to their vertices, or taken in order when there are as many as
+	// vertices and the facets do not refer to them
+	bool parse_obj(MeshData& mesh)
+	{
+		std::vector<double> vt, vn;
+		std::vector<long> corner_vt, corner_vn;
+		bool any_vt = false, any_vn = false;
+		while( next_data_line() )
+		{
+			if( keyword("v") )
+			{
+				double x, y, z;
+				if( !read_real(x) || !read_real(y) || !read_real(z) )
+					return fail("bad OBJ vertex");
+				mesh.positions.push_back(x);
+				mesh.positions.push_back(y);
+				mesh.positions.push_back(z);
+			}
+			else if( keyword("vt") )
+			{
+				double u, v = 0;
+				if( !read_real(u) )
+					return fail("bad OBJ texture coordinates");
+				if( !at_line_end() ) read_real(v);
+				vt.push_back(u);
+				vt.push_back(v);
+			}
+			else if( keyword("vn") )
+			{
+				double x, y, z;
+				if( !read_real(x) || !read_real(y) || !read_real(z) )
+					return fail("bad OBJ normal");
+				vn.push_back(x);
+				vn.push_back(y);
+				vn.push_back(z);
+			}
+			else if( keyword("f") )
+			{
+				long nv = (long) mesh.n_vertices(), nt = (long) vt.size()/2, nn = (long) vn.size()/3;
+				while( !at_line_end() )
+				{
+					if( *p_=='\\' )	// the facet goes on at the next line
+					{
+						skip_line();
+						continue;
+					}
+					long idx[3] = {0, 0, 0};
+					for( int k=0; k<3; ++k )
+					{
+						if( k>0 )
+						{
+							if( p_>=end_ || *p_!='/' )
+								break;
+							++p_;
+							if( p_<end_ && *p_=='/' )
+								continue;
+						}
+						const char* q = parse_int(p_, end_, idx[k]);
+						if( q==NULL )
+							return fail("bad OBJ facet");
+						p_ = q;
+					}
+					long v = idx[0]<0 ? nv + idx[0] : idx[0] - 1;
+					if( idx[0]==0 || v<0 )
+						return fail("bad OBJ facet");
+					mesh.indices.push_back((unsigned int) v);
+					corner_vt.push_back(idx[1]==0 ? -1 : (idx[1]<0 ? nt + idx[1] : idx[1] - 1));
+					corner_vn.push_back(idx[2]==0 ? -1 : (idx[2]<0 ? nn + idx[2] : idx[2] - 1));
+					any_vt = any_vt || idx[1]!=0;
+					any_vn = any_vn || idx[2]!=0;
+				}
+				mesh.facet_start.push_back((unsigned int) mesh.indices.size());
+			}
+			skip_line();
+		}
+
+		size_t nverts = mesh.n_vertices();
+		if( any_vt )
+			corner_attributes(mesh, corner_vt, vt, 2, mesh.uv);
+		else if( vt.size()==2*nverts )
+			mesh.uv.swap(vt);
+		if( any_vn )
+			corner_attributes(mesh, corner_vn, vn, 3, mesh.normals);
+		else if( vn.size()==3*nverts )
+			mesh.normals.swap(vn);
+		return true;
+	}
+
+	static void corner_attributes(const MeshData& mesh, const std::vector<long>& corner, const std::vector<double>& values, int dim, std::vector<double>& out)
+	{
+		long n = (long) values.size()/dim;
+		out.assign(dim*mesh.n_vertices(), 0.0);
+		for( size_t c=0; c<corner.size(); ++c )
+			if( corner[c]>=0 && corner[c]<n )
+				for( int k=0; k<dim; ++k )
+					out[dim*mesh.indices[c] + k] = values[dim*corner[c] + k];
+	}
+
+	//----------------------------------------------------------------
+	// COF: v x y z, vt u v (of the vertices in order), f i j k (0-based),
+	// cv i [u v] (constrained vertex)
+	bool parse_cof(MeshData& mesh)
+	{
+		while( next_data_line() )
+		{
+			if( keyword("v") )
+			{
+				double x, y, z;
+				if( !read_real(x) || !read_real(y) || !read_real(z) )
+					return fail("bad COF vertex");
+				mesh.positions.push_back(x);
+				mesh.positions.push_back(y);
+				mesh.positions.push_back(z);
+			}
+			else if( keyword("vt") )
+			{
+				double u, v;
+				if( !read_real(u) || !read_real(v) )
+					return fail("bad COF texture coordinates");
+				mesh.uv.push_back(u);
+				mesh.uv.push_back(v);
+			}
+			else if( keyword("f") )
+			{
+				while( !at_line_end() )
+				{
+					unsigned long v;
+					const char* q = parse_uint(p_, end_, v);
+					if( q==NULL )
+						return fail("bad COF facet");
+					p_ = q;
+					mesh.indices.push_back((unsigned int) v);
+				}
+				mesh.facet_start.push_back((unsigned int) mesh.indices.size());
+			}
+			else if( keyword("cv") )
+			{
+				unsigned long v;
+				skip_blanks();
+				const char* q = parse_uint(p_, end_, v);
+				if( q==NULL )
+					return fail("bad COF constrained vertex");
+				p_ = q;
+				double u = sqrt(-1.0), w = u;
+				if( !at_line_end() && (!read_real(u) || !read_real(w)) )
+					return fail("bad COF constrained vertex");
+				mesh.constrained.push_back((unsigned int) v);
+				mesh.constrained_uv.push_back(u);
+				mesh.constrained_uv.push_back(w);
+			}
+			skip_line();
+		}
+		return true;
+	}
+
+	//----------------------------------------------------------------
+	// PLY: the vertex element (x y z, nx ny nz, u v | s t | texture_u
+	// texture_v, of any type) and the face element (vertex_indices or
+	// vertex_index list), any other element or property is skipped
+	enum PlyType { PLY_NONE = 0, PLY_INT8, PLY_UINT8, PLY_INT16, PLY_UINT16, PLY_INT32, PLY_UINT32, PLY_FLOAT32, PLY_FLOAT64 };
+	struct PlyProperty
+	{
+		std::string name;
+		PlyType type, count_type;	// count_type!=PLY_NONE for a list
+	};
+	struct PlyElement
+	{
+		std::string name;
+		unsigned long count;
+		std::vector<PlyProperty> props;
+	};
+
+	static PlyType ply_type(const std::string& s)
+	{
+		if( s=="char" || s=="int8" ) return PLY_INT8;
+		if( s=="uchar" || s=="uint8" ) return PLY_UINT8;
+		if( s=="short" || s=="int16" ) return PLY_INT16;
+		if( s=="ushort" || s=="uint16" ) return PLY_UINT16;
+		if( s=="int" || s=="int32" ) return PLY_INT32;
+		if( s=="uint" || s=="uint32" ) return PLY_UINT32;
+		if( s=="float" || s=="float32" ) return PLY_FLOAT32;
+		if( s=="double" || s=="float64" ) return PLY_FLOAT64;
+		return PLY_NONE;
+	}
+	static int ply_size(PlyType t)
+	{
+		static const int size[] = { 0, 1, 1, 2, 2, 4, 4, 4, 8 };
+		return size[t];
+	}
+
+	// one binary value, swapped when the file and the machine byte orders differ
+	static double ply_binary(const char* p, PlyType t, bool swap)
+	{
+		unsigned char b[8];
+		int n = ply_size(t);
+		for( int i=0; i<n; ++i )
+			b[i] = (unsigned char) p[swap ? n-1-i : i];
+		switch( t )
+		{
+		case PLY_INT8: { int8_t v; memcpy(&v, b, 1); return v; }
+		case PLY_UINT8: return b[0];
+		case PLY_INT16: { int16_t v; memcpy(&v, b, 2); return v; }
+		case PLY_UINT16: { uint16_t v; memcpy(&v, b, 2); return v; }
+		case PLY_INT32: { int32_t v; memcpy(&v, b, 4); return v; }
+		case PLY_UINT32: { uint32_t v; memcpy(&v, b, 4); return v; }
+		case PLY_FLOAT32: { float v; memcpy(&v, b, 4); return v; }
+		case PLY_FLOAT64: { double v; memcpy(&v, b, 8); return v; }
+		default: return 0;
+		}
+	}
+
+	bool ply_value(PlyType t, bool ascii, bool swap, double& x)
+	{
+		if( ascii )
+			return read_real_any(x);
+		int n = ply_size(t);
+		if( end_ - p_<n )
+			return false;
+		x = ply_binary(p_, t, swap);
+		p_ += n;
+		return true;
+	}
+
+	bool parse_ply(MeshData& mesh)
+	{
+		if( !keyword("ply") )
+			return fail("not a PLY file");
+		skip_line();
+		bool ascii = true, swap = false;
+		std::vector<PlyElement> elements;
+		std::string word;
+		for( ;; )
+		{
+			if( p_>=end_ )
+				return fail("PLY header without end_header");
+			read_word(word);
+			if( word=="end_header" )
+			{
+				skip_line();
+				break;
+			}
+			if( word=="format" )
+			{
+				read_word(word);
+				unsigned int one = 1;
+				bool little = *(unsigned char*) &one==1;
+				if( word=="ascii" ) ascii = true;
+				else if( word=="binary_little_endian" ) { ascii = false; swap = !little; }
+				else if( word=="binary_big_endian" ) { ascii = false; swap = little; }
+				else return fail("unknown PLY format");
+			}
+			else if( word=="element" )
+			{
+				PlyElement e;
+				read_word(e.name);
+				unsigned long count;
+				skip_blanks();
+				const char* q = parse_uint(p_, end_, count);
+				if( q==NULL )
+					return fail("bad PLY element");
+				p_ = q;
+				e.count = count;
+				elements.push_back(e);
+			}
+			else if( word=="property" )
+			{
+				if( elements.empty() )
+					return fail("PLY property without element");
+				PlyProperty prop;
+				read_word(word);
+				prop.count_type = PLY_NONE;
+				if( word=="list" )
+				{
+					read_word(word);
+					prop.count_type = ply_type(word);
+					read_word(word);
+					if( prop.count_type==PLY_NONE )
+						return fail("bad PLY list");
+				}
+				prop.type = ply_type(word);
+				if( prop.type==PLY_NONE )
+					return fail("unknown PLY property type");
+				read_word(prop.name);
+				elements.back().props.push_back(prop);
+			}
+			skip_line();
+		}
+
+		for( size_t e=0; e<elements.size(); ++e )
+		{
+			const PlyElement& el = elements[e];
+			bool is_vertex = el.name=="vertex", is_face = el.name=="face";
+			int xyz[3] = {-1, -1, -1}, nxyz[3] = {-1, -1, -1}, uv[2] = {-1, -1}, list = -1;
+			for( size_t k=0; k<el.props.size(); ++k )
+			{
+				const std::string& n = el.props[k].name;
+				if( el.props[k].count_type!=PLY_NONE )
+				{
+					if( is_face && (n=="vertex_indices" || n=="vertex_index") ) list = (int) k;
+					continue;
+				}
+				if( n=="x" ) xyz[0] = (int) k; else if( n=="y" ) xyz[1] = (int) k; else if( n=="z" ) xyz[2] = (int) k;
+				else if( n=="nx" ) nxyz[0] = (int) k; else if( n=="ny" ) nxyz[1] = (int) k; else if( n=="nz" ) nxyz[2] = (int) k;
+				else if( n=="u" || n=="s" || n=="texture_u" ) uv[0] = (int) k;
+				else if( n=="v" || n=="t" || n=="texture_v" ) uv[1] = (int) k;
+			}
+			if( is_vertex )
+			{
+				if( xyz[0]<0 || xyz[1]<0 || xyz[2]<0 )
+					return fail("PLY vertices without x y z");
+				if( !fits(el.count, 1) )
+					return fail("PLY header counts more vertices than the file holds");
+				mesh.positions.resize(3*el.count);
+				if( nxyz[0]>=0 && nxyz[1]>=0 && nxyz[2]>=0 ) mesh.normals.resize(3*el.count);
+				if( uv[0]>=0 && uv[1]>=0 ) mesh.uv.resize(2*el.count);
+			}
+			if( is_face )
+			{
+				if( list<0 )
+					return fail("PLY faces without vertex_indices");
+				if( !fits(el.count, 1) )
+					return fail("PLY header counts more faces than the file holds");
+				mesh.facet_start.resize(el.count+1);
+				mesh.indices.reserve(3*el.count);
+			}
+
+			std::vector<double> values(el.props.size());
+			for( unsigned long i=0; i<el.count; ++i )
+			{
+				for( size_t k=0; k<el.props.size(); ++k )
+				{
+					const PlyProperty& prop = el.props[k];
+					if( prop.count_type==PLY_NONE )
+					{
+						if( !ply_value(prop.type, ascii, swap, values[k]) )
+							return fail("PLY file too short");
+						continue;
+					}
+					double count;
+					if( !ply_value(prop.count_type, ascii, swap, count) )
+						return fail("PLY file too short");
+					for( long j=0; j<(long) count; ++j )
+					{
+						double v;
+						if( !ply_value(prop.type, ascii, swap, v) )
+							return fail("PLY file too short");
+						if( (int) k==list )
+							mesh.indices.push_back((unsigned int) v);
+					}
+				}
+				if( ascii )
+					skip_line();
+				if( is_vertex )
+				{
+					for( int c=0; c<3; ++c )
+						mesh.positions[3*i+c] = values[xyz[c]];
+					if( !mesh.normals.empty() )
+						for( int c=0; c<3; ++c )
+							mesh.normals[3*i+c] = values[nxyz[c]];
+					if( !mesh.uv.empty() )
+						for( int c=0; c<2; ++c )
+							mesh.uv[2*i+c] = values[uv[c]];
+				}
+				if( is_face )
+					mesh.facet_start[i+1] = (unsigned int) mesh.indices.size();
+			}
+		}
+		return true;
+	}
+
+	bool use_cache_;
+	std::string error_;
+	const char* p_;
+	const char* end_;
+};
+
+#endif // MESH_LOADER_H
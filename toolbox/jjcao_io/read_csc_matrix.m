@@ -0,0 +1,74 @@
+function [W, info] = read_csc_matrix(filename, cols, symmetrize)
+
+% read_csc_matrix - read a sparse matrix written by the mex files built on
+% sparse_csc_builder.h (perform_mesh_weight, cotangentLaplacianMatrix,
+% symmshlpmatrix) with options.file.
+%
+%   [W, info] = read_csc_matrix(filename);
+%   W = read_csc_matrix(filename, cols);
+%   W = read_csc_matrix(filename, cols, symmetrize);
+%
+%   'cols' = [first last] reads only these columns (1-based), the others
+%       stay on the disk: W is m x (last-first+1). Default: all columns.
+%   'symmetrize' = 1 mirrors a matrix stored with options.storage = 'upper',
+%       W = U + triu(U,1)' (all the columns are needed). Default: 1.
+%   'info' has the fields m, n, nnz, precision ('single' or 'double') and
+%       storage ('full' or 'upper').
+
+fid = fopen(filename,'r');
+if( fid==-1 )
+    error('Can''t open the file.');
+end
+
+magic = fread(fid, 8, '*char')';
+if ~strcmp(magic, 'JJCSC001')
+    fclose(fid);
+    error('Not a sparse matrix file.');
+end
+sizes = fread(fid, 3, 'uint64');
+flags = fread(fid, 2, 'uint32');
+info.m = sizes(1);
+info.n = sizes(2);
+info.nnz = sizes(3);
+if flags(1)==4
+    info.precision = 'single';
+else
+    info.precision = 'double';
+end
+if flags(2)==1
+    info.storage = 'upper';
+else
+    info.storage = 'full';
+end
+
+if nargin < 2 || isempty(cols)
+    cols = [1 info.n];
+end
+if nargin < 3
+    symmetrize = 1;
+end
+
+header = 8 + 3*8 + 2*4;
+offset_values = header + 8*info.nnz;
+offset_jc = offset_values + flags(1)*info.nnz;
+
+% column pointers of the columns to read
+fseek(fid, offset_jc + 8*(cols(1)-1), 'bof');
+jc = fread(fid, cols(2)-cols(1)+2, 'uint64');
+first = jc(1);
+count = jc(end) - first;
+
+fseek(fid, header + 8*first, 'bof');
+ir = fread(fid, count, 'uint64');
+fseek(fid, offset_values + flags(1)*first, 'bof');
+val = fread(fid, count, [info.precision '=>double']);
+fclose(fid);
+
+% column of each entry, empty columns start where the next one starts
+J = accumarray(jc(2:end-1)-first+1, 1, [count+1 1]);
+J = cumsum(J(1:count)) + 1;
+W = sparse(ir+1, J, val, info.m, cols(2)-cols(1)+1);
+
+if symmetrize && strcmp(info.storage, 'upper') && cols(1)==1 && cols(2)==info.n
+    W = W + triu(W,1)';
+end
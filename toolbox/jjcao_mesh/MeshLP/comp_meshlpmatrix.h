@@ -2,9 +2,14 @@
 #define __COMP_MESHLPMATRIX_H__
 
 #include "tmesh.h"
+class CscBuilder;
 void generate_sym_meshlp_matrix(TMesh& mesh, double h, double rho, vector<unsigned int>& IIV,  vector<unsigned int>& JJV,  vector<double>& SSV, vector<double>& AAV);
 void generate_sym_meshlp_matrix_geod(TMesh& mesh, double h, double rho, vector<unsigned int>& IIV,  vector<unsigned int>& JJV,  vector<double>& SSV, vector<double>& AAV);
 
+//the same matrices built directly in CSC, the geodesic one as its upper triangle only
+void generate_sym_meshlp_matrix(TMesh& mesh, double h, double rho, CscBuilder& W, vector<double>& AAV);
+void generate_sym_meshlp_matrix_geod(TMesh& mesh, double h, double rho, CscBuilder& W, vector<double>& AAV);
+
 void generate_meshlp_matrix(TMesh& mesh, double h, double rho, vector<unsigned int>& IIV,  vector<unsigned int>& JJV,  vector<double>& SSV);
 void generate_meshlp_matrix_geod(TMesh& mesh, double h, double rho, vector<unsigned int>& IIV,  vector<unsigned int>& JJV,  vector<double>& SSV);
 
@@ -47,6 +47,9 @@ public:
 	virtual unsigned best_source(SurfacePoint& point,			//after propagation step is done, quickly find what source this point belongs to and what is the distance to this source
 								 double& best_source_distance) = 0; 
 
+	virtual void reached_vertices(double max_distance,		//after propagation, list the vertices within max_distance of the sources
+								  std::vector<std::pair<unsigned, double> >& storage);
+
 	virtual void print_statistics()		//print info about timing and memory usage in the propagation step of the algorithm
 	{
 		std::cout << "propagation step took " << m_time_consumed << " seconds " << std::endl;
@@ -147,6 +150,22 @@ inline void GeodesicAlgorithmBase::geodesic(std::vector<SurfacePoint>& sources,
 	}
 }
 
+inline void GeodesicAlgorithmBase::reached_vertices(double max_distance,
+													std::vector<std::pair<unsigned, double> >& storage)
+{
+	storage.clear();
+	for(unsigned i=0; i<m_mesh->vertices().size(); ++i)
+	{
+		SurfacePoint p(&m_mesh->vertices()[i]);
+		double distance;
+		best_source(p, distance);
+		if(distance <= max_distance)
+		{
+			storage.push_back(std::make_pair(i, distance));
+		}
+	}
+}
+
 inline void GeodesicAlgorithmBase::set_stop_conditions(std::vector<SurfacePoint>* stop_points, 
 														double stop_distance)
 {
@@ -8,7 +8,6 @@
 #include <vector>
 #include <cmath>
 #include <assert.h>
-#include <set>
 #include <cstring>
 
 namespace geodesic{
@@ -41,11 +40,12 @@ public:
 	unsigned best_source(SurfacePoint& point,			//quickly find what source this point belongs to and what is the distance to this source
 		double& best_source_distance); 
 
+	void reached_vertices(double max_distance,		//after propagation, list the vertices within max_distance of the sources;
+						  std::vector<std::pair<unsigned, double> >& storage);	//only the edges touched by the propagation are visited
+
 	void print_statistics();
 
 private:
-	typedef std::set<interval_pointer, Interval> IntervalQueue;
-
 	void update_list_and_queue(list_pointer list,
 							   IntervalWithStop* candidates,	//up to two candidates
 							   unsigned num_candidates);
@@ -90,10 +90,11 @@ private:
 	{
 		m_memory_allocator.clear();
 		m_queue.clear();
-		for(unsigned i=0; i<m_edge_interval_lists.size(); ++i)
+		for(unsigned i=0; i<m_touched_edges.size(); ++i)		//only these lists are not empty
 		{
-			m_edge_interval_lists[i].clear();
+			m_edge_interval_lists[m_touched_edges[i]].clear();
 		}
+		m_touched_edges.clear();
 		m_propagation_distance_stopped = GEODESIC_INF;
 	};
 
@@ -125,10 +126,18 @@ private:
 
 	bool erase_from_queue(interval_pointer p);
 
-	IntervalQueue m_queue;	//interval queue
+	void copy_interval(interval_pointer to, Interval* from)		//the copy is not in the queue
+	{
+		memcpy(to,from,sizeof(Interval));
+		to->queue_stamp() = 0;
+	}
 
-	MemoryAllocator<Interval> m_memory_allocator;			//quickly allocate and deallocate intervals 
+	IntervalQueue m_queue;	//interval queue, a heap with lazy deletion
+
+	MemoryAllocator<Interval> m_memory_allocator;			//quickly allocate and deallocate intervals, the blocks are reused by the next propagation
 	std::vector<IntervalList> m_edge_interval_lists;		//every edge has its interval data 
+	std::vector<unsigned> m_touched_edges;					//edges with a non-empty interval list, so that local propagations cost O(touched edges)
+	std::vector<bool> m_vertex_marks;						//used in reached_vertices
 
 	enum MapType {OLD, NEW};		//used for interval intersection
 	MapType map[5];		
@@ -316,15 +325,7 @@ inline bool GeodesicAlgorithmExact::erase_from_queue(interval_pointer p)
 {
 	if(p->min() < GEODESIC_INF/10.0)// && p->min >= queue->begin()->first)
 	{
-		assert(m_queue.count(p)<=1);			//the set is unique
-
-		IntervalQueue::iterator it = m_queue.find(p);
-
-		if(it != m_queue.end())
-		{
-			m_queue.erase(it);
-			return true;
-		}
+		return m_queue.erase(p);
 	}
 
 	return false;
@@ -560,8 +561,7 @@ inline void GeodesicAlgorithmExact::propagate(std::vector<SurfacePoint>& sources
 			}
 		}
 
-		interval_pointer min_interval = *m_queue.begin();
-		m_queue.erase(m_queue.begin());
+		interval_pointer min_interval = m_queue.pop();
 		edge_pointer edge = min_interval->edge();
 		list_pointer list = interval_list(edge);
 
@@ -661,7 +661,7 @@ inline void GeodesicAlgorithmExact::propagate(std::vector<SurfacePoint>& sources
 		} 
 	} 
 
-	m_propagation_distance_stopped = m_queue.empty() ? GEODESIC_INF : (*m_queue.begin())->min();
+	m_propagation_distance_stopped = m_queue.empty() ? GEODESIC_INF : m_queue.top()->min();
 	clock_t stop = clock();
 	m_time_consumed = (static_cast<double>(stop)-static_cast<double>(start))/CLOCKS_PER_SEC;
 
@@ -682,7 +682,7 @@ inline void GeodesicAlgorithmExact::propagate(std::vector<SurfacePoint>& sources
 
 inline bool GeodesicAlgorithmExact::check_stop_conditions(unsigned& index)
 {
-	double queue_distance = (*m_queue.begin())->min();
+	double queue_distance = m_queue.top()->min();
 	if(queue_distance < stop_distance())
 	{
 		return false;
@@ -719,6 +719,8 @@ inline void GeodesicAlgorithmExact::update_list_and_queue(list_pointer list,
 
 	if(list->first() == NULL) 
 	{
+		m_touched_edges.push_back(edge->id());
+
 		interval_pointer* p = &list->first();
 		IntervalWithStop* first;
 		IntervalWithStop* second; 
@@ -755,14 +757,14 @@ inline void GeodesicAlgorithmExact::update_list_and_queue(list_pointer list,
 		}
 
 		*p = m_memory_allocator.allocate();
-		memcpy(*p,first,sizeof(Interval));
+		copy_interval(*p,first);
 		m_queue.insert(*p);
 
 		if(num_candidates == 2)
 		{
 			p = &(*p)->next();
 			*p = m_memory_allocator.allocate();
-			memcpy(*p,second,sizeof(Interval));
+			copy_interval(*p,second);
 			m_queue.insert(*p);
 		}
 
@@ -829,7 +831,7 @@ inline void GeodesicAlgorithmExact::update_list_and_queue(list_pointer list,
 					interval_pointer next = p->next();
 					erase_from_queue(p);
 
-					memcpy(previous,q,sizeof(Interval));
+					copy_interval(previous,q);
 
 					previous->start() = start[0];
 					previous->next() = next;
@@ -872,7 +874,7 @@ inline void GeodesicAlgorithmExact::update_list_and_queue(list_pointer list,
 			else				//p becomes "previous"
 			{
 				i_new[0] = p;
-				memcpy(p,q,sizeof(Interval));
+				copy_interval(p,q);
 
 				p->next() = i_new[1];
 				p->start() = start[0];
@@ -886,11 +888,11 @@ inline void GeodesicAlgorithmExact::update_list_and_queue(list_pointer list,
 
 				if(map[j] == OLD)	
 				{
-					memcpy(current_interval,&swap,sizeof(Interval));
+					copy_interval(current_interval,&swap);
 				}
 				else
 				{
-					memcpy(current_interval,q,sizeof(Interval));
+					copy_interval(current_interval,q);
 				}
 				
 				if(j == N-1)	
@@ -1186,6 +1188,45 @@ inline unsigned GeodesicAlgorithmExact::best_source(SurfacePoint& point,			//qui
 	return best_source_index;
 } 
 
+inline void GeodesicAlgorithmExact::reached_vertices(double max_distance,
+													 std::vector<std::pair<unsigned, double> >& storage)
+{
+	storage.clear();
+	if(m_vertex_marks.size() != m_mesh->vertices().size())
+	{
+		m_vertex_marks.assign(m_mesh->vertices().size(), false);
+	}
+
+	for(unsigned i=0; i<m_touched_edges.size(); ++i)		//a vertex without touched adjacent edges is not reached
+	{
+		edge_pointer e = &m_mesh->edges()[m_touched_edges[i]];
+		for(unsigned j=0; j<2; ++j)
+		{
+			vertex_pointer v = e->adjacent_vertices()[j];
+			if(m_vertex_marks[v->id()])
+			{
+				continue;
+			}
+			m_vertex_marks[v->id()] = true;
+
+			SurfacePoint p(v);
+			double distance;
+			best_source(p, distance);
+			if(distance <= max_distance)
+			{
+				storage.push_back(std::make_pair(v->id(), distance));
+			}
+		}
+	}
+
+	for(unsigned i=0; i<m_touched_edges.size(); ++i)
+	{
+		edge_pointer e = &m_mesh->edges()[m_touched_edges[i]];
+		m_vertex_marks[e->adjacent_vertices()[0]->id()] = false;
+		m_vertex_marks[e->adjacent_vertices()[1]->id()] = false;
+	}
+}
+
 inline interval_pointer GeodesicAlgorithmExact::best_first_interval(SurfacePoint& point, 
 															 double& best_total_distance, 
 															 double& best_interval_position, 
@@ -1369,13 +1410,22 @@ inline void GeodesicAlgorithmExact::print_statistics()
 
 	double memory = m_edge_interval_lists.size()*sizeof(IntervalList) + 
 					interval_counter*sizeof(Interval);
-
-	std::cout << "uses about " << memory/1e6 << "Mb of memory" <<std::endl;
+	double reserved = m_edge_interval_lists.size()*sizeof(IntervalList) + 
+					  m_memory_allocator.memory() + m_queue.memory();
+
+	std::cout << "uses about " << memory/1e6 << "Mb of memory, " 
+			  << reserved/1e6 << "Mb reserved" << std::endl;
+	std::cout << m_memory_allocator.number_of_units() << " intervals allocated in " 
+			  << m_memory_allocator.number_of_blocks() << " blocks of " 
+			  << m_memory_allocator.memory()/1e6/m_memory_allocator.number_of_blocks() << "Mb" << std::endl;
 	std::cout << interval_counter << " total intervals, or " 
 			  << intervals_per_edge << " intervals per edge"
 			  << std::endl;
 	std::cout << "maximum interval queue size is " << m_queue_max_size << std::endl;
 	std::cout << "number of interval propagations is " << m_iterations << std::endl;
+	std::cout << m_queue.number_of_insertions() << " queue insertions, " 
+			  << m_queue.number_of_stale_entries() << " erased entries skipped, heap of " 
+			  << m_queue.memory()/1e6 << "Mb" << std::endl;
 }
 
 }		//geodesic
@@ -133,6 +133,7 @@ public:
 	DirectionType& direction(){return m_direction;};
 	bool visible_from_source(){return m_direction == FROM_SOURCE;};
 	unsigned& source_index(){return m_source_index;};
+	unsigned& queue_stamp(){return m_queue_stamp;};
 
 	void initialize(edge_pointer edge, 
 					SurfacePoint* point = NULL, 
@@ -149,6 +150,7 @@ protected:
 	edge_pointer m_edge;				//edge that the interval belongs to
 	unsigned m_source_index;			//the source it belongs to
 	DirectionType m_direction;			//where the interval is coming from
+	unsigned m_queue_stamp;				//stamp of its entry in the interval queue, 0 if it is not in the queue
 };
 
 struct IntervalWithStop : public Interval
@@ -257,6 +259,201 @@ private:
 	edge_pointer m_edge;				//edge that owns this list
 };
 
+class IntervalQueue		//4-ary heap of intervals in the order of Interval::operator(), 
+{							//erased intervals are left in the heap and skipped when they reach the top
+public:
+	IntervalQueue():
+		m_size(0),
+		m_stamp(0),
+		m_stale(0)
+	{};
+
+	void clear()
+	{
+		m_heap.clear();			//keeps the capacity
+		m_size = 0;
+		m_stamp = 0;
+		m_stale = 0;
+	};
+
+	bool empty(){return m_size == 0;};
+	size_t size(){return m_size;};		//number of intervals in the queue
+
+	void insert(interval_pointer p)
+	{
+		if(p->queue_stamp())		//already there, the old entry becomes stale
+		{
+			--m_size;
+		}
+		p->queue_stamp() = ++m_stamp;
+		++m_size;
+
+		Entry e;
+		e.min = p->min();
+		e.start = p->start();
+		e.edge_id = p->edge()->id();
+		e.stamp = m_stamp;
+		e.interval = p;
+		m_heap.push_back(e);
+		sift_up(m_heap.size() - 1);
+	};
+
+	bool erase(interval_pointer p)		//returns false if p is not in the queue
+	{
+		if(!p->queue_stamp())
+		{
+			return false;
+		}
+		p->queue_stamp() = 0;
+		--m_size;
+
+		if(m_heap.size() > 2*m_size + 1024)		//mostly stale entries
+		{
+			compact();
+		}
+		return true;
+	};
+
+	interval_pointer top()
+	{
+		drop_stale();
+		return m_heap[0].interval;
+	};
+
+	interval_pointer pop()
+	{
+		drop_stale();
+		interval_pointer p = m_heap[0].interval;
+		p->queue_stamp() = 0;
+		--m_size;
+		remove_top();
+		return p;
+	};
+
+	unsigned number_of_insertions(){return m_stamp;};
+	size_t number_of_stale_entries(){return m_stale;};		//erased entries dropped so far
+	size_t memory(){return m_heap.capacity()*sizeof(Entry);};
+
+private:
+	struct Entry			//the key is copied so that the heap does not touch the intervals
+	{
+		double min;
+		double start;
+		unsigned edge_id;
+		unsigned stamp;
+		interval_pointer interval;
+	};
+
+	static bool less(Entry const& x, Entry const& y)		//same as Interval::operator()
+	{
+		if(x.min != y.min)
+		{
+			return x.min < y.min;
+		}
+		else if(x.start != y.start)
+		{
+			return x.start < y.start;
+		}
+		else
+		{
+			return x.edge_id < y.edge_id;
+		}
+	};
+
+	void sift_up(size_t i)
+	{
+		Entry e = m_heap[i];
+		while(i > 0)
+		{
+			size_t parent = (i - 1)/4;
+			if(!less(e, m_heap[parent]))
+			{
+				break;
+			}
+			m_heap[i] = m_heap[parent];
+			i = parent;
+		}
+		m_heap[i] = e;
+	};
+
+	void sift_down(size_t i)
+	{
+		size_t const n = m_heap.size();
+		Entry e = m_heap[i];
+		while(true)
+		{
+			size_t child = 4*i + 1;
+			if(child >= n)
+			{
+				break;
+			}
+			size_t best = child;
+			size_t const last = std::min(child + 4, n);
+			for(++child; child < last; ++child)
+			{
+				if(less(m_heap[child], m_heap[best]))
+				{
+					best = child;
+				}
+			}
+			if(!less(m_heap[best], e))
+			{
+				break;
+			}
+			m_heap[i] = m_heap[best];
+			i = best;
+		}
+		m_heap[i] = e;
+	};
+
+	void remove_top()
+	{
+		m_heap[0] = m_heap.back();
+		m_heap.pop_back();
+		if(!m_heap.empty())
+		{
+			sift_down(0);
+		}
+	};
+
+	bool is_stale(Entry const& e){return e.interval->queue_stamp() != e.stamp;};
+
+	void drop_stale()
+	{
+		while(is_stale(m_heap[0]))
+		{
+			remove_top();
+			++m_stale;
+		}
+	};
+
+	void compact()		//removes all the stale entries and heapifies the rest
+	{
+		size_t n = 0;
+		for(size_t i=0; i<m_heap.size(); ++i)
+		{
+			if(!is_stale(m_heap[i]))
+			{
+				m_heap[n++] = m_heap[i];
+			}
+		}
+		m_stale += m_heap.size() - n;
+		m_heap.resize(n);
+		for(size_t i=n/4 + 1; i-- > 0;)
+		{
+			if(i < n)
+			{
+				sift_down(i);
+			}
+		}
+	};
+
+	std::vector<Entry> m_heap;
+	size_t m_size;			//live entries
+	unsigned m_stamp;		//stamp of the last insertion
+	size_t m_stale;
+};
+
 class SurfacePointWithIndex : public SurfacePoint
 {
 public:
@@ -395,6 +592,7 @@ inline void Interval::initialize(edge_pointer edge,
 								 unsigned source_index)
 {
 	m_next = NULL;
+	m_queue_stamp = 0;
 	//m_geodesic_previous = NULL;	
 	m_direction = UNDEFINED_DIRECTION;
 	m_edge = edge;
@@ -0,0 +1,133 @@
+#ifndef GEODESIC_DISTANCE_MATRIX_H
+#define GEODESIC_DISTANCE_MATRIX_H
+
+//distances from many sources at once: one propagation per source, the sources are
+//distributed over a pool of algorithms, one per thread, sharing the same read-only mesh
+
+#include "geodesic_mesh.h"
+#include "geodesic_algorithm_dijkstra.h"
+#include "geodesic_algorithm_subdivision.h"
+#include "geodesic_algorithm_exact.h"
+#include <vector>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+namespace geodesic{
+
+inline GeodesicAlgorithmBase* new_geodesic_algorithm(Mesh* mesh,		//0 - exact, 1 - subdivision, 2 - dijkstra
+													 long type,
+													 long subdivision)
+{
+	if(subdivision == 0 && type == 1)//SUBDIVISION)
+	{
+		type = 2;		//DIJKSTRA;
+	}
+
+	switch(type)
+	{
+		case 2: //DIJKSTRA
+			return new GeodesicAlgorithmDijkstra(mesh);
+		case 1: //SUBDIVISION:
+			return new GeodesicAlgorithmSubdivision(mesh, subdivision);
+		case 0://EXACT:
+		default:
+			return new GeodesicAlgorithmExact(mesh);
+	}
+}
+
+class DistanceMatrix
+{
+public:
+	DistanceMatrix(Mesh* mesh,
+				   long type,				//as in new_geodesic_algorithm
+				   long subdivision = 0,
+				   unsigned num_threads = 0):	//0 - all the cores
+		m_mesh(mesh)
+	{
+#ifdef _OPENMP
+		if(num_threads == 0)
+		{
+			num_threads = omp_get_max_threads();
+		}
+#else
+		num_threads = 1;
+#endif
+		m_algorithms.resize(num_threads);
+		for(unsigned i=0; i<num_threads; ++i)
+		{
+			m_algorithms[i] = new_geodesic_algorithm(mesh, type, subdivision);
+		}
+	};
+
+	~DistanceMatrix()
+	{
+		for(unsigned i=0; i<m_algorithms.size(); ++i)
+		{
+			delete m_algorithms[i];
+		}
+	};
+
+	unsigned num_threads(){return m_algorithms.size();};
+
+	void compute(std::vector<SurfacePoint>& sources,		//distances[t + s*targets.size()] from sources[s] to targets[t],
+				 std::vector<SurfacePoint>& targets,		//GEODESIC_INF beyond max_distance
+				 double max_distance,
+				 double* distances)
+	{
+		long const num_sources = sources.size();
+		unsigned const num_targets = targets.size();
+
+		#pragma omp parallel for schedule(dynamic) num_threads(m_algorithms.size())
+		for(long s=0; s<num_sources; ++s)
+		{
+			GeodesicAlgorithmBase* algorithm = m_algorithms[thread_id()];
+			std::vector<SurfacePoint> source(1, sources[s]);
+			algorithm->propagate(source, max_distance);
+
+			double* column = distances + (size_t)s*num_targets;
+			for(unsigned t=0; t<num_targets; ++t)
+			{
+				algorithm->best_source(targets[t], column[t]);
+				if(column[t] > max_distance)
+				{
+					column[t] = GEODESIC_INF;
+				}
+			}
+		}
+	};
+
+	void compute_vertices(std::vector<SurfacePoint>& sources,		//rows[s]: the vertices within max_distance of sources[s]
+						  double max_distance,						//and their distances
+						  std::vector<std::vector<std::pair<unsigned, double> > >& rows)
+	{
+		long const num_sources = sources.size();
+		rows.resize(num_sources);
+
+		#pragma omp parallel for schedule(dynamic) num_threads(m_algorithms.size())
+		for(long s=0; s<num_sources; ++s)
+		{
+			GeodesicAlgorithmBase* algorithm = m_algorithms[thread_id()];
+			std::vector<SurfacePoint> source(1, sources[s]);
+			algorithm->propagate(source, max_distance);
+			algorithm->reached_vertices(max_distance, rows[s]);
+		}
+	};
+
+private:
+	static unsigned thread_id()
+	{
+#ifdef _OPENMP
+		return omp_get_thread_num();
+#else
+		return 0;
+#endif
+	}
+
+	Mesh* m_mesh;
+	std::vector<GeodesicAlgorithmBase*> m_algorithms;		//one per thread
+};
+
+}//geodesic
+
+#endif //GEODESIC_DISTANCE_MATRIX_H
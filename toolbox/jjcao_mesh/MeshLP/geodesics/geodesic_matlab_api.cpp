@@ -5,16 +5,19 @@
 #include <iostream>
 #include <fstream>
 #include <string>
+#include <map>
 
 #include "geodesic_mesh.h"
 #include "geodesic_algorithm_dijkstra_alternative.h"
 #include "geodesic_algorithm_dijkstra.h"
 #include "geodesic_algorithm_subdivision.h"
 #include "geodesic_algorithm_exact.h"
+#include "geodesic_distance_matrix.h"
 #include "geodesic_matlab_api.h"
 
 typedef boost::shared_ptr<geodesic::Mesh> mesh_shared_pointer;
 std::vector<mesh_shared_pointer> meshes;
+std::map<geodesic::Mesh*, std::size_t> mesh_ids;		//index of every mesh in meshes
 
 typedef boost::shared_ptr<geodesic::GeodesicAlgorithmBase> algorithm_shared_pointer;
 std::vector<algorithm_shared_pointer> algorithms;
@@ -25,12 +28,22 @@ geodesic::OutputBuffer output_buffer, output_buffer1;
 
 std::size_t find_mesh_id(geodesic::Mesh* mesh)
 {
-	for(std::size_t i=0; i<meshes.size(); ++i)
+	std::map<geodesic::Mesh*, std::size_t>::iterator it = mesh_ids.find(mesh);
+	assert(it != mesh_ids.end());
+	return it->second;
+}
+
+void fill_surface_points(std::vector<geodesic::SurfacePoint>& points,
+						 double* data,
+						 long num_points,
+						 geodesic::Mesh* mesh)
+{
+	points.resize(num_points);
+	for(long i=0; i<num_points; ++i)
 	{
-		if(meshes[i].get() == mesh)
-		{
-			return i;
-		}
+		geodesic::fill_surface_point_structure(&points[i], 
+												data + 5*i, 
+												mesh);
 	}
 }
 
@@ -110,23 +123,13 @@ GEODESIC_DLL_IMPORT void propagate(long algorithm_id,
 									long num_stop_points,
 									double max_propagation_distance)
 {
-	std::vector<geodesic::SurfacePoint> sources(num_sources);
-
 	geodesic::Mesh* mesh = algorithms[algorithm_id]->mesh();
-	for(std::size_t i=0; i<num_sources; ++i)
-	{
-		geodesic::fill_surface_point_structure(&sources[i], 
-												source_points + 5*i, 
-												mesh);
-	}
 
-	std::vector<geodesic::SurfacePoint> stop(num_stop_points);
-	for(std::size_t i=0; i<num_stop_points; ++i)
-	{
-		geodesic::fill_surface_point_structure(&stop[i], 
-												stop_points + 5*i, 
-												mesh);
-	}
+	std::vector<geodesic::SurfacePoint> sources;
+	fill_surface_points(sources, source_points, num_sources, mesh);
+
+	std::vector<geodesic::SurfacePoint> stop;
+	fill_surface_points(stop, stop_points, num_stop_points, mesh);
 
 	algorithms[algorithm_id]->propagate(sources, 
 										max_propagation_distance,
@@ -143,6 +146,7 @@ GEODESIC_DLL_IMPORT long new_mesh(long num_points,
 {
 	mesh_shared_pointer new_mesh = mesh_shared_pointer(new geodesic::Mesh);
 	meshes.push_back(new_mesh);
+	mesh_ids[new_mesh.get()] = meshes.size() - 1;
 
 	new_mesh->initialize_mesh_data(num_points,
 								   points,	
@@ -174,32 +178,8 @@ GEODESIC_DLL_IMPORT long new_algorithm(long mesh_id,
 						               long type,
 									   long subdivision)
 {
-	if(subdivision == 0 && type == 1)//SUBDIVISION)
-	{
-		type = 2;		//DIJKSTRA;
-	}
-
 	geodesic::Mesh* mesh = meshes[mesh_id].get();
-	geodesic::GeodesicAlgorithmBase* algorithm;
-	switch(type)
-	{
-		case 2: //DIJKSTRA
-		{
-			algorithm = new geodesic::GeodesicAlgorithmDijkstra(mesh);
-			break;
-		}
-		case 1: //SUBDIVISION:
-		{
-			algorithm = new geodesic::GeodesicAlgorithmSubdivision(mesh, subdivision);
-			break;
-		}
-		case 0://EXACT:
-		default:
-		{
-			algorithm = new geodesic::GeodesicAlgorithmExact(mesh);
-			break;
-		}
-	}
+	geodesic::GeodesicAlgorithmBase* algorithm = geodesic::new_geodesic_algorithm(mesh, type, subdivision);
 
 	algorithms.push_back(algorithm_shared_pointer(algorithm));
 
@@ -220,9 +200,89 @@ GEODESIC_DLL_IMPORT void delete_mesh(long id)		//delete mesh and all related alg
 		}
 	}
 
+	mesh_ids.erase(mesh);
 	meshes[id] = mesh_shared_pointer();
 }
 
+GEODESIC_DLL_IMPORT long distance_matrix(long mesh_id,
+										  long type,
+										  long subdivision,
+										  double* source_points,
+										  long num_sources,
+										  double* target_points,
+										  long num_targets,
+										  double max_propagation_distance,
+										  long num_threads,
+										  double** distances)
+{
+	geodesic::Mesh* mesh = meshes[mesh_id].get();
+
+	std::vector<geodesic::SurfacePoint> sources;
+	fill_surface_points(sources, source_points, num_sources, mesh);
+
+	std::vector<geodesic::SurfacePoint> targets;
+	if(target_points)
+	{
+		fill_surface_points(targets, target_points, num_targets, mesh);
+	}
+	else
+	{
+		for(std::size_t i=0; i<mesh->vertices().size(); ++i)
+		{
+			targets.push_back(geodesic::SurfacePoint(&mesh->vertices()[i]));
+		}
+	}
+
+	output_buffer.allocate<double>(targets.size()*sources.size());
+	*distances = output_buffer.get<double>();
+
+	geodesic::DistanceMatrix matrix(mesh, type, subdivision, num_threads);
+	matrix.compute(sources, targets, max_propagation_distance, *distances);
+
+	return targets.size();
+}
+
+GEODESIC_DLL_IMPORT long distance_matrix_sparse(long mesh_id,
+												long type,
+												long subdivision,
+												double* source_points,
+												long num_sources,
+												double max_propagation_distance,
+												long num_threads,
+												double** entries)
+{
+	geodesic::Mesh* mesh = meshes[mesh_id].get();
+
+	std::vector<geodesic::SurfacePoint> sources;
+	fill_surface_points(sources, source_points, num_sources, mesh);
+
+	std::vector<std::vector<std::pair<unsigned, double> > > rows;
+	geodesic::DistanceMatrix matrix(mesh, type, subdivision, num_threads);
+	matrix.compute_vertices(sources, max_propagation_distance, rows);
+
+	std::size_t num_entries = 0;
+	for(std::size_t i=0; i<rows.size(); ++i)
+	{
+		num_entries += rows[i].size();
+	}
+
+	output_buffer.allocate<double>(num_entries*3);
+	double* buffer = output_buffer.get<double>();
+	for(std::size_t i=0; i<rows.size(); ++i)
+	{
+		for(std::size_t j=0; j<rows[i].size(); ++j)
+		{
+			buffer[0] = rows[i][j].first;
+			buffer[1] = i;
+			buffer[2] = rows[i][j].second;
+			buffer += 3;
+		}
+	}
+
+	*entries = output_buffer.get<double>();
+	return num_entries;
+}
+
 GEODESIC_DLL_IMPORT void delete_algorithm(long id)
 {
 	if(id < algorithms.size())
@@ -43,6 +43,26 @@ GEODESIC_DLL_IMPORT long distance_and_source_for_all_vertices(long algorithm_id,
 															  double** distances,	//list distance/source info for all vertices of the mesh
 															  long** sources);
 
+GEODESIC_DLL_IMPORT long distance_matrix(long mesh_id,		//propagations from many sources at once, on num_threads cores (0 - all)
+										  long type,			//algorithm type and subdivision as in new_algorithm
+										  long subdivision,
+										  double* source_points,
+										  long num_sources,
+										  double* target_points,	//NULL - all the vertices of the mesh
+										  long num_targets,
+										  double max_propagation_distance,
+										  long num_threads,
+										  double** distances);		//num_targets x num_sources, column by column; returns num_targets
+
+GEODESIC_DLL_IMPORT long distance_matrix_sparse(long mesh_id,	//same, only the vertices within max_propagation_distance
+												long type,
+												long subdivision,
+												double* source_points,
+												long num_sources,
+												double max_propagation_distance,
+												long num_threads,
+												double** entries);	//(vertex, source, distance) triplets; returns their number
+
 #ifdef __cplusplus
 }
 #endif
@@ -78,10 +78,11 @@ public:
 
 	~MemoryAllocator(){};
 
-	void clear()
+	void clear()			//deallocates everything, the blocks are kept for the next round
 	{
-		reset(m_block_size, 
-			  m_max_number_of_blocks);
+		m_current_block = 0;
+		m_current_position = 0;
+		m_deleted.clear();
 	}
 
 	void reset(unsigned block_size, 
@@ -93,6 +94,7 @@ public:
 		assert(m_block_size > 0);
 		assert(m_max_number_of_blocks > 0);
 
+		m_current_block = 0;
 		m_current_position = 0;
 
 		m_storage.reserve(max_number_of_blocks);
@@ -110,11 +112,14 @@ public:
 		{
 			if(m_current_position + 1 >= m_block_size)
 			{
-				m_storage.push_back( std::vector<T>() );
-				m_storage.back().resize(m_block_size);
+				if(++m_current_block == m_storage.size())
+				{
+					m_storage.push_back( std::vector<T>() );
+					m_storage.back().resize(m_block_size);
+				}
 				m_current_position = 0;
 			}
-			result = & m_storage.back()[m_current_position];
+			result = & m_storage[m_current_block][m_current_position];
 			++m_current_position;
 		}
 		else
@@ -134,10 +139,23 @@ public:
 		}
 	};
 
+	size_t number_of_units()		//units handed out since the last clear, including the deallocated ones
+	{
+		return (size_t)m_current_block*(m_block_size - 1) + m_current_position;
+	}
+
+	size_t memory()					//bytes held by the blocks and the list of deleted units
+	{
+		return m_storage.size()*m_block_size*sizeof(T) + m_deleted.capacity()*sizeof(pointer);
+	}
+
+	size_t number_of_blocks(){return m_storage.size();};
+
 private:
 	std::vector<std::vector<T> > m_storage;
 	unsigned m_block_size;				//size of a single block
 	unsigned m_max_number_of_blocks;		//maximum allowed number of blocks
+	unsigned m_current_block;			//block in use, the following ones are recycled
 	unsigned m_current_position;			//first unused element inside the current block
 
 	std::vector<pointer> m_deleted;			//pointers to deleted elemets
@@ -3,10 +3,16 @@
 
 #include <vector>
 using namespace std;
+class CscBuilder;
 bool generate_sym_meshlp_matrix_matlab(char* filename, unsigned int htype, double hs, double rho, double &h, vector<unsigned int>& IIV, vector<unsigned int>& JJV, vector<double>& SSV, vector<double>& AAV);
 
 bool generate_sym_meshlp_matrix_geod_matlab(char* filename, unsigned int htype, double hs, double rho, double &h, vector<unsigned int>& IIV, vector<unsigned int>& JJV, vector<double>& SSV, vector<double>& AAV);
 
+//W built directly in CSC (see sparse_csc_builder.h), the geodesic one as its upper triangle only
+bool generate_sym_meshlp_matrix_matlab(char* filename, unsigned int htype, double hs, double rho, double &h, CscBuilder& W, vector<double>& AAV);
+
+bool generate_sym_meshlp_matrix_geod_matlab(char* filename, unsigned int htype, double hs, double rho, double &h, CscBuilder& W, vector<double>& AAV);
+
 //bool generate_sym_meshlp_matrix_geod_matlab_fastmarching(char* filename, unsigned int htype, double hs, double rho, vector<unsigned int>& IIV, vector<unsigned int>& JJV, vector<double>& SSV, vector<double>& AAV);
 
 bool generate_meshlp_matrix_matlab(char* filename, unsigned int htype, double hs, double rho, vector<unsigned int>& IIV, vector<unsigned int>& JJV, vector<double>& SSV);
@@ -0,0 +1,51 @@
+#ifndef __MESHTOPO_H__
+#define __MESHTOPO_H__
+
+#include <vector>
+#include <utility>
+
+using namespace std;
+
+//-------------------------------------------------------------------
+//MeshTopo: adjacency of a polygon mesh in flat (CSR) arrays
+//-------------------
+//Built in O(F): the directed edges of all the facets are bucketed by
+//their smaller vertex and sorted by the other one, so the facets
+//sharing an edge end up next to each other. No per vertex search.
+//
+//  incident facets of v:   vf_adj[vf_start[v]] .. vf_adj[vf_start[v+1]-1], increasing
+//  neighbours of v:        vv_adj[vv_start[v]] .. vv_adj[vv_start[v+1]-1], in the
+//                          order of the edges of its incident facets
+//  neighbour of facet f across its edge fverts[h] -- fverts[next(h)],
+//  h = fstart[f] + j:      ff_adj[h], -1 if none
+//
+//An edge shared by more than two facets is non-manifold: the facets are
+//paired in increasing order, the extra ones stay without a neighbour
+//across it, and the edge is listed in nonmanifold_edges.
+class MeshTopo{
+public:
+  //facet f is fverts[fstart[f]] .. fverts[fstart[f+1]-1]
+  void build(unsigned int nverts, const vector<unsigned int>& fstart, const vector<unsigned int>& fverts);
+  //triangles: facet f is tris[3f], tris[3f+1], tris[3f+2]
+  void build(unsigned int nverts, const vector<unsigned int>& tris);
+
+  unsigned int n_verts() const { return vf_start.empty() ? 0 : vf_start.size() - 1; }
+  unsigned int n_facets() const { return fstart.empty() ? 0 : fstart.size() - 1; }
+
+  void clear();
+
+  vector<unsigned int> fstart, fverts;
+  vector<unsigned int> vf_start, vf_adj;
+  vector<unsigned int> vv_start, vv_adj;
+  vector<int> ff_adj;
+  vector<pair<unsigned int, unsigned int> > nonmanifold_edges;
+
+private:
+  unsigned int next(unsigned int h, unsigned int f) const { return h + 1 < fstart[f + 1] ? h + 1 : fstart[f]; }
+  unsigned int prev(unsigned int h, unsigned int f) const { return h > fstart[f] ? h - 1 : fstart[f + 1] - 1; }
+  void build_vertex_topo(unsigned int nverts);
+  void build_facet_topo(unsigned int nverts);
+};
+//-------------------------------------------------------------------
+
+#endif //__MESHTOPO_H__
@@ -15,7 +15,16 @@ function [W A h] = symmshlp_matrix(filename, opt)
 %  opt.dtype: the way to compute the distance 
 %             dtype = 'euclidean' or 'geodesic';
 %             Default : 'euclidean'
-
+%  opt.storage: 'full' or 'upper' (only triu(W), W = U + triu(U,1)').
+%             Default : 'full'
+%  opt.file:  if given, W is written to this file (see read_csc_matrix) and
+%             the number of nonzeros is returned instead of W.
+%  opt.precision: 'double' or 'single', the values of opt.file.
+%             Default : 'double'
+%
+%  W is built column by column directly as a sparse matrix (see
+%  sparse_csc_builder.h); with geodesic distances only its upper triangle
+%  is built, the full W is mirrored here.
 %
 % OUTPUTS
 %  W: symmetric weight matrix 
@@ -38,9 +47,14 @@ if opt.hs <= 0 | opt.rho <= 0
 end
 
 
-[II JJ SS AA h] = symmshlpmatrix(filename, opt);
-W=sparse(II, JJ, SS);
-A=AA;
+mirror = strcmp(opt.dtype, 'geodesic') && strcmp(opt.storage, 'full');
+if mirror
+	opt.storage = 'upper';
+end
+[W A h] = symmshlpmatrix(filename, opt);
+if mirror && ~isfield(opt, 'file')
+	W = W + triu(W,1)';
+end
 
 % Parsing Option.
 function option = parse_opt(opt)
@@ -61,3 +75,7 @@ if ~isfield(option,'dtype'),
 	option = setfield(option,'dtype', 'euclidean');
 end
 
+if ~isfield(option,'storage'),
+	option = setfield(option,'storage', 'full');
+end
+
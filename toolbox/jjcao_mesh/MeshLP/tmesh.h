@@ -2,6 +2,7 @@
 #define __TMESH_H__
 
 #include "datastructure.h"
+#include "meshtopo.h"
 
 //-------------------------------------------------------------------
 //VTMesh: vertex class for triangle mesh
@@ -63,6 +64,9 @@ public:
       }
     }//for i
   }                                                  
+  //replace the incident facets/vertices by a range of the flat topology
+  void set_facets(const unsigned int* begin, const unsigned int* end){ _facets.assign(begin, end); }
+  void set_verts(const unsigned int* begin, const unsigned int* end){ _verts.assign(begin, end); }
   unsigned int add_unique_facet(unsigned int fid){
     for(unsigned int i = 0; i < _facets.size(); i ++)
       if(fid == _facets[i])  return i;;
@@ -156,14 +160,18 @@ public:
   VECTOR3 pmin(){ return _pmin; }
   VECTOR3 pmax(){ return _pmax; }
 
+  //flat adjacency built by GenerateMeshTopo
+  const MeshTopo& topo() const { return _topo; }
+
   
   //Clear
-  void clear(){ _vertices.clear();  _facets.clear(); }
+  void clear(){ _vertices.clear();  _facets.clear(); _topo.clear(); }
             
 private:
   char _name[256];
   vector<VTMesh> _vertices;
   vector<FTMesh> _facets;
+  MeshTopo _topo;
   VECTOR3 _pmin;
   VECTOR3 _pmax;
 };
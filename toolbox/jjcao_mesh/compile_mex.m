@@ -7,8 +7,15 @@ mex adjacency_matrix.cpp
 mex minimaAndMaxima.cpp
 
 % mex -g -largeArrayDims -I"../../include/eigen-3.1.3" vertex_area.cpp % for debuging
-mex -largeArrayDims -I"../../include/eigen-3.1.3" vertex_area.cpp
-mex -largeArrayDims -I"../../include/eigen-3.1.3" perform_mesh_weight.cpp
+% the weights of mesh_weight_kernel.h run on all cores when compiled with OpenMP
+if ispc
+    omp = {'COMPFLAGS="$COMPFLAGS /openmp"'};
+else
+    omp = {'CXXFLAGS="$CXXFLAGS -fopenmp"', 'LDFLAGS="$LDFLAGS -fopenmp"'};
+end
+mex('-largeArrayDims', omp{:}, '-I../../include/eigen-3.1.3', 'vertex_area.cpp');
+mex('-largeArrayDims', omp{:}, 'perform_mesh_weight.cpp');
+mex('-largeArrayDims', omp{:}, 'cotangentLaplacianMatrix.cpp');
 mex -largeArrayDims -I"../../include/eigen-3.1.3" 3d-transformation/create_rotation3d_line_angle.cpp
 if exist('create_rotation3d_line_angle.mexw64', 'file'); movefile('create_rotation3d_line_angle.mexw64', '3d-transformation/'); end
 
@@ -22,8 +29,12 @@ mex -largeArrayDims geodesic/mex/perform_dijkstra_propagation.cpp geodesic/mex/f
 if exist('perform_dijkstra_propagation.mexw32', 'file'); movefile('perform_dijkstra_propagation.mexw32', 'geodesic/'); end
 if exist('perform_dijkstra_propagation.mexw64', 'file'); movefile('perform_dijkstra_propagation.mexw64', 'geodesic/'); end
 
-% geodesic 2: 
-mex "-largeArrayDims" geodesic/mex/dijkstra.cpp 
+% geodesic 2: many sources at once, distributed over all cores with OpenMP
+if ispc
+    mex -largeArrayDims COMPFLAGS="$COMPFLAGS /openmp" geodesic/mex/dijkstra.cpp
+else
+    mex -largeArrayDims CXXFLAGS="$CXXFLAGS -fopenmp" LDFLAGS="$LDFLAGS -fopenmp" geodesic/mex/dijkstra.cpp
+end
 % eval(['!rename', dijkstra.mexw32 name2]);
 if exist('dijkstra.mexw32', 'file'); movefile('dijkstra.mexw32', 'geodesic/perform_dijkstra_fast.mexw32'); end
 if exist('dijkstra.mexw64', 'file'); movefile('dijkstra.mexw64', 'geodesic/perform_dijkstra_fast.mexw64'); end
@@ -31,8 +42,8 @@ if exist('dijkstra.mexglx', 'file'); movefile('dijkstra.mexglx', 'geodesic/perfo
 if exist('dijkstra.mexmaci', 'file'); movefile('dijkstra.mexmaci', 'geodesic/perform_dijkstra_fast.mexmaci'); end
 
 %% geodesic 3:
-mex "-largeArrayDims" geodesic/mex/perform_front_propagation_2d.cpp geodesic/mex/perform_front_propagation_2d_mex.cpp geodesic/mex/fheap/fib.cpp 
-mex "-largeArrayDims" geodesic/mex/perform_front_propagation_3d.cpp geodesic/mex/perform_front_propagation_3d_mex.cpp geodesic/mex/fheap/fib.cpp 
+mex "-largeArrayDims" geodesic/mex/perform_front_propagation_2d.cpp geodesic/mex/perform_front_propagation_2d_mex.cpp
+mex "-largeArrayDims" geodesic/mex/perform_front_propagation_3d.cpp geodesic/mex/perform_front_propagation_3d_mex.cpp
 if exist('perform_front_propagation_2d.mexw32', 'file');  movefile('perform_front_propagation_2d.mexw32', 'geodesic/');end;
 if exist('perform_front_propagation_2d.mexw64', 'file');  movefile('perform_front_propagation_2d.mexw64', 'geodesic/');end;
 if exist('perform_front_propagation_3d.mexw32', 'file');  movefile('perform_front_propagation_3d.mexw32', 'geodesic/');end;
@@ -51,6 +62,7 @@ files =  { ...
     'gw/gw_core/GW_Vertex.cpp',           ...
     'gw/gw_geodesic/GW_GeodesicFace.cpp', ...                                              
     'gw/gw_geodesic/GW_GeodesicMesh.cpp',     ...                                 
+    'gw/gw_geodesic/GW_GeodesicMarcher.cpp',  ...
     'gw/gw_geodesic/GW_GeodesicPath.cpp',         ...                       
     'gw/gw_geodesic/GW_GeodesicPoint.cpp',            ...           
     'gw/gw_geodesic/GW_TriangularInterpolation_Cubic.cpp', ...      
@@ -66,33 +78,30 @@ eval(str);
 if exist('perform_front_propagation_mesh.mexw32', 'file'); movefile('perform_front_propagation_mesh.mexw32', 'geodesic/');end
 if exist('perform_front_propagation_mesh.mexw64', 'file'); movefile('perform_front_propagation_mesh.mexw64', 'geodesic/');end
 
-%% geodesic 4: a newer version than geodesic 3 from the same author's svn. 
-% But I've not time to test it.
-basep = 'geodesic/mex/';
-disp('Compiling EikonalSolverMesh, might time some time.');
-files =  { ...
-    'AnisoEikonalSolverMesh.cpp', ...
-    'gw/gw_core/GW_Config.cpp',           ...
-    'gw/gw_core/GW_FaceIterator.cpp',     ...
-    'gw/gw_core/GW_SmartCounter.cpp',     ...
-    'gw/gw_core/GW_VertexIterator.cpp',   ...
-    'gw/gw_core/GW_Face.cpp',             ...
-    'gw/gw_core/GW_Mesh.cpp',             ...
-    'gw/gw_core/GW_Vertex.cpp',           ...
-    'gw/gw_geodesic/GW_GeodesicFace.cpp', ...                                              
-    'gw/gw_geodesic/GW_GeodesicMesh.cpp',     ...                                 
-    'gw/gw_geodesic/GW_GeodesicPath.cpp',         ...                       
-    'gw/gw_geodesic/GW_GeodesicPoint.cpp',            ...           
-    'gw/gw_geodesic/GW_TriangularInterpolation_Cubic.cpp', ...      
-    'gw/gw_geodesic/GW_GeodesicVertex.cpp',                    ...  
-    'gw/gw_geodesic/GW_TriangularInterpolation_Linear.cpp',      ...
-    'gw/gw_geodesic/GW_TriangularInterpolation_Quadratic.cpp',  ...
-};
-str = 'mex '; % -v
+% same propagation on a mesh built once, the batches run on all cores when compiled with OpenMP
+disp('Compiling fast_marching_mesh, might time some time.');
+files{1} = 'fast_marching_mesh.cpp';
+if ispc
+    str = 'mex COMPFLAGS="$COMPFLAGS /openmp" ';
+else
+    str = 'mex CXXFLAGS="$CXXFLAGS -fopenmp" LDFLAGS="$LDFLAGS -fopenmp" ';
+end
 for i=1:length(files)
     str = [str basep files{i} ' '];
 end
 eval(str);
+if exist('fast_marching_mesh.mexw32', 'file'); movefile('fast_marching_mesh.mexw32', 'geodesic/');end
+if exist('fast_marching_mesh.mexw64', 'file'); movefile('fast_marching_mesh.mexw64', 'geodesic/');end
+
+% heat method: the factorizations of a mesh are kept between calls, the batches run on all cores with OpenMP
+mex('-largeArrayDims', omp{:}, '-I../../include/eigen-3.1.3', [basep 'heat_geodesic.cpp']);
+if exist('heat_geodesic.mexw32', 'file'); movefile('heat_geodesic.mexw32', 'geodesic/');end
+if exist('heat_geodesic.mexw64', 'file'); movefile('heat_geodesic.mexw64', 'geodesic/');end
+
+%% geodesic 4: anisotropic eikonal solver, the Fast Iterative Method of
+% aniso_eikonal_fim.h, its sweeps run on all cores when compiled with OpenMP
+basep = 'geodesic/mex/';
+mex('-largeArrayDims', omp{:}, [basep 'AnisoEikonalSolverMesh.cpp']);
 if exist('AnisoEikonalSolverMesh.mexw32', 'file'); movefile('AnisoEikonalSolverMesh.mexw32', 'geodesic/');end
 if exist('AnisoEikonalSolverMesh.mexw64', 'file'); movefile('AnisoEikonalSolverMesh.mexw64', 'geodesic/');end
 
@@ -126,15 +135,6 @@ if exist('ComputeMeshConnectivity.mexw32', 'file'); movefile('ComputeMeshConnect
 if exist('ComputeMeshConnectivity.mexw64', 'file'); movefile('ComputeMeshConnectivity.mexw64', 'geodesic/');end
 
 % Code on mesh grid with matlab connectivity
-basep = 'geodesic/mex/';
-disp('Compiling AnisoEikonalSolverMatlabMesh, might take no time :-P.');
-files =  { ...
-    'AnisoEikonalSolverMatlabMesh.cpp'
-};
-str = 'mex '; % -v
-for i=1:length(files)
-    str = [str basep files{i} ' '];
-end
-eval(str);
+mex('-largeArrayDims', omp{:}, [basep 'AnisoEikonalSolverMatlabMesh.cpp']);
 if exist('AnisoEikonalSolverMatlabMesh.mexw32', 'file'); movefile('AnisoEikonalSolverMatlabMesh.mexw32', 'geodesic/');end
 if exist('AnisoEikonalSolverMatlabMesh.mexw64', 'file'); movefile('AnisoEikonalSolverMatlabMesh.mexw64', 'geodesic/');end
\ No newline at end of file
@@ -61,7 +61,7 @@ switch lower(type)
         W = my_euclidean_distance_2(triangulation2adjacency(faces),vertices);
         W(W>0) = 1./W(W>0);
     case 'spring'
-        W = sqrt(my_euclidean_distance(triangulation2adjacency(faces),vertices));
+        W = my_euclidean_distance(triangulation2adjacency(faces),vertices);
         W(W>0) = 1./W(W>0);
     otherwise       
         if isfield(options, 'rings')
@@ -9,11 +9,20 @@
 	D = sparse(1:length(diagValue),1:length(diagValue),diagValue);
 	L = D - W;
  *
+ * or W directly, built column by column without the triplets (the dcp weight
+ * of perform_mesh_weight, see mesh_weight_kernel.h):
+   W = cotangentLaplacianMatrix(V,F);
+   W = cotangentLaplacianMatrix(V,F,options);
+ *	options.storage = 'upper': only triu(W) is returned, W = U + triu(U,1)';
+ *	options.file = filename: W is written to the file, see read_csc_matrix.m,
+ *		and the number of nonzeros is returned;
+ *	options.precision = 'single': the values of the file are float32.
  *
  * =================================================================*/
 
 #include <mex.h>
 #include <math.h>
+#include "mesh_weight_kernel.h"
 
 double cotangent(double P[], double Q[], double R[])
 {
@@ -41,6 +50,11 @@ void mexFunction( int nlhs, mxArray *plhs[], int nrhs, const mxArray*prhs[])
     double *V,*F,*Ir,*Jr,*Vr;
     double v1[3], v2[3], v3[3];
     
+    if(nrhs < 2 || nrhs > 3)
+        mexErrMsgTxt("2 or 3 input arguments are required.");
+    if(nlhs != 1 && nlhs != 3)
+        mexErrMsgTxt("1 or 3 output arguments are required.");
+    
     rowv = mxGetM(prhs[0]);
     rowf = mxGetM(prhs[1]);
     colf = mxGetN(prhs[1]);
@@ -50,6 +64,29 @@ void mexFunction( int nlhs, mxArray *plhs[], int nrhs, const mxArray*prhs[])
     V = mxGetPr(prhs[0]);
     F = mxGetPr(prhs[1]);
     
+    if(nlhs == 1)
+    {
+        std::vector<mwIndex> tri(3 * rowf);
+        for(i = 0;i < rowf;i++)
+        {
+            for(k = 0;k < 3;k++)
+            {
+                double v = F[k * rowf + i];
+                if(v < 1 || v > rowv)
+                    mexErrMsgTxt("Face index out of bound.");
+                tri[3*i + k] = (mwIndex)v - 1;
+            }
+        }
+        CscBuilder W;
+        if(nrhs == 3)
+            W.parse_options(prhs[2]);
+        MeshWeightKernel kernel(tri, rowv);
+        kernel.set_vertices(V, false);
+        kernel.compute(MeshWeightKernel::DCP, NULL, W);
+        plhs[0] = W.finish();
+        return;
+    }
+    
     plhs[0] = mxCreateDoubleMatrix(3 * rowf,1,mxREAL);
     plhs[1] = mxCreateDoubleMatrix(3 * rowf,1,mxREAL);
     plhs[2] = mxCreateDoubleMatrix(3 * rowf,1,mxREAL);
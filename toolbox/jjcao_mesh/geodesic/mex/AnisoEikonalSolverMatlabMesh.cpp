@@ -2,77 +2,178 @@
 //================================================================
 // File: AnisoEikonalSolverMatlabMesh.cpp
 // (C) 02/2010 by Fethallah Benmansour
+// and Thomas Satzger 2010 - TU München
 //================================================================
 //================================================================
+// [U,V] = AnisoEikonalSolverMatlabMesh(vertex, connectivity, T, start_points,
+//                                      doUpdate [,U,V])
+// connectivity is the output of ComputeMeshConnectivity. The distance is
+// computed by the Fast Iterative Method of aniso_eikonal_fim.h (on all cores
+// when compiled with OpenMP), then the Voronoi indices are transported along
+// increasing distances.
 
-#include "AnisoEikonalSolverMatlabMesh.h"
+#include "mex.h"
+#include "aniso_eikonal_fim.h"
+#include "grid_heap.h"
+
+//================================================================
+int searchMinNeighbor(const AnisoEikonalMesh& mesh, const double* U, const short* Vor, int pos)
+//================================================================
+{
+    double tmin = kAnisoInfinite;
+    int minIndex = -1;
+    //loop over all neighbors of point pos
+    for (int k = mesh.ring_begin(pos); k < mesh.ring_end(pos); k++) {
+        int neighborIndex = mesh.neighbor(k);
+        // if the neighbor has a valid colour
+        if (Vor[neighborIndex] >= 0 && U[neighborIndex] < tmin) {
+            tmin = U[neighborIndex];
+            minIndex = neighborIndex;
+        }
+    }
+    return minIndex;
+}
+
+//================================================================
+void setVoronoi(const AnisoEikonalMesh& mesh, const AnisoEikonalSolver& solver,
+        const double* U, short* Vor, int pos, bool clearConflicts)
+//================================================================
+{
+    double u;
+    short VoronoiTmp;
+    solver.update(pos, u, VoronoiTmp);
+    // the characteristic direction gives no valid colour:
+    // take the one of the nearest neighbour
+    if (VoronoiTmp < 0) {
+        int minNeighbor = searchMinNeighbor(mesh, U, Vor, pos);
+        Vor[pos] = minNeighbor >= 0 ? Vor[minNeighbor] : -1;
+    } else {
+        Vor[pos] = VoronoiTmp;
+    }
+    if (!clearConflicts)
+        return;
+    // neighbours with different valid colours: all of them are unknown
+    int firstColour = -1;
+    bool setNeighborFalse = false;
+    for (int k = mesh.ring_begin(pos); k < mesh.ring_end(pos); k++) {
+        int neighborIndex = mesh.neighbor(k);
+        if (Vor[neighborIndex] >= 0) {
+            if (firstColour < 0) {
+                firstColour = Vor[neighborIndex];
+            } else if (firstColour != Vor[neighborIndex]) {
+                setNeighborFalse = true;
+                break;
+            }
+        }
+    }
+    if (setNeighborFalse) {
+        Vor[pos] = -1;
+        for (int k = mesh.ring_begin(pos); k < mesh.ring_end(pos); k++)
+            Vor[mesh.neighbor(k)] = -1;
+    }
+}
+
+//================================================================
+void transportVoronoi(const AnisoEikonalMesh& mesh, const AnisoEikonalSolver& solver,
+        const double* U, short* Vor, const double* start_points, int nstart)
+//================================================================
+{
+    int nverts = mesh.nverts();
+    std::vector<int> heapIndex(nverts, -1);
+    GridHeap heap(&heapIndex[0]);
+    heap.reserve(nverts);
+    // delete voronoi information, but for the start points
+    for (int k = 0; k < nverts; k++)
+        Vor[k] = -1;
+    for (int k = 0; k < nstart; k++)
+        Vor[(int) start_points[k]] = k;
+    // first pass along increasing distances
+    for (int k = 0; k < nverts; k++)
+        if (Vor[k] < 0)
+            heap.push(k, U[k]);
+    while (!heap.empty())
+        setVoronoi(mesh, solver, U, Vor, heap.pop(), true);
+    // second pass on the points left unknown
+    for (int k = 0; k < nverts; k++)
+        if (Vor[k] < 0)
+            heap.push(k, U[k]);
+    while (!heap.empty())
+        setVoronoi(mesh, solver, U, Vor, heap.pop(), false);
+}
 
 void mexFunction(int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[]) {
-    {
-        //==================================================================
-        /* retrive arguments */
-        if (nrhs != 5 && nrhs != 7)
-            mexErrMsgTxt("5 or 7 input arguments are required.");
-        if (nlhs != 0 && nlhs != 2)
-            mexErrMsgTxt("0 or 2 output arguments are required.");
-        //==================================================================
-        // arg1 : vertex
-        vertex = mxGetPr(prhs[0]);
-        nverts = mxGetN(prhs[0]);
-        if (mxGetM(prhs[0]) != 3)
-            mexErrMsgTxt("vertex must be of size 3 x nverts.");
-        //==================================================================
-        // arg2 : connectivity
-        if ((int) mxGetN(prhs[1]) != nverts)
-            mexErrMsgTxt("connectivity must have the same size as vertex.");
-        Connectivity = (mxArray*) prhs[1];
-        nb_neigh_field = mxGetFieldNumber(Connectivity, "nb_neighbors");
-        neigh_idx_field = mxGetFieldNumber(Connectivity, "neighbours_idx");
-        //==================================================================
-        // arg3 : Metric (should be symmetric definite positive on the tangent plan)
-        // order of the 6 components for xx, yy, zz, xy, yz, zx
-        if (((int) mxGetDimensions(prhs[2])[0] != 6) || ((int) mxGetDimensions(prhs[2])[1] != nverts))
-            mexErrMsgTxt("T must be of same size as vertex with 6 components : 6xnverts.");
-        T = mxGetPr(prhs[2]);
-        //==================================================================
-        // arg4 : start_points
-        start_points = mxGetPr(prhs[3]);
-        nstart = mxGetM(prhs[3]);
-        //==================================================================
-        // arg5 : boolean array for region to update
-        doUpdate = (bool*) mxGetPr(prhs[4]);
-        //==================================================================
-        if (nrhs == 5) {
-            // first ouput : geodesic distance
-            //      plhs[0] = mxCreateNumericArray(1,&nverts, mxDOUBLE_CLASS, mxREAL );
-            //    	U = (double*) mxGetPr(plhs[0]);
-            U = mxGetPr(plhs[0] = (mxArray*) mxCreateDoubleMatrix(nverts, 1, mxREAL));
-            // second output : voronoi
-            //plhs[1] = mxCreateNumericArray(1, &nverts, mxINT16_CLASS, mxREAL);
-            //Vor = (short*) mxGetPr(plhs[1]);
-            Vor = (short*) mxGetPr(plhs[1] = mxCreateNumericArray(1, (mwSize*) &nverts, mxINT16_CLASS, mxREAL));
-            given_u = false;
-        } else if (nrhs == 7) {
-            U = mxGetPr(prhs[5]);
-            Vor = (short*) mxGetPr(prhs[6]);
-            given_u = true;
+    //==================================================================
+    /* retrive arguments */
+    if (nrhs != 5 && nrhs != 7)
+        mexErrMsgTxt("5 or 7 input arguments are required.");
+    if (nlhs != 0 && nlhs != 2)
+        mexErrMsgTxt("0 or 2 output arguments are required.");
+    //==================================================================
+    // arg1 : vertex
+    double* vertex = mxGetPr(prhs[0]);
+    mwSize nverts = mxGetN(prhs[0]);
+    if (mxGetM(prhs[0]) != 3)
+        mexErrMsgTxt("vertex must be of size 3 x nverts.");
+    //==================================================================
+    // arg2 : connectivity
+    if (!mxIsStruct(prhs[1]) || mxGetNumberOfElements(prhs[1]) != nverts)
+        mexErrMsgTxt("connectivity must have the same size as vertex.");
+    int nb_neigh_field = mxGetFieldNumber(prhs[1], "nb_neighbors");
+    int neigh_idx_field = mxGetFieldNumber(prhs[1], "neighbours_idx");
+    if (nb_neigh_field < 0 || neigh_idx_field < 0)
+        mexErrMsgTxt("connectivity must have the fields nb_neighbors and neighbours_idx.");
+    std::vector< std::vector<int> > ring(nverts);
+    for (mwIndex point = 0; point < nverts; point++) {
+        int nb_neigh = (int) mxGetScalar(mxGetFieldByNumber(prhs[1], point, nb_neigh_field));
+        double* neigh = mxGetPr(mxGetFieldByNumber(prhs[1], point, neigh_idx_field));
+        for (int j = 0; j < nb_neigh; j++) {
+            if (neigh[j] < 0 || neigh[j] >= nverts)
+                mexErrMsgTxt("connectivity should index the vertices.");
+            ring[point].push_back((int) neigh[j]);
         }
-        //------------------------------------------------------------------
-        InitializeArrays();
-        //------------------------------------------------------------------
-        InitializeQueue();
-        //------------------------------------------------------------------
-        GaussSiedelIterate();
-        //==================================================================
-        DELETEARRAY(S);
-        DELETEARRAY(Q);
-        DELETEARRAY(ITER);
-        DELETEARRAY(TAB);
-        DELETEARRAY(U_n_D);
-        DELETEARRAY(Utmp);
-        DELETEARRAY(Vtmp);
-        DELETEARRAY(heap);
-        DELETEARRAY(heapIndex);
-        //==================================================================
     }
-}
\ No newline at end of file
+    //==================================================================
+    // arg3 : Metric (should be symmetric definite positive on the tangent plan)
+    // order of the 6 components for xx, yy, zz, xy, yz, zx
+    if (mxGetM(prhs[2]) != 6 || mxGetN(prhs[2]) != nverts)
+        mexErrMsgTxt("T must be of same size as vertex with 6 components : 6xnverts.");
+    double* T = mxGetPr(prhs[2]);
+    //==================================================================
+    // arg4 : start_points
+    double* start_points = mxGetPr(prhs[3]);
+    int nstart = (int) mxGetM(prhs[3]);
+    for (int i = 0; i < nstart; i++)
+        if (start_points[i] < 0 || start_points[i] >= nverts)
+            mexErrMsgTxt("start_points should be in the domain.");
+    //==================================================================
+    // arg5 : boolean array for region to update
+    if (!mxIsLogical(prhs[4]) || mxGetNumberOfElements(prhs[4]) != nverts)
+        mexErrMsgTxt("doUpdate must be a logical array of size nverts.");
+    const bool* doUpdate = (const bool*) mxGetData(prhs[4]);
+    //==================================================================
+    double* U;
+    short* Vor;
+    bool given_u;
+    if (nrhs == 5) {
+        // first ouput : geodesic distance
+        U = mxGetPr(plhs[0] = mxCreateDoubleMatrix(nverts, 1, mxREAL));
+        // second output : voronoi
+        Vor = (short*) mxGetData(plhs[1] = mxCreateNumericArray(1, &nverts, mxINT16_CLASS, mxREAL));
+        given_u = false;
+    } else {
+        if (mxGetNumberOfElements(prhs[5]) != nverts || !mxIsInt16(prhs[6]) || mxGetNumberOfElements(prhs[6]) != nverts)
+            mexErrMsgTxt("U and V must be the double and int16 results of a previous call.");
+        U = mxGetPr(prhs[5]);
+        Vor = (short*) mxGetData(prhs[6]);
+        given_u = true;
+    }
+    //------------------------------------------------------------------
+    AnisoEikonalMesh mesh;
+    mesh.build_from_rings(vertex, (int) nverts, ring);
+    AnisoEikonalSolver solver(mesh, true);
+    solver.set_metric(T);
+    if (!solver.solve(start_points, nstart, NULL, NULL, doUpdate, given_u, U, Vor))
+        mexErrMsgTxt("z1 and z2 should not be collinear !!");
+    //------------------------------------------------------------------
+    transportVoronoi(mesh, solver, U, Vor, start_points, nstart);
+}
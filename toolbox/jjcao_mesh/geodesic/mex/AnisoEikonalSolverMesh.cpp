@@ -4,100 +4,117 @@
 // (C) 02/2010 by Fethallah Benmansour & Gabriel Peyre
 //================================================================
 //================================================================
+// [U,V] = AnisoEikonalSolverMesh(Nb_calls, vertex, faces, T, start_points,
+//                                U_ini_seeds, V_ini_seeds, doUpdate [,U,V])
+// The propagation is the Fast Iterative Method of aniso_eikonal_fim.h, its
+// sweeps run on all cores when compiled with OpenMP. The connectivity is
+// kept between calls: it is only rebuilt when Nb_calls is 0 or the number of
+// vertices changes.
 
-#include "AnisoEikonalSolverMesh.h"
+#include "mex.h"
+#include "aniso_eikonal_fim.h"
+
+static AnisoEikonalMesh* mesh = NULL;
+
+static void delete_mesh()
+{
+	delete mesh;
+	mesh = NULL;
+}
 
 void mexFunction(	int nlhs, mxArray *plhs[], 
 				 int nrhs, const mxArray*prhs[] ) 
 {
     //==================================================================
 	/* retrive arguments */
-	if( nrhs<7 ) 
-		mexErrMsgTxt("at least 7 input arguments are required.");
+	if( nrhs!=8 && nrhs!=10 ) 
+		mexErrMsgTxt("8 or 10 input arguments are required.");
 	if( nlhs!=0  && nlhs!=2 ) 
 		mexErrMsgTxt("0 or 2 output arguments are required.");
     //==================================================================
 	// arg1 : Nb_calls: How many times this function has been called
     // This parameter avoids the recomputation of the mesh connectivity
-	Nb_calls = (int) mxGetScalar(prhs[0]);
-    //mexPrintf("Nb_calls = %d\n", Nb_calls);
-    //NbMax_calls = (int) mxGetPr(prhs[0])[1];
+	int Nb_calls = (int) mxGetScalar(prhs[0]);
     //==================================================================
 	// arg2 : vertex
-	vertex = mxGetPr(prhs[1]);
-	nverts = mxGetN(prhs[1]); 
+	double* vertex = mxGetPr(prhs[1]);
+	mwSize nverts = mxGetN(prhs[1]); 
 	if( mxGetM(prhs[1])!=3 )
 		mexErrMsgTxt("vertex must be of size 3 x nverts."); 
 	//==================================================================
     // arg3 : faces
-	faces = mxGetPr(prhs[2]);
-	nfaces= mxGetN(prhs[2]);
+	double* faces = mxGetPr(prhs[2]);
+	int nfaces = (int) mxGetN(prhs[2]);
 	if( mxGetM(prhs[2])!=3 )
 		mexErrMsgTxt("face must be of size 3 x nfaces."); 
+	for( int i=0; i<3*nfaces; ++i )
+		if( faces[i]<0 || faces[i]>=nverts )
+			mexErrMsgTxt("faces should index the vertices.");
 	//==================================================================
     // arg4 : Metric (should be symmetric definite positive on the tangent plan)
     // order of the 6 components for xx, yy, zz, xy, yz, zx
-	if( (mxGetDimensions(prhs[3])[0] != 6) || (mxGetDimensions(prhs[3])[1] != nverts) )
+	if( mxGetM(prhs[3])!=6 || mxGetN(prhs[3])!=nverts )
         mexErrMsgTxt("T must be of same size as vertex with 6 components : 6xnverts.");
-	T = mxGetPr(prhs[3]);
+	double* T = mxGetPr(prhs[3]);
     //==================================================================
 	// arg5 : start_points
-	start_points = mxGetPr(prhs[4]);
-	nstart = mxGetM(prhs[4]);
+	double* start_points = mxGetPr(prhs[4]);
+	int nstart = (int) mxGetM(prhs[4]);
+	for( int i=0; i<nstart; ++i )
+		if( start_points[i]<0 || start_points[i]>=nverts )
+			mexErrMsgTxt("start_points should be in the domain.");
 	//==================================================================	
 	// arg 6 and 7 : if initial distance values at source points are given
     // In this case, provide the intial voronoi indices as well
-	U_ini_seeds = mxGetPr(prhs[5]);
-    V_ini_seeds = mxGetPr(prhs[6]);
+	double* U_ini_seeds = mxGetPr(prhs[5]);
+    double* V_ini_seeds = mxGetPr(prhs[6]);
 	if( mxGetM(prhs[5])==0 && mxGetN(prhs[5])==0 )
 		U_ini_seeds=NULL;
 	if( mxGetM(prhs[6])==0 && mxGetN(prhs[6])==0 )
 		V_ini_seeds=NULL;
-	if( U_ini_seeds!=NULL && (mxGetM(prhs[5])!=nstart || mxGetN(prhs[5])!=1) )
+	if( U_ini_seeds!=NULL && (mxGetM(prhs[5])!=(mwSize) nstart || mxGetN(prhs[5])!=1) )
         mexErrMsgTxt("values must be of size nb_start_points x 1."); 
-	if( V_ini_seeds!=NULL && (mxGetM(prhs[6])!=nstart || mxGetN(prhs[6])!=1) )
+	if( V_ini_seeds!=NULL && (mxGetM(prhs[6])!=(mwSize) nstart || mxGetN(prhs[6])!=1) )
 		mexErrMsgTxt("values must be of size nb_start_points x 1.");
+	if( (U_ini_seeds==NULL)!=(V_ini_seeds==NULL) )
+		mexErrMsgTxt("U_ini_seeds and V_ini_seeds should be given together.");
 	//==================================================================
 	// arg 8 : boolean array for region to update
-    doUpdate = (bool*) mxGetPr(prhs[7]);
+	if( !mxIsLogical(prhs[7]) || mxGetNumberOfElements(prhs[7])!=nverts )
+		mexErrMsgTxt("doUpdate must be a logical array of size nverts.");
+    const bool* doUpdate = (const bool*) mxGetData(prhs[7]);
     //==================================================================
+	double* U;
+	short* Vor;
+	bool given_u;
     if(nrhs == 8){
         // first ouput : geodesic distance
         plhs[0] = mxCreateNumericArray(1,&nverts, mxDOUBLE_CLASS, mxREAL ); 
     	U = (double*) mxGetPr(plhs[0]);
         // second output : voronoi
     	plhs[1] = mxCreateNumericArray(1,&nverts, mxINT16_CLASS, mxREAL ); 
-        Vor = (short*) mxGetPr(plhs[1]);
+        Vor = (short*) mxGetData(plhs[1]);
         given_u = false;
     }
-    else if(nrhs == 10){
+    else{
+		if( mxGetNumberOfElements(prhs[8])!=nverts || !mxIsInt16(prhs[9]) || mxGetNumberOfElements(prhs[9])!=nverts )
+			mexErrMsgTxt("U and V must be the double and int16 results of a previous call.");
         U   = mxGetPr(prhs[8]);
-        Vor = (short*) mxGetPr(prhs[9]);
+        Vor = (short*) mxGetData(prhs[9]);
         given_u = true;
     }
 	//==================================================================
-    if(Nb_calls == 0){
-        mexPrintf("Creating the Mesh\n");
-        create_the_mesh();
+    if( Nb_calls==0 || mesh==NULL || mesh->nverts()!=(int) nverts ){
+		if( mesh==NULL )
+			mexAtExit( delete_mesh );
+		else
+			delete mesh;
+        mesh = new AnisoEikonalMesh;
+        mesh->build_from_faces( vertex, (int) nverts, faces, nfaces );
 	}
     //------------------------------------------------------------------
-    InitializeArrays();
-	//------------------------------------------------------------------
-	InitializeQueue();
-    //------------------------------------------------------------------
-	GaussSiedelIterate();
-    //------------------------------------------------------------------
-    //Nb_calls++;
-	//==================================================================
-    DELETEARRAY(S);
-    DELETEARRAY(Q);
-    DELETEARRAY(ITER);
-    DELETEARRAY(TAB);
-    DELETEARRAY(U_n_D);
-    //==================================================================
-    //if(Nb_calls >= NbMax_calls){
-    //    mexPrintf("Clening the geodesic Mesh\n");
-    //    Mesh.~GW_Mesh();
-	//}
-    
-};
\ No newline at end of file
+	AnisoEikonalSolver solver( *mesh );
+	solver.set_metric( T );
+	if( !solver.solve(start_points, nstart, U_ini_seeds, V_ini_seeds, doUpdate, given_u, U, Vor) )
+		mexErrMsgTxt("z1 and z2 should not be collinear !!");
+}
@@ -0,0 +1,485 @@
+/*=================================================================
+% aniso_eikonal_fim.h - anisotropic eikonal equation on a triangle mesh by
+%   the Fast Iterative Method (Jeong & Whitaker 08).
+%
+%   The local solver is the one of AnisoEikonalSolverMesh: the Tsitsiklis
+%   update of a vertex from each face around it, with a symmetric 3x3 metric
+%   per vertex. The adaptive Gauss-Seidel queue is replaced by an active list
+%   processed in sweeps. The vertices are coloured once so that two
+%   neighbours never share a colour; a sweep goes through the active list
+%   colour by colour, and the vertices of one colour, having no common face,
+%   are updated in place in parallel. The neighbours of the vertices whose
+%   value changed make the next active list.
+%   Values only decrease, so the sweeps reach the same fixed point as the
+%   Gauss-Seidel iteration, with the same result for any number of threads.
+%   Each thread gathers its own candidates, they are merged with one flag per
+%   vertex: no lock is taken.
+%
+%   AnisoEikonalMesh holds the topology (shared read-only by any number of
+%   solvers), AnisoEikonalSolver the metric, stored per component (xx, yy,
+%   zz, xy, yz, zx), and the state of one propagation.
+*=================================================================*/
+
+#ifndef ANISO_EIKONAL_FIM_H
+#define ANISO_EIKONAL_FIM_H
+
+#include <math.h>
+#include <vector>
+#include <algorithm>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+class AnisoEikonalMesh
+{
+public:
+	AnisoEikonalMesh() : nverts_(0), nb_colors_(0) {}
+
+	// vertex: 3 x nverts, faces: 3 x nfaces of zero-based indices
+	void build_from_faces( const double* vertex, int nverts, const double* faces, int nfaces )
+	{
+		set_vertices( vertex, nverts );
+		std::vector< std::vector<int> > ring( nverts ), fan( nverts );
+		for( int f=0; f<nfaces; ++f )
+		{
+			int v[3] = { (int) faces[3*f], (int) faces[3*f+1], (int) faces[3*f+2] };
+			for( int i=0; i<3; ++i )
+			{
+				// same order as GW_Face::GetNextVertex
+				int a = v[i], b = v[(i+1)%3], c = v[(i+2)%3];
+				fan[a].push_back( b );
+				fan[a].push_back( c );
+				ring[a].push_back( b );
+				ring[a].push_back( c );
+			}
+		}
+		for( int i=0; i<nverts; ++i )
+		{
+			std::sort( ring[i].begin(), ring[i].end() );
+			ring[i].erase( std::unique(ring[i].begin(), ring[i].end()), ring[i].end() );
+		}
+		flatten( ring, ring_start_, ring_ );
+		flatten( fan, fan_start_, fan_ );
+		color_vertices();
+	}
+
+	// ring: ordered one ring of each vertex, a face is assumed between two
+	// consecutive neighbours when they are neighbours themselves
+	void build_from_rings( const double* vertex, int nverts, const std::vector< std::vector<int> >& ring )
+	{
+		set_vertices( vertex, nverts );
+		flatten( ring, ring_start_, ring_ );
+		std::vector< std::vector<int> > fan( nverts );
+		for( int i=0; i<nverts; ++i )
+		{
+			int n = (int) ring[i].size();
+			for( int k=0; k<n; ++k )
+			{
+				int a = ring[i][k], b = ring[i][(k+1)%n];
+				if( are_neighbors(a, b) )
+				{
+					fan[i].push_back( a );
+					fan[i].push_back( b );
+				}
+			}
+		}
+		flatten( fan, fan_start_, fan_ );
+		color_vertices();
+	}
+
+	int nverts() const { return nverts_; }
+	const double* position( int i ) const { return &position_[3*i]; }
+	// neighbours of i are ring_[ring_begin(i)..ring_end(i)[
+	int ring_begin( int i ) const { return ring_start_[i]; }
+	int ring_end( int i ) const { return ring_start_[i+1]; }
+	int neighbor( int k ) const { return ring_[k]; }
+	// faces around i, as the pairs of vertices opposite to i
+	int fan_begin( int i ) const { return fan_start_[i]/2; }
+	int fan_end( int i ) const { return fan_start_[i+1]/2; }
+	int fan_vertex( int k, int j ) const { return fan_[2*k+j]; }
+	// two neighbours never have the same colour
+	int color( int i ) const { return color_[i]; }
+	int nb_colors() const { return nb_colors_; }
+
+private:
+	void set_vertices( const double* vertex, int nverts )
+	{
+		nverts_ = nverts;
+		position_.assign( vertex, vertex+3*nverts );
+	}
+	// per vertex lists to compressed rows; fan lists hold pairs
+	static void flatten( const std::vector< std::vector<int> >& list, std::vector<int>& start, std::vector<int>& data )
+	{
+		int n = (int) list.size();
+		start.assign( n+1, 0 );
+		size_t total = 0;
+		for( int i=0; i<n; ++i )
+			total += list[i].size();
+		data.clear();
+		data.reserve( total );
+		for( int i=0; i<n; ++i )
+			data.insert( data.end(), list[i].begin(), list[i].end() );
+		start[0] = 0;
+		for( int i=0; i<n; ++i )
+			start[i+1] = start[i] + (int) list[i].size();
+	}
+	// greedy colouring of the graph of the rings, made symmetric
+	void color_vertices()
+	{
+		std::vector< std::vector<int> > adjacency( nverts_ );
+		for( int i=0; i<nverts_; ++i )
+		for( int k=ring_start_[i]; k<ring_start_[i+1]; ++k )
+		{
+			adjacency[i].push_back( ring_[k] );
+			adjacency[ring_[k]].push_back( i );
+		}
+		color_.assign( nverts_, -1 );
+		nb_colors_ = 0;
+		std::vector<int> used;
+		for( int i=0; i<nverts_; ++i )
+		{
+			used.assign( adjacency[i].size()+1, 0 );
+			for( size_t k=0; k<adjacency[i].size(); ++k )
+			{
+				int c = color_[adjacency[i][k]];
+				if( c>=0 && c<(int) used.size() )
+					used[c] = 1;
+			}
+			int c = 0;
+			while( used[c] )
+				c++;
+			color_[i] = c;
+			nb_colors_ = std::max( nb_colors_, c+1 );
+		}
+	}
+	bool are_neighbors( int a, int b ) const
+	{
+		const int* first = &ring_[0] + ring_start_[a];
+		const int* last = &ring_[0] + ring_start_[a+1];
+		return std::find( first, last, b )!=last;
+	}
+
+	int nverts_;
+	std::vector<double> position_;
+	std::vector<int> ring_start_, ring_;
+	std::vector<int> fan_start_, fan_;
+	std::vector<int> color_;
+	int nb_colors_;
+};
+
+// value of the vertices not reached, and change below which a vertex is
+// considered converged
+static const double kAnisoInfinite = 1e9;
+static const double kAnisoTol = 1e-15;
+
+class AnisoEikonalSolver
+{
+public:
+	enum { kSeed = -1, kEstimated = -2, kFar = -3, kBorder = -4 };
+
+	// update_on_tie: a face giving the same value as the current one still
+	// sets the Voronoi index (AnisoEikonalSolverMatlabMesh relies on it)
+	AnisoEikonalSolver( const AnisoEikonalMesh& mesh, bool update_on_tie = false )
+		: mesh_(mesh), update_on_tie_(update_on_tie), nb_sweeps_(0),
+		  U_(NULL), Vor_(NULL), doUpdate_(NULL)
+	{
+	}
+
+	// T: 6 x nverts, components xx, yy, zz, xy, yz, zx of each vertex
+	void set_metric( const double* T )
+	{
+		int n = mesh_.nverts();
+		for( int c=0; c<6; ++c )
+		{
+			metric_[c].resize( n );
+			for( int i=0; i<n; ++i )
+				metric_[c][i] = T[6*i+c];
+		}
+	}
+
+	// start_points: zero-based vertices, checked by the caller.
+	// U_ini/V_ini: optional distance and Voronoi index of the start points.
+	// given_u: U and Vor hold a previous propagation to be extended.
+	// Returns false if a face is degenerate for the metric.
+	bool solve( const double* start_points, int nstart, const double* U_ini, const double* V_ini,
+		const bool* doUpdate, bool given_u, double* U, short* Vor )
+	{
+		int n = mesh_.nverts();
+		U_ = U;
+		Vor_ = Vor;
+		doUpdate_ = doUpdate;
+		S_.resize( n );
+		active_flag_.assign( n, 0 );
+		nb_sweeps_ = 0;
+
+		// initialize the states
+		short maxVor = -1;
+		for( int x=0; x<n; ++x )
+		{
+			if( given_u )
+			{
+				S_[x] = doUpdate[x] ? kEstimated : kBorder;
+				if( U[x]>1e6 )
+					S_[x] = kFar;
+				maxVor = std::max( maxVor, Vor[x] );
+			}
+			else
+			{
+				U[x] = kAnisoInfinite;
+				Vor[x] = kBorder;
+				S_[x] = kBorder;
+			}
+		}
+		// seeds
+		for( int i=0; i<nstart; ++i )
+		{
+			int point = (int) start_points[i];
+			if( U_ini==NULL )
+			{
+				U[point] = 0.0;
+				S_[point] = kSeed;
+				Vor[point] = (short) (given_u ? i + 1 + maxVor : i);
+			}
+			else
+			{
+				U[point] = U_ini[i];
+				S_[point] = kEstimated;
+				Vor[point] = (short) V_ini[i];
+			}
+		}
+		// the first active list is made of the neighbours of the seeds
+		active_.clear();
+		for( int i=0; i<nstart; ++i )
+		{
+			int point = (int) start_points[i];
+			for( int k=mesh_.ring_begin(point); k<mesh_.ring_end(point); ++k )
+				activate( mesh_.neighbor(k) );
+		}
+
+		int nthreads = 1;
+#ifdef _OPENMP
+		nthreads = omp_get_max_threads();
+#endif
+		std::vector< std::vector<int> > candidates( nthreads );
+		int nb_colors = mesh_.nb_colors();
+		std::vector<int> color_start( nb_colors+1 );
+		while( !active_.empty() )
+		{
+			nb_sweeps_++;
+			int nactive = (int) active_.size();
+
+			// batches of independent vertices: sort the active list by colour
+			std::fill( color_start.begin(), color_start.end(), 0 );
+			for( int a=0; a<nactive; ++a )
+				color_start[mesh_.color(active_[a])+1]++;
+			for( int c=0; c<nb_colors; ++c )
+				color_start[c+1] += color_start[c];
+			batch_.resize( nactive );
+			for( int a=0; a<nactive; ++a )
+				batch_[color_start[mesh_.color(active_[a])]++] = active_[a];
+			for( int c=nb_colors; c>0; --c )
+				color_start[c] = color_start[c-1];
+			color_start[0] = 0;
+
+			// the vertices of a batch have no common face, they are updated in
+			// place; a neighbour whose value changed is a candidate for the
+			// next sweep, unless a later batch of this sweep updates it
+			for( int c=0; c<nb_colors; ++c )
+			{
+				int first = color_start[c], last = color_start[c+1];
+				if( first==last )
+					continue;
+				int degenerate = 0;
+				#pragma omp parallel num_threads(nthreads) reduction(+:degenerate)
+				{
+					int t = 0;
+#ifdef _OPENMP
+					t = omp_get_thread_num();
+#endif
+					std::vector<int>& mine = candidates[t];
+					#pragma omp for schedule(dynamic,64)
+					for( int a=first; a<last; ++a )
+					{
+						int point = batch_[a];
+						double u;
+						short v;
+						if( !update(point, u, v) )
+						{
+							degenerate++;
+							continue;
+						}
+						S_[point] = kEstimated;
+						if( fabs(u-U[point])>kAnisoTol )
+						{
+							U[point] = u;
+							Vor[point] = v;
+							for( int k=mesh_.ring_begin(point); k<mesh_.ring_end(point); ++k )
+							{
+								int npoint = mesh_.neighbor(k);
+								if( doUpdate[npoint] && !(active_flag_[npoint] && mesh_.color(npoint)>c) )
+									mine.push_back( npoint );
+							}
+						}
+					}
+				}
+				if( degenerate>0 )
+					return false;
+			}
+
+			// next active list, without duplicates
+			for( int a=0; a<nactive; ++a )
+				active_flag_[active_[a]] = 0;
+			active_.clear();
+			for( int t=0; t<nthreads; ++t )
+			{
+				for( size_t k=0; k<candidates[t].size(); ++k )
+					activate( candidates[t][k] );
+				candidates[t].clear();
+			}
+		}
+		return true;
+	}
+
+	// Tsitsiklis update of point from the faces around it, with the current
+	// values of the last solve; returns false on a degenerate face
+	bool update( int point, double& u, short& v ) const
+	{
+		double Ur = U_[point];
+		short Vr = Vor_[point];
+		bool is_updated = false;
+		for( int k=mesh_.fan_begin(point); k<mesh_.fan_end(point); ++k )
+		{
+			double res[3];
+			if( !triangle(res, point, mesh_.fan_vertex(k,0), mesh_.fan_vertex(k,1)) )
+				return false;
+			if( res[1]<Ur || (update_on_tie_ && res[1]==Ur) )
+			{
+				Ur = res[1];
+				Vr = (short) res[2];
+				is_updated = true;
+			}
+		}
+		u = is_updated ? Ur : U_[point];
+		v = is_updated ? Vr : Vor_[point];
+		return true;
+	}
+
+	int state( int point ) const { return S_[point]; }
+	// number of Jacobi sweeps of the last solve
+	int nb_sweeps() const { return nb_sweeps_; }
+
+private:
+	void activate( int point )
+	{
+		if( S_[point]!=kSeed && !active_flag_[point] )
+		{
+			active_flag_[point] = 1;
+			active_.push_back( point );
+		}
+	}
+
+	// V1^t M V2, M the symmetric metric of point
+	double dot( int point, const double* V1, const double* V2 ) const
+	{
+		return metric_[0][point]*V1[0]*V2[0] + metric_[1][point]*V1[1]*V2[1] + metric_[2][point]*V1[2]*V2[2]
+			+ metric_[3][point]*( V1[0]*V2[1] + V2[0]*V1[1] )
+			+ metric_[4][point]*( V1[1]*V2[2] + V2[1]*V1[2] )
+			+ metric_[5][point]*( V1[2]*V2[0] + V2[2]*V1[0] );
+	}
+
+	// minimum and arg min of alpha*k + u + || alpha*z1 + z2 ||_M, alpha in [0,1]
+	bool two_points( double* res, int point, double k, double u, const double* z1, const double* z2 ) const
+	{
+		double r11 = dot( point, z1, z1 );
+		double r22 = dot( point, z2, z2 );
+		double r12 = dot( point, z1, z2 );
+		double R = r11*r22-r12*r12;
+		if( !(R > 0) )
+			return false;
+		if( k >= sqrt(r11) )
+		{
+			res[0] = 0.0;
+			res[1] = u + sqrt(r22);
+		}
+		else if( k <= -sqrt(r11) )
+		{
+			res[0] = 1.0;
+			res[1] = k + u + sqrt(r11 + r22 + 2.0*r12);
+		}
+		else
+		{
+			double s = sqrt( R/(r11-k*k) );
+			if( r12 >= -k*s )
+			{
+				res[0] = 0.0;
+				res[1] = u + sqrt(r22);
+			}
+			else if( r12 <= -r11-k*s )
+			{
+				res[0] = 1.0;
+				res[1] = k + u + sqrt(r11 + r22 + 2.0*r12);
+			}
+			else
+			{
+				res[0] = -(r12 + k*s) / r11;
+				res[1] = res[0]*k + u + s;
+			}
+		}
+		return true;
+	}
+
+	// res = (arg min, min, Voronoi index) over the face (point, npoint1, npoint2)
+	bool triangle( double* res, int point, int npoint1, int npoint2 ) const
+	{
+		res[1] = U_[point]+1.0;	// bigger value
+		bool b_point1 = (S_[npoint1]==kEstimated || S_[npoint1]==kSeed) && doUpdate_[npoint1];
+		bool b_point2 = (S_[npoint2]==kEstimated || S_[npoint2]==kSeed) && doUpdate_[npoint2];
+		if( !b_point1 && !b_point2 )
+			return true;
+
+		const double* p = mesh_.position( point );
+		const double* p1 = mesh_.position( npoint1 );
+		const double* p2 = mesh_.position( npoint2 );
+		double X1[3], X2[3], X12[3];
+		for( int i=0; i<3; ++i )
+		{
+			X1[i] = p[i] - p1[i];
+			X2[i] = p[i] - p2[i];
+			X12[i] = X1[i] - X2[i];
+		}
+		if( b_point1 && b_point2 )
+		{
+			double U1 = U_[npoint1], U2 = U_[npoint2];
+			if( !two_points(res, point, U1-U2, U2, X12, X2) )
+				return false;
+			res[2] = res[0]>0.5 ? Vor_[npoint1] : Vor_[npoint2];
+		}
+		else if( b_point1 )
+		{
+			res[0] = 1.0;
+			res[1] = U_[npoint1] + sqrt( dot(point, X1, X1) );
+			res[2] = Vor_[npoint1];
+		}
+		else
+		{
+			res[0] = 0.0;
+			res[1] = U_[npoint2] + sqrt( dot(point, X2, X2) );
+			res[2] = Vor_[npoint2];
+		}
+		return true;
+	}
+
+	const AnisoEikonalMesh& mesh_;
+	bool update_on_tie_;
+	std::vector<double> metric_[6];
+	std::vector<short> S_;
+	std::vector<int> active_;
+	std::vector<unsigned char> active_flag_;
+	std::vector<int> batch_;
+	int nb_sweeps_;
+	double* U_;
+	short* Vor_;
+	const bool* doUpdate_;
+};
+
+#endif // ANISO_EIKONAL_FIM_H
@@ -0,0 +1,172 @@
+/*=================================================================
+% fast_marching_mesh - many fast marching propagations on a 3D mesh built once.
+%
+%   h = fast_marching_mesh('build', vertex, faces);
+%   [D,S,Q] = fast_marching_mesh('propagate', h, W, start_points, nb_iter_max, L, dmax, end_points, end_points_stop);
+%   fast_marching_mesh('delete', h);
+%
+%   'build' creates the mesh and its connectivity and returns a handle to it.
+%	'vertex' is 3 x nverts, 'faces' is 3 x nfaces (0-based).
+%
+%   'propagate' runs one independent propagation per start set:
+%	'start_points' is either a vector (one propagation from each point) or a
+%		cell array of vectors (one propagation from each set of points), 0-based.
+%	'W' is the weight (inverse of the speed), nverts x 1 or [] for a constant 1.
+%	'nb_iter_max', 'L' (constraint map, can be []) and 'dmax' are the stop
+%		conditions of perform_front_propagation_mesh, applied to each propagation.
+%	'end_points' (indices or logical mask) and 'end_points_stop' (1 by default,
+%		Inf for all) stop each propagation once that many end points are
+%		reached, e.g. to get the distance from each start point to its nearest
+%		landmark among thousands.
+%	D, S, Q are nverts x nb_propagations: column j is the result of the jth
+%		propagation, as returned by perform_front_propagation_mesh.
+%   The propagations run in parallel (one buffer per thread, the mesh is
+%   shared) when compiled with OpenMP.
+%
+%   'delete' frees the mesh.
+*=================================================================*/
+
+#include "perform_front_propagation_mesh.h"
+#include <set>
+#include <stdint.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+// meshes built by this mex file, a handle is valid only if it is in this set
+static std::set<GW_GeodesicMesh*> meshes;
+
+static void delete_all_meshes()
+{
+	for( std::set<GW_GeodesicMesh*>::iterator it=meshes.begin(); it!=meshes.end(); ++it )
+		delete *it;
+	meshes.clear();
+}
+
+static GW_GeodesicMesh* get_mesh(const mxArray* handle)
+{
+	if( handle==NULL || mxGetClassID(handle)!=mxUINT64_CLASS || mxGetNumberOfElements(handle)!=1 )
+		mexErrMsgTxt("h must be a handle returned by fast_marching_mesh('build', ...).");
+	GW_GeodesicMesh* Mesh = (GW_GeodesicMesh*) (uintptr_t) *((uint64_t*) mxGetData(handle));
+	if( meshes.find(Mesh)==meshes.end() )
+		mexErrMsgTxt("h is not a mesh or has already been deleted.");
+	return Mesh;
+}
+
+void mexFunction(	int nlhs, mxArray *plhs[],
+				 int nrhs, const mxArray*prhs[] )
+{
+	if( nrhs<2 || !mxIsChar(prhs[0]) )
+		mexErrMsgTxt("usage: fast_marching_mesh('build'|'propagate'|'delete', ...).");
+	char cmd[16];
+	mxGetString(prhs[0], cmd, sizeof(cmd));
+
+	if( strcmp(cmd, "build")==0 )
+	{
+		if( nrhs!=3 )
+			mexErrMsgTxt("usage: h = fast_marching_mesh('build', vertex, faces).");
+		GW_GeodesicMesh* Mesh = new GW_GeodesicMesh;
+		create_the_mesh( *Mesh, prhs[1], prhs[2] );
+		if( meshes.empty() )
+		{
+			// keep the meshes (and the code of their virtual methods) alive until deleted
+			mexLock();
+			mexAtExit( delete_all_meshes );
+		}
+		meshes.insert( Mesh );
+		plhs[0] = mxCreateNumericMatrix(1, 1, mxUINT64_CLASS, mxREAL);
+		*((uint64_t*) mxGetData(plhs[0])) = (uint64_t) (uintptr_t) Mesh;
+		return;
+	}
+
+	if( strcmp(cmd, "delete")==0 )
+	{
+		GW_GeodesicMesh* Mesh = get_mesh( prhs[1] );
+		meshes.erase( Mesh );
+		delete Mesh;
+		if( meshes.empty() )
+			mexUnlock();
+		return;
+	}
+
+	if( strcmp(cmd, "propagate")!=0 )
+		mexErrMsgTxt("unknown command, should be 'build', 'propagate' or 'delete'.");
+	if( nrhs<4 )
+		mexErrMsgTxt("usage: [D,S,Q] = fast_marching_mesh('propagate', h, W, start_points, nb_iter_max, L, dmax, end_points, end_points_stop).");
+
+	// check every argument before going parallel: no mexErrMsgTxt in the threads
+	GW_GeodesicMesh& Mesh = *get_mesh( prhs[1] );
+	int nverts = (int) Mesh.GetNbrVertex();
+	const double* W = get_vertex_array( prhs[2], nverts, "W must be of size nverts." );
+	std::vector<T_U32Vector> start_points;
+	if( mxIsCell(prhs[3]) )
+	{
+		start_points.resize( mxGetNumberOfElements(prhs[3]) );
+		for( size_t j=0; j<start_points.size(); ++j )
+		{
+			const mxArray* cell = mxGetCell(prhs[3], j);
+			if( cell==NULL || !mxIsDouble(cell) )
+				mexErrMsgTxt("start_points{j} must be a vector of vertex indices.");
+			get_vertex_list( cell, nverts, start_points[j], "start_points must index vertices (0-based)." );
+		}
+	}
+	else
+	{
+		T_U32Vector points;
+		get_vertex_list( prhs[3], nverts, points, "start_points must index vertices (0-based)." );
+		start_points.resize( points.size() );
+		for( size_t j=0; j<points.size(); ++j )
+			start_points[j].push_back( points[j] );
+	}
+	GW_U32 niter_max = (GW_U32) (1.2*nverts);
+	if( nrhs>=5 && mxGetNumberOfElements(prhs[4])>0 )
+		niter_max = (GW_U32) GW_MIN( GW_MAX( *mxGetPr(prhs[4]), 0 ), 1.2*nverts );
+	const double* L = NULL;
+	if( nrhs>=6 )
+		L = get_vertex_array( prhs[5], nverts, "L must be of size nverts." );
+	double dmax = 1e9;
+	if( nrhs>=7 && mxGetNumberOfElements(prhs[6])>0 )
+		dmax = *mxGetPr(prhs[6]);
+	T_U32Vector end_points;
+	if( nrhs>=8 )
+		get_end_points( prhs[7], nverts, end_points, "end_points must index vertices (0-based) or be a mask of size nverts." );
+	GW_U32 end_points_stop = get_end_points_stop( nrhs>=9 ? prhs[8] : NULL );
+
+	int nprop = (int) start_points.size();
+	plhs[0] = mxCreateDoubleMatrix(nverts, nprop, mxREAL);
+	double* D = mxGetPr(plhs[0]);
+	double* S = NULL;
+	double* Q = NULL;
+	if( nlhs>=2 )
+	{
+		plhs[1] = mxCreateDoubleMatrix(nverts, nprop, mxREAL);
+		S = mxGetPr(plhs[1]);
+	}
+	if( nlhs>=3 )
+	{
+		plhs[2] = mxCreateDoubleMatrix(nverts, nprop, mxREAL);
+		Q = mxGetPr(plhs[2]);
+	}
+
+	#pragma omp parallel
+	{
+		// per thread buffers, the mesh is only read
+		GW_GeodesicMarcher Marcher( Mesh );
+		Marcher.SetWeight( W );
+		Marcher.SetConstraint( L );
+		Marcher.SetMaxIteration( niter_max );
+		Marcher.SetMaxDistance( dmax );
+		Marcher.SetEndVertex( end_points, end_points_stop );
+
+		#pragma omp for schedule(dynamic)
+		for( int j=0; j<nprop; ++j )
+		{
+			Marcher.ResetMarcher();
+			for( IT_U32Vector it=start_points[j].begin(); it!=start_points[j].end(); ++it )
+				Marcher.AddStartVertex( *it );
+			Marcher.PerformFastMarching();
+			size_t offset = (size_t) j*nverts;
+			store_propagation( Marcher, D+offset, S!=NULL ? S+offset : NULL, Q!=NULL ? Q+offset : NULL );
+		}
+	}
+}
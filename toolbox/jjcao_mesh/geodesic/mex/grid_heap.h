@@ -0,0 +1,121 @@
+/*=================================================================
+% grid_heap.h - binary min heap of the points of a grid, used by the
+%   grid fast marching (perform_front_propagation_2d/3d).
+%
+%   The points are linear indices in the grid; each entry keeps its key
+%   next to the index so that sifting does not touch the grid arrays.
+%   pos[s] is the slot of point s in the heap, -1 when it is not in it, so
+%   decreasing the key of an open point is O(log n) without any search.
+%   Nothing is allocated per point: the heap grows like a std::vector and
+%   pos is given by the caller (one int per grid point).
+*=================================================================*/
+
+#ifndef _GRID_HEAP_H_
+#define _GRID_HEAP_H_
+
+#include <vector>
+
+class GridHeap
+{
+public:
+	// pos: one int per grid point, all set to -1
+	GridHeap( int* pos ) : pos_(pos) {}
+
+	bool empty() const { return heap_.empty(); }
+	int size() const { return (int) heap_.size(); }
+	bool contains( int s ) const { return pos_[s]>=0; }
+	void reserve( int n ) { heap_.reserve(n); }
+
+	void push( int s, double key )
+	{
+		Entry e = { key, s };
+		heap_.push_back( e );
+		pos_[s] = (int) heap_.size()-1;
+		up( pos_[s] );
+	}
+	// key of s (in the heap) became smaller
+	void decrease( int s, double key )
+	{
+		int h = pos_[s];
+		heap_[h].key = key;
+		up( h );
+	}
+	// removes the point with the smallest key
+	int pop()
+	{
+		int s = heap_[0].s;
+		pos_[s] = -1;
+		Entry last = heap_.back();
+		heap_.pop_back();
+		if( !heap_.empty() )
+		{
+			heap_[0] = last;
+			pos_[last.s] = 0;
+			down( 0 );
+		}
+		return s;
+	}
+
+private:
+	struct Entry
+	{
+		double key;
+		int s;
+	};
+
+	void up( int h )
+	{
+		Entry e = heap_[h];
+		while( h>0 )
+		{
+			int parent = (h-1)/2;
+			if( !(e.key<heap_[parent].key) )
+				break;
+			heap_[h] = heap_[parent];
+			pos_[heap_[h].s] = h;
+			h = parent;
+		}
+		heap_[h] = e;
+		pos_[e.s] = h;
+	}
+	void down( int h )
+	{
+		int n = (int) heap_.size();
+		Entry e = heap_[h];
+		for( ;; )
+		{
+			int c = 2*h+1;
+			if( c>=n )
+				break;
+			if( c+1<n && heap_[c+1].key<heap_[c].key )
+				++c;
+			if( !(heap_[c].key<e.key) )
+				break;
+			heap_[h] = heap_[c];
+			pos_[heap_[h].s] = h;
+			h = c;
+		}
+		heap_[h] = e;
+		pos_[e.s] = h;
+	}
+
+	std::vector<Entry> heap_;
+	int* pos_;
+};
+
+// priority of an open point: its distance, or distance + heuristic (A*)
+struct GridDistanceKey
+{
+	GridDistanceKey( const double* D, const double* ) : D_(D) {}
+	double operator()( int s ) const { return D_[s]; }
+	const double* D_;
+};
+struct GridHeuristicKey
+{
+	GridHeuristicKey( const double* D, const double* H ) : D_(D), H_(H) {}
+	double operator()( int s ) const { return D_[s]+H_[s]; }
+	const double* D_;
+	const double* H_;
+};
+
+#endif // _GRID_HEAP_H_
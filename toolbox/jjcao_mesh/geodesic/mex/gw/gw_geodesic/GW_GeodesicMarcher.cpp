@@ -0,0 +1,117 @@
+/*------------------------------------------------------------------------------*/
+/**
+ *  \file   GW_GeodesicMarcher.cpp
+ *  \brief  Definition of class \c GW_GeodesicMarcher
+ */
+/*------------------------------------------------------------------------------*/
+
+
+#include "stdafx.h"
+#include "GW_GeodesicMarcher.h"
+
+#ifndef GW_USE_INLINE
+    #include "GW_GeodesicMarcher.inl"
+#endif
+
+using namespace GW;
+
+/*------------------------------------------------------------------------------*/
+// Name : GW_GeodesicMarcher::ResetMarcher
+/**
+ *  Reset the vertices reached by the last propagation, in
+ *  O(number of reached vertices). The parameters are kept.
+ */
+/*------------------------------------------------------------------------------*/
+void GW_GeodesicMarcher::ResetMarcher()
+{
+	for( IT_U32Vector it=ReachedVertex_.begin(); it!=ReachedVertex_.end(); ++it )
+	{
+		Distance_[*it] = GW_INFINITE;
+		State_[*it] = GW_GeodesicVertex::kFar;
+		Front_[*it] = -1;
+		HeapPosition_[*it] = -1;
+	}
+	ReachedVertex_.clear();
+	Heap_.clear();
+	nNbrIteration_ = 0;
+	nNbrEndVertexReached_ = 0;
+}
+
+/*------------------------------------------------------------------------------*/
+// Name : GW_GeodesicMarcher::PerformFastMarching
+/**
+ *  Propagate from the start vertices until the front is empty or a stop
+ *  condition is met. Follows \c GW_GeodesicMesh::PerformFastMarchingOneStep.
+ */
+/*------------------------------------------------------------------------------*/
+void GW_GeodesicMarcher::PerformFastMarching()
+{
+	while( !Heap_.empty() )
+	{
+		GW_U32 nCur = this->HeapPop();
+		State_[nCur] = GW_GeodesicVertex::kDead;
+		GW_I32 nCurFront = Front_[nCur];
+		GW_GeodesicVertex* pCurVert = (GW_GeodesicVertex*) Mesh_.GetVertex( nCur );
+		GW_ASSERT( pCurVert!=NULL );
+
+		for( GW_VertexIterator VertIt = pCurVert->BeginVertexIterator(); VertIt!=pCurVert->EndVertexIterator(); ++VertIt )
+		{
+			GW_GeodesicVertex* pNewVert = (GW_GeodesicVertex*) *VertIt;
+			GW_ASSERT( pNewVert!=NULL );
+			GW_U32 nNew = pNewVert->GetID();
+			if( State_[nNew]==GW_GeodesicVertex::kDead )
+				continue;
+
+			/* compute it's new distance using neighborhood information */
+			GW_Float rNewDistance = GW_INFINITE;
+			for( GW_FaceIterator FaceIt=pNewVert->BeginFaceIterator(); FaceIt!=pNewVert->EndFaceIterator(); ++FaceIt )
+			{
+				GW_GeodesicFace* pFace = (GW_GeodesicFace*) *FaceIt;
+				GW_ASSERT( pFace!=NULL );
+				GW_GeodesicVertex* pVert1 = (GW_GeodesicVertex*) pFace->GetNextVertex( *pNewVert );
+				GW_ASSERT( pVert1!=NULL );
+				GW_GeodesicVertex* pVert2 = (GW_GeodesicVertex*) pFace->GetNextVertex( *pVert1 );
+				GW_ASSERT( pVert2!=NULL );
+
+				if( Distance_[pVert1->GetID()]>Distance_[pVert2->GetID()] )
+				{
+					GW_GeodesicVertex* pTempVert = pVert1;
+					pVert1 = pVert2;
+					pVert2 = pTempVert;
+				}
+				rNewDistance = GW_MIN( rNewDistance, this->ComputeVertexDistance( *pFace, *pNewVert, *pVert1, *pVert2, nCurFront ) );
+			}
+
+			if( State_[nNew]==GW_GeodesicVertex::kFar )
+			{
+				if( this->InsertVertex( nNew, rNewDistance ) )
+				{
+					Distance_[nNew] = rNewDistance;
+					State_[nNew] = GW_GeodesicVertex::kAlive;
+					Front_[nNew] = nCurFront;
+					ReachedVertex_.push_back( nNew );
+					this->HeapPush( nNew );
+				}
+			}
+			else if( rNewDistance<=Distance_[nNew] )
+			{
+				/* alive : the distance can only decrease */
+				Distance_[nNew] = rNewDistance;
+				Front_[nNew] = nCurFront;
+				if( bUseHeapRebuild_ )
+					this->HeapMakeHeap();
+				else
+					this->HeapSiftUp( (GW_U32) HeapPosition_[nNew] );
+			}
+		}
+
+		/* tested even when the heap is empty, so that the last dead vertex is counted */
+		if( this->StopMarching( nCur ) )
+			break;
+	}
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//                               END OF FILE                                 //
+///////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,141 @@
+/*------------------------------------------------------------------------------*/
+/**
+ *  \file   GW_GeodesicMarcher.h
+ *  \brief  Definition of class \c GW_GeodesicMarcher
+ */
+/*------------------------------------------------------------------------------*/
+
+#ifndef _GW_GEODESICMARCHER_H_
+#define _GW_GEODESICMARCHER_H_
+
+#include "../gw_core/GW_Config.h"
+#include "GW_GeodesicMesh.h"
+
+namespace GW {
+
+/*------------------------------------------------------------------------------*/
+/**
+ *  \class  GW_GeodesicMarcher
+ *  \brief  Fast marching on a shared, read-only \c GW_GeodesicMesh.
+ *
+ *  Same propagation as \c GW_GeodesicMesh::PerformFastMarching, but the
+ *  distance, state, front and heap of the vertices are kept in buffers
+ *  owned by the marcher instead of in the vertices. The mesh is only used
+ *  for its geometry and connectivity, so several marchers (e.g. one per
+ *  thread) can propagate on the same mesh at the same time.
+ *
+ *  Only the vertices reached by the last propagation are reset, so a
+ *  marcher can be reused for many local propagations at no O(n) cost.
+ */
+/*------------------------------------------------------------------------------*/
+
+class GW_GeodesicMarcher
+{
+
+public:
+
+    /*------------------------------------------------------------------------------*/
+    /** \name Constructor and destructor */
+    /*------------------------------------------------------------------------------*/
+    //@{
+    GW_GeodesicMarcher( GW_GeodesicMesh& Mesh );
+    virtual ~GW_GeodesicMarcher();
+    //@}
+
+    //-------------------------------------------------------------------------
+    /** \name Propagation parameters. */
+    //-------------------------------------------------------------------------
+    //@{
+	void SetWeight( const GW_Float* pWeight );
+	void SetConstraint( const GW_Float* pConstraint );
+	void SetMaxDistance( GW_Float rMaxDistance );
+	void SetMaxIteration( GW_U32 nMaxIteration );
+	void SetEndVertex( const T_U32Vector& EndVertex, GW_U32 nNbrEndVertexStop = 1 );
+	GW_U32 GetNbrEndVertexReached();
+	void SetUseHeapRebuild( GW_Bool bUseHeapRebuild );
+	GW_Bool GetUseHeapRebuild();
+    //@}
+
+    //-------------------------------------------------------------------------
+    /** \name Fast marching computations. */
+    //-------------------------------------------------------------------------
+	//@{
+	void ResetMarcher();
+	void AddStartVertex( GW_U32 nID, GW_Float rDistance = 0 );
+	void PerformFastMarching();
+    //@}
+
+    //-------------------------------------------------------------------------
+    /** \name Accessors. */
+    //-------------------------------------------------------------------------
+    //@{
+	GW_Float GetDistance( GW_U32 nID );
+	GW_GeodesicVertex::T_GeodesicVertexState GetState( GW_U32 nID );
+	GW_I32 GetFront( GW_U32 nID );
+	T_U32Vector& GetReachedVertex();
+	GW_U32 GetNbrVertex();
+    //@}
+
+private:
+
+	GW_Float ComputeVertexDistance( GW_GeodesicFace& CurrentFace, GW_GeodesicVertex& CurrentVertex,
+									GW_GeodesicVertex& Vert1, GW_GeodesicVertex& Vert2, GW_I32 nCurrentFront );
+	GW_Bool InsertVertex( GW_U32 nID, GW_Float rNewDistance );
+	GW_Bool StopMarching( GW_U32 nID );
+
+    //-------------------------------------------------------------------------
+    /** \name Heap of alive vertices. */
+    //-------------------------------------------------------------------------
+    //@{
+	void HeapPush( GW_U32 nID );
+	GW_U32 HeapPop();
+	void HeapSiftUp( GW_U32 nPos );
+	void HeapSiftDown( GW_U32 nPos );
+	void HeapMakeHeap();
+    //@}
+
+	/** the mesh, never modified */
+	GW_GeodesicMesh& Mesh_;
+
+	/** per vertex data, indexed by vertex ID */
+	T_FloatVector Distance_;
+	std::vector<GW_GeodesicVertex::T_GeodesicVertexState> State_;
+	std::vector<GW_I32> Front_;
+	std::vector<GW_I32> HeapPosition_;
+	/** binary heap of the alive vertices IDs */
+	T_U32Vector Heap_;
+	/** vertices that are not far anymore, to reset them */
+	T_U32Vector ReachedVertex_;
+
+	/** metric, one value per vertex (NULL for a constant metric) */
+	const GW_Float* pWeight_;
+	/** a vertex is inserted only if its distance is smaller than this bound (can be NULL) */
+	const GW_Float* pConstraint_;
+	GW_Float rMaxDistance_;
+	/** maximum number of insertion tries */
+	GW_U32 nMaxIteration_;
+	GW_U32 nNbrIteration_;
+	/** the propagation stops when nNbrEndVertexStop_ of these vertices are dead */
+	T_U32Vector EndVertex_;
+	/** one flag per vertex, so that the stop test is O(1) */
+	std::vector<bool> IsEndVertex_;
+	GW_U32 nNbrEndVertexStop_;
+	GW_U32 nNbrEndVertexReached_;
+	/** rebuild the whole heap when an alive vertex is updated (former behavior, kept for benchmarking) */
+	GW_Bool bUseHeapRebuild_;
+
+};
+
+} // End namespace GW
+
+#ifdef GW_USE_INLINE
+    #include "GW_GeodesicMarcher.inl"
+#endif
+
+
+#endif // _GW_GEODESICMARCHER_H_
+
+
+///////////////////////////////////////////////////////////////////////////////
+//                               END OF FILE                                 //
+///////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,483 @@
+/*------------------------------------------------------------------------------*/
+/**
+ *  \file   GW_GeodesicMarcher.inl
+ *  \brief  Inlined methods for \c GW_GeodesicMarcher
+ */
+/*------------------------------------------------------------------------------*/
+
+#include "GW_GeodesicMarcher.h"
+
+namespace GW {
+
+/*------------------------------------------------------------------------------*/
+// Name : GW_GeodesicMarcher constructor
+/**
+ *  \param  Mesh [GW_GeodesicMesh&] The mesh, with its connectivity already built.
+ *
+ *  Constructor. Allocate the per vertex buffers.
+ */
+/*------------------------------------------------------------------------------*/
+GW_INLINE
+GW_GeodesicMarcher::GW_GeodesicMarcher( GW_GeodesicMesh& Mesh )
+:	Mesh_			( Mesh ),
+	Distance_		( Mesh.GetNbrVertex(), GW_INFINITE ),
+	State_			( Mesh.GetNbrVertex(), GW_GeodesicVertex::kFar ),
+	Front_			( Mesh.GetNbrVertex(), -1 ),
+	HeapPosition_	( Mesh.GetNbrVertex(), -1 ),
+	pWeight_		( NULL ),
+	pConstraint_	( NULL ),
+	rMaxDistance_	( GW_INFINITE ),
+	nMaxIteration_	( Mesh.GetNbrVertex() ),
+	nNbrIteration_	( 0 ),
+	IsEndVertex_	( Mesh.GetNbrVertex(), false ),
+	nNbrEndVertexStop_		( 0 ),
+	nNbrEndVertexReached_	( 0 ),
+	bUseHeapRebuild_		( GW_False )
+{
+	/* NOTHING */
+}
+
+/*------------------------------------------------------------------------------*/
+// Name : GW_GeodesicMarcher destructor
+/**
+ *  Destructor.
+ */
+/*------------------------------------------------------------------------------*/
+GW_INLINE
+GW_GeodesicMarcher::~GW_GeodesicMarcher()
+{
+	/* NOTHING */
+}
+
+/*------------------------------------------------------------------------------*/
+// Name : GW_GeodesicMarcher::SetWeight
+/**
+ *  \param  pWeight [const GW_Float*] One value per vertex, NULL for the constant metric 1.
+ *
+ *  Set the metric on the mesh (inverse of the speed). The array is not copied.
+ */
+/*------------------------------------------------------------------------------*/
+GW_INLINE
+void GW_GeodesicMarcher::SetWeight( const GW_Float* pWeight )
+{
+	pWeight_ = pWeight;
+}
+
+/*------------------------------------------------------------------------------*/
+// Name : GW_GeodesicMarcher::SetConstraint
+/**
+ *  \param  pConstraint [const GW_Float*] One value per vertex, or NULL.
+ *
+ *  Only vertices whose new distance is smaller than their constraint are
+ *  inserted in the front. The array is not copied.
+ */
+/*------------------------------------------------------------------------------*/
+GW_INLINE
+void GW_GeodesicMarcher::SetConstraint( const GW_Float* pConstraint )
+{
+	pConstraint_ = pConstraint;
+}
+
+/*------------------------------------------------------------------------------*/
+// Name : GW_GeodesicMarcher::SetMaxDistance
+/**
+ *  \param  rMaxDistance [GW_Float] The distance.
+ *
+ *  Stop the propagation once a vertex farther than this dies.
+ */
+/*------------------------------------------------------------------------------*/
+GW_INLINE
+void GW_GeodesicMarcher::SetMaxDistance( GW_Float rMaxDistance )
+{
+	rMaxDistance_ = rMaxDistance;
+}
+
+/*------------------------------------------------------------------------------*/
+// Name : GW_GeodesicMarcher::SetMaxIteration
+/**
+ *  \param  nMaxIteration [GW_U32] The number of iterations.
+ *
+ *  Stop inserting new vertices in the front after this number of tries.
+ */
+/*------------------------------------------------------------------------------*/
+GW_INLINE
+void GW_GeodesicMarcher::SetMaxIteration( GW_U32 nMaxIteration )
+{
+	nMaxIteration_ = nMaxIteration;
+}
+
+/*------------------------------------------------------------------------------*/
+// Name : GW_GeodesicMarcher::SetEndVertex
+/**
+ *  \param  EndVertex [T_U32Vector&] IDs of the end vertices.
+ *  \param  nNbrEndVertexStop [GW_U32] How many of them must be reached.
+ *
+ *  Stop the propagation as soon as \c nNbrEndVertexStop distinct end vertices
+ *  are dead : 1 for the first hit, the number of end vertices (or more) to
+ *  wait for all of them. Duplicated IDs are counted once.
+ */
+/*------------------------------------------------------------------------------*/
+GW_INLINE
+void GW_GeodesicMarcher::SetEndVertex( const T_U32Vector& EndVertex, GW_U32 nNbrEndVertexStop )
+{
+	for( IT_U32Vector it=EndVertex_.begin(); it!=EndVertex_.end(); ++it )
+		IsEndVertex_[*it] = false;
+	EndVertex_.clear();
+	for( CIT_U32Vector it=EndVertex.begin(); it!=EndVertex.end(); ++it )
+	{
+		GW_ASSERT( *it<IsEndVertex_.size() );
+		if( !IsEndVertex_[*it] )
+		{
+			IsEndVertex_[*it] = true;
+			EndVertex_.push_back( *it );
+		}
+	}
+	nNbrEndVertexStop_ = GW_MIN( nNbrEndVertexStop, (GW_U32) EndVertex_.size() );
+}
+
+/*------------------------------------------------------------------------------*/
+// Name : GW_GeodesicMarcher::GetNbrEndVertexReached
+/**
+ *  \return [GW_U32] Number of distinct end vertices dead during the last propagation.
+ */
+/*------------------------------------------------------------------------------*/
+GW_INLINE
+GW_U32 GW_GeodesicMarcher::GetNbrEndVertexReached()
+{
+	return nNbrEndVertexReached_;
+}
+
+/*------------------------------------------------------------------------------*/
+// Name : GW_GeodesicMarcher::SetUseHeapRebuild
+/**
+ *  \param  bUseHeapRebuild [GW_Bool] Use it or not ?
+ *
+ *  Rebuild the whole heap each time an alive vertex is updated, as
+ *  \c GW_GeodesicMesh::SetUseHeapRebuild. Only useful for benchmarking.
+ */
+/*------------------------------------------------------------------------------*/
+GW_INLINE
+void GW_GeodesicMarcher::SetUseHeapRebuild( GW_Bool bUseHeapRebuild )
+{
+	bUseHeapRebuild_ = bUseHeapRebuild;
+}
+
+/*------------------------------------------------------------------------------*/
+// Name : GW_GeodesicMarcher::GetUseHeapRebuild
+/**
+ *  \return [GW_Bool] Is the whole heap rebuilt each time an alive vertex is updated ?
+ */
+/*------------------------------------------------------------------------------*/
+GW_INLINE
+GW_Bool GW_GeodesicMarcher::GetUseHeapRebuild()
+{
+	return bUseHeapRebuild_;
+}
+
+/*------------------------------------------------------------------------------*/
+// Name : GW_GeodesicMarcher::GetDistance
+/**
+ *  \param  nID [GW_U32] ID of the vertex.
+ *  \return [GW_Float] Distance computed by the last propagation.
+ */
+/*------------------------------------------------------------------------------*/
+GW_INLINE
+GW_Float GW_GeodesicMarcher::GetDistance( GW_U32 nID )
+{
+	GW_ASSERT( nID<Distance_.size() );
+	return Distance_[nID];
+}
+
+/*------------------------------------------------------------------------------*/
+// Name : GW_GeodesicMarcher::GetState
+/**
+ *  \param  nID [GW_U32] ID of the vertex.
+ *  \return [T_GeodesicVertexState] State at the end of the last propagation.
+ */
+/*------------------------------------------------------------------------------*/
+GW_INLINE
+GW_GeodesicVertex::T_GeodesicVertexState GW_GeodesicMarcher::GetState( GW_U32 nID )
+{
+	GW_ASSERT( nID<State_.size() );
+	return State_[nID];
+}
+
+/*------------------------------------------------------------------------------*/
+// Name : GW_GeodesicMarcher::GetFront
+/**
+ *  \param  nID [GW_U32] ID of the vertex.
+ *  \return [GW_I32] ID of the start vertex of the front that reached it, -1 if none.
+ */
+/*------------------------------------------------------------------------------*/
+GW_INLINE
+GW_I32 GW_GeodesicMarcher::GetFront( GW_U32 nID )
+{
+	GW_ASSERT( nID<Front_.size() );
+	return Front_[nID];
+}
+
+/*------------------------------------------------------------------------------*/
+// Name : GW_GeodesicMarcher::GetReachedVertex
+/**
+ *  \return [T_U32Vector&] IDs of the vertices that are not far.
+ *
+ *  The vertices reached by the last propagation, in the order they were
+ *  reached. Avoid scanning the whole mesh after a local propagation.
+ */
+/*------------------------------------------------------------------------------*/
+GW_INLINE
+T_U32Vector& GW_GeodesicMarcher::GetReachedVertex()
+{
+	return ReachedVertex_;
+}
+
+/*------------------------------------------------------------------------------*/
+// Name : GW_GeodesicMarcher::GetNbrVertex
+/**
+ *  \return [GW_U32] Number of vertices of the mesh.
+ */
+/*------------------------------------------------------------------------------*/
+GW_INLINE
+GW_U32 GW_GeodesicMarcher::GetNbrVertex()
+{
+	return (GW_U32) Distance_.size();
+}
+
+/*------------------------------------------------------------------------------*/
+// Name : GW_GeodesicMarcher::AddStartVertex
+/**
+ *  \param  nID [GW_U32] ID of the vertex.
+ *  \param  rDistance [GW_Float] Initial distance.
+ *
+ *  Add a new starting point for the next propagation.
+ */
+/*------------------------------------------------------------------------------*/
+GW_INLINE
+void GW_GeodesicMarcher::AddStartVertex( GW_U32 nID, GW_Float rDistance )
+{
+	GW_ASSERT( nID<Distance_.size() );
+	if( State_[nID]==GW_GeodesicVertex::kFar )
+		ReachedVertex_.push_back( nID );
+	Distance_[nID] = rDistance;
+	State_[nID] = GW_GeodesicVertex::kAlive;
+	Front_[nID] = (GW_I32) nID;
+	if( HeapPosition_[nID]<0 )
+		this->HeapPush( nID );
+	else
+	{
+		/* the start distance can be anything : move it both ways */
+		this->HeapSiftUp( (GW_U32) HeapPosition_[nID] );
+		this->HeapSiftDown( (GW_U32) HeapPosition_[nID] );
+	}
+}
+
+/*------------------------------------------------------------------------------*/
+// Name : GW_GeodesicMarcher::InsertVertex
+/**
+ *  \param  nID [GW_U32] ID of a far vertex.
+ *  \param  rNewDistance [GW_Float] Its tentative distance.
+ *  \return [GW_Bool] Should the vertex join the front ?
+ */
+/*------------------------------------------------------------------------------*/
+GW_INLINE
+GW_Bool GW_GeodesicMarcher::InsertVertex( GW_U32 nID, GW_Float rNewDistance )
+{
+	GW_Bool bInsert = nNbrIteration_<=nMaxIteration_;
+	if( pConstraint_!=NULL )
+		bInsert = bInsert && ( rNewDistance<pConstraint_[nID] );
+	nNbrIteration_++;
+	return bInsert;
+}
+
+/*------------------------------------------------------------------------------*/
+// Name : GW_GeodesicMarcher::StopMarching
+/**
+ *  \param  nID [GW_U32] ID of the vertex that just died.
+ *  \return [GW_Bool] Should the propagation stop ?
+ */
+/*------------------------------------------------------------------------------*/
+GW_INLINE
+GW_Bool GW_GeodesicMarcher::StopMarching( GW_U32 nID )
+{
+	if( Distance_[nID]>rMaxDistance_ )
+		return GW_True;
+	if( IsEndVertex_[nID] )
+	{
+		nNbrEndVertexReached_++;
+		if( nNbrEndVertexReached_>=nNbrEndVertexStop_ )
+			return GW_True;
+	}
+	return GW_False;
+}
+
+/*------------------------------------------------------------------------------*/
+// Name : GW_GeodesicMarcher::ComputeVertexDistance
+/**
+ *  \param  CurrentFace [GW_GeodesicFace&] The face used for the update.
+ *  \param  CurrentVertex [GW_GeodesicVertex&] The vertex to update.
+ *  \param  Vert1 [GW_GeodesicVertex&] It's 1st neighbor.
+ *  \param  Vert2 [GW_GeodesicVertex&] 2nd vertex.
+ *  \param  nCurrentFront [GW_I32] The front that is propagating.
+ *  \return The value of the distance according to this triangle contribution.
+ *
+ *  Same as \c GW_GeodesicMesh::ComputeVertexDistance, reading the marcher buffers.
+ */
+/*------------------------------------------------------------------------------*/
+GW_INLINE
+GW_Float GW_GeodesicMarcher::ComputeVertexDistance( GW_GeodesicFace& CurrentFace, GW_GeodesicVertex& CurrentVertex,
+													GW_GeodesicVertex& Vert1, GW_GeodesicVertex& Vert2, GW_I32 nCurrentFront )
+{
+	GW_U32 nCur = CurrentVertex.GetID();
+	GW_U32 n1 = Vert1.GetID();
+	GW_U32 n2 = Vert2.GetID();
+	GW_Float F = pWeight_!=NULL ? pWeight_[nCur] : 1;
+
+	GW_Bool bVert1Usable = State_[n1]!=GW_GeodesicVertex::kFar && Front_[n1]==nCurrentFront;
+	GW_Bool bVert2Usable = State_[n2]!=GW_GeodesicVertex::kFar && Front_[n2]==nCurrentFront;
+	if( !bVert1Usable && !bVert2Usable )
+		return GW_INFINITE;
+
+	GW_Vector3D Edge1 = Vert1.GetPosition() - CurrentVertex.GetPosition();
+	GW_Float b = Edge1.Norm();
+	Edge1 /= b;
+	GW_Vector3D Edge2 = Vert2.GetPosition() - CurrentVertex.GetPosition();
+	GW_Float a = Edge2.Norm();
+	Edge2 /= a;
+
+	GW_Float d1 = Distance_[n1];
+	GW_Float d2 = Distance_[n2];
+
+	/* only one point is a contributor */
+	if( !bVert1Usable )
+		return d2 + a * F;
+	if( !bVert2Usable )
+		return d1 + b * F;
+
+	GW_Float dot = Edge1*Edge2;
+
+	/* first special case for obtuse angles */
+	if( dot<0 && GW_GeodesicMesh::bUseUnfolding_ )
+	{
+		GW_Float c, dot1, dot2;
+		GW_GeodesicVertex* pVert = GW_GeodesicMesh::UnfoldTriangle( CurrentFace, CurrentVertex, Vert1, Vert2, c, dot1, dot2 );
+		if( pVert!=NULL && State_[pVert->GetID()]!=GW_GeodesicVertex::kFar )
+		{
+			GW_Float d3 = Distance_[pVert->GetID()];
+			/* use the unfolded value */
+			GW_Float t = GW_GeodesicMesh::ComputeUpdate_SethianMethod( d1, d3, c, b, dot1, F );
+			return GW_MIN( t, GW_GeodesicMesh::ComputeUpdate_SethianMethod( d3, d2, a, c, dot2, F ) );
+		}
+	}
+
+	return GW_GeodesicMesh::ComputeUpdate_SethianMethod( d1, d2, a, b, dot, F );
+}
+
+/*------------------------------------------------------------------------------*/
+// Name : GW_GeodesicMarcher::HeapPush
+/**
+ *  \param  nID [GW_U32] ID of the vertex to add.
+ */
+/*------------------------------------------------------------------------------*/
+GW_INLINE
+void GW_GeodesicMarcher::HeapPush( GW_U32 nID )
+{
+	HeapPosition_[nID] = (GW_I32) Heap_.size();
+	Heap_.push_back( nID );
+	this->HeapSiftUp( (GW_U32) Heap_.size()-1 );
+}
+
+/*------------------------------------------------------------------------------*/
+// Name : GW_GeodesicMarcher::HeapPop
+/**
+ *  \return [GW_U32] ID of the alive vertex with the smallest distance.
+ */
+/*------------------------------------------------------------------------------*/
+GW_INLINE
+GW_U32 GW_GeodesicMarcher::HeapPop()
+{
+	GW_ASSERT( !Heap_.empty() );
+	GW_U32 nTop = Heap_.front();
+	GW_U32 nLast = Heap_.back();
+	Heap_.pop_back();
+	HeapPosition_[nTop] = -1;
+	if( !Heap_.empty() )
+	{
+		Heap_[0] = nLast;
+		HeapPosition_[nLast] = 0;
+		this->HeapSiftDown( 0 );
+	}
+	return nTop;
+}
+
+/*------------------------------------------------------------------------------*/
+// Name : GW_GeodesicMarcher::HeapSiftUp
+/**
+ *  \param  nPos [GW_U32] Position in the heap of the vertex to move.
+ */
+/*------------------------------------------------------------------------------*/
+GW_INLINE
+void GW_GeodesicMarcher::HeapSiftUp( GW_U32 nPos )
+{
+	GW_U32 nID = Heap_[nPos];
+	while( nPos>0 )
+	{
+		GW_U32 nParent = (nPos-1)/2;
+		if( !(Distance_[Heap_[nParent]]>Distance_[nID]) )
+			break;
+		Heap_[nPos] = Heap_[nParent];
+		HeapPosition_[Heap_[nPos]] = (GW_I32) nPos;
+		nPos = nParent;
+	}
+	Heap_[nPos] = nID;
+	HeapPosition_[nID] = (GW_I32) nPos;
+}
+
+/*------------------------------------------------------------------------------*/
+// Name : GW_GeodesicMarcher::HeapSiftDown
+/**
+ *  \param  nPos [GW_U32] Position in the heap of the vertex to move.
+ */
+/*------------------------------------------------------------------------------*/
+GW_INLINE
+void GW_GeodesicMarcher::HeapSiftDown( GW_U32 nPos )
+{
+	GW_U32 nSize = (GW_U32) Heap_.size();
+	GW_U32 nID = Heap_[nPos];
+	while( 2*nPos+1<nSize )
+	{
+		GW_U32 nChild = 2*nPos+1;
+		if( nChild+1<nSize && Distance_[Heap_[nChild]]>Distance_[Heap_[nChild+1]] )
+			nChild++;
+		if( !(Distance_[nID]>Distance_[Heap_[nChild]]) )
+			break;
+		Heap_[nPos] = Heap_[nChild];
+		HeapPosition_[Heap_[nPos]] = (GW_I32) nPos;
+		nPos = nChild;
+	}
+	Heap_[nPos] = nID;
+	HeapPosition_[nID] = (GW_I32) nPos;
+}
+
+/*------------------------------------------------------------------------------*/
+// Name : GW_GeodesicMarcher::HeapMakeHeap
+/**
+ *  Rebuild the whole heap, only used when \c SetUseHeapRebuild asks for
+ *  the former behavior (benchmarking).
+ */
+/*------------------------------------------------------------------------------*/
+GW_INLINE
+void GW_GeodesicMarcher::HeapMakeHeap()
+{
+	GW_U32 nSize = (GW_U32) Heap_.size();
+	for( GW_U32 i=0; i<nSize; ++i )
+		HeapPosition_[Heap_[i]] = (GW_I32) i;
+	for( GW_U32 i=nSize/2; i>0; --i )
+		this->HeapSiftDown( i-1 );
+}
+
+} // End namespace GW
+
+
+///////////////////////////////////////////////////////////////////////////////
+//                               END OF FILE                                 //
+///////////////////////////////////////////////////////////////////////////////
@@ -78,8 +78,8 @@ void GW_GeodesicMesh::PerformFastMarching( GW_GeodesicVertex* pStartVertex )
 	
 	this->SetUpFastMarching( pStartVertex );
 
-	// first time : set up the heap
-	std::make_heap( ActiveVertex_.begin(), ActiveVertex_.end(), GW_GeodesicVertex::CompareVertex );
+	// first time : set up the heap (the distance of the start vertices may have been changed)
+	this->ActiveVertexMakeHeap();
 	/* main loop */
 	while( !this->PerformFastMarchingOneStep() )
 	{ }
@@ -102,7 +102,7 @@ void GW_GeodesicMesh::SetUpFastMarching( GW_GeodesicVertex* pStartVertex )
 	if( pStartVertex!=NULL )
 		this->AddStartVertex( *pStartVertex );
 
-	std::make_heap( ActiveVertex_.begin(), ActiveVertex_.end(), GW_GeodesicVertex::CompareVertex );
+	this->ActiveVertexMakeHeap();
 
 	bIsMarchingBegin_ = GW_True;
 	bIsMarchingEnd_ = GW_False;
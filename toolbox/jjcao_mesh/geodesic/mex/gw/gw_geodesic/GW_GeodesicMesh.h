@@ -69,6 +69,8 @@ public:
 
 	void SetUseUnfolding( GW_Bool bUseUnfolding );
 	GW_Bool GetUseUnfolding( );
+	void SetUseHeapRebuild( GW_Bool bUseHeapRebuild );
+	GW_Bool GetUseHeapRebuild( );
 
     //-------------------------------------------------------------------------
     /** \name Callback management. */
@@ -94,7 +96,8 @@ public:
 protected:
 
 	/** should be filled with the starting point of the marching before
-	    calling PerformFastMarching */
+	    calling PerformFastMarching. This is a binary heap, each vertex
+	    stores its position in it so that its distance can be decreased in place. */
 	T_GeodesicVertexVector ActiveVertex_;
 
 	/** a function that specify the metric on the mesh */
@@ -115,6 +118,9 @@ protected:
 
 private:
 
+	/** shares the update rules of the fast marching */
+	friend class GW_GeodesicMarcher;
+
 	GW_Float ComputeVertexDistance( GW_GeodesicFace& CurrentFace, GW_GeodesicVertex& CurrentVertex, 
 									GW_GeodesicVertex& Vert1, GW_GeodesicVertex& Vert2, GW_GeodesicVertex& CurrentFront );
 
@@ -123,8 +129,22 @@ private:
 	static GW_Float ComputeUpdate_SethianMethod( GW_Float d1, GW_Float d2, GW_Float a, GW_Float b, GW_Float dot, GW_Float F );
 	static GW_Float ComputeUpdate_MatrixMethod( GW_Float d1, GW_Float d2, GW_Float a, GW_Float b, GW_Float dot, GW_Float F );
 
+    //-------------------------------------------------------------------------
+    /** \name Heap of alive vertices. */
+    //-------------------------------------------------------------------------
+    //@{
+	void ActiveVertexPush( GW_GeodesicVertex& Vert );
+	GW_GeodesicVertex* ActiveVertexPop();
+	void ActiveVertexDecreaseKey( GW_GeodesicVertex& Vert );
+	void ActiveVertexMakeHeap();
+	void ActiveVertexSiftUp( GW_U32 nPos );
+	void ActiveVertexSiftDown( GW_U32 nPos );
+    //@}
+
 	/** Do we use unfolding to correct problem with non acute angles ? */
 	static GW_Bool bUseUnfolding_;
+	/** Do we rebuild the whole heap when an alive vertex is updated (former behavior, kept for benchmarking) ? */
+	GW_Bool bUseHeapRebuild_;
 
 };
 
@@ -29,7 +29,8 @@ GW_GeodesicMesh::GW_GeodesicMesh()
 	NewDeadVertexCallback_		( NULL ),
 	HeuristicToGoalCallbackFunction_	( NULL ),
 	bIsMarchingBegin_			( GW_False ),
-	bIsMarchingEnd_				( GW_False )
+	bIsMarchingEnd_				( GW_False ),
+	bUseHeapRebuild_			( GW_False )
 {
 	/* NOTHING */
 }
@@ -99,7 +100,10 @@ void GW_GeodesicMesh::AddStartVertex( GW_GeodesicVertex& StartVert )
 	StartVert.SetFront( &StartVert );
 	StartVert.SetDistance(0);
 	StartVert.SetState( GW_GeodesicVertex::kAlive );
-	ActiveVertex_.push_back( &StartVert );
+	if( StartVert.GetHeapPosition()<0 )
+		this->ActiveVertexPush( StartVert );
+	else
+		this->ActiveVertexDecreaseKey( StartVert );
 }
 
 /*------------------------------------------------------------------------------*/
@@ -191,10 +195,8 @@ GW_Bool GW_GeodesicMesh::PerformFastMarchingOneStep()
 	GW_ASSERT( bIsMarchingBegin_ );
 //	std::make_heap( ActiveVertex_.begin(), ActiveVertex_.end(), GW_GeodesicVertex::CompareVertex );
 	
-	GW_GeodesicVertex* pCurVert = ActiveVertex_.front();
+	GW_GeodesicVertex* pCurVert = this->ActiveVertexPop();
 	GW_ASSERT( pCurVert!=NULL );
-	std::pop_heap( ActiveVertex_.begin(), ActiveVertex_.end(), GW_GeodesicVertex::CompareVertex );
-	ActiveVertex_.pop_back();
 	pCurVert->SetState( GW_GeodesicVertex::kDead );
 
 	if( NewDeadVertexCallback_!=NULL )
@@ -244,8 +246,7 @@ GW_Bool GW_GeodesicMesh::PerformFastMarchingOneStep()
 				{
 					pNewVert->SetDistance( rNewDistance );
 					/* add the vertex to the heap */
-					ActiveVertex_.push_back( pNewVert );
-					std::push_heap( ActiveVertex_.begin(), ActiveVertex_.end(), GW_GeodesicVertex::CompareVertex );
+					this->ActiveVertexPush( *pNewVert );
 					/* this one can be added to the heap */
 					pNewVert->SetState( GW_GeodesicVertex::kAlive );
 					pNewVert->SetFront( pCurVert->GetFront() );
@@ -260,8 +261,11 @@ GW_Bool GW_GeodesicMesh::PerformFastMarchingOneStep()
 						pNewVert->GetFrontOverlapInfo().RecordOverlap( *pNewVert->GetFront(), pNewVert->GetDistance() );
 					pNewVert->SetDistance( rNewDistance );
 					pNewVert->SetFront( pCurVert->GetFront() );
-					// hum, check if we can correct this (avoid recomputing the whole heap).
-					std::make_heap( ActiveVertex_.begin(), ActiveVertex_.end(), GW_GeodesicVertex::CompareVertex );
+					/* the distance can only decrease : move the vertex up in the heap */
+					if( bUseHeapRebuild_ )
+						this->ActiveVertexMakeHeap();
+					else
+						this->ActiveVertexDecreaseKey( *pNewVert );
 				}
 				else
 				{
@@ -290,6 +294,135 @@ GW_Bool GW_GeodesicMesh::PerformFastMarchingOneStep()
 	return bIsMarchingEnd_;
 }
 
+/*------------------------------------------------------------------------------*/
+// Name : GW_GeodesicMesh::ActiveVertexPush
+/**
+ *  \param  Vert [GW_GeodesicVertex&] The vertex to add.
+ * 
+ *  Add a vertex to the heap of alive vertices, O(log n).
+ */
+/*------------------------------------------------------------------------------*/
+GW_INLINE
+void GW_GeodesicMesh::ActiveVertexPush( GW_GeodesicVertex& Vert )
+{
+	GW_ASSERT( Vert.GetHeapPosition()<0 );
+	Vert.SetHeapPosition( (GW_I32) ActiveVertex_.size() );
+	ActiveVertex_.push_back( &Vert );
+	this->ActiveVertexSiftUp( (GW_U32) ActiveVertex_.size()-1 );
+}
+
+/*------------------------------------------------------------------------------*/
+// Name : GW_GeodesicMesh::ActiveVertexPop
+/**
+ *  \return [GW_GeodesicVertex*] The vertex with the smallest distance.
+ * 
+ *  Remove the top of the heap of alive vertices, O(log n).
+ */
+/*------------------------------------------------------------------------------*/
+GW_INLINE
+GW_GeodesicVertex* GW_GeodesicMesh::ActiveVertexPop()
+{
+	GW_ASSERT( !ActiveVertex_.empty() );
+	GW_GeodesicVertex* pTop = ActiveVertex_.front();
+	GW_GeodesicVertex* pLast = ActiveVertex_.back();
+	ActiveVertex_.pop_back();
+	pTop->SetHeapPosition( -1 );
+	if( !ActiveVertex_.empty() )
+	{
+		ActiveVertex_[0] = pLast;
+		pLast->SetHeapPosition( 0 );
+		this->ActiveVertexSiftDown( 0 );
+	}
+	return pTop;
+}
+
+/*------------------------------------------------------------------------------*/
+// Name : GW_GeodesicMesh::ActiveVertexDecreaseKey
+/**
+ *  \param  Vert [GW_GeodesicVertex&] A vertex of the heap whose distance has decreased.
+ * 
+ *  Restore the heap after the distance of a vertex has decreased, O(log n).
+ */
+/*------------------------------------------------------------------------------*/
+GW_INLINE
+void GW_GeodesicMesh::ActiveVertexDecreaseKey( GW_GeodesicVertex& Vert )
+{
+	GW_ASSERT( Vert.GetHeapPosition()>=0 );
+	this->ActiveVertexSiftUp( (GW_U32) Vert.GetHeapPosition() );
+}
+
+/*------------------------------------------------------------------------------*/
+// Name : GW_GeodesicMesh::ActiveVertexMakeHeap
+/**
+ *  Rebuild the whole heap, O(n). Needed when the distance of alive 
+ *  vertices has been modified from outside (e.g. initial values).
+ */
+/*------------------------------------------------------------------------------*/
+GW_INLINE
+void GW_GeodesicMesh::ActiveVertexMakeHeap()
+{
+	GW_U32 nSize = (GW_U32) ActiveVertex_.size();
+	for( GW_U32 i=0; i<nSize; ++i )
+		ActiveVertex_[i]->SetHeapPosition( (GW_I32) i );
+	for( GW_U32 i=nSize/2; i>0; --i )
+		this->ActiveVertexSiftDown( i-1 );
+}
+
+/*------------------------------------------------------------------------------*/
+// Name : GW_GeodesicMesh::ActiveVertexSiftUp
+/**
+ *  \param  nPos [GW_U32] Position of the vertex to move.
+ * 
+ *  Move a vertex toward the top of the heap until its parent is closer.
+ */
+/*------------------------------------------------------------------------------*/
+GW_INLINE
+void GW_GeodesicMesh::ActiveVertexSiftUp( GW_U32 nPos )
+{
+	GW_GeodesicVertex* pVert = ActiveVertex_[nPos];
+	while( nPos>0 )
+	{
+		GW_U32 nParent = (nPos-1)/2;
+		GW_GeodesicVertex* pParent = ActiveVertex_[nParent];
+		if( !GW_GeodesicVertex::CompareVertex( pParent, pVert ) )
+			break;
+		ActiveVertex_[nPos] = pParent;
+		pParent->SetHeapPosition( (GW_I32) nPos );
+		nPos = nParent;
+	}
+	ActiveVertex_[nPos] = pVert;
+	pVert->SetHeapPosition( (GW_I32) nPos );
+}
+
+/*------------------------------------------------------------------------------*/
+// Name : GW_GeodesicMesh::ActiveVertexSiftDown
+/**
+ *  \param  nPos [GW_U32] Position of the vertex to move.
+ * 
+ *  Move a vertex toward the bottom of the heap until its children are farther.
+ */
+/*------------------------------------------------------------------------------*/
+GW_INLINE
+void GW_GeodesicMesh::ActiveVertexSiftDown( GW_U32 nPos )
+{
+	GW_U32 nSize = (GW_U32) ActiveVertex_.size();
+	GW_GeodesicVertex* pVert = ActiveVertex_[nPos];
+	while( 2*nPos+1<nSize )
+	{
+		GW_U32 nChild = 2*nPos+1;
+		if( nChild+1<nSize && GW_GeodesicVertex::CompareVertex( ActiveVertex_[nChild], ActiveVertex_[nChild+1] ) )
+			nChild++;
+		GW_GeodesicVertex* pChild = ActiveVertex_[nChild];
+		if( !GW_GeodesicVertex::CompareVertex( pVert, pChild ) )
+			break;
+		ActiveVertex_[nPos] = pChild;
+		pChild->SetHeapPosition( (GW_I32) nPos );
+		nPos = nChild;
+	}
+	ActiveVertex_[nPos] = pVert;
+	pVert->SetHeapPosition( (GW_I32) nPos );
+}
+
 /*------------------------------------------------------------------------------*/
 // Name : GW_GeodesicMesh::ComputeVertexDistance
 /**
@@ -723,6 +856,37 @@ GW_Bool GW_GeodesicMesh::GetUseUnfolding()
 
 
 
+/*------------------------------------------------------------------------------*/
+// Name : GW_GeodesicMesh::SetUseHeapRebuild
+/**
+ *  \param  bUseHeapRebuild [GW_Bool] Use it or not ?
+ * 
+ *  Rebuild the whole heap each time an alive vertex is updated, 
+ *  instead of moving it in place. This was the former behavior, 
+ *  O(front size) per update : only useful for benchmarking.
+ */
+/*------------------------------------------------------------------------------*/
+GW_INLINE
+void GW_GeodesicMesh::SetUseHeapRebuild( GW_Bool bUseHeapRebuild )
+{
+	bUseHeapRebuild_ = bUseHeapRebuild;
+}
+
+/*------------------------------------------------------------------------------*/
+// Name : GW_GeodesicMesh::GetUseHeapRebuild
+/**
+ *  \return [GW_Bool] Answer.
+ * 
+ *  Is the whole heap rebuilt each time an alive vertex is updated ?
+ */
+/*------------------------------------------------------------------------------*/
+GW_INLINE
+GW_Bool GW_GeodesicMesh::GetUseHeapRebuild()
+{
+	return bUseHeapRebuild_;
+}
+
+
 } // End namespace GW
 
 
@@ -59,6 +59,8 @@ public:
 	T_GeodesicVertexState GetState();
 	GW_GeodesicVertex* GetFront();
 	void SetFront( GW_GeodesicVertex* pFront );
+	GW_I32 GetHeapPosition();
+	void SetHeapPosition( GW_I32 nHeapPosition );
     //@}
 
 	void ResetGeodesicVertex();
@@ -147,6 +149,8 @@ private:
 	/** The vertex from which the front this vertex is in started.
 	    Can be \c NULL if this vertex hasn't be reached by a front. */
 	GW_GeodesicVertex* pFront_;
+	/** position of the vertex in the heap of alive vertices, -1 if it is not in the heap */
+	GW_I32 nHeapPosition_;
 
 
     //-------------------------------------------------------------------------
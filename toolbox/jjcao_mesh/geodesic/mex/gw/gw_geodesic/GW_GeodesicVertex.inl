@@ -26,6 +26,7 @@ GW_GeodesicVertex::GW_GeodesicVertex()
 	rDistance_	( GW_INFINITE ),
 	nState_		( kFar ),
 	pFront_		( NULL ),
+	nHeapPosition_	( -1 ),
 	bIsStoppingVertex_	( GW_False ),
 	bBoundaryReached_	( GW_False )
 {
@@ -145,6 +146,35 @@ void GW_GeodesicVertex::SetFront( GW_GeodesicVertex* pFront )
 }
 
 
+/*------------------------------------------------------------------------------*/
+// Name : GW_GeodesicVertex::GetHeapPosition
+/**
+ *  \return [GW_I32] Position in the heap, -1 if the vertex is not in the heap.
+ * 
+ *  Get the position of the vertex in the heap of alive vertices.
+ */
+/*------------------------------------------------------------------------------*/
+GW_INLINE
+GW_I32 GW_GeodesicVertex::GetHeapPosition()
+{
+	return nHeapPosition_;
+}
+
+/*------------------------------------------------------------------------------*/
+// Name : GW_GeodesicVertex::SetHeapPosition
+/**
+ *  \param  nHeapPosition [GW_I32] Position in the heap, -1 if removed.
+ * 
+ *  Only used by \c GW_GeodesicMesh to maintain its heap.
+ */
+/*------------------------------------------------------------------------------*/
+GW_INLINE
+void GW_GeodesicVertex::SetHeapPosition( GW_I32 nHeapPosition )
+{
+	nHeapPosition_ = nHeapPosition;
+}
+
+
 /*------------------------------------------------------------------------------*/
 // Name : GW_GeodesicVertex::CompareVertex
 /**
@@ -178,6 +208,7 @@ void GW_GeodesicVertex::ResetGeodesicVertex()
 	rDistance_	= GW_INFINITE;
 	nState_		= kFar;
 	pFront_		= NULL;
+	nHeapPosition_	= -1;
 	bIsStoppingVertex_	= GW_False;
 	FrontOverlapInfo_.Reset();
 }
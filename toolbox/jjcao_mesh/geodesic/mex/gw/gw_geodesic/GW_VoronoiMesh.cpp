@@ -28,6 +28,7 @@ T_VertexPathMultiMap GW_VoronoiMesh::BoundaryEdgeMap_;
 
 GW_U32 GW_VoronoiMesh::nNbrBaseVertex_RD_	= 0;
 T_FloatMap* GW_VoronoiMesh::pCurWeights_	= NULL;
+GW_VoronoiMesh::GW_FurthestPointCells* GW_VoronoiMesh::pCurFurthestPointCells_ = NULL;
 
 /*------------------------------------------------------------------------------*/
 // Name : GW_VoronoiMesh::PerformFastMarching
@@ -215,24 +216,46 @@ GW_Face* GW_VoronoiMesh::FindMaxFace( GW_GeodesicVertex& Vert )
 /**
  *  \param  Mesh [GW_GeodesicMesh&] The mesh.
  *  \param  nNbrIterations [GW_U32] Number of points.
+ *  \param  bIncremental [GW_Bool] Keep the Voronoi cells between two points.
  *  \author Gabriel Peyr?
  *  \date   4-14-2003
  * 
  *  Add a given number of furthest points.
+ *  In incremental mode the furthest point is taken from a heap of the cell
+ *	maxima instead of a scan of the mesh, and only the vertices re-marched by
+ *	the last point are reset, so a point costs the size of the cells it
+ *	changes. The points are the same as in the other mode.
  */
 /*------------------------------------------------------------------------------*/
-GW_U32 GW_VoronoiMesh::AddFurthestPointsIterate( T_GeodesicVertexList& VertList,GW_GeodesicMesh& Mesh, GW_U32 nNbrIterations, GW_Bool bUseRandomStartVertex, GW_Bool bUseProgressBar )
+GW_U32 GW_VoronoiMesh::AddFurthestPointsIterate( T_GeodesicVertexList& VertList,GW_GeodesicMesh& Mesh, GW_U32 nNbrIterations, GW_Bool bUseRandomStartVertex, GW_Bool bUseProgressBar, GW_Bool bIncremental )
 {
 	GW_U32 nNbrPoints = 0;
 	GW_ProgressBar pb;
 	if( bUseProgressBar )
 		pb.Begin();
+	GW_FurthestPointCells Cells;
+	GW_Bool bCellsReady = GW_False;
 	for( GW_U32 i=0; i<nNbrIterations; ++i )
 	{
-		nNbrPoints += GW_VoronoiMesh::AddFurthestPoint( VertList, Mesh, bUseRandomStartVertex );
+		if( !bIncremental || VertList.empty() )
+		{
+			nNbrPoints += GW_VoronoiMesh::AddFurthestPoint( VertList, Mesh, bUseRandomStartVertex );
+			bCellsReady = GW_False;
+		}
+		else
+		{
+			if( !bCellsReady )
+			{
+				Cells.Init( Mesh );
+				bCellsReady = GW_True;
+			}
+			nNbrPoints += GW_VoronoiMesh::AddFurthestPointIncremental( VertList, Mesh, Cells );
+		}
 		if( bUseProgressBar )
 			pb.Update(((GW_Float) i+1)/((GW_Float) nNbrIterations));
 	}
+	if( bCellsReady )
+		Cells.ResetTouchedState( Mesh );
 	if( bUseProgressBar )
 	{
 		pb.End();
@@ -241,8 +264,193 @@ GW_U32 GW_VoronoiMesh::AddFurthestPointsIterate( T_GeodesicVertexList& VertList,
 	return nNbrPoints;
 }
 
+/*------------------------------------------------------------------------------*/
+// Name : GW_VoronoiMesh::AddFurthestPointIncremental
+/**
+ *  \param  VertList [T_GeodesicVertexList&] The points, the last one is not marched yet.
+ *  \param  Mesh [GW_GeodesicMesh&] The mesh, holding the distance to the other points.
+ *  \param  Cells [GW_FurthestPointCells&] The Voronoi cells of the other points.
+ * 
+ *  Same as AddFurthestPoint for a non empty list : march from the last
+ *	point where it is nearer than the others, then add the furthest vertex.
+ */
+/*------------------------------------------------------------------------------*/
+GW_U32 GW_VoronoiMesh::AddFurthestPointIncremental( T_GeodesicVertexList& VertList, GW_GeodesicMesh& Mesh, GW_FurthestPointCells& Cells )
+{
+	Mesh.RegisterVertexInsersionCallbackFunction( GW_VoronoiMesh::FastMarchingCallbackFunction_VertexInsersion );
+	Mesh.RegisterNewDeadVertexCallbackFunction( GW_VoronoiMesh::FastMarchingCallbackFunction_FurthestPointNewDead );
+	pCurFurthestPointCells_ = &Cells;
+
+	/* perform marching */
+	Cells.ResetTouchedState( Mesh );
+	GW_GeodesicVertex* pStartVert = VertList.back();
+	GW_ASSERT( pStartVert!=NULL );
+	Mesh.PerformFastMarching( pStartVert );
+
+	GW_GeodesicVertex* pSelectedVert = Cells.FindMaxVertex( Mesh );
+	GW_ASSERT( pSelectedVert!=NULL );
+	VertList.push_back( pSelectedVert );
+
+	pCurFurthestPointCells_ = NULL;
+	Mesh.RegisterNewDeadVertexCallbackFunction( NULL );
+	Mesh.RegisterVertexInsersionCallbackFunction( NULL );
+	return 1;
+}
+
+/*------------------------------------------------------------------------------*/
+// Name : GW_VoronoiMesh::FastMarchingCallbackFunction_FurthestPointNewDead
+/**
+ *  \param  CurVert [GW_GeodesicVertex&] The vertex re-marched.
+ * 
+ *  Move the vertex to the cell of its new front.
+ */
+/*------------------------------------------------------------------------------*/
+void GW_VoronoiMesh::FastMarchingCallbackFunction_FurthestPointNewDead( GW_GeodesicVertex& CurVert )
+{
+	GW_ASSERT( pCurFurthestPointCells_!=NULL );
+	pCurFurthestPointCells_->UpdateVertex( CurVert );
+}
+
+/*------------------------------------------------------------------------------*/
+// Name : GW_VoronoiMesh::GW_FurthestPointCells::Init
+/**
+ *  \param  Mesh [GW_GeodesicMesh&] The mesh, with the distances of a marching.
+ * 
+ *  Build the cells from the front of each vertex, and reset the states.
+ */
+/*------------------------------------------------------------------------------*/
+void GW_VoronoiMesh::GW_FurthestPointCells::Init( GW_GeodesicMesh& Mesh )
+{
+	GW_U32 nNbrVertex = Mesh.GetNbrVertex();
+	VertCell_.resize( nNbrVertex );
+	VertPos_.resize( nNbrVertex );
+	CellVert_.assign( nNbrVertex+1, T_U32Vector() );
+	CellMax_.resize( nNbrVertex+1 );
+	IsDirty_.assign( nNbrVertex+1, GW_False );
+	DirtyCell_.clear();
+	Heap_ = std::priority_queue<CellMax>();
+	Touched_.clear();
+	for( GW_U32 i=0; i<nNbrVertex; ++i )
+	{
+		GW_GeodesicVertex* pVert = (GW_GeodesicVertex*) Mesh.GetVertex(i);
+		GW_ASSERT( pVert!=NULL );
+		GW_U32 nCell = this->GetCell( *pVert );
+		VertCell_[i] = nCell;
+		VertPos_[i] = (GW_U32) CellVert_[nCell].size();
+		CellVert_[nCell].push_back( i );
+		this->SetDirty( nCell );
+	}
+	GW_VoronoiMesh::ResetOnlyVertexState( Mesh );
+}
+
+/*------------------------------------------------------------------------------*/
+// Name : GW_VoronoiMesh::GW_FurthestPointCells::UpdateVertex
+/**
+ *  \param  Vert [GW_GeodesicVertex&] A vertex whose distance decreased.
+ */
+/*------------------------------------------------------------------------------*/
+void GW_VoronoiMesh::GW_FurthestPointCells::UpdateVertex( GW_GeodesicVertex& Vert )
+{
+	GW_U32 nID = Vert.GetID();
+	Touched_.push_back( nID );
+	GW_U32 nNewCell = this->GetCell( Vert );
+	GW_U32 nOldCell = VertCell_[nID];
+	if( nNewCell!=nOldCell )
+	{
+		/* remove from the old cell */
+		T_U32Vector& OldVert = CellVert_[nOldCell];
+		GW_U32 nLast = OldVert.back();
+		OldVert[VertPos_[nID]] = nLast;
+		VertPos_[nLast] = VertPos_[nID];
+		OldVert.pop_back();
+		this->SetDirty( nOldCell );
+		/* add to the new one */
+		VertCell_[nID] = nNewCell;
+		VertPos_[nID] = (GW_U32) CellVert_[nNewCell].size();
+		CellVert_[nNewCell].push_back( nID );
+	}
+	this->SetDirty( nNewCell );
+}
+
+/*------------------------------------------------------------------------------*/
+// Name : GW_VoronoiMesh::GW_FurthestPointCells::ResetTouchedState
+/**
+ *  \param  Mesh [GW_GeodesicMesh&] The mesh.
+ * 
+ *  Same as ResetOnlyVertexState, for the re-marched vertices only.
+ */
+/*------------------------------------------------------------------------------*/
+void GW_VoronoiMesh::GW_FurthestPointCells::ResetTouchedState( GW_GeodesicMesh& Mesh )
+{
+	for( IT_U32Vector it=Touched_.begin(); it!=Touched_.end(); ++it )
+		((GW_GeodesicVertex*) Mesh.GetVertex(*it))->SetState( GW_GeodesicVertex::kFar );
+	Touched_.clear();
+}
 
+/*------------------------------------------------------------------------------*/
+// Name : GW_VoronoiMesh::GW_FurthestPointCells::FindMaxVertex
+/**
+ *  \param  Mesh [GW_GeodesicMesh&] The mesh.
+ *  \return [GW_GeodesicVertex*] The max distance vertex.
+ * 
+ *  Same vertex as GW_VoronoiMesh::FindMaxVertex : the maximum of the cells
+ *	changed since the last call are recomputed, the others are in the heap.
+ */
+/*------------------------------------------------------------------------------*/
+GW_GeodesicVertex* GW_VoronoiMesh::GW_FurthestPointCells::FindMaxVertex( GW_GeodesicMesh& Mesh )
+{
+	GW_U32 nNbrVertex = (GW_U32) VertCell_.size();
+	for( IT_U32Vector it=DirtyCell_.begin(); it!=DirtyCell_.end(); ++it )
+	{
+		GW_U32 nCell = *it;
+		IsDirty_[nCell] = GW_False;
+		CellMax& m = CellMax_[nCell];
+		m.rDist_ = -GW_INFINITE;
+		m.nVert_ = nNbrVertex;
+		m.nCell_ = nCell;
+		T_U32Vector& Vert = CellVert_[nCell];
+		for( IT_U32Vector itv=Vert.begin(); itv!=Vert.end(); ++itv )
+		{
+			GW_GeodesicVertex* pVert = (GW_GeodesicVertex*) Mesh.GetVertex( *itv );
+			if( pVert->GetFace()!=NULL &&
+				( pVert->GetDistance()>m.rDist_ || (pVert->GetDistance()==m.rDist_ && *itv<m.nVert_) ) )
+			{
+				m.rDist_ = pVert->GetDistance();
+				m.nVert_ = *itv;
+			}
+		}
+		if( m.nVert_<nNbrVertex )
+			Heap_.push( m );
+	}
+	DirtyCell_.clear();
+
+	/* drop the entries of cells that changed since they were pushed */
+	while( !Heap_.empty() )
+	{
+		const CellMax& top = Heap_.top();
+		const CellMax& cur = CellMax_[top.nCell_];
+		if( top.nVert_==cur.nVert_ && top.rDist_==cur.rDist_ )
+			return (GW_GeodesicVertex*) Mesh.GetVertex( top.nVert_ );
+		Heap_.pop();
+	}
+	return NULL;
+}
+
+GW_U32 GW_VoronoiMesh::GW_FurthestPointCells::GetCell( GW_GeodesicVertex& Vert )
+{
+	if( Vert.GetFront()==NULL )
+		return (GW_U32) VertCell_.size();
+	return Vert.GetFront()->GetID();
+}
 
+void GW_VoronoiMesh::GW_FurthestPointCells::SetDirty( GW_U32 nCell )
+{
+	if( !IsDirty_[nCell] )
+	{
+		IsDirty_[nCell] = GW_True;
+		DirtyCell_.push_back( nCell );
+	}
+}
 
 /*------------------------------------------------------------------------------*/
 // Name : GW_VoronoiMesh::FastMarchingCallbackFunction_MeshBuilding
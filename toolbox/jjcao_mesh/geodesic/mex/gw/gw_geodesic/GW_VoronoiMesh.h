@@ -16,6 +16,7 @@
 #include "GW_GeodesicPath.h"
 #include "GW_VoronoiVertex.h"
 #include "../gw_core/GW_ProgressBar.h"
+#include <queue>
 
 namespace GW {
 
@@ -84,7 +85,7 @@ public:
     //-------------------------------------------------------------------------
     //@{
 	static GW_U32 AddFurthestPoint( T_GeodesicVertexList& VertList, GW_GeodesicMesh& Mesh, GW_Bool bUseRandomStartVertex = GW_False );
-	static GW_U32 AddFurthestPointsIterate( T_GeodesicVertexList& VertList, GW_GeodesicMesh& Mesh, GW_U32 nNbrIteration, GW_Bool bUseRandomStartVertex = GW_False, GW_Bool bUseProgressBar = GW_True );
+	static GW_U32 AddFurthestPointsIterate( T_GeodesicVertexList& VertList, GW_GeodesicMesh& Mesh, GW_U32 nNbrIteration, GW_Bool bUseRandomStartVertex = GW_False, GW_Bool bUseProgressBar = GW_True, GW_Bool bIncremental = GW_True );
 	void BuildMesh( GW_GeodesicMesh& OriginalMesh, GW_Bool bFixHole = GW_True );
     //@}
 
@@ -140,6 +141,45 @@ public:
 	static GW_Bool FastMarchingCallbackFunction_VertexInsersion( GW_GeodesicVertex& CurVert, GW_Float rNewDist );
 	static void ResetOnlyVertexState( GW_GeodesicMesh& Mesh );
 
+	/** helper for incremental furthest point building : the vertices of each
+		Voronoi cell and a max-heap of the cell maxima, updated with the
+		vertices re-marched by each new seed. */
+	class GW_FurthestPointCells
+	{
+	public:
+		void Init( GW_GeodesicMesh& Mesh );
+		void UpdateVertex( GW_GeodesicVertex& Vert );
+		void ResetTouchedState( GW_GeodesicMesh& Mesh );
+		GW_GeodesicVertex* FindMaxVertex( GW_GeodesicMesh& Mesh );
+	private:
+		struct CellMax
+		{
+			GW_Float rDist_;
+			GW_U32 nVert_;
+			GW_U32 nCell_;
+			/* smallest first for the heap : largest distance, then smallest ID */
+			bool operator<( const CellMax& m ) const
+			{ return rDist_<m.rDist_ || (rDist_==m.rDist_ && nVert_>m.nVert_); }
+		};
+		GW_U32 GetCell( GW_GeodesicVertex& Vert );
+		void SetDirty( GW_U32 nCell );
+		/** cell of each vertex (ID of its front, number of vertex when not reached) */
+		T_U32Vector VertCell_;
+		/** place of each vertex in the list of its cell */
+		T_U32Vector VertPos_;
+		std::vector<T_U32Vector> CellVert_;
+		/** current maximum of each cell, a heap entry is valid if it is equal */
+		std::vector<CellMax> CellMax_;
+		std::priority_queue<CellMax> Heap_;
+		T_U32Vector DirtyCell_;
+		std::vector<GW_Bool> IsDirty_;
+		/** vertices re-marched since the last reset */
+		T_U32Vector Touched_;
+	};
+	static GW_FurthestPointCells* pCurFurthestPointCells_;
+	static void FastMarchingCallbackFunction_FurthestPointNewDead( GW_GeodesicVertex& CurVert );
+	static GW_U32 AddFurthestPointIncremental( T_GeodesicVertexList& VertList, GW_GeodesicMesh& Mesh, GW_FurthestPointCells& Cells );
+
 
 	/** helper for natural neighbor interpolation */
 	class GW_GeodesicInformationDuplicata: public GW_SmartCounter
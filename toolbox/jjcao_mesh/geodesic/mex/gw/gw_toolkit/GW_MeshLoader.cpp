@@ -0,0 +1,97 @@
+/*------------------------------------------------------------------------------*/
+/** 
+ *  \file   GW_MeshLoader.cpp
+ *  \brief  Definition of class \c GW_MeshLoader
+ */ 
+/*------------------------------------------------------------------------------*/
+
+#include "stdafx.h"
+#include "GW_MeshLoader.h"
+
+using namespace GW;
+
+
+/*------------------------------------------------------------------------------*/
+// Name : GW_MeshLoader::Load
+/**
+*  \param  Mesh [GW_Mesh&] Mesh to load data to.
+*  \param  name [char*] File name.
+*  \param  bFlipFaces [GW_Bool] Reverse the orientation of the faces.
+*  \param  bUseCache [GW_Bool] Read/write the binary cache <name>.mcache.
+*  \param  Format [MeshLoader::Format] Format of the file, given by the extension if UNKNOWN.
+*  \return [GW_I32] >0 : loading successful.
+*/
+/*------------------------------------------------------------------------------*/
+GW_I32 GW_MeshLoader::Load( GW_Mesh& Mesh, const char *name, GW_Bool bFlipFaces, GW_Bool bUseCache, MeshLoader::Format Format )
+{
+	MeshData Data;
+	MeshLoader Loader;
+	Loader.use_cache( bUseCache==GW_True );
+	if( !Loader.load( name, Data, Format ) )
+	{
+		cerr << Loader.error() << endl;
+		FILE* pFile = fopen( name, "rb" );
+		if( pFile==NULL )
+			return GW_Error_Opening_File;
+		fclose( pFile );
+		return GW_ERROR;
+	}
+	return GW_MeshLoader::Build( Mesh, Data, bFlipFaces );
+}
+
+/*------------------------------------------------------------------------------*/
+// Name : GW_MeshLoader::Build
+/**
+*  \param  Mesh [GW_Mesh&] Mesh to load data to.
+*  \param  Data [MeshData&] Parsed file, its polygons are triangulated.
+*  \param  bFlipFaces [GW_Bool] Reverse the orientation of the faces.
+*  \return [GW_I32] >0 : loading successful.
+*/
+/*------------------------------------------------------------------------------*/
+GW_I32 GW_MeshLoader::Build( GW_Mesh& Mesh, MeshData& Data, GW_Bool bFlipFaces )
+{
+	Data.triangulate();
+	GW_U32 nNbrVertex = (GW_U32) Data.n_vertices();
+	GW_U32 nNbrFace = (GW_U32) Data.n_facets();
+	GW_U32 nNbrNormal = (GW_U32) Data.normals.size()/3;
+	GW_U32 nNbrTexture = (GW_U32) Data.uv.size()/2;
+
+	Mesh.SetNbrVertex( nNbrVertex );
+	Mesh.SetNbrFace( nNbrFace );
+	for( GW_U32 i=0; i<nNbrVertex; ++i )
+	{
+		const double* x = &Data.positions[3*i];
+		GW_Vertex* pVert = &Mesh.CreateNewVertex();
+		pVert->SetPosition( GW_Vector3D(x[0], x[1], x[2]) );
+		if( i<nNbrNormal )
+		{
+			const double* n = &Data.normals[3*i];
+			GW_Vector3D Normal( n[0], n[1], n[2] );
+			pVert->SetNormal( Normal );
+		}
+		if( i<nNbrTexture )
+			pVert->SetTexCoords( Data.uv[2*i], Data.uv[2*i+1] );
+		Mesh.SetVertex( i, pVert );
+	}
+	for( GW_U32 i=0; i<nNbrFace; ++i )
+	{
+		GW_Face* pFace = &Mesh.CreateNewFace();
+		for( GW_U32 j=0; j<3; ++j )
+		{
+			GW_Vertex* pVert = Mesh.GetVertex( Data.indices[3*i+j] );
+			GW_ASSERT( pVert!=NULL );
+			if( !bFlipFaces )
+				pFace->SetVertex( *pVert, j );
+			else
+				pFace->SetVertex( *pVert, 2-j );
+		}
+		Mesh.SetFace( i, pFace );
+	}
+
+	return GW_OK;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//                               END OF FILE                                 //
+///////////////////////////////////////////////////////////////////////////////
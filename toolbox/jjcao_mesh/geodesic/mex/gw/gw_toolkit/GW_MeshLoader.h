@@ -0,0 +1,45 @@
+/*------------------------------------------------------------------------------*/
+/** 
+ *  \file   GW_MeshLoader.h
+ *  \brief  Definition of class \c GW_MeshLoader
+ */ 
+/*------------------------------------------------------------------------------*/
+
+#ifndef __GW_MeshLoader__
+#define __GW_MeshLoader__
+
+#include "../gw_core/GW_Config.h"
+#include "../gw_core/GW_Mesh.h"
+#include "../../../../../jjcao_io/mesh_loader.h"
+
+GW_BEGIN_NAMESPACE
+
+/*------------------------------------------------------------------------------*/
+/** 
+ *  \class  GW_MeshLoader
+ *  \brief  Loads .off, .obj, .ply and .cof files with the memory mapped reader
+ *          of jjcao_io/mesh_loader.h.
+ *
+ *  Polygons are split in fans of triangles. The texture coordinates and
+ *  normals are given to the vertices when the file has them.
+ */ 
+/*------------------------------------------------------------------------------*/
+class GW_MeshLoader
+{
+public:
+
+	static GW_I32 Load( GW_Mesh& Mesh, const char *name, GW_Bool bFlipFaces = GW_False, GW_Bool bUseCache = GW_False,
+						MeshLoader::Format Format = MeshLoader::UNKNOWN );
+	static GW_I32 Build( GW_Mesh& Mesh, MeshData& Data, GW_Bool bFlipFaces = GW_False );
+
+};
+
+GW_END_NAMESPACE
+
+#endif	// #ifdef __GW_MeshLoader__
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+//                               END OF FILE                                 //
+///////////////////////////////////////////////////////////////////////////////
@@ -14,6 +14,7 @@
 
 #include "stdafx.h"
 #include "GW_OFFLoader.h"
+#include "GW_MeshLoader.h"
 
 
 using namespace GW;
@@ -28,82 +29,14 @@ using namespace GW;
 *  \author Gabriel Peyr
 *  \date   4-1-2003
 * 
-*  Load data from a .PLY file.
+*  Load data from a .OFF file.
 */
 /*------------------------------------------------------------------------------*/
 GW_I32 GW_OFFLoader::Load(GW_Mesh& Mesh, const char *name, const char* mode, GW_Bool bFlipFaces)
 {
-	FILE* pFile = NULL;
-	pFile = fopen( name, mode );
-	if( pFile ==NULL )
-		return GW_Error_Opening_File;
-
-	char data[255];
-	GW_U32 nNbrVertex = 0;
-	GW_U32 nNbrFace = 0;
-	GW_U32 nTemp = 0;
-	float Vect[3]; 
-	GW_U32 nVertexNumber[3];
-	GW_U32 nFaceValence = 0;
-	GW_Vertex* pVert = NULL;
-	GW_Face* pFace = NULL;
-
-	T_FloatVector vX, vY, vZ;
-
-	std::map<int, int> VertCorrespondance;
-	GW_Bool bVertexDone = GW_False;
-
-	while( !feof(pFile) )
-	{
-		fscanf(pFile, "%s", &data);
-
-		if( strcmp(data, "#")==0 )
-		{
-			/* skip the whole line */
-		}
-		else if( strcmp(data, "OFF")==0 )
-		{
-			/* begin to read the data */
-			fscanf(pFile, "%u %u %u", &nNbrVertex, &nNbrFace, &nTemp);
-			Mesh.SetNbrVertex( nNbrVertex );
-			Mesh.SetNbrFace( nNbrFace );
-			for( GW_U32 i=0; i<nNbrVertex; ++i )
-			{
-				/* load the position */
-				fscanf(pFile, "%f %f %f,", &Vect[0], &Vect[1], &Vect[2] );
-				GW_Vector3D Pos(Vect[0], Vect[1], Vect[2]);
-				pVert = &Mesh.CreateNewVertex();
-				pVert->SetPosition( Pos );
-				Mesh.SetVertex( i, pVert );
-			}
-			for( GW_U32 i=0; i<nNbrFace; ++i )
-			{
-				/* load the face */
-				fscanf(pFile, "%u %u %u %u", &nTemp, &nVertexNumber[0], &nVertexNumber[1], &nVertexNumber[2] );
-				GW_ASSERT( nTemp==3 );
-				if( nTemp!=3 )
-					return GW_ERROR;
-				pFace = &Mesh.CreateNewFace();
-				for( GW_U32 j=0; j<3; ++j )
-				{
-					pVert = Mesh.GetVertex( nVertexNumber[j] );
-					GW_ASSERT( pVert!=NULL );
-					if( !bFlipFaces )
-						pFace->SetVertex( *pVert, j );
-					else
-						pFace->SetVertex( *pVert, 2-j );
-				}
-				Mesh.SetFace( i, pFace );
-			}
-
-			fclose(pFile);
-
-			return GW_OK;
-		}
-	}
-
-	return GW_ERROR;
-
+	/* the file is memory mapped and parsed by GW_MeshLoader, any polygon is
+	   split in triangles; mode is not used anymore */
+	return GW_MeshLoader::Load( Mesh, name, bFlipFaces, GW_False, MeshLoader::OFF );
 }
 
 /*------------------------------------------------------------------------------*/
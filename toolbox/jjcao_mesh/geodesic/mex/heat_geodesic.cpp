@@ -0,0 +1,159 @@
+/*=================================================================
+% heat_geodesic - geodesic distances by the heat method, the mesh being
+%   factored once.
+%
+%   h = heat_geodesic('build', vertex, faces, t_factor);
+%   D = heat_geodesic('distance', h, start_points);
+%   heat_geodesic('delete', h);
+%
+%   'build' computes the cotangent Laplacian and the mixed Voronoi areas of
+%	the mesh and factors the heat and the Poisson systems (see
+%	heat_geodesic.h), it returns a handle to them.
+%	'vertex' is 3 x nverts, 'faces' is 3 x nfaces (0-based).
+%	't_factor' scales the time step t = t_factor*(mean edge length)^2, 1 by
+%	default; larger values give smoother distances.
+%
+%   'distance' costs two back substitutions per start set:
+%	'start_points' is either a vector (one distance from each point) or a
+%		cell array of vectors (one distance from each set of points), 0-based.
+%	D is nverts x nb_sets: column j is the distance to the jth set.
+%   The sets are solved by blocks of right hand sides, in parallel when
+%   compiled with OpenMP.
+%
+%   'delete' frees the factorizations.
+*=================================================================*/
+
+#include <mex.h>
+#include <string.h>
+#include <set>
+#include <stdint.h>
+#include "heat_geodesic.h"
+
+// factorizations built by this mex file, a handle is valid only if it is in this set
+static std::set<HeatGeodesic*> solvers;
+
+static void delete_all_solvers()
+{
+	for( std::set<HeatGeodesic*>::iterator it=solvers.begin(); it!=solvers.end(); ++it )
+		delete *it;
+	solvers.clear();
+}
+
+static HeatGeodesic* get_solver(const mxArray* handle)
+{
+	if( handle==NULL || mxGetClassID(handle)!=mxUINT64_CLASS || mxGetNumberOfElements(handle)!=1 )
+		mexErrMsgTxt("h must be a handle returned by heat_geodesic('build', ...).");
+	HeatGeodesic* solver = (HeatGeodesic*) (uintptr_t) *((uint64_t*) mxGetData(handle));
+	if( solvers.find(solver)==solvers.end() )
+		mexErrMsgTxt("h is not a heat geodesic solver or has already been deleted.");
+	return solver;
+}
+
+static void get_vertex_list(const mxArray* a, mwSize nverts, std::vector<mwIndex>& points)
+{
+	if( !mxIsDouble(a) )
+		mexErrMsgTxt("start_points must be a vector of vertex indices.");
+	const double* p = mxGetPr(a);
+	mwSize n = mxGetNumberOfElements(a);
+	points.resize(n);
+	for( mwSize i=0; i<n; ++i )
+	{
+		if( p[i]<0 || p[i]>=nverts || p[i]!=floor(p[i]) )
+			mexErrMsgTxt("start_points must index vertices (0-based).");
+		points[i] = (mwIndex) p[i];
+	}
+}
+
+void mexFunction(	int nlhs, mxArray *plhs[],
+				 int nrhs, const mxArray*prhs[] )
+{
+	if( nrhs<2 || !mxIsChar(prhs[0]) )
+		mexErrMsgTxt("usage: heat_geodesic('build'|'distance'|'delete', ...).");
+	char cmd[16];
+	mxGetString(prhs[0], cmd, sizeof(cmd));
+
+	if( strcmp(cmd, "build")==0 )
+	{
+		if( nrhs<3 || nrhs>4 )
+			mexErrMsgTxt("usage: h = heat_geodesic('build', vertex, faces, t_factor).");
+		if( !mxIsDouble(prhs[1]) || mxGetM(prhs[1])!=3 )
+			mexErrMsgTxt("vertex must be a 3 x nverts double matrix.");
+		if( !mxIsDouble(prhs[2]) || mxGetM(prhs[2])!=3 )
+			mexErrMsgTxt("faces must be a 3 x nfaces double matrix.");
+		mwSize nverts = mxGetN(prhs[1]);
+		const double* f = mxGetPr(prhs[2]);
+		std::vector<mwIndex> tri( mxGetNumberOfElements(prhs[2]) );
+		for( size_t i=0; i<tri.size(); ++i )
+		{
+			if( f[i]<0 || f[i]>=nverts )
+				mexErrMsgTxt("faces must index vertices (0-based).");
+			tri[i] = (mwIndex) f[i];
+		}
+		double t_factor = 1;
+		if( nrhs==4 && mxGetNumberOfElements(prhs[3])>0 )
+			t_factor = *mxGetPr(prhs[3]);
+		if( !(t_factor>0) )
+			mexErrMsgTxt("t_factor must be positive.");
+
+		HeatGeodesic* solver = new HeatGeodesic( mxGetPr(prhs[1]), nverts, tri, t_factor );
+		if( !solver->ok() )
+		{
+			delete solver;
+			mexErrMsgTxt("the factorization failed, is the mesh degenerate?");
+		}
+		if( solvers.empty() )
+		{
+			mexLock();
+			mexAtExit( delete_all_solvers );
+		}
+		solvers.insert( solver );
+		plhs[0] = mxCreateNumericMatrix(1, 1, mxUINT64_CLASS, mxREAL);
+		*((uint64_t*) mxGetData(plhs[0])) = (uint64_t) (uintptr_t) solver;
+		return;
+	}
+
+	if( strcmp(cmd, "delete")==0 )
+	{
+		HeatGeodesic* solver = get_solver( prhs[1] );
+		solvers.erase( solver );
+		delete solver;
+		if( solvers.empty() )
+			mexUnlock();
+		return;
+	}
+
+	if( strcmp(cmd, "distance")!=0 )
+		mexErrMsgTxt("unknown command, should be 'build', 'distance' or 'delete'.");
+	if( nrhs!=3 )
+		mexErrMsgTxt("usage: D = heat_geodesic('distance', h, start_points).");
+
+	// check every argument before going parallel: no mexErrMsgTxt in the threads
+	const HeatGeodesic& solver = *get_solver( prhs[1] );
+	mwSize nverts = solver.nverts();
+	std::vector< std::vector<mwIndex> > start_points;
+	if( mxIsCell(prhs[2]) )
+	{
+		start_points.resize( mxGetNumberOfElements(prhs[2]) );
+		for( size_t j=0; j<start_points.size(); ++j )
+		{
+			const mxArray* cell = mxGetCell(prhs[2], j);
+			if( cell==NULL )
+				mexErrMsgTxt("start_points{j} must be a vector of vertex indices.");
+			get_vertex_list( cell, nverts, start_points[j] );
+		}
+	}
+	else
+	{
+		std::vector<mwIndex> points;
+		get_vertex_list( prhs[2], nverts, points );
+		start_points.resize( points.size() );
+		for( size_t j=0; j<points.size(); ++j )
+			start_points[j].push_back( points[j] );
+	}
+	for( size_t j=0; j<start_points.size(); ++j )
+		if( start_points[j].empty() )
+			mexErrMsgTxt("each start set must have at least one vertex.");
+
+	plhs[0] = mxCreateDoubleMatrix(nverts, start_points.size(), mxREAL);
+	solver.distance( start_points, mxGetPr(plhs[0]) );
+}
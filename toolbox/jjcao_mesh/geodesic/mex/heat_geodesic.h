@@ -0,0 +1,218 @@
+/*=================================================================
+% heat_geodesic.h - geodesic distances by the heat method.
+%
+%   Geodesics in Heat: A New Approach to Computing Distance Based on Heat
+%   Flow, Crane et al. 13:
+%       (M + t*L) u = u0,      u0 = 1 at the sources
+%       X = -grad(u)/|grad(u)| on each face
+%       L phi = -div(X),       distance = phi - min(phi)
+%   L = D - W is the cotangent Laplacian, W the dcp weight of
+%   perform_mesh_weight (see mesh_weight_kernel.h), and M the mixed Voronoi
+%   areas. Both systems are factored once when the mesh is built, each set of
+%   sources then costs two back substitutions and a pass over the faces.
+%   Many sets are solved together, in parallel with OpenMP.
+*=================================================================*/
+
+#ifndef HEAT_GEODESIC_H
+#define HEAT_GEODESIC_H
+
+#include <math.h>
+#include <vector>
+#include <algorithm>
+#include <Eigen/Sparse>
+#include <Eigen/SparseCholesky>
+#include "../../mesh_weight_kernel.h"
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+class HeatGeodesic
+{
+public:
+	typedef Eigen::SparseMatrix<double> SpMat;
+
+	// vertex: 3 x nverts, tri: 3 zero-based vertices per face,
+	// t = t_factor * (mean edge length)^2
+	HeatGeodesic(const double* vertex, mwSize nverts, const std::vector<mwIndex>& tri, double t_factor = 1.0)
+		: nverts_(nverts), tri_(tri)
+	{
+		MeshWeightKernel kernel(tri, nverts);
+		kernel.set_vertices(vertex, true);
+		SpMat W;
+		EigenColumns columns(W);
+		kernel.compute(MeshWeightKernel::DCP, NULL, columns);
+		columns.finish();
+		std::vector<double> area = kernel.mixed_areas();
+
+		SpMat L = -W;
+		SpMat M(nverts, nverts);
+		M.reserve(Eigen::VectorXi::Constant(nverts, 1));
+		for( mwSize i=0; i<nverts; ++i )
+			M.insert(i, i) = area[i];
+		Eigen::VectorXd degree = W * Eigen::VectorXd::Ones(nverts);
+		for( mwSize i=0; i<nverts; ++i )
+			L.coeffRef(i, i) += degree[i];
+
+		compute_faces(vertex);
+		t_ = t_factor * mean_edge_length_ * mean_edge_length_;
+
+		SpMat A = M + t_*L;
+		heat_.compute(A);
+		// L is singular (constants), a tiny mass keeps it definite
+		double amax = nverts ? *std::max_element(area.begin(), area.end()) : 1;
+		double dmax = nverts ? degree.maxCoeff() : 1;
+		SpMat P = L + (1e-10*dmax/amax)*M;
+		poisson_.compute(P);
+	}
+
+	bool ok() const { return heat_.info()==Eigen::Success && poisson_.info()==Eigen::Success; }
+	double t() const { return t_; }
+	mwSize nverts() const { return nverts_; }
+
+	// D(:,j): distance to the vertices of sources[j]
+	void distance(const std::vector< std::vector<mwIndex> >& sources, double* D) const
+	{
+		long nsets = (long) sources.size();
+		long block = 16;
+		#pragma omp parallel for schedule(dynamic)
+		for( long first=0; first<nsets; first+=block )
+		{
+			long ncols = std::min(block, nsets-first);
+			Eigen::MatrixXd U0 = Eigen::MatrixXd::Zero(nverts_, ncols);
+			for( long j=0; j<ncols; ++j )
+				for( size_t k=0; k<sources[first+j].size(); ++k )
+					U0(sources[first+j][k], j) = 1;
+
+			Eigen::MatrixXd U = heat_.solve(U0);
+			Eigen::MatrixXd Div(nverts_, ncols);
+			for( long j=0; j<ncols; ++j )
+				divergence(U.col(j).data(), Div.col(j).data());
+			Eigen::MatrixXd Phi = poisson_.solve(-Div);
+
+			for( long j=0; j<ncols; ++j )
+			{
+				double* d = D + (size_t)(first+j)*nverts_;
+				double dmin = Phi.col(j).minCoeff();
+				for( mwSize i=0; i<nverts_; ++i )
+					d[i] = Phi(i, j) - dmin;
+			}
+		}
+	}
+
+private:
+	// W column by column, the rows of each column are sorted and unique
+	struct EigenColumns
+	{
+		EigenColumns(SpMat& S) : S_(S), col_(0) {}
+		void open(mwSize m, mwSize n, mwSize nzmax)
+		{
+			S_.resize(m, n);
+			S_.reserve(nzmax);
+			col_ = 0;
+			if( n )
+				S_.startVec(0);
+		}
+		void add(mwIndex row, double value) { S_.insertBack(row, col_) = value; }
+		void end_column()
+		{
+			if( ++col_ < S_.cols() )
+				S_.startVec(col_);
+		}
+		void finish() { S_.finalize(); }
+
+		SpMat& S_;
+		long col_;
+	};
+
+	// per face and corner c: grad_[c] = N x e_c/(2*area) where e_c is the
+	// edge opposite c, so grad(u) = sum u_c*grad_[c]; div_[c] =
+	// (cot(theta_1)*e_1 + cot(theta_2)*e_2)/2 with e_1, e_2 the edges from c
+	// and theta_1, theta_2 the angles opposite to them, so div(X)_c += div_[c].X
+	void compute_faces(const double* vertex)
+	{
+		mwSize nfaces = tri_.size()/3;
+		grad_.resize(9*nfaces);
+		div_.resize(9*nfaces);
+		double total = 0;
+		for( mwSize f=0; f<nfaces; ++f )
+		{
+			const double* p[3];
+			for( int c=0; c<3; ++c )
+				p[c] = vertex + 3*tri_[3*f+c];
+			double e[3][3];		// e[c] = p[c+2] - p[c+1], opposite to c
+			for( int c=0; c<3; ++c )
+				for( int k=0; k<3; ++k )
+					e[c][k] = p[(c+2)%3][k] - p[(c+1)%3][k];
+			double n[3];
+			cross(e[2], e[0], n);		// (p1-p0) x (p2-p1)
+			double area2 = sqrt(n[0]*n[0] + n[1]*n[1] + n[2]*n[2]);
+			for( int c=0; c<3; ++c )
+				total += sqrt(e[c][0]*e[c][0] + e[c][1]*e[c][1] + e[c][2]*e[c][2]);
+
+			double* g = &grad_[9*f];
+			double* d = &div_[9*f];
+			if( area2==0 )	// degenerate face, no gradient
+			{
+				std::fill(g, g+9, 0.0);
+				std::fill(d, d+9, 0.0);
+				continue;
+			}
+			double unit[3] = { n[0]/area2, n[1]/area2, n[2]/area2 };
+			double cot[3];
+			for( int c=0; c<3; ++c )
+			{
+				cross(unit, e[c], g+3*c);
+				for( int k=0; k<3; ++k )
+					g[3*c+k] /= area2;
+				// the angle at c is between e[c+2] and -e[c+1]
+				const double* a = e[(c+2)%3];
+				const double* b = e[(c+1)%3];
+				cot[c] = -(a[0]*b[0] + a[1]*b[1] + a[2]*b[2])/area2;
+			}
+			for( int c=0; c<3; ++c )
+			{
+				// from c to c+1 is e[c+2], opposite to c+2; from c to c+2 is -e[c+1], opposite to c+1
+				const double* to1 = e[(c+2)%3];
+				const double* to2 = e[(c+1)%3];
+				for( int k=0; k<3; ++k )
+					d[3*c+k] = 0.5*( cot[(c+2)%3]*to1[k] - cot[(c+1)%3]*to2[k] );
+			}
+		}
+		mean_edge_length_ = nfaces ? total/(3*nfaces) : 1;
+	}
+
+	void divergence(const double* u, double* div) const
+	{
+		std::fill(div, div+nverts_, 0.0);
+		mwSize nfaces = tri_.size()/3;
+		for( mwSize f=0; f<nfaces; ++f )
+		{
+			const mwIndex* v = &tri_[3*f];
+			const double* g = &grad_[9*f];
+			double x[3];
+			for( int k=0; k<3; ++k )
+				x[k] = u[v[0]]*g[k] + u[v[1]]*g[3+k] + u[v[2]]*g[6+k];
+			double norm = sqrt(x[0]*x[0] + x[1]*x[1] + x[2]*x[2]);
+			if( norm==0 )
+				continue;
+			const double* d = &div_[9*f];
+			for( int c=0; c<3; ++c )
+				div[v[c]] -= (d[3*c]*x[0] + d[3*c+1]*x[1] + d[3*c+2]*x[2])/norm;
+		}
+	}
+
+	static void cross(const double* a, const double* b, double* c)
+	{
+		c[0] = a[1]*b[2] - a[2]*b[1];
+		c[1] = a[2]*b[0] - a[0]*b[2];
+		c[2] = a[0]*b[1] - a[1]*b[0];
+	}
+
+	mwSize nverts_;
+	std::vector<mwIndex> tri_;
+	std::vector<double> grad_, div_;
+	double mean_edge_length_, t_;
+	Eigen::SimplicialLDLT<SpMat> heat_, poisson_;
+};
+
+#endif // HEAT_GEODESIC_H
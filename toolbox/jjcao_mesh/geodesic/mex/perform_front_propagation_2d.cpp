@@ -15,11 +15,6 @@
 %   Copyright (c) 2004 Gabriel Peyr�
 *=================================================================*/
 
-// select to test or not to test (debug purpose)
-// #define CHECK_HEAP check_heap(i,j,k);
-#ifndef CHECK_HEAP
-	#define CHECK_HEAP
-#endif
 // error display
 // #define ERROR_MSG(a) mexErrMsgTxt(a)
 #ifndef ERROR_MSG
@@ -31,161 +26,132 @@
 #endif
 
 #include "perform_front_propagation_2d.h"
-#include "fheap/fib.h"
-#include "fheap/fibpriv.h"
+#include "grid_heap.h"
 
 #define kDead -1
 #define kOpen 0
 #define kFar 1
 
-/* Global variables */
-int n;			// width
-int p;			// height
-double* D = NULL;
-double* S = NULL;
-double* W = NULL;
-double* Q = NULL;
-double* start_points = NULL;
-double* end_points = NULL;
-double* values = NULL;
-double* H = NULL;
-double* L = NULL;
-int nb_iter_max = 100000;
-int nb_start_points = 0;
-int nb_end_points = 0;
-fibheap_el** heap_pool = NULL;
-
 #define ACCESS_ARRAY(a,i,j) a[(i)+n*(j)]
 #define D_(i,j) ACCESS_ARRAY(D,i,j)
-#define S_(i,j) ACCESS_ARRAY(S,i,j)
-#define W_(i,j) ACCESS_ARRAY(W,i,j)
-#define H_(i,j) ACCESS_ARRAY(H,i,j)
 #define Q_(i,j) ACCESS_ARRAY(Q,i,j)
-#define L_(i,j) ACCESS_ARRAY(L,i,j)
-#define heap_pool_(i,j) ACCESS_ARRAY(heap_pool,i,j)
-#define start_points_(i,k) start_points[(i)+2*(k)]
-#define end_points_(i,k) end_points[(i)+2*(k)]
-
-struct point
-{
-	point( int ii, int jj )
-	{ i = ii; j = jj; }
-	int i,j;
-};
-typedef std::vector<point*> point_list;
+#define start_points_(i,k) fp.start_points[(i)+2*(k)]
+#define end_points_(i,k) fp.end_points[(i)+2*(k)]
 
-inline 
-bool end_points_reached(const int i, const int j )
+// end points of one propagation: 1 for an end point not reached yet, 2 once
+// it is dead, 0 otherwise, so that testing a dead point is O(1)
+struct EndPoints2D
 {
-	for( int k=0; k<nb_end_points; ++k )
+	EndPoints2D( const FrontPropagation2D& fp ) : nb_reached(0), nb_target(0)
 	{
-		if( i==((int)end_points_(0,k)) && j==((int)end_points_(1,k)) )
-			return true;
-	}
-	return false;
-}
-
-inline 
-int compare_points(void *x, void *y)
-{
-	point& a = *( (point*) x );
-	point& b = *( (point*) y );
-	if( H==NULL )
-		return cmp( D_(a.i,a.j), D_(b.i,b.j) );
-	else
-		return cmp( D_(a.i,a.j)+H_(a.i,a.j), D_(b.i,b.j)+H_(b.i,b.j) );
-}
-
-
-// test the heap validity
-void check_heap( int i, int j )
-{
-	for( int x=0; x<n; ++x )
-		for( int y=0; y<p; ++y )
+		int n = fp.n, p = fp.p;
+		if( fp.nb_end_points==0 && fp.end_points_mask==NULL )
+			return;
+		pool.assign( n*p, 0 );
+		for( int k=0; k<fp.nb_end_points; ++k )
 		{
-			if( heap_pool_(x,y)!=NULL )
+			int i = (int) end_points_(0,k);
+			int j = (int) end_points_(1,k);
+			if( i>=0 && i<n && j>=0 && j<p && pool[i+n*j]==0 )
 			{
-				point& pt = * (point*)heap_pool_(x,y)->fhe_data;
-				if( H==NULL )
-				{
-					if( D_(i,j)>D_(pt.i,pt.j) )
-						ERROR_MSG("Problem with heap.\n");
-				}
-				else
-				{
-					if( D_(i,j)+H_(i,j)>D_(pt.i,pt.j)+H_(pt.i,pt.j) )
-						ERROR_MSG("Problem with heap.\n");
-				}
+				pool[i+n*j] = 1;
+				nb_target++;
 			}
 		}
-}
-
-
+		if( fp.end_points_mask!=NULL )
+		for( int s=0; s<n*p; ++s )
+		{
+			if( fp.end_points_mask[s] && pool[s]==0 )
+			{
+				pool[s] = 1;
+				nb_target++;
+			}
+		}
+		nb_target = GW_MIN( GW_MAX(fp.nb_end_points_stop,1), nb_target );
+	}
+	// true when enough end points are dead
+	bool reached( int s )
+	{
+		if( pool.empty() || pool[s]!=1 )
+			return false;
+		pool[s] = 2;
+		nb_reached++;
+		return nb_reached>=nb_target;
+	}
+	std::vector<unsigned char> pool;
+	int nb_reached;
+	int nb_target;
+};
 
-void perform_front_propagation_2d(T_callback_intert_node callback_insert_node)
+// Key gives the priority of a point: templated so that the usual case
+// without heuristic does not test H for every comparison
+template<class Key>
+void perform_front_propagation_2d( FrontPropagation2D& fp )
 {
-	// create the Fibonacci heap
-	struct fibheap* open_heap = fh_makeheap();
-	fh_setcmp(open_heap, compare_points);
+	const int n = fp.n;
+	const int p = fp.p;
+	double* D = fp.D;
+	double* S = fp.S;
+	double* Q = fp.Q;
+	const double* W = fp.W;
+	const double* L = fp.L;
+	const double* values = fp.values;
+	T_callback_intert_node callback_insert_node = fp.callback_insert_node;
+	Key key( D, fp.H );
 
 	double h = 1.0/n;
 	
 	// initialize points
-	for( int i=0; i<n; ++i )
-	for( int j=0; j<p; ++j )
+	for( int s=0; s<n*p; ++s )
 	{
-		D_(i,j) = GW_INFINITE;
-		S_(i,j) = kFar;
-		Q_(i,j) = -1;
+		D[s] = GW_INFINITE;
+		S[s] = kFar;
+		Q[s] = -1;
 	}
 
-	// record all the points
-	heap_pool = new fibheap_el*[n*p]; 
-	memset( heap_pool, NULL, n*p*sizeof(fibheap_el*) );
+	// the open points, pos[s] is the place of s in the heap
+	std::vector<int> pos( n*p, -1 );
+	GridHeap open_heap( &pos[0] );
+	EndPoints2D end_points( fp );
 
 	// inialize open list
-	point_list existing_points;
-	for( int k=0; k<nb_start_points; ++k )
+	for( int k=0; k<fp.nb_start_points; ++k )
 	{
 		int i = (int) start_points_(0,k);
 		int j = (int) start_points_(1,k);
+		int s = i+n*j;
+		double d = values==NULL ? 0 : values[k];
 
-		if( D_( i,j )==0 )
+		if( open_heap.contains(s) )
+		{
 			ERROR_MSG("start_points should not contain duplicates.");
-
-		point* pt = new point( i,j );
-		existing_points.push_back( pt );			// for deleting at the end
-		heap_pool_(i,j) = fh_insert( open_heap, pt );			// add to heap
-		if( values==NULL ) 
-			D_( i,j ) = 0;
-		else
-			D_( i,j ) = values[k];
-		S_( i,j ) = kOpen;
-		Q_(i,j) = k;
+			if( d<D[s] )
+			{
+				D[s] = d;
+				Q[s] = k;
+				open_heap.decrease( s, key(s) );
+			}
+			continue;
+		}
+		D[s] = d;
+		S[s] = kOpen;
+		Q[s] = k;
+		open_heap.push( s, key(s) );
 	}
 
 	// perform the front propagation
 	int num_iter = 0;
 	bool stop_iteration = GW_False;
-	while( !fh_isempty(open_heap) && num_iter<nb_iter_max && !stop_iteration )
+	while( !open_heap.empty() && num_iter<fp.nb_iter_max && !stop_iteration )
 	{
 		num_iter++;
 
 		// current point
-		point& cur_point = * ((point*) fh_extractmin( open_heap ));
-		int i = cur_point.i;
-		int j = cur_point.j;
-		heap_pool_(i,j) = NULL;
-		S_(i,j) = kDead;
-		stop_iteration = end_points_reached(i,j);
-		
-		/*
-		char msg[200];
-		sprintf(msg, "Cool %f", Q_(i,j) );
-		WARN_MSG( msg ); 
-		*/
-		
-		CHECK_HEAP;
+		int cur = open_heap.pop();
+		int i = cur%n;
+		int j = cur/n;
+		S[cur] = kDead;
+		stop_iteration = end_points.reached(cur);
 
 		// recurse on each neighbor
 		int nei_i[4] = {i+1,i,i-1,i};
@@ -200,7 +166,8 @@ void perform_front_propagation_2d(T_callback_intert_node callback_insert_node)
 			// check that the contraint distance map is ok
 			if( ii>=0 && jj>=0 && ii<n && jj<p && bInsert )
 			{
-				double P = h/W_(ii,jj);
+				int s = ii+n*jj;
+				double P = h/W[s];
 				// compute its neighboring values
 				double a1 = GW_INFINITE;
 				int k1 = -1;
@@ -268,63 +235,41 @@ void perform_front_propagation_2d(T_callback_intert_node callback_insert_node)
 				}
 				else
 					A1 = a1 + P;
-				if( ((int) S_(ii,jj)) == kDead )
+				if( ((int) S[s]) == kDead )
 				{
 					// check if action has change. Should not happen for FM
-					// if( A1<D_(ii,jj) )
-					//	WARN_MSG("The update is not monotone");
-#if 1
-					if( A1<D_(ii,jj) )	// should not happen for FM
+					if( A1<D[s] )	// should not happen for FM
 					{
-						D_(ii,jj) = A1;
+						D[s] = A1;
 						// update the value of the closest starting point
-						//if( GW_ABS(a1-A1)<GW_ABS(a2-A1) && k1>=0  )
-							Q_(ii,jj) = k1;
-						//else
-						//	Q_(ii,jj) = k2;
-						//Q_(ii,jj) = Q_(i,j);
+						Q[s] = k1;
 					}
-#endif
 				}
-				else if( ((int) S_(ii,jj)) == kOpen )
+				else if( ((int) S[s]) == kOpen )
 				{
 					// check if action has change.
-					if( A1<D_(ii,jj) )
+					if( A1<D[s] )
 					{
-						D_(ii,jj) = A1;
+						D[s] = A1;
 						// update the value of the closest starting point
-						//if( GW_ABS(a1-A1)<GW_ABS(a2-A1) && k1>=0  )
-							Q_(ii,jj) = k1;
-						//else
-						//	Q_(ii,jj) = k2;
-						//Q_(ii,jj) = Q_(i,j);
+						Q[s] = k1;
 						// Modify the value in the heap
-						fibheap_el* cur_el = heap_pool_(ii,jj);
-						if( cur_el!=NULL )
-							fh_replacedata( open_heap, cur_el, cur_el->fhe_data );	// use same data for update
-						else
-							ERROR_MSG("Error in heap pool allocation."); 
+						open_heap.decrease( s, key(s) );
 					}
 				}
-				else if( ((int) S_(ii,jj)) == kFar )
+				else if( ((int) S[s]) == kFar )
 				{
-					if( D_(ii,jj)!=GW_INFINITE )
+					if( D[s]!=GW_INFINITE )
 						ERROR_MSG("Distance must be initialized to Inf");
-					if( L==NULL || A1<=L_(ii,jj) )
+					if( L==NULL || A1<=L[s] )
 					{
-						S_(ii,jj) = kOpen;
+						S[s] = kOpen;
 						// distance must have change.
-						D_(ii,jj) = A1;
+						D[s] = A1;
 						// update the value of the closest starting point
-						//if( GW_ABS(a1-A1)<GW_ABS(a2-A1) && k1>=0 )
-							Q_(ii,jj) = k1;
-						//else
-						//	Q_(ii,jj) = k2;
-						//Q_(ii,jj) = Q_(i,j);
+						Q[s] = k1;
 						// add to open list
-						point* pt = new point(ii,jj);
-						existing_points.push_back( pt );
-						heap_pool_(ii,jj) = fh_insert( open_heap, pt );			// add to heap	
+						open_heap.push( s, key(s) );
 					}
 				}
 				else 
@@ -333,16 +278,12 @@ void perform_front_propagation_2d(T_callback_intert_node callback_insert_node)
 			}	// end switch
 		}		// end for
 	}			// end while
+}
 
-//				char msg[200];
-//				sprintf(msg, "Cool %f", Q_(100,100) );
-//				 WARN_MSG( msg ); 
-
-	// free heap
-	fh_deleteheap(open_heap);
-	// free point pool
-	for( point_list::iterator it = existing_points.begin(); it!=existing_points.end(); ++it )
-		GW_DELETE( *it );
-	// free fibheap pool
-	GW_DELETEARRAY(heap_pool);
-}
\ No newline at end of file
+void perform_front_propagation_2d( FrontPropagation2D& fp )
+{
+	if( fp.H==NULL )
+		perform_front_propagation_2d<GridDistanceKey>( fp );
+	else
+		perform_front_propagation_2d<GridHeuristicKey>( fp );
+}
@@ -8,25 +8,38 @@
 #include <vector>
 #include <algorithm>
 
-// some global variables
-extern int n;			// width
-extern int p;			// height
-extern double* D;
-extern double* S;
-extern double* W;
-extern double* Q;
-extern double* L;
-extern double* start_points;
-extern double* end_points;
-extern double* H;
-extern double* values;
-extern int nb_iter_max;
-extern int nb_start_points;
-extern int nb_end_points;
-
 typedef bool (*T_callback_intert_node)(int i, int j, int ii, int jj);
 
+// Everything one propagation reads and writes: there is no global state,
+// so several propagations can run at the same time (one struct each).
+// D, S and Q (n x p) are written, the other arrays are only read.
+struct FrontPropagation2D
+{
+	FrontPropagation2D() : n(0), p(0), D(NULL), S(NULL), W(NULL), Q(NULL), L(NULL), H(NULL),
+		start_points(NULL), end_points(NULL), values(NULL), end_points_mask(NULL),
+		nb_iter_max(100000), nb_start_points(0), nb_end_points(0), nb_end_points_stop(1),
+		callback_insert_node(NULL) {}
+
+	int n;			// size on X
+	int p;			// size on Y
+	double* D;			// distance
+	double* S;			// state: -1 dead, 0 open, 1 far
+	double* W;			// weight (inverse of the speed)
+	double* Q;			// index of the closest start point
+	double* L;			// optional constraint, a point is opened only if its distance is <= L
+	double* H;			// optional heuristic (A*)
+	double* start_points;
+	double* end_points;
+	double* values;			// optional initial distance of the start points
+	bool* end_points_mask;		// optional, one flag per point
+	int nb_iter_max;
+	int nb_start_points;
+	int nb_end_points;
+	int nb_end_points_stop;		// stop once this number of end points are dead
+	T_callback_intert_node callback_insert_node;	// optional
+};
+
 // main function
-void perform_front_propagation_2d(T_callback_intert_node callback_insert_node = NULL);
+void perform_front_propagation_2d( FrontPropagation2D& fp );
 
 #endif // _PERFORM_FRONT_PROPAGATION_2D_H_
\ No newline at end of file
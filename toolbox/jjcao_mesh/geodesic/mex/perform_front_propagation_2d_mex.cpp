@@ -1,7 +1,7 @@
 /*=================================================================
 % perform_front_propagation_2d - perform a Fast Marching front propagation.
 %
-%   [D,S,Q] = perform_front_propagation_2d(W,start_points,end_points,nb_iter_max,H,L,values);
+%   [D,S,Q] = perform_front_propagation_2d(W,start_points,end_points,nb_iter_max,H,L,values,end_points_stop);
 %
 %   'D' is a 2D array containing the value of the distance function to seed.
 %	'S' is a 2D array containing the state of each point : 
@@ -11,6 +11,9 @@
 %	Q is the index of the closest point.
 %	'W' is the weight matrix (inverse of the speed).
 %	'start_points' is a 2 x num_start_points matrix where k is the number of starting points.
+%	'end_points' is a 2 x num_end_points matrix, or a logical mask of size n x p.
+%	'end_points_stop' the propagation stops once this number of end points
+%		are dead: 1 (default) for the first one, Inf for all of them.
 %	'H' is an heuristic (distance that remains to goal). This is a 2D matrix.
 %	L is a constraint matrix, points will be considered only if their current distance is less than L.
 %   
@@ -23,95 +26,118 @@
 void mexFunction(	int nlhs, mxArray *plhs[], 
 				 int nrhs, const mxArray*prhs[] ) 
 { 
+	FrontPropagation2D fp;
+
 	/* retrive arguments */
 	if( nrhs<4 ) 
-		mexErrMsgTxt("4 - 7 input arguments are required."); 
+		mexErrMsgTxt("4 - 8 input arguments are required."); 
 	if( nlhs<1 ) 
 		mexErrMsgTxt("1, 2 or 3 output arguments are required."); 
 
 	// first argument : weight list
-	n = mxGetM(prhs[0]); 
-	p = mxGetN(prhs[0]);
-	W = mxGetPr(prhs[0]);
+	fp.n = mxGetM(prhs[0]); 
+	fp.p = mxGetN(prhs[0]);
+	fp.W = mxGetPr(prhs[0]);
 	// second argument : start_points
-	start_points = mxGetPr(prhs[1]);
+	fp.start_points = mxGetPr(prhs[1]);
 	int tmp = mxGetM(prhs[1]); 
-	nb_start_points = mxGetN(prhs[1]);
-	if( nb_start_points==0 || tmp!=2 )
+	fp.nb_start_points = mxGetN(prhs[1]);
+	if( fp.nb_start_points==0 || tmp!=2 )
 		mexErrMsgTxt("start_points must be of size 2 x nb_start_poins."); 
-	// third argument : end_points
-	end_points = mxGetPr(prhs[2]);
-	tmp = mxGetM(prhs[2]); 
-	nb_end_points = mxGetN(prhs[2]);
-	if( nb_end_points!=0 && tmp!=2 )
-		mexErrMsgTxt("end_points must be of size 2 x nb_end_poins."); 
+	// third argument : end_points, as a list or as a mask
+	if( mxIsLogical(prhs[2]) && !mxIsEmpty(prhs[2]) )
+	{
+		if( mxGetM(prhs[2])!=fp.n || mxGetN(prhs[2])!=fp.p )
+			mexErrMsgTxt("end_points mask must be of size n x p."); 
+		fp.end_points = NULL;
+		fp.nb_end_points = 0;
+		fp.end_points_mask = (bool*) mxGetLogicals(prhs[2]);
+	}
+	else
+	{
+		fp.end_points = mxGetPr(prhs[2]);
+		tmp = mxGetM(prhs[2]); 
+		fp.nb_end_points = mxGetN(prhs[2]);
+		if( fp.nb_end_points!=0 && tmp!=2 )
+			mexErrMsgTxt("end_points must be of size 2 x nb_end_poins."); 
+		fp.end_points_mask = NULL;
+	}
 	//  argument 4: nb_iter_max
-	nb_iter_max = (int) *mxGetPr(prhs[3]);
+	fp.nb_iter_max = (int) *mxGetPr(prhs[3]);
 	//  argument 5: heuristic
 	if( nrhs>=5 )
 	{
-		H = mxGetPr(prhs[4]);
+		fp.H = mxGetPr(prhs[4]);
 		if( mxGetM(prhs[4])==0 && mxGetN(prhs[4])==0 )
-			H=NULL;
-		if( H!=NULL && (mxGetM(prhs[4])!=n || mxGetN(prhs[4])!=p) )
+			fp.H=NULL;
+		if( fp.H!=NULL && (mxGetM(prhs[4])!=fp.n || mxGetN(prhs[4])!=fp.p) )
 			mexErrMsgTxt("H must be of size n x p."); 
 	}
 	else
-		H = NULL;
+		fp.H = NULL;
 	// argument 6: constraint map
 	if( nrhs>=6 )
 	{
-		L = mxGetPr(prhs[5]);
+		fp.L = mxGetPr(prhs[5]);
 		if( mxGetM(prhs[5])==0 && mxGetN(prhs[5])==0 )
-			H=NULL;
-		if( L!=NULL && (mxGetM(prhs[5])!=n || mxGetN(prhs[5])!=p) )
+			fp.L=NULL;
+		if( fp.L!=NULL && (mxGetM(prhs[5])!=fp.n || mxGetN(prhs[5])!=fp.p) )
 			mexErrMsgTxt("L must be of size n x p."); 
 	}
 	else
-		L = NULL;
+		fp.L = NULL;
 	// argument 7: value list
 	if( nrhs>=7 )
 	{
-		values = mxGetPr(prhs[6]);
+		fp.values = mxGetPr(prhs[6]);
 		if( mxGetM(prhs[6])==0 && mxGetN(prhs[6])==0 )
-			values=NULL;
-		if( values!=NULL && (mxGetM(prhs[6])!=nb_start_points || mxGetN(prhs[6])!=1) )
+			fp.values=NULL;
+		if( fp.values!=NULL && (mxGetM(prhs[6])!=fp.nb_start_points || mxGetN(prhs[6])!=1) )
 			mexErrMsgTxt("values must be of size nb_start_points x 1."); 
 	}
 	else
-		values = NULL;
+		fp.values = NULL;
+	// argument 8: number of end points to reach
+	fp.nb_end_points_stop = 1;
+	if( nrhs>=8 && !mxIsEmpty(prhs[7]) )
+	{
+		double k = *mxGetPr(prhs[7]);
+		if( k<1 )
+			mexErrMsgTxt("end_points_stop must be at least 1."); 
+		fp.nb_end_points_stop = k>=2147483647. ? 2147483647 : (int) k;
+	}
 		
 		
 	// first ouput : distance
-	plhs[0] = mxCreateDoubleMatrix(n, p, mxREAL); 
-	D = mxGetPr(plhs[0]);
+	plhs[0] = mxCreateDoubleMatrix(fp.n, fp.p, mxREAL); 
+	fp.D = mxGetPr(plhs[0]);
 	// second output : state
 	if( nlhs>=2 )
 	{
-		plhs[1] = mxCreateDoubleMatrix(n, p, mxREAL); 
-		S = mxGetPr(plhs[1]);
+		plhs[1] = mxCreateDoubleMatrix(fp.n, fp.p, mxREAL); 
+		fp.S = mxGetPr(plhs[1]);
 	}
 	else
 	{
-		S = new double[n*p];
+		fp.S = new double[fp.n*fp.p];
 	}
 	// third output : index
 	if( nlhs>=3 )
 	{
-		plhs[2] = mxCreateDoubleMatrix(n, p, mxREAL); 
-		Q = mxGetPr(plhs[2]);
+		plhs[2] = mxCreateDoubleMatrix(fp.n, fp.p, mxREAL); 
+		fp.Q = mxGetPr(plhs[2]);
 	}
 	else
 	{
-		Q = new double[n*p];
+		fp.Q = new double[fp.n*fp.p];
 	}
 
 	// launch the propagation
-	perform_front_propagation_2d();
+	perform_front_propagation_2d( fp );
 
 	if( nlhs<2 )
-		GW_DELETEARRAY(S);		
+		GW_DELETEARRAY(fp.S);		
 	if( nlhs<3 )
-		GW_DELETEARRAY(Q);
+		GW_DELETEARRAY(fp.Q);
 	return;
 }
@@ -16,11 +16,6 @@
 %   Copyright (c) 2004 Gabriel Peyr
 *=================================================================*/
 
-// select to test or not to test (debug purpose)
-// #define CHECK_HEAP check_heap(i,j,k);
-#ifndef CHECK_HEAP
-	#define CHECK_HEAP
-#endif
 // error display
 // #define ERROR_MSG(a) mexErrMsgTxt(a)
 #ifndef ERROR_MSG
@@ -33,8 +28,7 @@
 
 
 #include "perform_front_propagation_3d.h"
-#include "fheap/fib.h"
-#include "fheap/fibpriv.h"
+#include "grid_heap.h"
 
 #define kDead -1
 #define kOpen 0
@@ -42,157 +36,137 @@
 
 #define ACCESS_ARRAY(a,i,j,k) a[(i)+n*(j)+n*p*(k)]
 #define D_(i,j,k) ACCESS_ARRAY(D,i,j,k)
-#define S_(i,j,k) ACCESS_ARRAY(S,i,j,k)
-#define W_(i,j,k) ACCESS_ARRAY(W,i,j,k)
-#define H_(i,j,k) ACCESS_ARRAY(H,i,j,k)
-#define L_(i,j,k) ACCESS_ARRAY(L,i,j,k)
-#define Q_(i,j,k) ACCESS_ARRAY(Q,i,j,k)
-#define heap_pool_(i,j,k) ACCESS_ARRAY(heap_pool,i,j,k)
-#define start_points_(i,s) start_points[(i)+3*(s)]
-#define end_points_(i,s) end_points[(i)+3*(s)]
-
-/* Global variables */
-int n;			// size on X
-int p;			// size on Y
-int q;			// size on Z
-double* D = NULL;
-double* S = NULL;
-double* W = NULL;
-double* Q = NULL;
-double* values = NULL;
-double* start_points = NULL;
-double* end_points = NULL;
-double* H = NULL;
-double* L = NULL;
-int nb_iter_max = 100000;
-int nb_start_points = 0;
-int nb_end_points = 0;
-fibheap_el** heap_pool = NULL;
-
-struct point
-{
-	point( int ii, int jj, int kk )
-	{ i = ii; j = jj; k = kk; }
-	int i,j,k;
-};
-typedef std::vector<point*> point_list;
+#define start_points_(i,s) fp.start_points[(i)+3*(s)]
+#define end_points_(i,s) fp.end_points[(i)+3*(s)]
 
-inline bool end_points_reached(const int i, const int j, const int k )
+// end points of one propagation: 1 for an end point not reached yet, 2 once
+// it is dead, 0 otherwise, so that testing a dead point is O(1)
+struct EndPoints3D
 {
-	for( int s=0; s<nb_end_points; ++s )
+	EndPoints3D( const FrontPropagation3D& fp ) : nb_reached(0), nb_target(0)
 	{
-		if( i==((int)end_points_(0,s)) && j==((int)end_points_(1,s)) && k==((int)end_points_(2,s)) )
-			return true;
-	}
-	return false;
-}
-
-inline 
-int compare_points(void *x, void *y)
-{
-	point& a = *( (point*) x );
-	point& b = *( (point*) y );
-	if( H==NULL )
-		return cmp( D_(a.i,a.j,a.k), D_(b.i,b.j,b.k) );
-	else
-		return cmp( D_(a.i,a.j,a.k)+H_(a.i,a.j,a.k), D_(b.i,b.j,b.k)+H_(b.i,b.j,b.k) );
-}
-
-// test the heap validity
-void check_heap( int i, int j, int k )
-{
-	for( int x=0; x<n; ++x )
-	for( int y=0; y<p; ++y )
-	for( int z=0; z<q; ++z )
-	{
-		if( heap_pool_(x,y,z)!=NULL )
+		int n = fp.n, p = fp.p, q = fp.q;
+		if( fp.nb_end_points==0 && fp.end_points_mask==NULL )
+			return;
+		pool.assign( n*p*q, 0 );
+		for( int s=0; s<fp.nb_end_points; ++s )
 		{
-			point& pt = * ((point*) heap_pool_(x,y,z)->fhe_data );
-			if( H==NULL )
+			int i = (int) end_points_(0,s);
+			int j = (int) end_points_(1,s);
+			int k = (int) end_points_(2,s);
+			if( i>=0 && i<n && j>=0 && j<p && k>=0 && k<q && pool[i+n*j+n*p*k]==0 )
 			{
-				if( D_(i,j,k)>D_(pt.i,pt.j,pt.k) )
-					ERROR_MSG("Problem with heap.\n");
+				pool[i+n*j+n*p*k] = 1;
+				nb_target++;
 			}
-			else
+		}
+		if( fp.end_points_mask!=NULL )
+		for( int s=0; s<n*p*q; ++s )
+		{
+			if( fp.end_points_mask[s] && pool[s]==0 )
 			{
-				if( D_(i,j,k)+H_(i,j,k)>D_(pt.i,pt.j,pt.k)+H_(pt.i,pt.j,pt.k) )
-					ERROR_MSG("Problem with heap.\n");
+				pool[s] = 1;
+				nb_target++;
 			}
 		}
+		nb_target = GW_MIN( GW_MAX(fp.nb_end_points_stop,1), nb_target );
 	}
-}
+	// true when enough end points are dead
+	bool reached( int s )
+	{
+		if( pool.empty() || pool[s]!=1 )
+			return false;
+		pool[s] = 2;
+		nb_reached++;
+		return nb_reached>=nb_target;
+	}
+	std::vector<unsigned char> pool;
+	int nb_reached;
+	int nb_target;
+};
 
-void perform_front_propagation_3d( T_callback_intert_node callback_insert_node ) 
+// Key gives the priority of a point: templated so that the usual case
+// without heuristic does not test H for every comparison
+template<class Key>
+void perform_front_propagation_3d( FrontPropagation3D& fp )
 { 
-	// create the Fibonacci heap
-	struct fibheap* open_heap = fh_makeheap();
-	fh_setcmp(open_heap, compare_points);
+	const int n = fp.n;
+	const int p = fp.p;
+	const int q = fp.q;
+	double* D = fp.D;
+	double* S = fp.S;
+	double* Q = fp.Q;
+	const double* W = fp.W;
+	const double* L = fp.L;
+	const double* values = fp.values;
+	T_callback_intert_node callback_insert_node = fp.callback_insert_node;
+	Key key( D, fp.H );
 
 	double h = 1.0/n;
 
 	// initialize points
-	for( int i=0; i<n; ++i )
-	for( int j=0; j<p; ++j )
-	for( int k=0; k<q; ++k )
+	for( int s=0; s<n*p*q; ++s )
 	{
-		D_(i,j,k) = GW_INFINITE;
-		S_(i,j,k) = kFar;
-		Q_(i,j,k) = -1;
+		D[s] = GW_INFINITE;
+		S[s] = kFar;
+		Q[s] = -1;
 	}
 
-	// record all the points
-	heap_pool = new fibheap_el*[n*p*q]; 
-	memset( heap_pool, NULL, n*p*q*sizeof(fibheap_el*) );
+	// the open points, pos[s] is the place of s in the heap
+	std::vector<int> pos( n*p*q, -1 );
+	GridHeap open_heap( &pos[0] );
+	EndPoints3D end_points( fp );
 
 	// initalize open list
-	point_list existing_points;
-	for( int s=0; s<nb_start_points; ++s )
+	for( int r=0; r<fp.nb_start_points; ++r )
 	{
-		int i = (int) start_points_(0,s);
-		int j = (int) start_points_(1,s);
-		int k = (int) start_points_(2,s);
+		int i = (int) start_points_(0,r);
+		int j = (int) start_points_(1,r);
+		int k = (int) start_points_(2,r);
+		int s = i+n*j+n*p*k;
+		double d = values==NULL ? 0 : values[r];
 
-		if( D_( i,j,k )==0 )
+		if( open_heap.contains(s) )
+		{
 			ERROR_MSG("start_points should not contain duplicates.");
-
-		point* pt = new point( i,j,k );
-		existing_points.push_back( pt );			// for deleting at the end
-		heap_pool_(i,j,k) = fh_insert( open_heap, pt );			// add to heap
-		if( values==NULL ) 
-			D_( i,j,k ) = 0;
-		else
-			D_( i,j,k ) = values[s];			
-		S_( i,j,k ) = kOpen;
-		Q_( i,j,k ) = s;
+			if( d<D[s] )
+			{
+				D[s] = d;
+				Q[s] = r;
+				open_heap.decrease( s, key(s) );
+			}
+			continue;
+		}
+		D[s] = d;
+		S[s] = kOpen;
+		Q[s] = r;
+		open_heap.push( s, key(s) );
 	}
 
 	// perform the front propagation
 	int num_iter = 0;
 	bool stop_iteration = GW_False;
-	while( !fh_isempty(open_heap) && num_iter<nb_iter_max && !stop_iteration )
+	while( !open_heap.empty() && num_iter<fp.nb_iter_max && !stop_iteration )
 	{
 		num_iter++;
 
 		// remove from open list and set up state to dead
-		point& cur_point = * ((point*) fh_extractmin( open_heap )); // current point
-		int i = cur_point.i;
-		int j = cur_point.j;
-		int k = cur_point.k;
-		heap_pool_(i,j,k) = NULL;
-		S_(i,j,k) = kDead;
-		stop_iteration = end_points_reached(i,j,k);
-
-		CHECK_HEAP;
+		int cur = open_heap.pop(); // current point
+		int i = cur%n;
+		int j = (cur/n)%p;
+		int k = cur/(n*p);
+		S[cur] = kDead;
+		stop_iteration = end_points.reached(cur);
 
 		// recurse on each neighbor
 		int nei_i[6] = {i+1,i,i-1,i,i,i};
 		int nei_j[6] = {j,j+1,j,j-1,j,j};
 		int nei_k[6] = {k,k,k,k,k-1,k+1};
-		for( int s=0; s<6; ++s )
+		for( int r=0; r<6; ++r )
 		{
-			int ii = nei_i[s];
-			int jj = nei_j[s];
-			int kk = nei_k[s];
+			int ii = nei_i[r];
+			int jj = nei_j[r];
+			int kk = nei_k[r];
 			
 			bool bInsert = true;
 			if( callback_insert_node!=NULL )
@@ -200,7 +174,8 @@ void perform_front_propagation_3d( T_callback_intert_node callback_insert_node )
 				
 			if( ii>=0 && jj>=0 && ii<n && jj<p && kk>=0 && kk<q && bInsert )
 			{
-				double P = h/W_(ii,jj,kk);
+				int s = ii+n*jj+n*p*kk;
+				double P = h/W[s];
 				// compute its neighboring values
 				double a1 = GW_INFINITE;
 				if( ii<n-1 )
@@ -247,46 +222,38 @@ void perform_front_propagation_3d( T_callback_intert_node callback_insert_node )
 						A1 = a1 + P;
 				}
 				// update the value
-				if( ((int) S_(ii,jj,kk)) == kDead )
+				if( ((int) S[s]) == kDead )
 				{
 					// check if action has change. Should not appen for FM
-					// if( A1<D_(ii,jj,kk) )
-					//	WARN_MSG("The update is not monotone");
-					if( A1<D_(ii,jj,kk) )	// should not happen for FM
+					if( A1<D[s] )	// should not happen for FM
 					{
-						D_(ii,jj,kk) = A1;
-						Q_(ii,jj,kk) = Q_(i,j,k);
+						D[s] = A1;
+						Q[s] = Q[cur];
 					}
 				}
-				else if( ((int) S_(ii,jj,kk)) == kOpen )
+				else if( ((int) S[s]) == kOpen )
 				{
 					// check if action has change.
-					if( A1<D_(ii,jj,kk) )
+					if( A1<D[s] )
 					{
-						D_(ii,jj,kk) = A1;
-						Q_(ii,jj,kk) = Q_(i,j,k);
+						D[s] = A1;
+						Q[s] = Q[cur];
 						// Modify the value in the heap
-						fibheap_el* cur_el = heap_pool_(ii,jj,kk);
-						if( cur_el!=NULL )
-							fh_replacedata( open_heap, cur_el, cur_el->fhe_data );	// use same data for update
-						else
-							ERROR_MSG("Error in heap pool allocation."); 							
+						open_heap.decrease( s, key(s) );
 					}
 				}
-				else if( ((int) S_(ii,jj,kk)) == kFar )
+				else if( ((int) S[s]) == kFar )
 				{
-					if( D_(ii,jj,kk)!=GW_INFINITE )
+					if( D[s]!=GW_INFINITE )
 						WARN_MSG("Distance must be initialized to Inf");  
-					if( L==NULL || A1<=L_(ii,jj,kk) )
+					if( L==NULL || A1<=L[s] )
 					{
-						S_(ii,jj,kk) = kOpen;
+						S[s] = kOpen;
 						// distance must have change.
-						D_(ii,jj,kk) = A1;
-						Q_(ii,jj,kk) = Q_(i,j,k);
+						D[s] = A1;
+						Q[s] = Q[cur];
 						// add to open list
-						point* pt = new point(ii,jj,kk);
-						existing_points.push_back( pt );
-						heap_pool_(ii,jj,kk) = fh_insert( open_heap, pt );			// add to heap	
+						open_heap.push( s, key(s) );
 					}
 				}
 				else 
@@ -294,14 +261,12 @@ void perform_front_propagation_3d( T_callback_intert_node callback_insert_node )
 			}	// end swich
 		}		// end for
 	}			// end while
+}
 
-	// free heap
-	fh_deleteheap(open_heap);
-	// free point pool
-	for( point_list::iterator it = existing_points.begin(); it!=existing_points.end(); ++it )
-		GW_DELETE( *it );
-	// free fibheap pool
-	GW_DELETEARRAY(heap_pool);
-	
-	return;
-}
\ No newline at end of file
+void perform_front_propagation_3d( FrontPropagation3D& fp )
+{
+	if( fp.H==NULL )
+		perform_front_propagation_3d<GridDistanceKey>( fp );
+	else
+		perform_front_propagation_3d<GridHeuristicKey>( fp );
+}
@@ -0,0 +1,156 @@
+/*=================================================================
+% perform_front_propagation_mesh.h - helpers shared by the mex files doing
+%   fast marching on a 3D mesh (perform_front_propagation_mesh, fast_marching_mesh).
+*=================================================================*/
+
+#ifndef _PERFORM_FRONT_PROPAGATION_MESH_H_
+#define _PERFORM_FRONT_PROPAGATION_MESH_H_
+
+#include <math.h>
+#include "config.h"
+#include <algorithm>
+#include <map>
+#include <vector>
+#include <list>
+#include <string>
+#include <iostream>
+#include <fstream>
+#include <string.h>
+using std::string;
+using std::cerr;
+using std::cout;
+using std::endl;
+
+#include "mex.h"
+#include "gw/gw_core/GW_Config.h"
+#include "gw/gw_core/GW_MathsWrapper.h"
+#include "gw/gw_geodesic/GW_GeodesicMesh.h"
+#include "gw/gw_geodesic/GW_GeodesicMarcher.h"
+using namespace GW;
+
+//================================================================
+// build the mesh and its connectivity from 3 x nverts vertex and 3 x nfaces
+// faces (0-based) MATLAB arrays. The mesh is only read by the propagations.
+void create_the_mesh(GW_GeodesicMesh& Mesh, const mxArray* vertex_arg, const mxArray* faces_arg)
+//================================================================
+{
+	if( mxGetM(vertex_arg)!=3 )
+		mexErrMsgTxt("vertex must be of size 3 x nverts.");
+	if( mxGetM(faces_arg)!=3 )
+		mexErrMsgTxt("face must be of size 3 x nfaces.");
+	const double* vertex = mxGetPr(vertex_arg);
+	int nverts = (int) mxGetN(vertex_arg);
+	const double* faces = mxGetPr(faces_arg);
+	int nfaces = (int) mxGetN(faces_arg);
+
+	Mesh.SetNbrVertex(nverts);
+	for( int i=0; i<nverts; ++i )
+	{
+		GW_GeodesicVertex& vert = (GW_GeodesicVertex&) Mesh.CreateNewVertex();
+		vert.SetPosition( GW_Vector3D(vertex[3*i],vertex[3*i+1],vertex[3*i+2]) );
+		Mesh.SetVertex(i, &vert);
+	}
+	Mesh.SetNbrFace(nfaces);
+	for( int i=0; i<nfaces; ++i )
+	{
+		for( int k=0; k<3; ++k )
+			if( faces[3*i+k]<0 || faces[3*i+k]>=nverts )
+				mexErrMsgTxt("faces must index vertices (0-based).");
+		GW_GeodesicFace& face = (GW_GeodesicFace&) Mesh.CreateNewFace();
+		GW_Vertex* v1 = Mesh.GetVertex((int) faces[3*i]); GW_ASSERT( v1!=NULL );
+		GW_Vertex* v2 = Mesh.GetVertex((int) faces[3*i+1]); GW_ASSERT( v2!=NULL );
+		GW_Vertex* v3 = Mesh.GetVertex((int) faces[3*i+2]); GW_ASSERT( v3!=NULL );
+		face.SetVertex( *v1,*v2,*v3 );
+		Mesh.SetFace(i, &face);
+	}
+	Mesh.BuildConnectivity();
+}
+
+//================================================================
+// returns the data of an optional per vertex array, NULL if it is empty
+const double* get_vertex_array(const mxArray* arg, int nverts, const char* errmsg)
+//================================================================
+{
+	if( arg==NULL || mxGetNumberOfElements(arg)==0 )
+		return NULL;
+	if( (int) mxGetNumberOfElements(arg)!=nverts )
+		mexErrMsgTxt(errmsg);
+	return mxGetPr(arg);
+}
+
+//================================================================
+// reads a list of vertex indices (0-based) into ids
+void get_vertex_list(const mxArray* arg, int nverts, T_U32Vector& ids, const char* errmsg)
+//================================================================
+{
+	ids.clear();
+	if( arg==NULL )
+		return;
+	const double* p = mxGetPr(arg);
+	int n = (int) mxGetNumberOfElements(arg);
+	for( int i=0; i<n; ++i )
+	{
+		if( p[i]<0 || p[i]>=nverts )
+			mexErrMsgTxt(errmsg);
+		ids.push_back( (GW_U32) p[i] );
+	}
+}
+
+//================================================================
+// reads a set of end vertices, given either as a list of indices (0-based)
+// or as a logical mask of size nverts
+void get_end_points(const mxArray* arg, int nverts, T_U32Vector& ids, const char* errmsg)
+//================================================================
+{
+	if( arg==NULL || !mxIsLogical(arg) )
+	{
+		get_vertex_list( arg, nverts, ids, errmsg );
+		return;
+	}
+	ids.clear();
+	if( mxGetNumberOfElements(arg)==0 )
+		return;
+	if( (int) mxGetNumberOfElements(arg)!=nverts )
+		mexErrMsgTxt(errmsg);
+	const mxLogical* mask = mxGetLogicals(arg);
+	for( int i=0; i<nverts; ++i )
+		if( mask[i] )
+			ids.push_back( (GW_U32) i );
+}
+
+//================================================================
+// number of end vertices to reach before stopping: 1 (first hit) if empty,
+// Inf for all of them
+GW_U32 get_end_points_stop(const mxArray* arg)
+//================================================================
+{
+	if( arg==NULL || mxGetNumberOfElements(arg)==0 )
+		return 1;
+	double k = *mxGetPr(arg);
+	if( k<1 )
+		mexErrMsgTxt("end_points_stop must be at least 1.");
+	return k>=4294967295. ? 0xFFFFFFFF : (GW_U32) k;
+}
+
+//================================================================
+// copies the result of a propagation into the columns of D, S, Q (any can be NULL)
+void store_propagation(GW_GeodesicMarcher& Marcher, double* D, double* S, double* Q)
+//================================================================
+{
+	int nverts = (int) Marcher.GetNbrVertex();
+	for( int i=0; i<nverts; ++i )
+	{
+		if( D!=NULL ) D[i] = GW_INFINITE;
+		if( S!=NULL ) S[i] = GW_GeodesicVertex::kFar;
+		if( Q!=NULL ) Q[i] = -1;
+	}
+	T_U32Vector& reached = Marcher.GetReachedVertex();
+	for( IT_U32Vector it=reached.begin(); it!=reached.end(); ++it )
+	{
+		if( D!=NULL ) D[*it] = Marcher.GetDistance(*it);
+		if( S!=NULL ) S[*it] = Marcher.GetState(*it);
+		if( Q!=NULL ) Q[*it] = Marcher.GetFront(*it);
+	}
+}
+
+#endif // _PERFORM_FRONT_PROPAGATION_MESH_H_
@@ -1,4 +1,9 @@
 % function dist = perform_dijkstra_fast(A, startIDs)
-% A: a square distance matrix
+% function dist = perform_dijkstra_fast(A, startIDs, rmax)
+% A: a square sparse distance matrix
 % startIDs: a one dimensional matrix
+% dist: length(startIDs) x size(A,1), dist(k,j) is the distance from startIDs(k) to j
+% rmax: optional cutoff radius, dist is then sparse and only holds the
+%   distances <= rmax, the other nodes are not explored.
+% The sources run in parallel when compiled with OpenMP (see compile_mex).
 % Copyright (c) 2014 Junjie Cao
\ No newline at end of file
@@ -18,7 +18,10 @@ function [D,S,Q] = perform_fast_marching_mesh(vertex, faces, start_points, optio
 %   Optional:
 %   - You can provide non-uniform speed in options.W.
 %   - You can provide special conditions for stop in options :
-%       'options.end_points' : stop when these points are reached
+%       'options.end_points' : stop when these points are reached, given
+%          as indices or as a logical mask of size nverts.
+%       'options.end_points_stop' : number of end points to reach before
+%          stopping, 1 (default) for the first one, Inf for all of them.
 %       'options.nb_iter_max' : stop when a given number of iterations is
 %          reached.
 %   - You can provide an heuristic in options.heuristic (typically that try to guess the distance
@@ -28,6 +31,9 @@ function [D,S,Q] = perform_fast_marching_mesh(vertex, faces, start_points, optio
 %       explored points. Only points with current distance smaller than L
 %       will be expanded. Set some entries of L to -Inf to avoid any
 %       exploration of these points.
+%   - options.heap_rebuild=1 rebuilds the whole heap each time an open point
+%       is updated, as older versions did. It is much slower on large meshes
+%       and only kept for benchmarking (see test_perform_fast_marching_mesh_heap).
 %
 %
 %   adapted by junjie cao
@@ -46,6 +52,8 @@ L       = getoptions(options, 'constraint_map', []);
 H       = getoptions(options, 'heuristic', []);
 values  = getoptions(options, 'values', []);
 dmax    = getoptions(options, 'dmax', 1e9);
+heap_rebuild = getoptions(options, 'heap_rebuild', 0);
+end_points_stop = getoptions(options, 'end_points_stop', 1);
 
 I = find(L==-Inf); L(I)=-1e9;
 I = find(L==Inf); L(I)=1e9;
@@ -60,10 +68,13 @@ if size(faces,1)>size(faces,2)
 end
 start_points = start_points(:);
 end_points = end_points(:);
+if ~islogical(end_points)
+    end_points = end_points-1;
+end
 
 % use fast C-coded version if possible
 if exist('perform_front_propagation_mesh')~=0 %% adapted by jjcao
-    [D,S,Q] = perform_front_propagation_mesh(vertex, faces-1, W,start_points-1,end_points-1, nb_iter_max, H, L, values, dmax);
+    [D,S,Q] = perform_front_propagation_mesh(vertex, faces-1, W,start_points-1,end_points, nb_iter_max, H, L, values, dmax, heap_rebuild, end_points_stop);
     Q = Q+1;
 else
     error('You have to run compiler_mex before.');
@@ -0,0 +1,71 @@
+function [D,S,Q] = perform_fast_marching_mesh_batch(vertex, faces, start_points, options)
+
+% perform_fast_marching_mesh_batch - many independent Fast Marching on a 3D mesh.
+%
+%   [D,S,Q] = perform_fast_marching_mesh_batch(vertex, faces, start_points, options)
+%
+%   vertex, faces: a 3D mesh, can be [] if options.mesh_handle is given.
+%   start_points is either a vector: one propagation from each start_points(j),
+%       or a cell array: one propagation from each set of points start_points{j}.
+%
+%   D(:,j), S(:,j), Q(:,j) are the results of the jth propagation, see
+%   perform_fast_marching_mesh. The propagations run in parallel.
+%
+%   Optional:
+%   - options.W, options.nb_iter_max, options.constraint_map, options.dmax,
+%       options.end_points, options.end_points_stop :
+%       as in perform_fast_marching_mesh, the same for every propagation.
+%   - options.mesh_handle : a mesh built by
+%           h = fast_marching_mesh('build', vertex', faces'-1);
+%       to avoid building the mesh and its connectivity at each call. It
+%       must be released with fast_marching_mesh('delete', h).
+
+options.null = 0;
+h       = getoptions(options, 'mesh_handle', []);
+W       = getoptions(options, 'W', []);
+nb_iter_max = getoptions(options, 'nb_iter_max', Inf);
+L       = getoptions(options, 'constraint_map', []);
+dmax    = getoptions(options, 'dmax', 1e9);
+end_points = getoptions(options, 'end_points', []);
+end_points_stop = getoptions(options, 'end_points_stop', 1);
+
+I = find(L==-Inf); L(I)=-1e9;
+I = find(L==Inf); L(I)=1e9;
+
+if exist('fast_marching_mesh')==0
+    error('You have to run compiler_mex before.');
+end
+
+if isempty(h)
+    if size(vertex,1)>size(vertex,2)
+        vertex = vertex';
+    end
+    if size(faces,1)>size(faces,2)
+        faces = faces';
+    end
+    mesh = fast_marching_mesh('build', vertex, faces-1);
+else
+    mesh = h;
+end
+
+if iscell(start_points)
+    for j=1:length(start_points)
+        start_points{j} = start_points{j}(:)-1;
+    end
+else
+    start_points = start_points(:)-1;
+end
+end_points = end_points(:);
+if ~islogical(end_points)
+    end_points = end_points-1;
+end
+
+[D,S,Q] = fast_marching_mesh('propagate', mesh, W(:), start_points, nb_iter_max, L(:), dmax, end_points, end_points_stop);
+Q = Q+1;
+
+if isempty(h)
+    fast_marching_mesh('delete', mesh);
+end
+
+% replace C 'Inf' value (1e9) by Matlab Inf value.
+D(D>1e8) = Inf;
@@ -0,0 +1,56 @@
+function D = perform_heat_geodesic_mesh(vertex, faces, start_points, options)
+
+% perform_heat_geodesic_mesh - geodesic distances on a 3D mesh by the heat method.
+%
+%   D = perform_heat_geodesic_mesh(vertex, faces, start_points, options)
+%
+%   vertex, faces: a 3D mesh, can be [] if options.mesh_handle is given.
+%   start_points is either a vector: one distance to each start_points(j),
+%       or a cell array: one distance to each set of points start_points{j}.
+%
+%   D(:,j) is the distance to the jth start set, see Geodesics in Heat,
+%   Crane et al. 13. It is approximate (a few percent on a regular mesh) but
+%   each set only costs two back substitutions once the mesh is factored,
+%   and the sets are solved in parallel.
+%
+%   Optional:
+%   - options.t_factor : the time step is t_factor*(mean edge length)^2,
+%       1 by default, larger values give smoother distances.
+%   - options.mesh_handle : the factorizations of a mesh, built by
+%           h = heat_geodesic('build', vertex', faces'-1, t_factor);
+%       to factor the mesh only once for many calls. It must be released
+%       with heat_geodesic('delete', h).
+
+options.null = 0;
+h        = getoptions(options, 'mesh_handle', []);
+t_factor = getoptions(options, 't_factor', 1);
+
+if exist('heat_geodesic')==0
+    error('You have to run compiler_mex before.');
+end
+
+if isempty(h)
+    if size(vertex,1)>size(vertex,2)
+        vertex = vertex';
+    end
+    if size(faces,1)>size(faces,2)
+        faces = faces';
+    end
+    mesh = heat_geodesic('build', vertex, faces-1, t_factor);
+else
+    mesh = h;
+end
+
+if iscell(start_points)
+    for j=1:length(start_points)
+        start_points{j} = start_points{j}(:)-1;
+    end
+else
+    start_points = start_points(:)-1;
+end
+
+D = heat_geodesic('distance', mesh, start_points);
+
+if isempty(h)
+    heat_geodesic('delete', mesh);
+end
@@ -25,6 +25,18 @@ toc
 D1 = perform_dijkstra_fast(A, start_points)';
 sum(sum(abs(D - D1)))
 
+%% all sources at once, with and without a cutoff radius
+tic
+Dall = perform_dijkstra_fast(W, 1:nverts);
+toc
+rmax = 0.1*diagLength;
+tic
+Dr = perform_dijkstra_fast(W, 1:nverts, rmax);
+toc
+Dall(Dall>rmax) = 0;
+disp(['cutoff error: ' num2str(full(max(max(abs(Dr - Dall))))) ', density: ' num2str(nnz(Dr)/numel(Dr))]);
+clear Dall Dr;
+
 %% show the result
 i = 1;
 figure('Name','shortest distance by Dijkstra using distance matrix'); set(gcf,'color','white');
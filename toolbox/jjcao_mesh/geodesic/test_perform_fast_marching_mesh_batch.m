@@ -0,0 +1,43 @@
+% test_perform_fast_marching_mesh_batch
+%
+% many independent propagations on a mesh built once, compared to calling
+% perform_fast_marching_mesh for each source.
+
+clear;clc;close all;
+MYTOOLBOXROOT='../..';
+addpath ([MYTOOLBOXROOT '/jjcao_mesh'])
+addpath ([MYTOOLBOXROOT '/jjcao_io'])
+addpath ([MYTOOLBOXROOT '/jjcao_plot'])
+addpath ([MYTOOLBOXROOT '/jjcao_mesh/geodesic'])
+addpath ([MYTOOLBOXROOT '/jjcao_common'])
+
+%% read mesh
+[verts,faces] = read_mesh([MYTOOLBOXROOT '/data/wolf0.off']);
+nverts = size(verts,1);
+sources = round(linspace(1, nverts, 64));
+
+%% one call per source
+options.nb_iter_max = Inf;
+tic
+D = zeros(nverts, length(sources));
+for j=1:length(sources)
+    D(:,j) = perform_fast_marching_mesh(verts, faces, sources(j), options);
+end
+disp(sprintf('%d calls to perform_fast_marching_mesh: %.3fs', length(sources), toc));
+
+%% one batch, the mesh is built once
+tic
+h = fast_marching_mesh('build', verts', faces'-1);
+options.mesh_handle = h;
+D1 = perform_fast_marching_mesh_batch([], [], sources, options);
+disp(sprintf('perform_fast_marching_mesh_batch: %.3fs, max difference %g', toc, max(abs(D(:)-D1(:)))));
+
+%% multi-source propagations reuse the same mesh
+landmark = {[2686,4132]+1, 2686+1};
+[D2,S2,Q2] = perform_fast_marching_mesh_batch([], [], landmark, options);
+fast_marching_mesh('delete', h);
+
+options = rmfield(options, 'mesh_handle');
+options.start_points = landmark{1};
+figure('name', 'geodesic distance to two landmarks, from a batch');
+plot_fast_marching_mesh(verts, faces, D2(:,1), [], options);
@@ -0,0 +1,44 @@
+% test_perform_fast_marching_mesh_heap
+%
+% benchmark of the heap used by perform_front_propagation_mesh: open points
+% are now moved in place when their distance decreases, older versions
+% rebuilt the whole heap instead (options.heap_rebuild=1).
+
+clear;clc;close all;
+MYTOOLBOXROOT='../..';
+addpath ([MYTOOLBOXROOT '/jjcao_mesh'])
+addpath ([MYTOOLBOXROOT '/jjcao_io'])
+addpath ([MYTOOLBOXROOT '/jjcao_mesh/geodesic'])
+addpath ([MYTOOLBOXROOT '/jjcao_common'])
+
+%% read mesh
+[verts,faces] = read_mesh([MYTOOLBOXROOT '/data/wolf0.off']);
+landmark = [2686,4132]+1;% start points
+options.nb_iter_max = Inf;
+
+%% compare both heaps on meshes of increasing size
+nsub = 0:2; % each subdivision multiplies the number of vertices by about 4
+tnew = zeros(size(nsub)); told = tnew; nv = tnew;
+for i = 1:length(nsub)
+    if nsub(i)>0
+        sub_options.sub_type = 'linear4';
+        [v,f] = perform_mesh_subdivision(verts', faces', nsub(i), sub_options);
+        v = v'; f = f';
+    else
+        v = verts; f = faces;
+    end
+    nv(i) = size(v,1);
+
+    options.heap_rebuild = 0;
+    tic; D = perform_fast_marching_mesh(v, f, landmark, options); tnew(i) = toc;
+    options.heap_rebuild = 1;
+    tic; D1 = perform_fast_marching_mesh(v, f, landmark, options); told(i) = toc;
+
+    fprintf('%8d vertices: %.3fs (in place update), %.3fs (heap rebuild), max difference %g\n', ...
+        nv(i), tnew(i), told(i), max(abs(D-D1)));
+end
+
+figure('name', 'fast marching time');
+loglog(nv, tnew, 'b-o', nv, told, 'r-o');
+legend('in place update', 'heap rebuild', 'Location', 'NorthWest');
+xlabel('number of vertices'); ylabel('time (s)');
@@ -0,0 +1,45 @@
+% test_perform_heat_geodesic_mesh
+%
+% heat method distances from a mesh factored once, compared to fast marching.
+
+clear;clc;close all;
+MYTOOLBOXROOT='../..';
+addpath ([MYTOOLBOXROOT '/jjcao_mesh'])
+addpath ([MYTOOLBOXROOT '/jjcao_io'])
+addpath ([MYTOOLBOXROOT '/jjcao_plot'])
+addpath ([MYTOOLBOXROOT '/jjcao_mesh/geodesic'])
+addpath ([MYTOOLBOXROOT '/jjcao_common'])
+
+%% read mesh
+[verts,faces] = read_mesh([MYTOOLBOXROOT '/data/wolf0.off']);
+nverts = size(verts,1);
+sources = round(linspace(1, nverts, 64));
+
+%% fast marching, one batch
+options.nb_iter_max = Inf;
+tic
+D = perform_fast_marching_mesh_batch(verts, faces, sources, options);
+disp(sprintf('perform_fast_marching_mesh_batch: %.3fs', toc));
+
+%% heat method, factored once
+tic
+h = heat_geodesic('build', verts', faces'-1, 1);
+disp(sprintf('heat_geodesic build: %.3fs', toc));
+options.mesh_handle = h;
+tic
+D1 = perform_heat_geodesic_mesh([], [], sources, options);
+disp(sprintf('perform_heat_geodesic_mesh: %.3fs, mean relative difference %g', toc, sum(abs(D(:)-D1(:)))/sum(D(:))));
+
+% one set at a time gives the same columns as the batch
+D2 = perform_heat_geodesic_mesh([], [], sources(7), options);
+disp(sprintf('single vs batch, max difference %g', max(abs(D2-D1(:,7)))));
+
+%% multi-source
+landmark = {[2686,4132]+1, 2686+1};
+D3 = perform_heat_geodesic_mesh([], [], landmark, options);
+heat_geodesic('delete', h);
+
+options = rmfield(options, 'mesh_handle');
+options.start_points = landmark{1};
+figure('name', 'heat method distance to two landmarks');
+plot_fast_marching_mesh(verts, faces, D3(:,1), [], options);
@@ -0,0 +1,314 @@
+/*=================================================================
+% mesh_weight_kernel.h - all the edge weights of a triangle mesh in one pass.
+%
+%   type:
+%       0: 'combinatorial': W(i,j) = 1 if the edge (i,j) exists.
+%       1: 'distance': W(i,j) = 1/d_ij^2.
+%       2: 'spring': W(i,j) = 1/d_ij.
+%       3: 'conformal' or 'dcp': W(i,j) = (cot(alpha_ij)+cot(beta_ij))/2.
+%       4: 'Laplace-Beltrami': W(i,j) = (1/area_i)*(cot(alpha_ij)+cot(beta_ij))/2.
+%       5: 'Manifold-harmonic': W(i,j) = (1/sqrt(area_i*area_j))*(cot(alpha_ij)+cot(beta_ij))/2.
+%       6: 'mvc': W(i,j) = sum of tan(theta/2)/d_ij, theta the angle at i of the faces of the edge.
+%   area_i is the mixed Voronoi area of vertex i (Discrete Differential-Geometry
+%   Operators for Triangulated 2-Manifolds, Meyer et al. 02), unless given.
+%
+%   The connectivity (faces around each vertex) is built once, the vertices
+%   can then be changed and W rebuilt, e.g. for a deforming mesh:
+%		MeshWeightKernel kernel(tri, nverts);
+%		kernel.set_vertices(verts, true);
+%		kernel.compute(3, NULL, W);		// W: a CscBuilder
+%
+%   The vertices are kept as separate x, y, z arrays and the angles, cotangents
+%   and lengths of all the faces are computed first in a flat loop over the
+%   faces, vectorized by the compiler and parallel over blocks of faces; then
+%   blocks of columns are gathered in parallel from the faces around each
+%   vertex and streamed to the sparse output.
+*=================================================================*/
+
+#ifndef MESH_WEIGHT_KERNEL_H
+#define MESH_WEIGHT_KERNEL_H
+
+#include <math.h>
+#include <vector>
+#include <algorithm>
+#include "sparse_csc_builder.h"
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+class MeshWeightKernel
+{
+public:
+	enum Type { COMBINATORIAL = 0, DISTANCE = 1, SPRING = 2, DCP = 3, LAPLACE_BELTRAMI = 4, MANIFOLD_HARMONIC = 5, MVC = 6 };
+
+	// tri holds the 3 zero-based vertices of each face
+	MeshWeightKernel(const std::vector<mwIndex>& tri, mwSize nverts)
+		: tri_(tri), nverts_(nverts), nfaces_(tri.size()/3)
+	{
+		ring_.build(tri_, nverts_);
+	}
+
+	// interleaved: x0 y0 z0 x1 ... (3 x n), otherwise x0 x1 ... y0 y1 ... (n x 3)
+	void set_vertices(const double* verts, bool interleaved)
+	{
+		x_.resize(nverts_);
+		y_.resize(nverts_);
+		z_.resize(nverts_);
+		for( mwSize i=0; i<nverts_; ++i )
+		{
+			if( interleaved )
+			{
+				x_[i] = verts[3*i];
+				y_[i] = verts[3*i+1];
+				z_[i] = verts[3*i+2];
+			}
+			else
+			{
+				x_[i] = verts[i];
+				y_[i] = verts[nverts_+i];
+				z_[i] = verts[2*nverts_+i];
+			}
+		}
+	}
+
+	static bool is_symmetric(int type) { return type!=LAPLACE_BELTRAMI && type!=MVC; }
+	static bool is_valid(int type) { return type>=COMBINATORIAL && type<=MVC; }
+
+	// W of the given type into W (opened here), vert_areas may be NULL; W is
+	// a CscBuilder or any sink with the same open/add/end_column
+	template<class Builder>
+	void compute(int type, const double* vert_areas, Builder& W)
+	{
+		compute_faces(type);
+		if( type==LAPLACE_BELTRAMI || type==MANIFOLD_HARMONIC )
+		{
+			if( vert_areas )
+				area_.assign(vert_areas, vert_areas+nverts_);
+			else
+				compute_mixed_areas();
+		}
+
+		long block = 1024*num_threads();
+		std::vector< std::vector< std::pair<mwIndex,double> > > columns(block);
+		for( long first=0; first<(long) nverts_ || first==0; first+=block )
+		{
+			long last = std::min((long) nverts_, first+block);
+			#pragma omp parallel for schedule(dynamic, 64)
+			for( long j=first; j<last; ++j )
+				gather_column(type, (mwIndex) j, columns[j-first]);
+
+			if( first==0 )
+				W.open(nverts_, nverts_, estimate_nnz(columns, last));
+			for( long j=first; j<last; ++j )
+			{
+				std::vector< std::pair<mwIndex,double> >& column = columns[j-first];
+				for( size_t k=0; k<column.size(); ++k )
+					W.add(column[k].first, column[k].second);
+				W.end_column();
+			}
+			if( nverts_==0 )
+				break;
+		}
+	}
+
+	// mixed Voronoi area of each vertex
+	const std::vector<double>& mixed_areas()
+	{
+		compute_faces(LAPLACE_BELTRAMI);
+		compute_mixed_areas();
+		return area_;
+	}
+
+private:
+	static int num_threads()
+	{
+#ifdef _OPENMP
+		return omp_get_max_threads();
+#else
+		return 1;
+#endif
+	}
+
+	//----------------------------------------------------------------
+	// per face and corner c (u, v: the edges from c to the next corners):
+	// cot_[c] cotangent of the angle at c, len2_[c] squared length of the
+	// edge opposite to c, tan_[c] tangent of the half angle at c
+	void compute_faces(int type)
+	{
+		bool angles = type>=DCP;
+		bool areas = type==LAPLACE_BELTRAMI || type==MANIFOLD_HARMONIC;
+		for( int c=0; c<3; ++c )
+		{
+			cot_[c].resize(angles ? nfaces_ : 0);
+			tan_[c].resize(type==MVC ? nfaces_ : 0);
+			len2_[c].resize(nfaces_);
+		}
+		area2_.resize(areas ? nfaces_ : 0);
+
+		const mwIndex* tri = nfaces_ ? &tri_[0] : NULL;
+		const double* x = nverts_ ? &x_[0] : NULL;
+		const double* y = nverts_ ? &y_[0] : NULL;
+		const double* z = nverts_ ? &z_[0] : NULL;
+		long nfaces = (long) nfaces_;
+		#pragma omp parallel for schedule(static)
+		for( long f=0; f<nfaces; ++f )
+		{
+			mwIndex v[3] = { tri[3*f], tri[3*f+1], tri[3*f+2] };
+			for( int c=0; c<3; ++c )
+			{
+				mwIndex p = v[c], q = v[(c+1)%3], r = v[(c+2)%3];
+				double ux = x[q]-x[p], uy = y[q]-y[p], uz = z[q]-z[p];
+				double vx = x[r]-x[p], vy = y[r]-y[p], vz = z[r]-z[p];
+				double wx = x[r]-x[q], wy = y[r]-y[q], wz = z[r]-z[q];
+				len2_[c][f] = wx*wx + wy*wy + wz*wz;
+				if( !angles )
+					continue;
+				// summed as Eigen does, the cotangents stay those of (u.v)/|u x v|
+				double dot = ux*vx + (uy*vy + uz*vz);
+				double cx = uy*vz - uz*vy, cy = uz*vx - ux*vz, cz = ux*vy - uy*vx;
+				double cross = sqrt(cx*cx + (cy*cy + cz*cz));
+				cot_[c][f] = cross!=0.0 ? dot/cross : 0.0;
+				if( type==MVC )
+				{
+					// tan(theta/2) = sin/(1+cos)
+					double lu = sqrt(ux*ux + uy*uy + uz*uz), lv = sqrt(vx*vx + vy*vy + vz*vz);
+					double den = lu*lv + dot;
+					tan_[c][f] = den>0.0 ? cross/den : 0.0;
+				}
+				if( areas && c==0 )
+					area2_[f] = cross;
+			}
+		}
+	}
+
+	// area of each vertex: the Voronoi part of its non-obtuse faces, half or
+	// a quarter of its obtuse faces
+	void compute_mixed_areas()
+	{
+		area_.resize(nverts_);
+		long nverts = (long) nverts_;
+		#pragma omp parallel for schedule(dynamic, 256)
+		for( long j=0; j<nverts; ++j )
+		{
+			double area = 0;
+			for( mwIndex k=ring_.start[j]; k<ring_.start[j+1]; ++k )
+			{
+				mwIndex f = ring_.face[k];
+				int c = corner(f, (mwIndex) j);
+				int a = (c+1)%3, b = (c+2)%3;
+				double farea = 0.5*area2_[f];
+				if( cot_[c][f]<0 )
+					area += 0.5*farea;
+				else if( cot_[a][f]<0 || cot_[b][f]<0 )
+					area += 0.25*farea;
+				else	// |PR|^2 cot(Q) + |PQ|^2 cot(R), the edges from c
+					area += 0.125*( len2_[a][f]*cot_[a][f] + len2_[b][f]*cot_[b][f] );
+			}
+			area_[j] = area;
+		}
+	}
+
+	int corner(mwIndex f, mwIndex j) const
+	{
+		const mwIndex* v = &tri_[3*f];
+		return v[0]==j ? 0 : (v[1]==j ? 1 : 2);
+	}
+
+	//----------------------------------------------------------------
+	// column j: the edges (s,t) of the faces around j, s=j or t=j
+	void gather_column(int type, mwIndex j, std::vector< std::pair<mwIndex,double> >& column)
+	{
+		column.clear();
+		for( mwIndex k=ring_.start[j]; k<ring_.start[j+1]; ++k )
+		{
+			mwIndex f = ring_.face[k];
+			const mwIndex* v = &tri_[3*f];
+			for( int l=0; l<3; ++l )
+			{
+				// edge l goes from corner l to l+1, the corner l+2 is opposite
+				int m = (l+2)%3;
+				mwIndex s = v[l], t = v[(l+1)%3];
+				if( s!=j && t!=j )
+					continue;
+				double len2 = len2_[m][f];
+				double w = 0;
+				switch( type )
+				{
+				case COMBINATORIAL:
+					w = 1;
+					break;
+				case DISTANCE:
+					w = len2>0 ? 1/len2 : 0;
+					break;
+				case SPRING:
+					w = len2>0 ? 1/sqrt(len2) : 0;
+					break;
+				case DCP:
+				case LAPLACE_BELTRAMI:
+				case MANIFOLD_HARMONIC:
+					w = 0.5*cot_[m][f];
+					break;
+				}
+				if( type==MVC )
+				{
+					double d = sqrt(len2);
+					if( t==j )
+						column.push_back( std::make_pair(s, d>0 ? tan_[l][f]/d : 0) );
+					if( s==j )
+						column.push_back( std::make_pair(t, d>0 ? tan_[(l+1)%3][f]/d : 0) );
+					continue;
+				}
+				if( t==j )
+					column.push_back( std::make_pair(s, w) );
+				if( s==j )
+					column.push_back( std::make_pair(t, w) );
+			}
+		}
+
+		// sorted by rows, duplicates summed in the order of the faces, or
+		// only once for the weights of the edge alone
+		std::stable_sort( column.begin(), column.end(), compare_rows );
+		bool once = type==COMBINATORIAL || type==DISTANCE || type==SPRING;
+		size_t count = 0;
+		for( size_t k=0; k<column.size(); )
+		{
+			std::pair<mwIndex,double> entry = column[k];
+			for( ++k; k<column.size() && column[k].first==entry.first; ++k )
+				if( !once )
+					entry.second += column[k].second;
+			column[count++] = entry;
+		}
+		column.resize(count);
+
+		if( type==LAPLACE_BELTRAMI )
+			for( size_t k=0; k<count; ++k )
+				column[k].second /= area_[column[k].first];
+		else if( type==MANIFOLD_HARMONIC )
+			for( size_t k=0; k<count; ++k )
+				column[k].second /= sqrt(area_[column[k].first]*area_[j]);
+	}
+
+	static bool compare_rows(const std::pair<mwIndex,double>& a, const std::pair<mwIndex,double>& b)
+	{
+		return a.first<b.first;
+	}
+
+	// nonzeros of the whole matrix extrapolated from the first block of columns
+	mwSize estimate_nnz(const std::vector< std::vector< std::pair<mwIndex,double> > >& columns, long ncols) const
+	{
+		double nnz = 0;
+		for( long j=0; j<ncols; ++j )
+			nnz += columns[j].size();
+		return (mwSize) (1.05*nnz*nverts_/std::max(ncols, 1L)) + 1;
+	}
+
+	std::vector<mwIndex> tri_;
+	mwSize nverts_, nfaces_;
+	VertexFaceRing ring_;
+	std::vector<double> x_, y_, z_;
+	std::vector<double> cot_[3], tan_[3], len2_[3];
+	std::vector<double> area2_;		// twice the area of each face
+	std::vector<double> area_;		// area of each vertex
+};
+
+#endif // MESH_WEIGHT_KERNEL_H
@@ -26,138 +26,43 @@
 			%           beta_ij are the adjacent angle to edge (i,j). 
 			%           Refer to Spectral Geometry Processing with Manifold Harmonics_08
 			%       6: 'mvc': W(i,j) = [tan(/_kij/2)+tan(/_jil/2)]/d_ij where /_kij and /_jil are angles at i
-		options.?:
+		options.vert_areas: 1*nverts, area_i of 4 and 5. Default: the mixed
+			Voronoi areas of Meyer et al. 02.
+		options.storage = 'upper': only triu(W) is returned, W = U + triu(U,1)'.
+		options.file = filename: W is written to the file, see read_csc_matrix.m,
+			and the number of nonzeros is returned.
+		options.precision = 'single': the values of the file are float32.
 *
-*           4 or 5 can be built on 3 in matlab.          
-*           just 0 & 3 are handled here. 1, 2 and 6 are left as todo.
+*           The angles and lengths of all the faces are computed first, then W is built
+*           column by column, the column of vertex j from the faces around j, directly
+*           into the sparse output (see mesh_weight_kernel.h and sparse_csc_builder.h).
+*           4 and 6 are not symmetric, W(i,j) is the weight of j for vertex i.
 *
 * JJCAO, 2013
 *
 *=================================================================*/
 
 #include <mex.h>
-#include <Eigen/Sparse>
-#include <Eigen/Dense>
 #include <vector>
+#include <sstream>
+#include "mesh_weight_kernel.h"
 
-using namespace Eigen;
 using namespace std;
 
-typedef Triplet<double> T;
-typedef SparseMatrix<double>::Index Index;
-typedef SparseMatrix<double>::Scalar Scalar;
-
-
-/// Return cotangent of (P,Q,R) corner (ie cotan of QP,QR angle).
-double cotangent(const Vector3d& P,
-                    const Vector3d& Q,
-                    const Vector3d& R)
-{
-
-    Vector3d u = P - Q;
-    Vector3d v = R - Q;
-    // (u . v)/((u x v).len)
-    double dot = u.dot(v);
-    Vector3d cross_vector = u.cross(v);
-    double cross_norm = std::sqrt(cross_vector.dot(cross_vector));
-    if(cross_norm != 0.0)
-        return (dot/cross_norm);
-    else
-        return 0.0; // undefined
-}
-
-////                                                  -> ->
-///// Return tangent of (P,Q,R) corner (ie tangent of QP,QR angle).
-//double tangent(const Point_3& P,
-//                const Point_3& Q,
-//                const Point_3& R)
-//{
-//    Vector_3 u = P - Q;
-//    Vector_3 v = R - Q;
-//    // (u . v)/((u x v).len)
-//    double dot = (u*v);
-//    CGAL_surface_mesh_parameterization_assertion(dot != 0.0);
-//    Vector_3 cross_vector = CGAL::cross_product(u,v);
-//    double cross_norm = std::sqrt(cross_vector*cross_vector);
-//    if(dot != 0.0)
-//        return (cross_norm/dot);
-//    else
-//        return 0.0; // undefined
-//}
-
-void compute_dcp_weight(double* verts, double* faces, int nverts, int nfaces, SparseMatrix<double>& sm)
-{
-	int i,j,m;
-	double dtmp;
-	std::vector<T> coef(nverts*6);	
-	for (int k = 0; k < nfaces; ++k)
-	{
-		int tmp = 3*k;
-		int face[3] = {faces[tmp],faces[tmp+1],faces[tmp+2]};			
-		for (int l = 0; l < 3; ++l)
-		{
-			i = face[l]; j = face[(l+1)%3]; m = face[(l+2)%3];
-			Vector3d p(verts[3*i],verts[3*i+1],verts[3*i+2]);
-			Vector3d q(verts[3*m],verts[3*m+1],verts[3*m+2]);
-			Vector3d r(verts[3*j],verts[3*j+1],verts[3*j+2]);
-			dtmp = 0.5*cotangent(p, q, r);
-			coef.push_back(T(i,j,dtmp));
-		}			
-	}
-	{
-		SparseMatrix<double> smtmp(nverts, nverts);
-		smtmp.setFromTriplets(coef.begin(), coef.end());
-		sm = SparseMatrix<double>(smtmp.transpose()) + smtmp;
-	}
-}
-
-void perform_mesh_weight(double* verts, int nverts, double *faces, int nfaces, int type, double *vert_areas, SparseMatrix<double>& sm)
+void perform_mesh_weight(double* verts, int nverts, const vector<mwIndex>& faces, int type, double *vert_areas, CscBuilder& sm)
 {	
-	switch(type)
+	if ( !MeshWeightKernel::is_valid(type) )
 	{
-	case 0: //'combinatorial' or 'graph'
-		// ܴ
-		{
-		int i,j;	
-		std::vector<T> coef(nverts*6);	
-		for (int k = 0; k < nfaces; ++k)
-		{
-			int tmp = 3*k;
-			int face[3] = {faces[tmp],faces[tmp+1],faces[tmp+2]};			
-			for (int l = 0; l < 3; ++l)
-			{
-				i = face[l]; j = face[(l+1)%3];
-				coef.push_back(T(i,j,1));
-			}			
-		}
-		sm.setFromTriplets(coef.begin(), coef.end());
-		//sm.coeffRef(1,1) = 2;sm.coeffRef(2,2) = 3;//sm.coeffRef(0,0) = 1;
-		}
-		break;
-	case 3: //'conformal' or 'dcp'		
-		compute_dcp_weight(verts, faces, nverts, nfaces, sm);
-		break;
-	//case 4: // 'Mean_curvature' or 'Laplace-Beltrami'	
-	//	//if (vert_areas == 0)
-	//	//{
-	//	//	stringstream ss("options.vert_areas is not offered! ");	 
-	//	//	mexErrMsgTxt(ss.str().c_str());
-	//	//}
-	//	compute_dcp_weight(verts, faces, nverts, nfaces, sm);
-	//	//{
-	//	//	for ( int i = 0; i < sm.rows(); ++i)
-	//	//	{
-	//	//		sm.row(i) = sm.row(i) * (1.0/vert_areas[i]);
-	//	//	}
-	//	//}
-	//	break;
-	default:
-		stringstream ss("type: ");	 
-		ss << type << " is not supported!";
+		stringstream ss;
+		ss << "type: " << type << " is not supported!";
 		mexErrMsgTxt(ss.str().c_str());
 	}
+	if ( sm.storage() == CscBuilder::UPPER && !MeshWeightKernel::is_symmetric(type) )
+		mexErrMsgTxt("options.storage = 'upper' needs a symmetric weight!");
 
-	sm.makeCompressed();
+	MeshWeightKernel kernel(faces, nverts);
+	kernel.set_vertices(verts, true);
+	kernel.compute(type, vert_areas, sm);
 }
 
 void mexFunction( int nlhs, mxArray *plhs[], int nrhs, const mxArray*prhs[])
@@ -201,46 +106,29 @@ void mexFunction( int nlhs, mxArray *plhs[], int nrhs, const mxArray*prhs[])
 			// options.vert_areas: 1*nverts
 			tmp = mxGetField(options,0,"vert_areas");
 			if (tmp)
-				vert_areas = mxGetPr(tmp);// not used!
-			//mexPrintf("%f, %f, %f\n", vert_areas[0],vert_areas[1],vert_areas[2]);	
+			{
+				if ( (int)mxGetNumberOfElements(tmp) != nverts )
+					mexErrMsgTxt("options.vert_areas should have nverts elements!");
+				vert_areas = mxGetPr(tmp);
+			}
 		}
 	}
 
 	///////////////////////////////////////////////	
+	vector<mwIndex> tri(nfaces*3);
 	for(int i = 0; i < nfaces*3; ++i)
-		--faces[i];
+	{
+		if (faces[i] < 1 || faces[i] > nverts)
+			mexErrMsgTxt("Face index out of bound.");
+		tri[i] = (mwIndex)faces[i] - 1;
+	}
 	
-	SparseMatrix<double> sm(nverts, nverts);
-	perform_mesh_weight(verts, nverts, faces, nfaces, *type, vert_areas, sm);
-
-	Index* innerInd = sm.innerIndexPtr();
-	Index* outerInd = sm.outerIndexPtr();
-	Scalar* valuePtr = sm.valuePtr();
+	CscBuilder sm;
+	if ( nrhs > 3) 
+		sm.parse_options(prhs[3]);
+	perform_mesh_weight(verts, nverts, tri, *type, vert_areas, sm);
 
 	///////////////////////////////////////////////
 	// output 0
-	//plhs[0] = mxCreateDoubleMatrix( nverts, nverts, mxREAL);
-    mwSize nzmax= sm.nonZeros();
-	plhs[0] = mxCreateSparse( nverts, nverts, nzmax, mxREAL);
-	double *L = mxGetPr(plhs[0]);
-	mwIndex *irs = mxGetIr(plhs[0]);//row index
-    mwIndex *jcs = mxGetJc(plhs[0]);//column index	
-	
-
-	for (int k = 0; k<nzmax; ++k)
-	{
-		//double dtmp = valuePtr[k];
-		//long ltmp = innerInd[k];
-		L[k] = valuePtr[k];
-		irs[k] = innerInd[k];
-		//mexPrintf("%f %f\n", L[k], irs[k]);
-	}
-
-	for (int k = 0; k<nverts; ++k)
-	{
-		//long ltmp = outerInd[k];
-		jcs[k] = outerInd[k];
-	}
-	//long ltmp = outerInd[nverts];
-	jcs[nverts]=outerInd[nverts];
-}
\ No newline at end of file
+	plhs[0] = sm.finish();
+}
@@ -1 +1,7 @@
-mex -I"../../../kdtree" compute_gaussian_weighted_curvature.cpp
\ No newline at end of file
+% the vertices are processed on all cores when compiled with OpenMP
+if ispc
+    omp = {'COMPFLAGS="$COMPFLAGS /openmp"'};
+else
+    omp = {'CXXFLAGS="$CXXFLAGS -fopenmp"', 'LDFLAGS="$LDFLAGS -fopenmp"'};
+end
+mex(omp{:}, '-I../../../kdtree', 'compute_gaussian_weighted_curvature.cpp')
@@ -1,58 +1,19 @@
 #include "KDTree.h"
+#include "KDTreeHandle.h"
 #include "mex.h"
-#include <numeric>
 
-void retrieve_tree( const mxArray* matptr, KDTree* & tree){
-    // retrieve pointer from the MX form
-    double* pointer0 = mxGetPr(matptr);
-    // check that I actually received something
-    if( pointer0 == NULL )
-        mexErrMsgTxt("vararg{1} must be a valid k-D tree pointer\n");
-    // convert it to "long" datatype (good for addresses)
-    long pointer1 = (long) pointer0[0];
-    // convert it to "KDTree"
-    tree = (KDTree*) pointer1;
-    // check that I actually received something
-    if( tree == NULL )
-        mexErrMsgTxt("vararg{1} must be a valid k-D tree pointer\n");
-    if( tree -> ndims() <= 0 )
-        mexErrMsgTxt("the k-D tree must have k>0"); 
-}
 
-void retrieve_delta( const mxArray* matptr, double& delta ){
+void retrieve_delta( const mxArray* matptr, vector<double>& delta ){
     // check that I actually received something
     if( matptr == NULL )
-        mexErrMsgTxt("vararg{3} must be a scalar\n");
+        mexErrMsgTxt("vararg{3} must be a scalar or a vector\n");
 
-    if( 1 != mxGetM(matptr) || !mxIsNumeric(matptr) || 1 != mxGetN(matptr) )
-    	mexErrMsgTxt("vararg{3} must be a scalar\n");    
+    if( !mxIsNumeric(matptr) || mxIsEmpty(matptr) || (1 != mxGetM(matptr) && 1 != mxGetN(matptr)) )
+    	mexErrMsgTxt("vararg{3} must be a scalar or a vector\n");    
     
-    // retrieve point
-	delta = mxGetScalar(matptr);	
-}
-
-double gaussian_weighted_curcature(vector<double> &point, double qradi, KDTree* tree, double* curvature)
-{
-    double rval(0.0);
-    vector<int> idxsInRange;
-    vector<double> dists;
-    tree->ball_query( point, qradi, idxsInRange, dists );
-
-    ///////////////////////////////////////////////
-    vector<double> temp(idxsInRange.size(),0);
-    for(int k = 0;k < temp.size(); ++k)
-    {
-        temp[k] = -dists[k]*dists[k];
-        temp[k] = temp[k]/(qradi*qradi*0.5);
-        temp[k] = exp(temp[k]);
-    }
-    for(int k = 0;k < temp.size(); ++k)
-    {
-        rval += curvature[idxsInRange[k]]*temp[k];
-    }
-    rval /= std::accumulate(temp.begin(), temp.end(), 0);
-
-	return rval;
+    // retrieve the scales
+    double* pr = mxGetPr(matptr);
+	delta.assign( pr, pr + mxGetNumberOfElements(matptr) );
 }
 
 //GaussWeighcurvature= compute_gaussian_weighted_curvature(vertex,Cmean,delta,tree)
@@ -79,37 +40,51 @@ void mexFunction(int nlhs, mxArray * plhs[], int nrhs, const mxArray * prhs[])
 	int column_curvature=mxGetN(prhs[1]); //þ
 	double *curvature = mxGetPr( prhs[1] );
 
-	 // retrieve the delta
-    double delta = 0;
+	 // retrieve the deltas, one or several scales
+    vector<double> delta;
     retrieve_delta(prhs[2], delta);
+    int nscales = 2*delta.size();
 
 	// retrieve the tree pointer
-    KDTree* tree;
-    retrieve_tree( prhs[3], tree ); 
+    KDTree* tree = kdtree_handle_get( prhs[3] ); 
+    if( row_curvature*column_curvature < tree->size() )
+		mexErrMsgTxt("varargin{1} must have a mean curvature for every point of the kdtree\n");
     
-    /////////////////////////////////////////////////// retrieve the query point  
-    vector<double> gw1(row_vertex,0),gw2(row_vertex,0);
-	double qradi = 2*delta;
-    double  qradii = 2*qradi;
-	for (int i = 0;i < row_vertex;++i)
-	{
-		vector<double> point(column_vertex,0);
-		for (int j = 0;j < column_vertex; ++j)
-		{
-			point[j] = vertex[j*row_vertex+i];			
-		}
-        gw1[i] = gaussian_weighted_curcature(point, qradi, tree, curvature);
-        gw2[i] = gaussian_weighted_curcature(point, qradii, tree, curvature);
-	}
-    
-    plhs[0] = mxCreateDoubleMatrix(row_vertex, 2, mxREAL);
+    /////////////////////////////////////////////////// the two Gaussians of every delta
+    // sigma = delta and 2*delta, each one cut at radius 2*sigma
+    vector<double> radius(nscales), sigma2(nscales);
+    for (int s = 0; s < delta.size(); ++s)
+    {
+        radius[2*s] = 2*delta[s];
+        sigma2[2*s] = delta[s]*delta[s];
+        radius[2*s+1] = 4*delta[s];
+        sigma2[2*s+1] = 4*delta[s]*delta[s];
+    }
+
+    plhs[0] = mxCreateDoubleMatrix(row_vertex, nscales, mxREAL);
     double* Arr =(double*)mxGetPr(plhs[0]);
 
-    for(int i = 0;i < row_vertex;++i)
+    // all the scales of a vertex come from a single ball query
+    #pragma omp parallel
     {
-        Arr[i] = gw1[i];
-        Arr[i + row_vertex] = gw2[i];
-    }    
-    //printf("function end\n");   
+        KDTreeQuery query;
+        vector<double> point(column_vertex,0);
+        vector<double> gw(nscales,0);
+        vector<int> count(nscales,0);
+
+        #pragma omp for schedule(dynamic,64)
+        for (int i = 0;i < row_vertex;++i)
+        {
+            for (int j = 0;j < column_vertex; ++j)
+            {
+                point[j] = vertex[j*row_vertex+i];			
+            }
+            tree->gaussian_averages( query, &point[0], nscales, &radius[0], &sigma2[0], curvature, 1, row_curvature, &gw[0], &count[0] );
+            for (int s = 0;s < nscales;++s)
+            {
+                Arr[i + s*row_vertex] = gw[s];
+            }
+        }
+    }
 }
 //#endif
@@ -1,6 +1,16 @@
 % function  GaussWeighcurvature= compute_gaussian_weighted_curvature(vertex,Cmean,delta,tree)
 % c++ comments
 %
+% Gaussian weighted average of the mean curvature Cmean around every vertex,
+% with sigma = delta (neighbors within 2*delta) and sigma = 2*delta (neighbors
+% within 4*delta).
+%
+% delta: a scalar, or a vector of the deltas of several scales
+% GaussWeighcurvature: n*2 for a scalar delta, n*(2*numel(delta)) otherwise:
+%   columns 2*s-1 and 2*s are the averages of delta(s).
+%
+% All the scales of a vertex are computed from a single ball query (at the
+% largest radius), the vertices in parallel when compiled with OpenMP.
 
 %% matlab implementation
 % function  GaussWeighcurvature= compute_gaussian_weighted_curvature(vertex,Cmean,delta,tree)
@@ -46,11 +46,12 @@ end
 %%
 finalsalency = zeros(M.nverts,1);
 saliency = zeros(M.nverts,5);
-for i= 2:size(saliency,2)+1
-    delta = i*eps;
-    GaussWeighcurvature = compute_gaussian_weighted_curvature(M.verts,Cmean,delta,tree);%%%ƽʸ˹Ȩƽ
+delta = (2:size(saliency,2)+1)*eps;
+tic
+GaussWeighcurvature = compute_gaussian_weighted_curvature(M.verts,Cmean,delta,tree);%%%ƽʸ˹Ȩƽ
 toc
-    saliency(:,i-1) = GaussWeighcurvature(:,1) - GaussWeighcurvature(:,2);
+for i= 2:size(saliency,2)+1
+    saliency(:,i-1) = GaussWeighcurvature(:,2*i-3) - GaussWeighcurvature(:,2*i-2);
     saliency(:,i-1) = abs(saliency(:,i-1)); %%%%ֵ
 
     if DEBUG
@@ -46,19 +46,20 @@ c = mean(sqrt(dist2));% average distance of all edges
 sumDistPerVert = sum( sparse(I,J, sqrt(dist2)), 2);
 k = c*sum(A,2)./sumDistPerVert + 1;
 
-j = 1;
-for i = t
+% Mt and Mkt of every t, from a single ball query per vertex
+sigma2 = [repmat(t, M.nverts, 1), k*t];
+[vertsT, nneighT] = gaussian_smoothing(M.verts, M.verts, dist_const*sqrt(sigma2), sigma2, tree);
+for j = 1:length(t)
     % Mt
-    [verts1, nneigh] = gaussian_smoothing(M.verts, M.verts, dist_const*sqrt(i)*ones(M.nverts,1), i*ones(M.nverts,1), tree);    
+    verts1 = vertsT(:,:,j);
     % SMt: saliency of Mt
     SMt = log_spectral_saliency(verts1, M.faces, options);
     % Mkt
-    [verts2, nneigh] = gaussian_smoothing(M.verts, M.verts,dist_const*sqrt(i*k), i*k, tree);
+    verts2 = vertsT(:,:,length(t)+j); nneigh = nneighT(:,length(t)+j);
     % SMkt: saliency of Mkt
     SMkt = log_spectral_saliency(verts2, M.faces, options);   
     % absolute difference of them
     S(:,j) = abs(SMkt - SMt);
-    j = j + 1;
     sprintf('mean of |neighbors|: %f, if it is too small, it means that sigma2 is too low!', mean(nneigh))
     % map back to original mesh
     % ...    
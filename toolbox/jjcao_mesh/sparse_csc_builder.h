@@ -0,0 +1,393 @@
+/*=================================================================
+% sparse_csc_builder.h - builds a sparse matrix column by column,
+%   directly in the compressed sparse column (CSC) format of MATLAB.
+%
+%   The columns are given in increasing order, the entries of one column
+%   in any order; duplicated rows are summed. Only the current column is
+%   buffered, so no triplet arrays are needed. The output is either
+%     - a MATLAB sparse matrix, preallocated and grown in place, or
+%     - a file holding the CSC arrays, for matrices larger than the
+%       memory: only the column pointers stay in memory, the values may
+%       be stored in single precision. Read it back (or memory map it)
+%       with read_csc_matrix.m.
+%   With storage 'upper' only the entries on and above the diagonal of a
+%   symmetric matrix are kept: W = U + triu(U,1)'.
+%
+%   usage:
+%		CscBuilder W;
+%		W.parse_options(options);	// options.storage, options.file, options.precision
+%		W.open(m, n, nzmax);
+%		for( j=0; j<n; ++j ){ W.add(i, v); ... W.end_column(); }
+%		plhs[0] = W.finish();	// the sparse matrix, or nnz when written to a file
+%
+%   file layout (native byte order):
+%		char[8] "JJCSC001", uint64 m, n, nnz, uint32 bytes per value (4 or 8), uint32 storage (0 full, 1 upper)
+%		uint64 ir[nnz], values[nnz], uint64 jc[n+1]
+*=================================================================*/
+
+#ifndef SPARSE_CSC_BUILDER_H
+#define SPARSE_CSC_BUILDER_H
+
+#include <mex.h>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+class CscBuilder
+{
+public:
+	enum Storage { FULL = 0, UPPER = 1 };
+
+	CscBuilder(Storage storage = FULL)
+		: storage_(storage), single_(false), m_(0), n_(0), col_(0), nnz_(0),
+		matrix_(NULL), pr_(NULL), ir_(NULL), nzmax_(0), file_(NULL), values_(NULL)
+	{
+	}
+	~CscBuilder()
+	{
+		close_files();
+		if( matrix_ )
+			mxDestroyArray(matrix_);
+	}
+
+	//----------------------------------------------------------------
+	// options.storage = 'full' | 'upper', options.file = filename,
+	// options.precision = 'double' | 'single' (only with options.file)
+	void parse_options(const mxArray* options)
+	{
+		if( options==NULL || !mxIsStruct(options) )
+			return;
+		mxArray* tmp = mxGetField(options, 0, "storage");
+		if( tmp && mxIsChar(tmp) )
+		{
+			char* str = mxArrayToString(tmp);
+			bool upper = strcmp(str, "upper")==0;
+			bool full = strcmp(str, "full")==0;
+			mxFree(str);
+			if( !upper && !full )
+				mexErrMsgTxt("options.storage must be 'full' or 'upper'.");
+			storage_ = upper ? UPPER : FULL;
+		}
+		tmp = mxGetField(options, 0, "file");
+		if( tmp && mxIsChar(tmp) )
+		{
+			char* str = mxArrayToString(tmp);
+			filename_ = str;
+			mxFree(str);
+		}
+		tmp = mxGetField(options, 0, "precision");
+		if( tmp && mxIsChar(tmp) )
+		{
+			char* str = mxArrayToString(tmp);
+			bool single = strcmp(str, "single")==0;
+			bool dbl = strcmp(str, "double")==0;
+			mxFree(str);
+			if( !single && !dbl )
+				mexErrMsgTxt("options.precision must be 'double' or 'single'.");
+			if( single && filename_.empty() )
+				mexErrMsgTxt("MATLAB sparse matrices are double, options.precision = 'single' needs options.file.");
+			single_ = single;
+		}
+	}
+	void set_storage(Storage storage) { storage_ = storage; }
+	void set_file(const char* filename, bool single_precision)
+	{
+		filename_ = filename;
+		single_ = single_precision;
+	}
+	Storage storage() const { return storage_; }
+
+	// starts an m x n matrix, nzmax is a guess of the number of nonzeros
+	void open(mwSize m, mwSize n, mwSize nzmax)
+	{
+		m_ = m;
+		n_ = n;
+		col_ = 0;
+		nnz_ = 0;
+		jc_.assign(1, 0);
+		jc_.reserve(n+1);
+		diagonal_.assign(std::min(m, n), no_diagonal());
+		if( filename_.empty() )
+		{
+			nzmax_ = std::max(nzmax, (mwSize) 1);
+			matrix_ = mxCreateSparse(m, n, nzmax_, mxREAL);
+			pr_ = mxGetPr(matrix_);
+			ir_ = mxGetIr(matrix_);
+		}
+		else
+		{
+			file_ = fopen(filename_.c_str(), "wb");
+			values_ = tmpfile();
+			if( file_==NULL || values_==NULL )
+			{
+				close_files();
+				mexErrMsgTxt("Can not open the output file of the sparse matrix.");
+			}
+			write_header();
+		}
+	}
+
+	// adds value at (row, current column)
+	void add(mwIndex row, double value)
+	{
+		entries_.push_back( std::make_pair(row, value) );
+	}
+
+	// closes the current column, returns its number of entries
+	mwSize end_column()
+	{
+		// stable: the duplicates are summed in the order they were added
+		std::stable_sort( entries_.begin(), entries_.end(), compare_rows );
+		mwSize count = 0;
+		for( size_t k=0; k<entries_.size(); )
+		{
+			mwIndex row = entries_[k].first;
+			double value = entries_[k].second;
+			for( ++k; k<entries_.size() && entries_[k].first==row; ++k )
+				value += entries_[k].second;
+			if( storage_==UPPER && row>col_ )
+				break;
+			entries_[count++] = std::make_pair(row, value);
+		}
+		entries_.resize(count);
+		reserve(count);
+
+		if( col_<diagonal_.size() )
+			for( mwSize k=0; k<count; ++k )
+				if( entries_[k].first==col_ )
+					diagonal_[col_] = nnz_ + k;
+		if( file_ )
+			write_column();
+		else
+			for( mwSize k=0; k<count; ++k )
+			{
+				ir_[nnz_+k] = entries_[k].first;
+				pr_[nnz_+k] = entries_[k].second;
+			}
+		nnz_ += count;
+		jc_.push_back(nnz_);
+		entries_.clear();
+		++col_;
+		return count;
+	}
+
+	// changes the value of the diagonal entry of a closed column, the entry
+	// has to be added before, e.g. with a zero, when the value is only known later
+	void set_diagonal(mwIndex j, double value)
+	{
+		if( j>=diagonal_.size() || diagonal_[j]==no_diagonal() )
+			mexErrMsgTxt("set_diagonal: no diagonal entry in this column.");
+		if( file_ )
+		{
+			fseek_64( values_, diagonal_[j]*value_bytes() );
+			write_values( &value, 1 );
+			fseek_end( values_ );
+		}
+		else
+			pr_[diagonal_[j]] = value;
+	}
+
+	mwSize nnz() const { return nnz_; }
+	mwIndex column() const { return col_; }
+
+	// the sparse matrix, or the number of nonzeros (a double) when written to a file
+	mxArray* finish()
+	{
+		while( col_<n_ )
+			end_column();
+		if( file_ )
+		{
+			// values after the row indices, then the column pointers
+			rewind(values_);
+			std::vector<char> buffer(1<<20);
+			size_t count;
+			while( (count = fread(&buffer[0], 1, buffer.size(), values_))>0 )
+				fwrite(&buffer[0], 1, count, file_);
+			std::vector<unsigned long long> jc(jc_.begin(), jc_.end());
+			fwrite(&jc[0], sizeof(unsigned long long), jc.size(), file_);
+			rewind(file_);
+			write_header();
+			bool failed = ferror(file_)!=0 || ferror(values_)!=0;
+			close_files();
+			if( failed )
+				mexErrMsgTxt("Failed to write the sparse matrix file.");
+			return mxCreateDoubleScalar( (double) nnz_ );
+		}
+
+		// no explicit zeros, as with sparse(), e.g. the diagonal of an isolated vertex
+		mwIndex* jc = mxGetJc(matrix_);
+		mwSize count = 0;
+		for( mwSize j=0; j<n_; ++j )
+		{
+			jc[j] = count;
+			for( mwIndex k=jc_[j]; k<jc_[j+1]; ++k )
+				if( pr_[k]!=0 )
+				{
+					ir_[count] = ir_[k];
+					pr_[count] = pr_[k];
+					++count;
+				}
+		}
+		jc[n_] = count;
+		nnz_ = count;
+
+		// give back the unused part of the preallocation
+		if( nzmax_>nnz_ && nnz_>0 )
+			resize(nnz_);
+		mxArray* matrix = matrix_;
+		matrix_ = NULL;
+		return matrix;
+	}
+
+private:
+	static mwIndex no_diagonal() { return (mwIndex) -1; }
+
+	static bool compare_rows(const std::pair<mwIndex,double>& a, const std::pair<mwIndex,double>& b)
+	{
+		return a.first<b.first;
+	}
+
+	size_t value_bytes() const { return single_ ? sizeof(float) : sizeof(double); }
+
+	// room for count more entries in the MATLAB matrix, grown by a quarter at least
+	void reserve(mwSize count)
+	{
+		if( file_ || nnz_+count<=nzmax_ )
+			return;
+		resize( std::max(nnz_+count, nzmax_ + nzmax_/4) );
+	}
+	void resize(mwSize nzmax)
+	{
+		pr_ = (double*) mxRealloc(pr_, nzmax*sizeof(double));
+		ir_ = (mwIndex*) mxRealloc(ir_, nzmax*sizeof(mwIndex));
+		mxSetPr(matrix_, pr_);
+		mxSetIr(matrix_, ir_);
+		mxSetNzmax(matrix_, nzmax);
+		nzmax_ = nzmax;
+	}
+
+	void write_header()
+	{
+		char magic[8] = {'J','J','C','S','C','0','0','1'};
+		unsigned long long sizes[3] = { m_, n_, nnz_ };
+		unsigned int flags[2] = { (unsigned int) value_bytes(), (unsigned int) storage_ };
+		fwrite(magic, 1, 8, file_);
+		fwrite(sizes, sizeof(unsigned long long), 3, file_);
+		fwrite(flags, sizeof(unsigned int), 2, file_);
+	}
+	void write_column()
+	{
+		size_t count = entries_.size();
+		if( count==0 )
+			return;
+		rows_.resize(count);
+		column_values_.resize(count);
+		for( size_t k=0; k<count; ++k )
+		{
+			rows_[k] = entries_[k].first;
+			column_values_[k] = entries_[k].second;
+		}
+		fwrite(&rows_[0], sizeof(unsigned long long), count, file_);
+		write_values(&column_values_[0], count);
+	}
+	void write_values(const double* values, size_t count)
+	{
+		if( !single_ )
+		{
+			fwrite(values, sizeof(double), count, values_);
+			return;
+		}
+		floats_.resize(count);
+		for( size_t k=0; k<count; ++k )
+			floats_[k] = (float) values[k];
+		fwrite(&floats_[0], sizeof(float), count, values_);
+	}
+	static void fseek_64(FILE* f, unsigned long long offset)
+	{
+#ifdef _WIN32
+		_fseeki64(f, (__int64) offset, SEEK_SET);
+#else
+		fseeko(f, (off_t) offset, SEEK_SET);
+#endif
+	}
+	static void fseek_end(FILE* f)
+	{
+		fseek(f, 0, SEEK_END);
+	}
+	void close_files()
+	{
+		if( file_ )
+			fclose(file_);
+		if( values_ )
+			fclose(values_);
+		file_ = NULL;
+		values_ = NULL;
+	}
+
+	// not copyable: owns the matrix and the files
+	CscBuilder(const CscBuilder&);
+	CscBuilder& operator=(const CscBuilder&);
+
+	Storage storage_;
+	bool single_;
+	std::string filename_;
+	mwSize m_, n_;
+	mwIndex col_;
+	mwSize nnz_;
+	std::vector<mwIndex> jc_;
+	std::vector<mwIndex> diagonal_;		// position of the diagonal entry of each column
+	std::vector< std::pair<mwIndex,double> > entries_;	// current column
+
+	// MATLAB output
+	mxArray* matrix_;
+	double* pr_;
+	mwIndex* ir_;
+	mwSize nzmax_;
+
+	// file output, the values go to a temporary file until the number of nonzeros is known
+	FILE* file_;
+	FILE* values_;
+	std::vector<unsigned long long> rows_;
+	std::vector<double> column_values_;
+	std::vector<float> floats_;
+};
+
+//================================================================
+// faces around each vertex, for the matrices assembled column by column
+// from the faces: the faces of vertex v are face[start[v] .. start[v+1]-1]
+struct VertexFaceRing
+//================================================================
+{
+	std::vector<mwIndex> start;
+	std::vector<mwIndex> face;
+
+	// tri holds the 3 zero-based vertices of each face
+	void build(const std::vector<mwIndex>& tri, mwSize nverts)
+	{
+		mwSize nfaces = tri.size()/3;
+		start.assign(nverts+1, 0);
+		for( mwSize f=0; f<nfaces; ++f )
+			for( int l=0; l<3; ++l )
+				if( first_corner(tri, f, l) )
+					++start[ tri[3*f+l]+1 ];
+		for( mwSize v=0; v<nverts; ++v )
+			start[v+1] += start[v];
+		face.resize(start[nverts]);
+		std::vector<mwIndex> pos(start.begin(), start.end()-1);
+		for( mwSize f=0; f<nfaces; ++f )
+			for( int l=0; l<3; ++l )
+				if( first_corner(tri, f, l) )
+					face[ pos[ tri[3*f+l] ]++ ] = f;
+	}
+
+	// a degenerate face is listed once around its repeated vertex
+	static bool first_corner(const std::vector<mwIndex>& tri, mwSize f, int l)
+	{
+		const mwIndex* t = &tri[3*f];
+		return (l<1 || t[l]!=t[0]) && (l<2 || t[l]!=t[1]);
+	}
+};
+
+#endif // SPARSE_CSC_BUILDER_H
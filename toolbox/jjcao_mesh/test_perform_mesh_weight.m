@@ -48,3 +48,40 @@ if sum(sum(L4-L40)) > 1e-10
     tmp = full(max(max(abs(L4-L40))));
     sprintf('max difference is: %f', tmp)
 end
+
+%% upper triangle and file output of the same weights
+W = perform_mesh_weight(verts', faces', 3);
+opt.storage = 'upper';
+U = perform_mesh_weight(verts', faces', 3, opt);
+if nnz(U - triu(W)) || nnz(W - (U + triu(U,1)'))
+    disp('upper storage differs');
+end
+opt.file = [tempname '.csc'];
+opt.precision = 'single';
+nz = perform_mesh_weight(verts', faces', 3, opt);
+W1 = read_csc_matrix(opt.file);
+delete(opt.file);
+if nz ~= nnz(U) || full(max(max(abs(W1-W)))) > 1e-6*full(max(max(abs(W))))
+    disp('file output differs');
+end
+
+%% the other weights of the C implementation
+for type = {'combinatorial','distance','spring','mvc'}
+    ntype = find(strcmp(type{1}, {'combinatorial','distance','spring','','','','mvc'})) - 1;
+    W = perform_mesh_weight(verts', faces', ntype);
+    W0 = compute_mesh_weight(verts, faces, type{1});
+    tmp = full(max(max(abs(W-W0))));
+    assert( tmp <= 1e-10*full(max(max(abs(W0)))), sprintf('%s: max difference is: %g', type{1}, tmp));
+end
+
+% mixed voronoi areas cover the surface, W4 = diag(1./area)*W3
+va = vertex_area(verts, faces, 1);
+va0 = vertex_area(verts, faces);
+if abs(sum(va) - sum(va0)) > 1e-10*sum(va0)
+    disp('voronoi areas differ from the surface area');
+end
+W3 = perform_mesh_weight(verts', faces', 3);
+W4 = perform_mesh_weight(verts', faces', 4);
+if full(max(max(abs(W4 - spdiags(1./va,0,length(va),length(va))*W3)))) > 1e-10*full(max(max(abs(W4))))
+    disp('Laplace-Beltrami weight differs');
+end
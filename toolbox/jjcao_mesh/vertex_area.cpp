@@ -1,14 +1,14 @@
 /*=================================================================
 *
-* todo!!!!!!!!
-* compute "voronoi" area of each vertex
+* compute area of each vertex, a third of its faces or its mixed "voronoi" area
 * reference: Discrete Differential Geometry Operators for triangulated 2-manifolds_02
 * usage: 
 		va = vertex_area(verts, faces);
 * inputs:
-		verts: 3*nverts
-		faces: 3*faces
-		bVoronoi: use fast approximation or voronoi area
+		verts: nverts*3
+		faces: nfaces*3
+		bVoronoi: use fast approximation (0, default) or voronoi area (1),
+			see mesh_weight_kernel.h
 *
 * output:
 *		va: nverts*1
@@ -20,6 +20,7 @@
 
 #include <mex.h>
 #include <Eigen/Dense>
+#include "mesh_weight_kernel.h"
 
 using namespace std;
 
@@ -48,7 +49,22 @@ void compute_vertex_area_fast(Eigen::MatrixXd& V, Eigen::MatrixXd& F, double* va
 }
 void compute_vertex_voronoi_area(Eigen::MatrixXd& V, Eigen::MatrixXd& F, double* va)
 {
-	mexErrMsgTxt("not implemented still !");
+	vector<mwIndex> tri(F.size());
+	for( int i = 0; i < F.rows(); ++i)
+	{
+		for( int k = 0; k < 3; ++k)
+		{
+			if ( F.coeff(i,k) < 1 || F.coeff(i,k) > V.rows())
+				mexErrMsgTxt("Face index out of bound.");
+			tri[3*i+k] = (mwIndex)F.coeff(i,k) - 1;
+		}
+	}
+
+	MeshWeightKernel kernel(tri, V.rows());
+	kernel.set_vertices(V.data(), false);
+	const vector<double>& area = kernel.mixed_areas();
+	for( int i = 0; i < V.rows(); ++i)
+		va[i] = area[i];
 }
 void mexFunction( int nlhs, mxArray *plhs[], int nrhs, const mxArray*prhs[])
 {
@@ -1,2 +1,8 @@
-mex -I"../kdtree" gaussian_smoothing.cpp
-% mex -g -I"../kdtree" gaussian_smoothing.cpp % for debuging
\ No newline at end of file
+% the vertices are processed on all cores when compiled with OpenMP
+if ispc
+    omp = {'COMPFLAGS="$COMPFLAGS /openmp"'};
+else
+    omp = {'CXXFLAGS="$CXXFLAGS -fopenmp"', 'LDFLAGS="$LDFLAGS -fopenmp"'};
+end
+mex(omp{:}, '-I../kdtree', 'gaussian_smoothing.cpp')
+% mex -g -I"../kdtree" gaussian_smoothing.cpp % for debuging
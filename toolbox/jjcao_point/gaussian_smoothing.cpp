@@ -1,24 +1,7 @@
 #include "KDTree.h"
+#include "KDTreeHandle.h"
 #include "mex.h"
-#include <numeric>
-const double pi = 3.1415926;
 
-void retrieve_tree( const mxArray* matptr, KDTree* & tree){
-    // retrieve pointer from the MX form
-    double* pointer0 = mxGetPr(matptr);
-    // check that I actually received something
-    if( pointer0 == NULL )
-        mexErrMsgTxt("vararg{1} must be a valid k-D tree pointer\n");
-    // convert it to "long" datatype (good for addresses)
-    long pointer1 = (long) pointer0[0];
-    // convert it to "KDTree"
-    tree = (KDTree*) pointer1;
-    // check that I actually received something
-    if( tree == NULL )
-        mexErrMsgTxt("vararg{1} must be a valid k-D tree pointer\n");
-    if( tree -> ndims() <= 0 )
-        mexErrMsgTxt("the k-D tree must have k>0"); 
-}
 //% function [nfunc,nneigh] = gaussian_smoothing(verts, func, neighDist, sigma2, kdtree)
 //% smoothing a scalar or vector function func defined on verts, using
 //% Gaussian with sigma^2 = sigma2, and find neighbor vertices within
@@ -28,8 +11,12 @@ void retrieve_tree( const mxArray* matptr, KDTree* & tree){
 //% func: n*m1 matrix, which is a function defined on verts, you can set func=verts to smooth the point set
 //% neighDist: n*1 distance vector, neighDist(i) is used to collect neighbors of vertex i
 //% sigma2: n*1 vector, sigma2(i) is sigma^2 for the Gaussian filter of vertex i
+//% neighDist and sigma2 can also be scalars (the same for every vertex), or
+//% n*s (or 1*s) matrices, one column per scale: all the scales are computed
+//% from a single ball query per vertex, at the largest neighDist.
 //%
-//% nneigh: numbers of neighbors selected for each vertex
+//% newfunc: n*m1 matrix, n*m1*s for several scales
+//% nneigh: numbers of neighbors selected for each vertex, n*s for several scales
 //%
 //% jjcao @ 2014
 //%
@@ -54,58 +41,67 @@ void mexFunction(int nlhs, mxArray * plhs[], int nrhs, const mxArray * prhs[])
 	int column_vertex=mxGetN(prhs[0]); //þ
     double *vertex = mxGetPr( prhs[0] );
 
-	//int row_func=mxGetM(prhs[1]); //þ
+	int row_func=mxGetM(prhs[1]); //þ
 	int column_func=mxGetN(prhs[1]); //þ
 	double *func = mxGetPr( prhs[1] );
 
-	 // retrieve neighDist, a vector or scalar
+	 // retrieve neighDist, a vector or scalar, one column per scale
 	int row_neighDist=mxGetM(prhs[2]);
+	int nscales=mxGetN(prhs[2]);
     double *neighDist = mxGetPr( prhs[2] );
 
-	 // retrieve sigma2, a vector or scalar
+	 // retrieve sigma2, a vector or scalar, one column per scale
 	int row_sigma2 = mxGetM(prhs[3]);
     double *sigma2 = mxGetPr( prhs[3] );
 
+	if( (row_neighDist!=1 && row_neighDist!=row_vertex) || (row_sigma2!=1 && row_sigma2!=row_vertex) )
+		mexErrMsgTxt("neighDist and sigma2 must have 1 or n rows\n");
+	if( nscales<1 || (int)mxGetN(prhs[3])!=nscales )
+		mexErrMsgTxt("neighDist and sigma2 must have the same number of columns (scales)\n");
+
 	// retrieve the tree pointer
-    KDTree* tree;
-    retrieve_tree( prhs[4], tree ); 
+    KDTree* tree = kdtree_handle_get( prhs[4] ); 
+	if( row_func < tree->size() )
+		mexErrMsgTxt("func must have a row for every point of the kdtree\n");
     
     /////////////////////////////////////////////////// Gaussian smoothing
-	plhs[0] = mxCreateDoubleMatrix(row_vertex, column_func, mxREAL);
+	mwSize dims[3] = { (mwSize)row_vertex, (mwSize)column_func, (mwSize)nscales };
+	plhs[0] = mxCreateNumericArray(nscales>1 ? 3 : 2, dims, mxDOUBLE_CLASS, mxREAL);
 	double* result =(double*)mxGetPr(plhs[0]);
-	plhs[1] = mxCreateNumericMatrix(row_vertex, 1, mxINT32_CLASS, mxREAL);
+	plhs[1] = mxCreateNumericMatrix(row_vertex, nscales, mxINT32_CLASS, mxREAL);
 	int* nneigh =(int*)mxGetPr(plhs[1]);
-	for (int i = 0;i < row_vertex;++i)
+
+	// all the scales of a vertex come from a single ball query
+	#pragma omp parallel
 	{
-		double rval(0.0);
-		vector<int> idxsInRange;
-		vector<double> dists;
+		KDTreeQuery query;
 		vector<double> point(column_vertex,0);
-		for (int j = 0;j < column_vertex; ++j)
-		{
-			point[j] = vertex[j*row_vertex+i];			
-		}
-		tree->ball_query( point, neighDist[i], idxsInRange, dists );		
-		
-		nneigh[i] = idxsInRange.size();
-		std::vector<double> gauss(nneigh[i],0);
-		
-		for ( int j = 0; j < nneigh[i]; ++j)
-		{
-			gauss[j] = exp(-dists[j]*dists[j]/(2*sigma2[i])) / sqrt(2*pi*sigma2[i]);
-		}
-		for (int j = 0;j < column_func; ++j)
+		vector<double> radius(nscales), sigma(nscales);
+		vector<double> rval(nscales*column_func);
+		vector<int> count(nscales);
+
+		#pragma omp for schedule(dynamic,64)
+		for (int i = 0;i < row_vertex;++i)
 		{
-			int offset = j*row_vertex;
-			//result[i + offset] = gaussian_smoothing(func, idxsInRange, dists);
-			std::vector<double> value(nneigh[i],0);
-			for ( int k = 0; k < nneigh[i]; ++k)
+			for (int j = 0;j < column_vertex; ++j)
+			{
+				point[j] = vertex[j*row_vertex+i];			
+			}
+			for (int s = 0; s < nscales; ++s)
+			{
+				radius[s] = neighDist[(row_neighDist==1 ? 0 : i) + s*row_neighDist];
+				sigma[s] = sigma2[(row_sigma2==1 ? 0 : i) + s*row_sigma2];
+			}
+			tree->gaussian_averages( query, &point[0], nscales, &radius[0], &sigma[0], func, column_func, row_func, &rval[0], &count[0] );
+
+			for (int s = 0; s < nscales; ++s)
 			{
-				value[k] = func[idxsInRange[k] + offset];
-			}			
-			double tmp1 = std::inner_product(gauss.begin(),gauss.end(),value.begin(),0.0);
-			double tmp2 = std::accumulate(gauss.begin(), gauss.end(), 0.0);
-			result[i + offset] = tmp1/tmp2;
+				nneigh[i + s*row_vertex] = count[s];
+				for (int j = 0;j < column_func; ++j)
+				{
+					result[i + (j + s*column_func)*row_vertex] = rval[s*column_func + j];
+				}
+			}
 		}
 	}
 }
@@ -7,8 +7,14 @@
 % func: n*m1 matrix, which is a function defined on verts, you can set func=verts to smooth the point set
 % neighDist: n*1 distance vector, neighDist(i) is used to collect neighbors of vertex i
 % sigma2: n*1 vector, sigma2(i) is sigma^2 for the Gaussian filter of vertex i
+% neighDist and sigma2 can also be scalars (the same for every vertex), or
+% n*s (or 1*s) matrices, one column per scale: all the scales are computed
+% from a single ball query per vertex, at the largest neighDist.
 %
-% nneigh: numbers of neighbors selected for each vertex
+% newfunc: n*m1 matrix, n*m1*s for several scales. It is NaN for a vertex
+%   without any neighbor within neighDist (or whose Gaussian weights all
+%   underflow, sigma2 much smaller than the distances)
+% nneigh: numbers of neighbors selected for each vertex, n*s for several scales
 %
 % jjcao @ 2014
 %
@@ -1,12 +1,18 @@
 //============================================================================
 // Name        : KDTree.h
-// Version     : 1.3
+// Version     : 1.4
 // Copyright   : (c) Andrea Tagliasacchi - All Rights Reserved
 // Description : KDTree for n-dimensional points implementation
 // Note: tab size 4
 //
 // Feb 20, 2009: Created by Andrea Tagliasacchi
 // Mar 18, 2009: Corrected inverted distances bug in "k_closest_points"
+// Oct 17, 2026: Flat layout: points in one contiguous buffer, nodes in a single
+//               array with implicit child indexing, bucketed leaves and
+//               nth_element median splits (O(n log n) construction)
+// Oct 17, 2026: Binary file format (save/load), loaded trees are memory-mapped
+// Oct 17, 2026: Approximate kNN, best-bin-first search with a budget of comparisons
+// Oct 17, 2026: Multi-scale Gaussian weighted averages from a single ball query
 //============================================================================
 #ifndef _KDTREE_H_
 #define _KDTREE_H_
@@ -20,288 +26,363 @@
 #endif
 
 #include <vector>    // point datatype
+#include <algorithm> // nth_element
+#include <functional> // greater (best-bin-first queue)
 #include <math.h>    // fabs operation
+#include <stdio.h>   // file output
+#include <string.h>  // memcmp
+#include <limits>    // quiet_NaN (empty Gaussian averages)
 #include "MyHeaps.h" // priority queues
+#include "../../include/MappedFile.h" // memory-mapped loading
 #include "float.h"   // max floating point number
 
 using namespace std;
 
 typedef vector<double> Point;
 
-/// The root node is stored in position 0 of nodesPtrs
+/// The root node is stored in position 0 of nodes
 #define ROOT 0
 
-class Node{
+/// Default number of points stored in a leaf (1 gives the classic one-point-per-leaf tree)
+#define KDTREE_BUCKETSIZE 8
+
+/// Marks a live KDTree object, checked before a handle coming from MATLAB is used
+#define KDTREE_SIGNATURE 0x4B445452u
+
+/**
+ * Binary file format (version 1), native endianness, all offsets in bytes:
+ *      0  header (KDTreeFileHeader, padded to 64 bytes)
+ *     64  nodes:  nnodes Node records (sizeof(Node) bytes each)
+ *         points: npoints*ndim doubles, in leaf order
+ *         pidx:   npoints int32, index in the input of every stored point
+ * Every section starts on an 8 bytes boundary, so the file can be used in
+ * place once memory-mapped.
+ */
+#define KDTREE_FILE_VERSION 1
+#define KDTREE_FILE_HEADERSIZE 64
+struct KDTreeFileHeader{
+	char magic[8];     // "KDTREE\0\0"
+	int  version;      // KDTREE_FILE_VERSION
+	int  endian;       // 1 written as int, to detect foreign byte orders
+	int  nodesize;     // sizeof(Node) of the writer
+	int  ndim;
+	int  npoints;
+	int  bucketsize;
+	int  nnodes;
+};
+
+/**
+ * Scratch state of a kNN search. The tree itself is never modified by a query,
+ * so several threads can search the same tree as long as each one owns its
+ * own KDTreeQuery (buffers are reused from one query to the next).
+ */
+class KDTreeQuery{
 public:
-    double		key;		// the key (value along k-th dimension) of the split
-    int			LIdx;		// the index to the left cell  (-1 if none)
-	int			RIdx;		// the index to the right cell (-1 if none)
+	Point Bmin;  		 	  // bounding box lower bound
+	Point Bmax;  		      // bounding box upper bound
+	MaxHeap<double> pq;  	  // <key,idx> = <distance, point idx>
+	int k;					  // number of records to search for
+	int checks;				  // number of points compared by the last query
+
+	// best-bin-first search only
+	vector< pair<double,int> > bins;  // <lower bound of the distance to the cell, node idx>, a min-heap
+	vector<int> path;                 // nodes from a cell up to the root
+	vector<int> touched;              // dimensions of Bmin/Bmax bounded for the current cell
+
+	// multi-scale Gaussian averages only
+	vector<int> ball;                 // indexes of the points in the largest ball
+	vector<double> ball_dists;        // their distances
+	vector< pair<double,int> > sweep; // <distance, point idx>, by increasing distance
+	vector<int> scales;               // scales by increasing radius
+	vector<double> wsum;              // sum of the weights of every scale
+};
 
-	/**
-	 * A poiter back to the structure data of input points,
-	 * but ONLY if the node is a LEAF, otherwise value is (-1)
-	 */
-	int			pIdx;
+/**
+ * A node of the flat tree. Children are not stored: the node in position i
+ * has its children in positions 2i+1 (left) and 2i+2 (right). The range of
+ * points covered by a node is not stored either, it is recovered while
+ * descending the tree since every split sends ceil(n/2) points to the left.
+ */
+class Node{
+public:
+	double		key;		// the key (value along k-th dimension) of the split
+	int			dim;		// the split dimension (-1 if the node is a LEAF)
 
 	inline bool isLeaf() const{
-		return pIdx>=0;
+		return dim<0;
 	}
 	/// Default constructor
 	Node(){
-		LIdx = -1;
-		RIdx = -1;
-		key  = -1;
-		pIdx  = -1;
+		key = 0;
+		dim = -1;
 	}
 };
 class KDTree {
 
-	// Core data contained in the tree
-	private: vector<Point> points;    // Points data
-	private: vector<Node*> nodesPtrs; // Memory to keep nodes
+	// Core data contained in the tree, either owned (vectors below) or memory-mapped
+	private: const double* points;    // Points data, ndim contiguous coordinates per point, in leaf order
+	private: const int*    pidx;      // pidx[i]: index in the input of the i-th stored point
+	private: const Node*   nodes;     // Memory to keep nodes (implicit binary tree)
+	private: int nnodes;              // Number of nodes
 	private: int ndim;                // Data dimensionality
 	private: int npoints;             // Number of points
-	private: vector<int>   workarray; // Used in tree construction
-
-	// Data used ONLY for "kNN" search (k-nearest neighbors)
-	private: Point Bmin;  		 	  // bounding box lower bound
-	private: Point Bmax;  		      // bounding box upper bound
-	private: MaxHeap<double> pq;  	  // <key,idx> = <distance, node idx>
-	private: int k;					  // number of records to search for
-	private: bool terminate_search;   // true if k points have been found
-
-    /// Default destructor (delete the nodes)
-	public: ~KDTree(){
-    	for (unsigned int i=0; i < nodesPtrs.size(); i++)
-			delete nodesPtrs[i];
-    }
-
-	/// Heapsort algorithm used by fast KDtree construction
-	// Note: this is copied almost verbatim from the heapsort
-	// wiki page: http://en.wikipedia.org/wiki/Heapsort
-	// 11/9/05
-	// there was a bug for len==2 though!
-	int heapsort(int dim, vector<int>& idx, int len) {
-		unsigned int n = len;
-		unsigned int i=len/2;
-		unsigned int parent, child;
-		int t;
-
-//		if( len == 2 ){
-//			if( points[idx[0]][dim]>points[idx[1]][dim] ){
-//				t = idx[1];
-//				idx[1] = idx[0];
-//				idx[0] = t;
-//			}
-//			return 0;
-//		}
-
-		for (;;) {
-			if (i>0) {
-				i--;
-				t = idx[i];
-			} else {
-				n--;
-				if (n ==0)
-					return 0;
-				t = idx.at(n);
-				idx[n] = idx[0];
-			}
-
-			parent = i;
-			child = i*2+1;
-
-			while (child < n) {
-				if ((child +1 < n) && (points[idx[child+1]][dim]>points[idx[child]][dim])) {
-						child++;
-				}
-					if(points[idx[child]][dim]> points[t][dim]) {
-						idx[parent] = idx[child];
-						parent = child;
-						child = parent*2+1;
-					}
-					else {
-						break;
-					}
-			}
-			idx[parent] = t;
-		} // end of for loop
-		return 0;
-	} // end of heapsort
+	private: int bucketsize;          // Maximum number of points in a leaf
+	private: unsigned int signature;  // KDTREE_SIGNATURE while the object is alive
+
+	// Storage of a tree built in memory
+	private: vector<double> points_data;
+	private: vector<int>    pidx_data;
+	private: vector<Node>   nodes_data;
+	// Storage of a tree loaded from file
+	private: MappedFile     mapping;
+
+	/// Orders point indexes along one coordinate, used by nth_element in construction
+	private: struct CoordinateLess{
+		const double* data;
+		int ndim;
+		int dim;
+		CoordinateLess(const double* data, int ndim, int dim) : data(data), ndim(ndim), dim(dim){}
+		inline bool operator()(int a, int b) const{
+			return data[a*ndim+dim] < data[b*ndim+dim];
+		}
+	};
 
+	/// Children and point ranges of the implicit tree
+	private: static inline int left_child( int nodeIdx ){ return 2*nodeIdx+1; }
+	private: static inline int right_child( int nodeIdx ){ return 2*nodeIdx+2; }
+	private: static inline int split_offset( int begin, int end ){ return begin + (end-begin+1)/2; }
 
     /**
      * Creates a KDtree filled with the provided data.
      *
-     * @param points   a vector< vector<double> > containing the point data
-     * 				   the number of points and the dimensionality is inferred
-     *                 by the data
+     * @param points     a vector< vector<double> > containing the point data
+     * 				     the number of points and the dimensionality is inferred
+     *                   by the data
+     * @param bucketsize the maximum number of points stored in a leaf
      */
-	public: KDTree(const vector<Point>& points){
-    	// initialize data
-    	this -> npoints   = points.size();
-    	this -> ndim      = points[0].size();
-        this -> points    = points;
-        nodesPtrs.reserve( npoints );
-        workarray.resize( npoints, -1 ); //used in sorting based construction
-
-	    // create the heap structure to support the tree creation
-	    vector< MinHeap<double> > heaps(ndim, npoints);
-	    for( int dIdx=0; dIdx<ndim; dIdx++ )
-	    	for( int pIdx=0; pIdx<npoints; pIdx++ )
-	    		heaps[dIdx].push( points[pIdx][dIdx], pIdx );
-
-	    // Invoke heap sort generating indexing vectors
-	    // indexes[dim][i]: in dimension dim, which is the index of the i-th smallest element?
-	    vector< vector<int> > indexes( ndim, vector<int>(npoints,0) );
-	    for( int dIdx=0; dIdx<ndim; dIdx++ )
-	    	heaps[dIdx].heapsort( indexes[dIdx] );
-
-	    // Invert the indexing structure!!
-	    // srtidx[dim][j]: in dimension dim, which is ordering number of point j-th?
-	    // the j-th smallest entry in dim dimension
-	    vector< vector<int> > srtidx( ndim, vector<int>(npoints,0) );
-	    for (unsigned int dim=0; dim<indexes.size(); dim++)
-	    	for (unsigned int i=0; i < indexes[dim].size(); i++)
-	    		srtidx[dim][indexes[dim][i]] = i;
-
-	    // DEBUG: visualize indexes
-		#ifdef DEBUG
-		cout << "indexing matrix" << endl;
-	    for (unsigned int j=0; j <indexes.size(); j++){
-	    	for (unsigned int i=0; i < indexes[j].size(); i++)
-	    		cout << indexes[j][i] << " ";
-	    	cout << endl;
-	    }
-		cout << "sortindex matrix" << endl;
-	    for (unsigned int j=0; j <srtidx.size(); j++){
-	    	for (unsigned int i=0; i < srtidx[j].size(); i++)
-	    		cout << srtidx[j][i] << " ";
-	    	cout << endl;
-	    }
-		#endif
-
-	    // First partition is on every single point ([1:npoints])
-	    vector<int> pidx(npoints,0);
-	    for (int i = 0; i < npoints; i++) pidx[i] = i;
-	    build_recursively(srtidx, pidx, 0);
-    }
+	public: KDTree(const vector<Point>& points, int bucketsize = KDTREE_BUCKETSIZE){
+		this -> npoints    = points.size();
+		this -> ndim       = points[0].size();
+		this -> bucketsize = bucketsize<1 ? 1 : bucketsize;
+		this -> points_data.resize( npoints*ndim );
+		for( int pIdx=0; pIdx<npoints; pIdx++ )
+			for( int dIdx=0; dIdx<ndim; dIdx++ )
+				this -> points_data[pIdx*ndim+dIdx] = points[pIdx][dIdx];
+		build();
+	}
+
+	/**
+	 * Creates a KDtree from a column-major NxD matrix (MATLAB layout)
+	 * without going through an intermediate vector< vector<double> >.
+	 *
+	 * @param data       the N*D coordinates, data[i + d*N] is coordinate d of point i
+	 * @param npoints    number of points N
+	 * @param ndim       dimensionality D
+	 * @param bucketsize the maximum number of points stored in a leaf
+	 */
+	public: KDTree(const double* data, int npoints, int ndim, int bucketsize = KDTREE_BUCKETSIZE){
+		this -> npoints    = npoints;
+		this -> ndim       = ndim;
+		this -> bucketsize = bucketsize<1 ? 1 : bucketsize;
+		this -> points_data.resize( npoints*ndim );
+		for( int pIdx=0; pIdx<npoints; pIdx++ )
+			for( int dIdx=0; dIdx<ndim; dIdx++ )
+				this -> points_data[pIdx*ndim+dIdx] = data[pIdx + dIdx*npoints];
+		build();
+	}
+
+	/// Empty tree, filled by load()
+	private: KDTree() : points(NULL), pidx(NULL), nodes(NULL), nnodes(0), ndim(0), npoints(0), bucketsize(0), signature(0){}
+
+	/// Default destructor (unmaps loaded data, invalidates handles)
+	public: ~KDTree(){
+		signature = 0;
+		mapping.close();
+	}
+
+	/// @return true if the object is a live KDTree (used to validate handles)
+	public: inline bool is_valid() const { return signature == KDTREE_SIGNATURE; }
 
 	/// @return the number of points in the kd-tree
-	public: inline int size(){ return points.size(); }
+	public: inline int size(){ return npoints; }
 
 	/// @return the number of points in the kd-tree
 	public: inline int ndims(){ return ndim; }
 
+	/// @return the maximum number of points in a leaf
+	public: inline int bucket_size(){ return bucketsize; }
+
 	/**
-	 * Algorithm that recursively performs median splits along dimension "dim"
-	 * using the pre-prepared information given by the sorting.
+	 * Allocates the implicit node array, performs the median splits and finally
+	 * rearranges the coordinates so that the points of every leaf are contiguous.
+	 */
+	private: void build(){
+		// the deepest leaf is reached following the left (larger) halves
+		int depth = 0;
+		for( int n=npoints; n>bucketsize; n=(n+1)/2 )
+			depth++;
+		nodes_data.assign( (2<<depth)-1, Node() );
+
+		pidx_data.resize( npoints );
+		for( int i=0; i<npoints; i++ ) pidx_data[i] = i;
+		build_recursively( ROOT, 0, npoints, 0 );
+
+		// store the coordinates in leaf order
+		vector<double> sorted( points_data.size() );
+		for( int i=0; i<npoints; i++ )
+			std::copy( points_data.begin()+pidx_data[i]*ndim, points_data.begin()+(pidx_data[i]+1)*ndim, sorted.begin()+i*ndim );
+		points_data.swap( sorted );
+
+		points = &points_data[0];
+		pidx   = &pidx_data[0];
+		nodes  = &nodes_data[0];
+		nnodes = nodes_data.size();
+		signature = KDTREE_SIGNATURE;
+	}
+
+	/**
+	 * Writes the tree in the binary format described by KDTreeFileHeader.
 	 *
-	 * @param sortidx: the back indexes produced by sorting along every dimension used
-	 *                 for linear time median computation
-	 * @param pidx:    a vector of indexes to active elements
+	 * @param filename the file to (over)write
+	 * @return false if the file could not be written
+	 */
+	public: bool save( const char* filename ){
+		KDTreeFileHeader header;
+		memset( &header, 0, sizeof(header) );
+		memcpy( header.magic, "KDTREE\0\0", 8 );
+		header.version    = KDTREE_FILE_VERSION;
+		header.endian     = 1;
+		header.nodesize   = sizeof(Node);
+		header.ndim       = ndim;
+		header.npoints    = npoints;
+		header.bucketsize = bucketsize;
+		header.nnodes     = nnodes;
+
+		FILE* fid = fopen( filename, "wb" );
+		if( fid == NULL )
+			return false;
+		char block[KDTREE_FILE_HEADERSIZE];
+		memset( block, 0, sizeof(block) );
+		memcpy( block, &header, sizeof(header) );
+		bool ok = fwrite( block, 1, sizeof(block), fid ) == sizeof(block);
+		// nodes are copied in a zeroed record so that their padding is written as zeros
+		for( int i=0; ok && i<nnodes; i++ ){
+			Node node;
+			memset( &node, 0, sizeof(node) );
+			node.key = nodes[i].key;
+			node.dim = nodes[i].dim;
+			ok = fwrite( &node, sizeof(Node), 1, fid ) == 1;
+		}
+		ok = ok
+			&& fwrite( points, sizeof(double), (size_t)npoints*ndim, fid ) == (size_t)npoints*ndim
+			&& fwrite( pidx,   sizeof(int),    npoints,           fid ) == (size_t) npoints;
+		return fclose(fid) == 0 && ok;
+	}
+
+	/**
+	 * Memory-maps a tree written by save(). Nothing is copied or rebuilt: the
+	 * queries run directly on the mapped file.
 	 *
-	 * @param dim:     the current split dimension
+	 * @param filename the file to map
+	 * @return the tree, or NULL if the file is missing or not a valid tree
+	 */
+	public: static KDTree* load( const char* filename ){
+		KDTree* tree = new KDTree();
+		if( !tree->mapping.open(filename) || tree->mapping.size() < KDTREE_FILE_HEADERSIZE ){
+			delete tree;
+			return NULL;
+		}
+
+		KDTreeFileHeader header;
+		memcpy( &header, tree->mapping.data(), sizeof(header) );
+		size_t nodesbytes  = (size_t)header.nnodes*sizeof(Node);
+		size_t pointsbytes = (size_t)header.npoints*header.ndim*sizeof(double);
+		size_t pidxbytes   = (size_t)header.npoints*sizeof(int);
+		if( memcmp(header.magic, "KDTREE\0\0", 8) != 0 || header.version != KDTREE_FILE_VERSION
+			|| header.endian != 1 || header.nodesize != (int)sizeof(Node)
+			|| header.ndim <= 0 || header.npoints <= 0 || header.bucketsize <= 0 || header.nnodes <= 0
+			|| tree->mapping.size() != KDTREE_FILE_HEADERSIZE + nodesbytes + pointsbytes + pidxbytes ){
+			delete tree;
+			return NULL;
+		}
+
+		const char* base   = tree->mapping.data() + KDTREE_FILE_HEADERSIZE;
+		tree->nodes      = (const Node*) base;
+		tree->points     = (const double*) (base + nodesbytes);
+		tree->pidx       = (const int*) (base + nodesbytes + pointsbytes);
+		tree->nnodes     = header.nnodes;
+		tree->ndim       = header.ndim;
+		tree->npoints    = header.npoints;
+		tree->bucketsize = header.bucketsize;
+
+		// the node records and point indexes are used as they are by the queries:
+		// a crafted or damaged file must not make them read out of bounds
+		if( !tree->valid_layout() ){
+			delete tree;
+			return NULL;
+		}
+		tree->signature  = KDTREE_SIGNATURE;
+		return tree;
+	}
+
+	/**
+	 * Checks a loaded tree against the layout build() produces: as many nodes
+	 * as the median splits of npoints down to bucketsize, a split dimension
+	 * below ndim for every internal node (which must cover more than
+	 * bucketsize points, so that its children exist) and point indexes in
+	 * [0,npoints).
+	 */
+	private: bool valid_layout() const{
+		int depth = 0;
+		for( int n=npoints; n>bucketsize; n=(n+1)/2 )
+			depth++;
+		if( depth > 30 || nnodes != (2<<depth)-1 )
+			return false;
+		for( int i=0; i<npoints; i++ )
+			if( pidx[i] < 0 || pidx[i] >= npoints )
+				return false;
+		return valid_subtree( ROOT, 0, npoints );
+	}
+	/// @see valid_layout, checks the nodes reachable from nodeIdx
+	private: bool valid_subtree( int nodeIdx, int begin, int end ) const{
+		const Node& node = nodes[nodeIdx];
+		if( node.isLeaf() )
+			return true;
+		if( node.dim >= ndim || end-begin <= bucketsize )
+			return false;
+		int mid = split_offset( begin, end );
+		return valid_subtree( left_child(nodeIdx), begin, mid )
+			&& valid_subtree( right_child(nodeIdx), mid, end );
+	}
+
+	/**
+	 * Algorithm that recursively performs median splits along dimension "dim".
+	 * The median is found in linear time with nth_element, which leaves the
+	 * points not greater than the key on its left.
 	 *
-	 * @note this is the memory-friendly version
+	 * @param nodeIdx: the node to fill
+	 * @param begin:   first entry of pidx_data covered by the node
+	 * @param end:     one past the last entry of pidx_data covered by the node
+	 * @param dim:     the current split dimension
 	 */
-	private: int build_recursively(vector< vector<int> >& sortidx, vector<int>& pidx, int dim){
-		#ifdef DEBUG
-		cout << endl << endl << "received current vector: ";
-		for( unsigned int i=0; i< pidx.size(); i++ )
-			cout << pidx[ i ] << " ";
-		cout << endl;
-		#endif
+	private: void build_recursively(int nodeIdx, int begin, int end, int dim){
+		Node& node = nodes_data[nodeIdx];
 
 		// Stop condition
-	  	if(pidx.size() == 1) {
-	  		Node *node = new Node();		// create a new node
-			int nodeIdx = nodesPtrs.size(); // its address is
-			nodesPtrs.push_back( node ); 	// important to push back here
-			node->LIdx = -1;				// no child
-			node->RIdx = -1;    			// no child
-			node->pIdx = pidx[0]; 			// the only index available
-			node->key = 0;					// key is useless here
-			return nodeIdx;
-		}
-
-		// allocate the vectors
-	  	vector<int> Larray;
-	  	vector<int> Rarray;
-	 	Larray.reserve( pidx.size()/2 + (pidx.size()%2==0 ? 0:1) );
-		Rarray.reserve( pidx.size()/2 );
-
-		// initialize the "partition" array
-		// Setting parray to -1 indicates we are not using the point
-		for (int i = 0; i < npoints; i++)
-			workarray[i] = -1;
-		for (unsigned int i = 0; i < pidx.size(); i++)
-			workarray[ sortidx[dim][pidx[i]] ] = pidx[i];
-
-		#ifdef DEBUG
-		cout << "work array: ";
-		for( unsigned int i=0; i< workarray.size(); i++ )
-			cout << workarray[ i ] << " ";
-		cout << endl;
-		#endif
-
-		int pivot = -1; //index of the median element
-		if((double)pidx.size()*log((double)pidx.size()) < npoints) {
-			Larray.resize( pidx.size()/2 + (pidx.size()%2==0 ? 0:1), -1 );
-			Rarray.resize( pidx.size()/2, -1 );
-			heapsort(dim,pidx,pidx.size());
-			std::copy(pidx.begin(), pidx.begin()+Larray.size(), Larray.begin());
-			std::copy(pidx.begin()+Larray.size(), pidx.end(),   Rarray.begin());
-			pivot = pidx[(pidx.size()-1)/2];
-		}
-		else{
-			// The middle valid value of parray is the pivot,
-			// the left go to a node on the left, the right
-			// and the pivot go to a node on the right.
-			unsigned int TH = (pidx.size()-1)/2; //defines median offset
-			unsigned int cnt = 0; //number of points found
-			for (int i=0; i < npoints; i++) {
-				// Is the current point not in the current selection? skip
-				if (workarray[i] == -1)
-					continue;
-
-				// len/2 is on the "right" of pivot.
-				// Pivot is still put on the left side
-				if (cnt == TH) {
-					pivot = workarray[i];
-					Larray.push_back( workarray[i] );
-				} else if (cnt > TH)
-					Rarray.push_back( workarray[i] );
-				else
-					Larray.push_back( workarray[i] );
-
-				// Don't overwork, if we already read all the necessary just stop.
-				cnt++;
-				if(cnt>pidx.size())
-					break;
-			}
+		if( end-begin <= bucketsize ){
+			node.dim = -1;
+			node.key = 0; // key is useless here
+			return;
 		}
 
-		#ifdef DEBUG
-		cout << "passing L: ";
-		for( unsigned int i=0; i< Larray.size(); i++ )
-			cout << Larray[ i ] << " ";
-		cout << endl;
-		cout << "passing R: ";
-		for( unsigned int i=0; i< Rarray.size(); i++ )
-			cout << Rarray[ i ] << " ";
-		cout << endl;
-		#endif
-
-		// CREATE THE NODE
-		Node* node = new Node();
-		int nodeIdx = nodesPtrs.size(); //why it's not +1? should not happend after push back? -> no since size() is the index of last element+1!!
-		nodesPtrs.push_back( node ); //important to push back here
-		node->pIdx  	= -1; //not a leaf
-		node->key  		= points[ pivot ][ dim ];
-		node->LIdx 		= build_recursively( sortidx, Larray, (dim+1)%ndim );
-		node->RIdx 		= build_recursively( sortidx, Rarray, (dim+1)%ndim );
-		return nodeIdx;
+		// Pivot is the last element of the left side
+		int mid = split_offset( begin, end );
+		std::nth_element( pidx_data.begin()+begin, pidx_data.begin()+mid-1, pidx_data.begin()+end, CoordinateLess(&points_data[0], ndim, dim) );
+		node.dim = dim;
+		node.key = points_data[ pidx_data[mid-1]*ndim + dim ];
+
+		build_recursively( left_child(nodeIdx),  begin, mid, (dim+1)%ndim );
+		build_recursively( right_child(nodeIdx), mid,   end, (dim+1)%ndim );
 	}
 
 	/**
@@ -309,10 +390,8 @@ class KDTree {
 	 * in which the tree is stored.
 	 */
 	private: void linear_tree_print(){
-		for (unsigned int i=0; i < nodesPtrs.size(); i++) {
-			Node* n = nodesPtrs[i];
-			cout << "[i]" << i << " key: " << n->key << " LIdx: "<< n->LIdx << " RIdx: "<< n->RIdx << endl;
-		}
+		for (int i=0; i < nnodes; i++)
+			cout << "[i]" << i << " key: " << nodes[i].key << " dim: "<< nodes[i].dim << endl;
 	}
 
 	/**
@@ -324,13 +403,14 @@ class KDTree {
 	 *        (default is the root)
 	 */
 	public: void left_depth_first_print( int nodeIdx = 0 ){
-		Node* currnode = nodesPtrs[nodeIdx];
-
-		if( currnode -> LIdx != -1 )
-			left_depth_first_print( currnode -> LIdx );
-		cout << currnode -> key << " ";
-		if( currnode -> RIdx != -1 )
-			left_depth_first_print( currnode -> RIdx );
+		const Node& currnode = nodes[nodeIdx];
+		if( currnode.isLeaf() ){
+			cout << currnode.key << " ";
+			return;
+		}
+		left_depth_first_print( left_child(nodeIdx) );
+		cout << currnode.key << " ";
+		left_depth_first_print( right_child(nodeIdx) );
 	}
 
 	/**
@@ -338,31 +418,33 @@ class KDTree {
 	 * the underlying hierarchical structure using indentation.
 	 *
 	 * @param index the index of the node from which to start printing
-	 * @param level the key-dimension of the node from which to start printing
+	 * @param level the depth of the node from which to start printing
 	 */
 	void print_tree( int index = 0, int level = 0 ){
-		Node* currnode = nodesPtrs[index];
+		print_tree( index, level, 0, npoints );
+	}
+	private: void print_tree( int index, int level, int begin, int end ){
+		const Node& currnode = nodes[index];
 
 		// leaf
-		if( currnode->pIdx >= 0 ){
-			cout << "--- "<< currnode->pIdx+1 << " --- "; //node is given in matlab indexes
-			for( int i=0; i<ndim; i++ ) cout << points[ currnode->pIdx ][ i ] << " ";
-			cout << endl;
+		if( currnode.isLeaf() ){
+			for( int i=begin; i<end; i++ ){
+				cout << "--- "<< pidx[i]+1 << " --- "; //node is given in matlab indexes
+				for( int d=0; d<ndim; d++ ) cout << points[ i*ndim+d ] << " ";
+				cout << endl;
+			}
+			return;
 		}
-		else
-			cout << "l(" << level%ndim << ") - " << currnode->key << " nIdx: " << index << endl;
+		cout << "l(" << currnode.dim << ") - " << currnode.key << " nIdx: " << index << endl;
 
 		// navigate the childs
-		if( currnode -> LIdx != -1 ){
-			for( int i=0; i<level; i++ ) cout << "  ";
-			cout << "left: ";
-			print_tree( currnode->LIdx, level+1 );
-		}
-		if( currnode -> RIdx != -1 ){
-			for( int i=0; i<level; i++ ) cout << "  ";
-			cout << "right: ";
-			print_tree( currnode->RIdx, level+1 );
-		}
+		int mid = split_offset( begin, end );
+		for( int i=0; i<level; i++ ) cout << "  ";
+		cout << "left: ";
+		print_tree( left_child(index), level+1, begin, mid );
+		for( int i=0; i<level; i++ ) cout << "  ";
+		cout << "right: ";
+		print_tree( right_child(index), level+1, mid, end );
 	}
 
 	/**
@@ -370,10 +452,12 @@ class KDTree {
 	 * @param b a point in ndim-dimension
 	 * @returns L2 distance (in dimension ndim) between two points
 	 */
-	inline double distance_squared( const vector<double>& a, const vector<double>& b){
+	public: inline double distance_squared( const vector<double>& a, const vector<double>& b){
+		return distance_squared( &a[0], &b[0] );
+	}
+	public: inline double distance_squared( const double* a, const double* b){
 		double d = 0;
-		double N = a.size();
-		for( int i=0; i<N; i++ )
+		for( int i=0; i<ndim; i++ )
 			d += (a[i]-b[i])*(a[i]-b[i]);
 		return d;
 	}
@@ -388,54 +472,193 @@ class KDTree {
 	 *
 	 */
 	public: void k_closest_points(const Point& Xq, int k, vector<int>& idxs, vector<double>& distances){
-    	// initialize search data
-    	Bmin = vector<double>(ndim,-DBL_MAX);
-    	Bmax = vector<double>(ndim,+DBL_MAX);
-    	this->k = k;
-    	this->terminate_search = false;
-
-    	// call search on the root [0] fill the queue
-    	// with elements from the search
-    	knn_search( Xq );
-
-    	// scan the created pq and extract the first "k" elements
-    	// pop the remaining
-    	int N = pq.size();
-    	for (int i=0; i < N; i++) {
-			pair<double, int> topel = pq.top();
-    		pq.pop();
-    		if( i>=N-k ){
-    			idxs.push_back( topel.second );
-                distances.push_back( sqrt(topel.first) ); // it was distance squared
-            }
-		}
-
-    	// invert the vector, passing first closest results
-    	std::reverse( idxs.begin(), idxs.end() );
-        std::reverse( distances.begin(), distances.end() );
-    }
+		if( k<=0 ) return;
+		KDTreeQuery query;
+		vector<int> I(k);
+		vector<double> D(k);
+		int n = k_closest_points( query, &Xq[0], k, &I[0], &D[0] );
+		idxs.insert( idxs.end(), I.begin(), I.begin()+n );
+		distances.insert( distances.end(), D.begin(), D.begin()+n );
+	}
 
-	private: void leaves_of_node( int nodeIdx, vector<int>& indexes ){
-		Node* node = nodesPtrs[ nodeIdx ];
-		if( node->isLeaf() ){
-			indexes.push_back( node->pIdx );
-			return;
+	/**
+	 * k-NN query using caller owned scratch state, safe to call concurrently
+	 * from several threads (one KDTreeQuery per thread).
+	 *
+	 * @param query scratch state of the search
+	 * @param Xq the query point (ndim coordinates)
+	 * @param k  the number of neighbors to search for
+	 * @param idxs (return) at least k entries, the indexes of the closest points first
+	 * @param distances (return) at least k entries, the corresponding distances
+	 * @return the number of neighbors found, min(k, size())
+	 */
+	public: int k_closest_points(KDTreeQuery& query, const double* Xq, int k, int* idxs, double* distances){
+		// initialize search data
+		query.Bmin.assign( ndim, -DBL_MAX );
+		query.Bmax.assign( ndim, +DBL_MAX );
+		query.k = k;
+		query.checks = 0;
+
+		// call search on the root [0] fill the queue
+		// with elements from the search
+		knn_search( query, Xq, ROOT, 0, npoints );
+
+		return pop_results( query, idxs, distances );
+	}
+
+	/**
+	 * Approximate k-NN query: best-bin-first search [Beis and Lowe 1997].
+	 * The cells are visited in increasing order of their distance to the
+	 * query and the search stops once max_checks points have been compared,
+	 * so the neighbors returned may not be the closest ones. The search is
+	 * exact when it finishes within the budget.
+	 *
+	 * @param query scratch state of the search
+	 * @param Xq the query point (ndim coordinates)
+	 * @param k  the number of neighbors to search for
+	 * @param idxs (return) at least k entries, the indexes of the closest points found first
+	 * @param distances (return) at least k entries, the corresponding distances
+	 * @param max_checks maximum number of points compared, <=0 for an exact search
+	 * @return the number of neighbors found, at most min(k, max_checks)
+	 *
+	 * @inproceedings{beis1997bbf,
+	 *          author = {Jeffrey S. Beis and David G. Lowe},
+	 *          title = {Shape Indexing Using Approximate Nearest-Neighbour Search in High-Dimensional Spaces},
+	 *          booktitle = {Proc. CVPR},
+	 *          year = {1997},
+	 *          pages = {1000--1006}}
+	 */
+	public: int k_closest_points(KDTreeQuery& query, const double* Xq, int k, int* idxs, double* distances, int max_checks){
+		if( max_checks<=0 )
+			return k_closest_points( query, Xq, k, idxs, distances );
+
+		// initialize search data
+		query.Bmin.assign( ndim, -DBL_MAX );
+		query.Bmax.assign( ndim, +DBL_MAX );
+		query.k = k;
+		query.checks = 0;
+		query.bins.clear();
+		query.bins.push_back( make_pair(0.0, ROOT) );
+
+		while( !query.bins.empty() && query.checks<max_checks ){
+			pop_heap( query.bins.begin(), query.bins.end(), greater< pair<double,int> >() );
+			pair<double,int> bin = query.bins.back();
+			query.bins.pop_back();
+			// all the cells left are farther than the k-th neighbor
+			if( query.pq.size()==query.k && bin.first>=query.pq.top().first )
+				break;
+			bbf_search( query, Xq, bin.second, bin.first, max_checks );
 		}
 
-		leaves_of_node( node->LIdx, indexes );
-		leaves_of_node( node->RIdx, indexes );
+		return pop_results( query, idxs, distances );
+	}
+
+	/// Empties the queue of a search into the outputs, closest first
+	private: int pop_results( KDTreeQuery& query, int* idxs, double* distances ){
+		// the queue top is the farthest: fill the outputs from the back
+		int N = query.pq.size();
+		for (int i=N-1; i >= 0; i--) {
+			const pair<double, int>& topel = query.pq.top();
+			idxs[i] = topel.second;
+			distances[i] = sqrt(topel.first); // it was distance squared
+			query.pq.pop();
+		}
+		return N;
+	}
+
+	/** @see k_closest_points (approximate)
+	 *
+	 * Descends from a queued node to the leaf closest to the query, queueing
+	 * the farther child of every node on the way, then compares the points of
+	 * the leaf. The bound of a cell is the squared distance from the query to
+	 * its box, the box is rebuilt from the root since only node indexes are
+	 * queued.
+	 *
+	 * @param nodeIdx the queued node
+	 * @param bound the squared distance from the query to the cell of nodeIdx
+	 */
+	private: void bbf_search( KDTreeQuery& query, const double* Xq, int nodeIdx, double bound, int max_checks ){
+		MaxHeap<double>& pq = query.pq;
+		Point& Bmin = query.Bmin;
+		Point& Bmax = query.Bmax;
+
+		// the cell of the node: box and range of points
+		query.path.clear();
+		for( int i=nodeIdx; i!=ROOT; i=(i-1)/2 )
+			query.path.push_back( i );
+		query.touched.clear();
+		int idx = ROOT, begin = 0, end = npoints;
+		for( int p=query.path.size()-1; p>=0; p-- ){
+			const Node& node = nodes[idx];
+			int mid = split_offset( begin, end );
+			query.touched.push_back( node.dim );
+			if( query.path[p]==left_child(idx) ){
+				Bmax[node.dim] = node.key;
+				end = mid;
+			}
+			else{
+				Bmin[node.dim] = node.key;
+				begin = mid;
+			}
+			idx = query.path[p];
+		}
+
+		// descend on the closer sons
+		while( !nodes[idx].isLeaf() ){
+			const Node& node = nodes[idx];
+			int dim = node.dim;
+			int mid = split_offset( begin, end );
+			// the farther son is as far as the cell, but along dim where the split is closer
+			double out = Xq[dim]<Bmin[dim] ? Bmin[dim]-Xq[dim] : ( Xq[dim]>Bmax[dim] ? Xq[dim]-Bmax[dim] : 0 );
+			double far_bound = bound - out*out + (Xq[dim]-node.key)*(Xq[dim]-node.key);
+			int far_child;
+			query.touched.push_back( dim );
+			if( Xq[dim] <= node.key ){
+				far_child = right_child(idx);
+				Bmax[dim] = node.key;
+				end = mid;
+				idx = left_child(idx);
+			}
+			else{
+				far_child = left_child(idx);
+				Bmin[dim] = node.key;
+				begin = mid;
+				idx = right_child(idx);
+			}
+			if( pq.size()<query.k || far_bound<pq.top().first ){
+				query.bins.push_back( make_pair(far_bound, far_child) );
+				push_heap( query.bins.begin(), query.bins.end(), greater< pair<double,int> >() );
+			}
+		}
+
+		// We are in LEAF
+		for( int i=begin; i<end && query.checks<max_checks; i++ ){
+			double distance = distance_squared( Xq, &points[i*ndim] );
+			query.checks++;
+			if( pq.size()==query.k && pq.top().first>distance ){
+				pq.pop(); // remove farther record
+				pq.push( distance, pidx[i] ); //push new one
+			}
+			else if( pq.size()<query.k )
+				pq.push( distance, pidx[i] );
+		}
+
+		// back to the unbounded box of the root
+		for( size_t i=0; i<query.touched.size(); i++ ){
+			Bmin[ query.touched[i] ] = -DBL_MAX;
+			Bmax[ query.touched[i] ] = +DBL_MAX;
+		}
 	}
 
 	/**
 	 * The algorithm that computes kNN on a k-d tree as specified by the
 	 * referenced paper.
 	 *
-	 * @param nodeIdx the node from which to start searching (default root)
+	 * @param query the search state: Bmin, Bmax, pq
 	 * @param Xq the query point
-	 * @param dim the dimension of the current node (default 0, the first)
-	 *
-	 * @note: this function and its subfunctions make use of shared
-	 *        data declared within the data structure: Bmin, Bmax, pq
+	 * @param nodeIdx the node from which to start searching (default root)
+	 * @param begin first point covered by the node
+	 * @param end one past the last point covered by the node
 	 *
 	 * @article{friedman1977knn,
 	 *          author = {Jerome H. Freidman and Jon Louis Bentley and Raphael Ari Finkel},
@@ -450,50 +673,56 @@ class KDTree {
 	 *          publisher = {ACM},
 	 *          address = {New York, NY, USA}}
 	 */
-	private: void knn_search( const Point& Xq, int nodeIdx = 0, int dim = 0){
-		// cout << "at node: " << nodeIdx << endl;
-		Node* node = nodesPtrs[ nodeIdx ];
+	private: void knn_search( KDTreeQuery& query, const double* Xq, int nodeIdx, int begin, int end ){
+		const Node& node = nodes[ nodeIdx ];
+		MaxHeap<double>& pq = query.pq;
+		Point& Bmin = query.Bmin;
+		Point& Bmax = query.Bmax;
 		double temp;
 
 		// We are in LEAF
-		if( node -> isLeaf() ){
-			double distance = distance_squared( Xq, points[ node->pIdx ] );
-
-			// pqsize is at maximum size k, if overflow and current record is closer
-			// pop further and insert the new one
-			if( pq.size()==k && pq.top().first>distance ){
-				pq.pop(); // remove farther record
-				pq.push( distance, node->pIdx ); //push new one
+		if( node.isLeaf() ){
+			query.checks += end-begin;
+			for( int i=begin; i<end; i++ ){
+				double distance = distance_squared( Xq, &points[i*ndim] );
+
+				// pqsize is at maximum size k, if overflow and current record is closer
+				// pop further and insert the new one
+				if( pq.size()==query.k && pq.top().first>distance ){
+					pq.pop(); // remove farther record
+					pq.push( distance, pidx[i] ); //push new one
+				}
+				else if( pq.size()<query.k )
+					pq.push( distance, pidx[i] );
 			}
-			else if( pq.size()<k )
-				pq.push( distance, node->pIdx );
-
 			return;
 		}
 
 		////// Explore the sons //////
+		int dim = node.dim;
+		int mid = split_offset( begin, end );
 		// recurse on closer son
-		if( Xq[dim] <= node->key ){
-			temp = Bmax[dim]; Bmax[dim] = node->key;
-			knn_search( Xq, node->LIdx, (dim+1)%ndim );
+		if( Xq[dim] <= node.key ){
+			temp = Bmax[dim]; Bmax[dim] = node.key;
+			knn_search( query, Xq, left_child(nodeIdx), begin, mid );
 			Bmax[dim] = temp;
 		}
 		else{
-			temp = Bmin[dim]; Bmin[dim] = node->key;
-			knn_search( Xq, node->RIdx, (dim+1)%ndim );
+			temp = Bmin[dim]; Bmin[dim] = node.key;
+			knn_search( query, Xq, right_child(nodeIdx), mid, end );
 			Bmin[dim] = temp;
 		}
 		// recurse on farther son
-		if( Xq[dim] <= node->key ){
-			temp = Bmin[dim]; Bmin[dim] = node->key;
-			if( bounds_overlap_ball(Xq) )
-				knn_search( Xq, node->RIdx, (dim+1)%ndim );
+		if( Xq[dim] <= node.key ){
+			temp = Bmin[dim]; Bmin[dim] = node.key;
+			if( bounds_overlap_ball(query, Xq) )
+				knn_search( query, Xq, right_child(nodeIdx), mid, end );
 			Bmin[dim] = temp;
 		}
 		else{
-			temp = Bmax[dim]; Bmax[dim] = node->key;
-			if( bounds_overlap_ball(Xq) )
-				knn_search( Xq, node->LIdx, (dim+1)%ndim );
+			temp = Bmax[dim]; Bmax[dim] = node.key;
+			if( bounds_overlap_ball(query, Xq) )
+				knn_search( query, Xq, left_child(nodeIdx), begin, mid );
 			Bmax[dim] = temp;
 		}
     }
@@ -509,16 +738,17 @@ class KDTree {
      * found point, doesn't touches the boundaries of the current
      * BBox.
      *
+     * @param query the search state
      * @param Xq the query point
      * @return true if the search can be safely terminated, false otherwise
      */
-	private: bool ball_within_bounds(const Point& Xq){
+	private: bool ball_within_bounds(KDTreeQuery& query, const double* Xq){
 
     	//extract best distance from queue top
-    	double best_dist = sqrt( pq.top().first );
+    	double best_dist = sqrt( query.pq.top().first );
     	// check if ball is completely within BBOX
     	for (int d=0; d < ndim; d++)
-    		if( fabs(Xq[d]-Bmin[d]) < best_dist || fabs(Xq[d]-Bmax[d]) < best_dist )
+    		if( fabs(Xq[d]-query.Bmin[d]) < best_dist || fabs(Xq[d]-query.Bmax[d]) < best_dist )
     			return false;
     	return true;
     }
@@ -527,17 +757,19 @@ class KDTree {
 	 * This is the search bounding condition. It checks wheter the ball centered
 	 * in the sample point, with radius given by the k-th closest point to the query
 	 * (if k-th closest not defined is \inf), touches the bounding box defined for
-	 * the current node (Bmin Bmax globals).
+	 * the current node (Bmin Bmax of the query state).
 	 *
 	 */
-	private: double bounds_overlap_ball(const Point& Xq){
+	private: bool bounds_overlap_ball(KDTreeQuery& query, const double* Xq){
 		// k-closest still not found. termination test unavailable
-		if( pq.size()<k )
+		if( query.pq.size()<query.k )
 			return true;
 
+		const Point& Bmin = query.Bmin;
+		const Point& Bmax = query.Bmax;
     	double sum = 0;
     	//extract best distance from queue top
-    	double best_dist_sq = pq.top().first;
+    	double best_dist_sq = query.pq.top().first;
     	// cout << "current best dist: " << best_dist_sq << endl;
     	for (int d=0; d < ndim; d++) {
     		// lower than low boundary
@@ -558,34 +790,42 @@ class KDTree {
     }
 
 	/// Computes the closest point in the set to the query point "p"
-    public: int closest_point(Point p){
+    public: int closest_point(const Point& p){
         double neigh_dst = 0;
         return closest_point(p, neigh_dst);
     }
-	public: int closest_point(Point p, double& neigh_dst){
+	public: int closest_point(const Point& p, double& neigh_dst){
 		// search closest leaf
-		int dim = 0; // variable to cycle through dimensions
-		Node* leaf = nodesPtrs[0];
-		for (;;) {
-			// Is leaf node... this is my stop
-			if( leaf->pIdx >= 0 )
-				break;
-
+		int nodeIdx = ROOT;
+		int begin = 0, end = npoints;
+		while( !nodes[nodeIdx].isLeaf() ){
 			// Not a leaf... browse through
-			if( p[dim] <= leaf->key )
-				leaf = nodesPtrs[ leaf -> LIdx ];
-			else
-				leaf = nodesPtrs[ leaf -> RIdx ];
-			dim = (dim + 1) % ndim;
-		}
-
-		double cdistsq = distance_squared( p, points[leaf->pIdx] ); 	// best distance at the moment
-		// cout << "first approximation: " << leaf->idx+1 << endl;
-		int closest_neighbor = leaf->pIdx;
-		check_border_distance(ROOT, 0, p, cdistsq, closest_neighbor); 		//check if anything else can do better
-		
+			const Node& node = nodes[nodeIdx];
+			int mid = split_offset( begin, end );
+			if( p[node.dim] <= node.key ){
+				nodeIdx = left_child(nodeIdx);
+				end = mid;
+			}
+			else{
+				nodeIdx = right_child(nodeIdx);
+				begin = mid;
+			}
+		}
+
+		// best distance at the moment
+		double cdistsq = DBL_MAX;
+		int closest_neighbor = -1;
+		for( int i=begin; i<end; i++ ){
+			double dsq = distance_squared( &p[0], &points[i*ndim] );
+			if( dsq < cdistsq ){
+				cdistsq = dsq;
+				closest_neighbor = i;
+			}
+		}
+		check_border_distance(ROOT, 0, npoints, p, cdistsq, closest_neighbor); //check if anything else can do better
+
         neigh_dst = sqrt( cdistsq );
-        return closest_neighbor;
+        return pidx[closest_neighbor];
 	}
 	/** @see closest_point
 	 *
@@ -593,45 +833,46 @@ class KDTree {
 	 * closest point computation.
 	 *
 	 * @param nodeIdx the index of the node to check for the current recursion
-	 * @param dim     the dimension to check in the current recursion
+	 * @param begin   first point covered by the node
+	 * @param end     one past the last point covered by the node
 	 * @param pnt     the query point
 	 * @param cdistsq the euclidean distance for query to the point "idx"
-	 * @param idx     the index to the "currently" valid closest point
+	 * @param idx     the (stored) index to the "currently" valid closest point
 	 */
-	private: void check_border_distance(int nodeIdx, int dim, Point pnt, double& cdistsq, int& idx){
-		Node* node = nodesPtrs[ nodeIdx ];
-		// cout << "checking node: " << node->idx+1 << endl;
+	private: void check_border_distance(int nodeIdx, int begin, int end, const Point& pnt, double& cdistsq, int& idx){
+		const Node& node = nodes[ nodeIdx ];
 
 		// Are we at a leaf node? check if condition and close recursion
-		if( node->pIdx >= 0 ){
+		if( node.isLeaf() ){
 			// is the leaf closer in distance?
-			float dsq = distance_squared(pnt, points[ node->pIdx ] );
-			if (dsq < cdistsq){
-				cdistsq = dsq;
-			    idx = node->pIdx;
-			    // cout << "updated optimal with: " << node -> idx+1 << endl;
+			for( int i=begin; i<end; i++ ){
+				double dsq = distance_squared( &pnt[0], &points[i*ndim] );
+				if (dsq < cdistsq){
+					cdistsq = dsq;
+					idx = i;
+				}
 			}
 			return;
 		}
 
 		// The distance squared along the CURRENT DIMENSION between the point and the key
-		float ndistsq = (node->key - pnt[dim])*(node->key - pnt[dim]);
-		// cout << "distance to key: " << ndistsq << " optimal current distance: " << cdistsq << "(dim:"<<dim<<")"<<endl;
+		int dim = node.dim;
+		int mid = split_offset( begin, end );
+		double ndistsq = (node.key - pnt[dim])*(node.key - pnt[dim]);
 
 		// If the distance squared from the key to the current value is greater than the
 		// nearest distance, we need only look in one direction.
 		if (ndistsq > cdistsq) {
-			if (node->key > pnt[dim])
-				check_border_distance(node->LIdx, (dim+1)%ndim, pnt, cdistsq, idx);
+			if (node.key > pnt[dim])
+				check_border_distance(left_child(nodeIdx), begin, mid, pnt, cdistsq, idx);
 		    else
-		    	check_border_distance(node->RIdx, (dim+1)%ndim, pnt, cdistsq, idx);
+		    	check_border_distance(right_child(nodeIdx), mid, end, pnt, cdistsq, idx);
 		}
 		// If the distance from the key to the current value is less than the nearest distance,
 		// we still need to look in both directions.
 		else {
-			//cout << "both directions need to be checked" << endl;
-			check_border_distance(node->LIdx, (dim+1)%ndim, pnt, cdistsq, idx);
-		    check_border_distance(node->RIdx, (dim+1)%ndim, pnt, cdistsq, idx);
+			check_border_distance(left_child(nodeIdx), begin, mid, pnt, cdistsq, idx);
+		    check_border_distance(right_child(nodeIdx), mid, end, pnt, cdistsq, idx);
 		}
 	}
 
@@ -649,15 +890,101 @@ class KDTree {
 	 *       2) all the points in between the bbox and the ball are visited as well, then rejected
 	 */
 	public: void ball_query( const Point& point, const double radius, vector<int>& idxsInRange, vector<double>& distances ){
+		ball_query( &point[0], radius, idxsInRange, distances );
+	}
+	/// @see ball_query, the query point is given as ndim contiguous coordinates
+	public: void ball_query( const double* point, const double radius, vector<int>& idxsInRange, vector<double>& distances ){
+		KDTreeQuery query;
+		ball_query( query, point, radius, idxsInRange, distances );
+	}
+	/// @see ball_query, the bounding box of the ball is kept in caller owned scratch state
+	public: void ball_query( KDTreeQuery& query, const double* point, const double radius, vector<int>& idxsInRange, vector<double>& distances ){
 		// create pmin pmax that bound the sphere
-		Point pmin(ndim,0);
-		Point pmax(ndim,0);
+		Point& pmin = query.Bmin;
+		Point& pmax = query.Bmax;
+		pmin.resize(ndim);
+		pmax.resize(ndim);
 		for (int dim=0; dim < ndim; dim++) {
 			pmin[dim] = point[dim]-radius;
 			pmax[dim] = point[dim]+radius;
 		}
-		// start from root at zero-th dimension
-		ball_bbox_query( ROOT, pmin, pmax, idxsInRange, distances, point, radius*radius, 0 );
+		// start from root
+		ball_bbox_query( ROOT, 0, npoints, pmin, pmax, idxsInRange, distances, point, radius*radius );
+	}
+
+	/**
+	 * Gaussian weighted averages of a function at several scales around a point.
+	 * Scale s averages the values of the points within radius[s] of the query,
+	 * weighted by exp(-d^2/(2*sigma2[s])). The neighbors of all the scales are
+	 * collected by a single ball query at the largest radius, then accumulated
+	 * in one sweep by increasing distance: a neighbor only visits the scales
+	 * whose radius it falls within. Safe to call concurrently from several
+	 * threads (one KDTreeQuery per thread).
+	 *
+	 * @param query scratch state of the search
+	 * @param point the query point (ndim coordinates)
+	 * @param nscales the number of scales
+	 * @param radius the radius of every scale
+	 * @param sigma2 the variance of the Gaussian of every scale
+	 * @param values the function, value c of point i at values[i + c*ldvalues]
+	 * @param nvalues the number of values of every point
+	 * @param ldvalues the stride between two values of a point
+	 * @param averages (return) nscales*nvalues entries, value c of scale s at averages[s*nvalues + c],
+	 *                 NaN for a scale without any weight (no point in its ball, or all the weights underflow)
+	 * @param counts (return) nscales entries, the number of neighbors of every scale
+	 */
+	public: void gaussian_averages( KDTreeQuery& query, const double* point, int nscales, const double* radius, const double* sigma2,
+	                                const double* values, int nvalues, int ldvalues, double* averages, int* counts ){
+		if( nscales<=0 ) return;
+
+		// scales by increasing radius (insertion sort, there are only a few)
+		vector<int>& scales = query.scales;
+		scales.resize( nscales );
+		for( int s=0; s<nscales; s++ ){
+			int a = s;
+			for( ; a>0 && radius[scales[a-1]] > radius[s]; a-- )
+				scales[a] = scales[a-1];
+			scales[a] = s;
+		}
+
+		// one ball query at the largest radius, neighbors by increasing distance
+		query.ball.clear();
+		query.ball_dists.clear();
+		ball_query( query, point, radius[scales[nscales-1]], query.ball, query.ball_dists );
+		vector< pair<double,int> >& sweep = query.sweep;
+		sweep.resize( query.ball.size() );
+		for( size_t j=0; j<sweep.size(); j++ )
+			sweep[j] = make_pair( query.ball_dists[j], query.ball[j] );
+		sort( sweep.begin(), sweep.end() );
+
+		query.wsum.assign( nscales, 0.0 );
+		fill( averages, averages+nscales*nvalues, 0.0 );
+		fill( counts, counts+nscales, 0 );
+
+		// scales[first..nscales-1] are the ones containing the current neighbor
+		int first = 0;
+		for( size_t j=0; j<sweep.size(); j++ ){
+			const double d = sweep[j].first;
+			while( first<nscales && radius[scales[first]] < d )
+				first++;
+			if( first==nscales ) break;
+
+			const double* v = values + sweep[j].second;
+			for( int a=first; a<nscales; a++ ){
+				const int s = scales[a];
+				const double w = exp( -d*d/(2*sigma2[s]) );
+				double* avg = averages + s*nvalues;
+				query.wsum[s] += w;
+				counts[s]++;
+				for( int c=0; c<nvalues; c++ )
+					avg[c] += w*v[c*ldvalues];
+			}
+		}
+		for( int s=0; s<nscales; s++ ){
+			double* avg = averages + s*nvalues;
+			for( int c=0; c<nvalues; c++ )
+				avg[c] = query.wsum[s]>0 ? avg[c]/query.wsum[s] : numeric_limits<double>::quiet_NaN();
+		}
 	}
 	/** @see ball_query, range_query
 	 *
@@ -665,23 +992,25 @@ class KDTree {
 	 *
 	 * @note this is similar to "range_query" i just replaced "lies_in_range" with "euclidean_distance"
 	 */
-	public: void ball_bbox_query(int nodeIdx, Point& pmin, Point& pmax, vector<int>& inrange_idxs, vector<double>& distances, const Point& point, const double& radiusSquared, int dim=0){
-		Node* node = nodesPtrs[nodeIdx];
+	private: void ball_bbox_query(int nodeIdx, int begin, int end, const Point& pmin, const Point& pmax, vector<int>& inrange_idxs, vector<double>& distances, const double* point, const double& radiusSquared){
+		const Node& node = nodes[nodeIdx];
 
 		// if it's a leaf and it lies in R
-		if( node->isLeaf() ){
-			double distance = distance_squared(points[node->pIdx], point);
-			if( distance <= radiusSquared ){
-				inrange_idxs.push_back( node->pIdx );
-				distances.push_back( sqrt(distance) );
-				return;
+		if( node.isLeaf() ){
+			for( int i=begin; i<end; i++ ){
+				double distance = distance_squared( &points[i*ndim], point );
+				if( distance <= radiusSquared ){
+					inrange_idxs.push_back( pidx[i] );
+					distances.push_back( sqrt(distance) );
+				}
 			}
 		}
 		else{
-			if(node->key >= pmin[dim] && node->LIdx != -1 )
-				ball_bbox_query( node->LIdx, pmin, pmax, inrange_idxs, distances, point, radiusSquared, (dim+1)%ndim);
-			if(node->key <= pmax[dim] && node->RIdx != -1 )
-				ball_bbox_query( node->RIdx, pmin, pmax, inrange_idxs, distances, point, radiusSquared, (dim+1)%ndim);
+			int mid = split_offset( begin, end );
+			if( node.key >= pmin[node.dim] )
+				ball_bbox_query( left_child(nodeIdx), begin, mid, pmin, pmax, inrange_idxs, distances, point, radiusSquared );
+			if( node.key <= pmax[node.dim] )
+				ball_bbox_query( right_child(nodeIdx), mid, end, pmin, pmax, inrange_idxs, distances, point, radiusSquared );
 		}
 	}
 
@@ -694,22 +1023,24 @@ class KDTree {
 	 * @param inrange_idxs the indexes which satisfied the query, falling in the bounding box area
 	 *
 	 */
-	public: void range_query( const Point& pmin, const Point& pmax, vector<int>& inrange_idxs, int nodeIdx=0, int dim=0 ){
-		Node* node = nodesPtrs[nodeIdx];
-		//cout << "I am in: "<< nodeIdx << "which is is leaf?" << node->isLeaf() << endl;
+	public: void range_query( const Point& pmin, const Point& pmax, vector<int>& inrange_idxs ){
+		range_query( pmin, pmax, inrange_idxs, ROOT, 0, npoints );
+	}
+	private: void range_query( const Point& pmin, const Point& pmax, vector<int>& inrange_idxs, int nodeIdx, int begin, int end ){
+		const Node& node = nodes[nodeIdx];
 
 		// if it's a leaf and it lies in R
-		if( node->isLeaf() ){
-			if( lies_in_range(points[node->pIdx], pmin, pmax) ){
-				inrange_idxs.push_back( node->pIdx );
-				return;
-			}
+		if( node.isLeaf() ){
+			for( int i=begin; i<end; i++ )
+				if( lies_in_range(&points[i*ndim], pmin, pmax) )
+					inrange_idxs.push_back( pidx[i] );
 		}
 		else{
-			if(node->key >= pmin[dim] && node->LIdx != -1 )
-				range_query( pmin, pmax, inrange_idxs, node->LIdx, (dim+1)%ndim);
-			if(node->key <= pmax[dim] && node->RIdx != -1 )
-				range_query( pmin, pmax, inrange_idxs, node->RIdx, (dim+1)%ndim);
+			int mid = split_offset( begin, end );
+			if( node.key >= pmin[node.dim] )
+				range_query( pmin, pmax, inrange_idxs, left_child(nodeIdx), begin, mid );
+			if( node.key <= pmax[node.dim] )
+				range_query( pmin, pmax, inrange_idxs, right_child(nodeIdx), mid, end );
 		}
 	}
 	/** @see range_query
@@ -721,7 +1052,7 @@ class KDTree {
 	 *
 	 * @return true if the point lies in the box, false otherwise
 	 */
-	private: bool lies_in_range( const Point& p, const Point& pMin, const Point& pMax ){
+	private: bool lies_in_range( const double* p, const Point& pMin, const Point& pMax ){
 		for (int dim=0; dim < ndim; dim++)
 			if( p[dim]<pMin[dim] || p[dim]>pMax[dim] )
 				return false;
@@ -730,6 +1061,3 @@ class KDTree {
 };
 
 #endif
-
-
-
@@ -0,0 +1,84 @@
+/**
+ * @file KDTreeHandle.h
+ * @brief conversion between KDTree objects and the handles given to MATLAB
+ *
+ * A handle is a [1x1] uint64 holding the address of the tree (a double
+ * cannot hold every 64 bit address, and "long" is only 32 bit on Win64).
+ * A handle is only dereferenced once it has been found among the live trees,
+ * so a stale, forged or mistyped handle raises an error instead of reading
+ * freed or unmapped memory.
+ *
+ * Every mex file is a separate module with its own statics: the live trees
+ * are kept by one of them, kdtree_registry, in a static std::set as in
+ * fast_marching_mesh.cpp (locked while not empty, the trees are freed at
+ * exit). kdtree_build/kdtree_load add to it, kdtree_delete removes from it
+ * and every mex querying a tree checks its handle against it.
+ */
+#ifndef KDTREEHANDLE_H_
+#define KDTREEHANDLE_H_
+
+#include <stdint.h>
+#include "KDTree.h"
+
+/// Calls kdtree_registry(cmd, address) @return the logical it returns, if any
+inline bool kdtree_registry_call( const char* cmd, uint64_t address, int nlhs ){
+	mxArray* in[2];
+	in[0] = mxCreateString( cmd );
+	in[1] = mxCreateNumericMatrix(1, 1, mxUINT64_CLASS, mxREAL);
+	*((uint64_t*) mxGetData(in[1])) = address;
+	mxArray* out = NULL;
+	mexCallMATLAB( nlhs, &out, 2, in, "kdtree_registry" );
+	mxDestroyArray( in[0] );
+	mxDestroyArray( in[1] );
+	bool answer = false;
+	if( out != NULL ){
+		answer = mxIsLogicalScalarTrue( out );
+		mxDestroyArray( out );
+	}
+	return answer;
+}
+
+/// @return a new [1x1] uint64 MATLAB handle to the tree, which is registered as live
+inline mxArray* kdtree_handle_create( KDTree* tree ){
+	mxArray* handle = mxCreateNumericMatrix(1, 1, mxUINT64_CLASS, mxREAL);
+	*((uint64_t*) mxGetData(handle)) = (uint64_t) (uintptr_t) tree;
+	kdtree_registry_call( "add", (uint64_t) (uintptr_t) tree, 0 );
+	return handle;
+}
+
+/**
+ * Retrieves and validates the tree behind a MATLAB handle, raises a MATLAB
+ * error if the handle is not a live tree. Handles stored as double by older
+ * versions of kdtree_build are still accepted.
+ */
+inline KDTree* kdtree_handle_get( const mxArray* matptr ){
+	// check that I actually received something
+	if( matptr == NULL || mxGetNumberOfElements(matptr) != 1 )
+		mexErrMsgTxt("vararg{1} must be a valid k-D tree pointer\n");
+
+	uint64_t address = 0;
+	if( mxGetClassID(matptr) == mxUINT64_CLASS )
+		address = *((uint64_t*) mxGetData(matptr));
+	else if( mxIsDouble(matptr) )
+		address = (uint64_t) mxGetScalar(matptr);
+	else
+		mexErrMsgTxt("vararg{1} must be a valid k-D tree pointer\n");
+
+	// nothing is read at the address before it is found among the live trees
+	if( address == 0 || !kdtree_registry_call("contains", address, 1) )
+		mexErrMsgTxt("vararg{1} is not a k-D tree or has already been deleted\n");
+	KDTree* tree = (KDTree*) (uintptr_t) address;
+	if( !tree->is_valid() )
+		mexErrMsgTxt("vararg{1} is not a k-D tree or has already been deleted\n");
+	if( tree -> ndims() <= 0 )
+		mexErrMsgTxt("the k-D tree must have k>0");
+	return tree;
+}
+
+/// Unregisters and deletes the tree behind a MATLAB handle (the registry frees it)
+inline void kdtree_handle_destroy( const mxArray* matptr ){
+	KDTree* tree = kdtree_handle_get( matptr );
+	kdtree_registry_call( "delete", (uint64_t) (uintptr_t) tree, 0 );
+}
+
+#endif /* KDTREEHANDLE_H_ */
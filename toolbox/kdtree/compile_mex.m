@@ -1,6 +1,15 @@
 mex kdtree_build.cpp 
 mex kdtree_delete.cpp 
+mex kdtree_save.cpp
+mex kdtree_load.cpp
+mex kdtree_registry.cpp
 mex kdtree_nearest_neighbor.cpp 
-mex kdtree_k_nearest_neighbors.cpp 
+% batched queries run on all cores when compiled with OpenMP
+if ispc
+    omp = {'COMPFLAGS="$COMPFLAGS /openmp"'};
+else
+    omp = {'CXXFLAGS="$CXXFLAGS -fopenmp"', 'LDFLAGS="$LDFLAGS -fopenmp"'};
+end
+mex(omp{:}, 'kdtree_k_nearest_neighbors.cpp')
 mex kdtree_range_query.cpp 
-mex kdtree_ball_query.cpp
\ No newline at end of file
+mex(omp{:}, 'kdtree_ball_query.cpp')
\ No newline at end of file
@@ -0,0 +1,79 @@
+% KDTREE_ANN_BENCHMARK recall vs. throughput of approximate kNN searches
+%
+% Compares, on SIFT-like data (128-D), the approximate k-nearest neighbor
+% searches with a budget of comparisons per query:
+%   * kdtree_k_nearest_neighbors( tree, Q, k, max_checks )  (best-bin-first)
+%   * nn_search( X, atria, Q, k, 0, max_checks )            (ATRIA, nnsearch toolbox)
+%   * vl_kdtreequery( forest, X', Q', 'MaxComparisons', m )  (randomized forest, jjcao_img)
+% against the exact search. Recall is the fraction of the exact k nearest
+% neighbors that are found. The searchers that are not compiled/on the
+% path are skipped.
+%
+% Neighbors that are not found are not reported the same way: the kd-tree
+% and ATRIA give index NaN at distance Inf, vl_kdtreequery gives index 0
+% (uint32) at distance NaN. Neither matches an exact neighbor, so both
+% count as misses in the recall.
+
+clc;
+
+%% data: clustered 128-D descriptors
+N = 50000; M = 1000; D = 128; k = 5;
+rand('seed',1); randn('seed',1);
+centers = 255*rand( 100, D );
+X = centers( ceil(100*rand(N,1)), : ) + 30*randn( N, D );
+Q = centers( ceil(100*rand(M,1)), : ) + 30*randn( M, D );
+budgets = [16 64 256 1024 4096];
+
+%% exact search (ground truth)
+tree = kdtree_build( X );
+tic; exact = kdtree_k_nearest_neighbors( tree, Q, k ); t = toc;
+fprintf('exact kd-tree     : %8.0f queries/s\n', M/t);
+recall = @(idxs) mean( arrayfun(@(i) numel(intersect(idxs(i,:), exact(i,:))), 1:M) ) / k;
+
+results = {};
+%% kd-tree, best-bin-first
+r = zeros(size(budgets)); qps = r;
+for b=1:numel(budgets)
+    tic; idxs = kdtree_k_nearest_neighbors( tree, Q, k, budgets(b) ); t = toc;
+    r(b) = recall( idxs ); qps(b) = M/t;
+    fprintf('kd-tree  %6d checks : recall %.3f, %8.0f queries/s\n', budgets(b), r(b), qps(b));
+end
+results(end+1,:) = {'kd-tree (BBF)', r, qps};
+kdtree_delete( tree );
+
+%% ATRIA
+if exist('nn_prepare','file')==3 && exist('nn_search','file')==3
+    atria = nn_prepare( X );
+    r = zeros(size(budgets)); qps = r;
+    for b=1:numel(budgets)
+        tic; idxs = nn_search( X, atria, Q, k, 0, budgets(b) ); t = toc;
+        r(b) = recall( idxs ); qps(b) = M/t;
+        fprintf('ATRIA    %6d checks : recall %.3f, %8.0f queries/s\n', budgets(b), r(b), qps(b));
+    end
+    results(end+1,:) = {'ATRIA', r, qps};
+end
+
+%% randomized kd-tree forests
+if exist('vl_kdtreebuild','file')==3 && exist('vl_kdtreequery','file')==3
+    Xs = single(X'); Qs = single(Q');
+    for ntrees=[1 4 8]
+        forest = vl_kdtreebuild( Xs, 'NumTrees', ntrees );
+        r = zeros(size(budgets)); qps = r;
+        for b=1:numel(budgets)
+            tic; idxs = vl_kdtreequery( forest, Xs, Qs, 'NumNeighbors', k, 'MaxComparisons', budgets(b) ); t = toc;
+            % idxs is uint32, 0 for a neighbor not found
+            r(b) = recall( double(idxs') ); qps(b) = M/t;
+            fprintf('forest %d %6d checks : recall %.3f, %8.0f queries/s\n', ntrees, budgets(b), r(b), qps(b));
+        end
+        results(end+1,:) = {sprintf('%d-tree forest', ntrees), r, qps};
+    end
+end
+
+%% plot
+close all; figure; hold on;
+for i=1:size(results,1)
+    semilogy( results{i,2}, results{i,3}, '.-' );
+end
+set(gca, 'YScale', 'log');
+xlabel('recall'); ylabel('queries / s');
+legend( results(:,1) );
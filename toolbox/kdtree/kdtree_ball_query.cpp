@@ -8,49 +8,59 @@
 #define __STDC_UTF_16__
 #endif
 #include "mex.h"
+#include "KDTreeHandle.h"
 
-void retrieve_tree( const mxArray* matptr, KDTree* & tree){
-    // retrieve pointer from the MX form
-    double* pointer0 = mxGetPr(matptr);
-    // check that I actually received something
-    if( pointer0 == NULL )
-        mexErrMsgTxt("vararg{1} must be a valid k-D tree pointer\n");
-    // convert it to "long" datatype (good for addresses)
-    long pointer1 = (long) pointer0[0];
-    // convert it to "KDTree"
-    tree = (KDTree*) pointer1;
-    // check that I actually received something
-    if( tree == NULL )
-        mexErrMsgTxt("vararg{1} must be a valid k-D tree pointer\n");
-    if( tree -> ndims() <= 0 )
-        mexErrMsgTxt("the k-D tree must have k>0"); 
-}
-void retrieve_point( const mxArray* matptr, vector<double>& point ){
+void retrieve_queries( const mxArray* matptr, int ndims, double*& data, int& nqueries, bool& batch ){
     // check that I actually received something
     if( matptr == NULL )
         mexErrMsgTxt("vararg{2} must be a [kxN] matrix of data\n");
     
-    // check dimensions
-    if( ( mxGetM(matptr)!=1 || mxGetN(matptr)!=point.size() ) &&
-    	( mxGetN(matptr)!=1 || mxGetM(matptr)!=point.size() ) )
-    	mexErrMsgTxt("vararg{2} must be a [kx1] or a [1xk] point\n");  
-    
-    // retrieve point
-    double* data = mxGetPr(matptr);
+    int M = mxGetM(matptr);
+    int N = mxGetN(matptr);
+    // a single [kx1] or [1xk] point, as in the original interface
+    if( (M==1 || N==1) && M*N==ndims ){
+    	batch = false;
+    	nqueries = 1;
+    }
+    // a [Mxk] matrix of query points, one per row
+    else if( N==ndims ){
+    	batch = true;
+    	nqueries = M;
+    }
+    else
+    	mexErrMsgTxt("vararg{2} must be a [kx1] or a [1xk] point or a [Mxk] matrix of points\n");
     
-    for(int dim=0; dim < point.size(); dim++)
-		point[dim] = data[dim];
+    data = mxGetPr(matptr);
 }
-void retrieve_radius( const mxArray* matptr, double& radius ){
+void retrieve_radius( const mxArray* matptr, int nqueries, double*& radius, bool& perquery ){
     // check that I actually received something
-    if( matptr == NULL )
+    if( matptr == NULL || !mxIsNumeric(matptr) )
         mexErrMsgTxt("vararg{3} must be a scalar\n");
 
-    if( 1 != mxGetM(matptr) || !mxIsNumeric(matptr) || 1 != mxGetN(matptr) )
-    	mexErrMsgTxt("vararg{3} must be a scalar\n");    
+    // either one radius for all the queries or one per query
+    int n = mxGetM(matptr)*mxGetN(matptr);
+    if( n == 1 )
+    	perquery = false;
+    else if( n == nqueries && (mxGetM(matptr)==1 || mxGetN(matptr)==1) )
+    	perquery = true;
+    else
+    	mexErrMsgTxt("vararg{3} must be a scalar or a vector with one radius per query point\n");    
     
-    // retrieve point
-	radius = mxGetScalar(matptr);	
+    radius = mxGetPr(matptr);
+}
+mxArray* create_column( const vector<int>& idxsInRange ){
+    mxArray* column = mxCreateDoubleMatrix(idxsInRange.size(), 1, mxREAL);
+    double* indexes = mxGetPr(column);
+    for (int i=0; i < idxsInRange.size(); i++)
+    	indexes[ i ] = idxsInRange[i] + 1;
+    return column;
+}
+mxArray* create_column( const vector<double>& dists ){
+    mxArray* column = mxCreateDoubleMatrix(dists.size(), 1, mxREAL);
+    double* distances = mxGetPr(column);
+    for (int i=0; i < dists.size(); i++)
+    	distances[ i ] = dists[i];
+    return column;
 }
 void mexFunction(int nlhs, mxArray * plhs[], int nrhs, const mxArray * prhs[]){
 	// chec number of arguments
@@ -62,44 +72,54 @@ void mexFunction(int nlhs, mxArray * plhs[], int nrhs, const mxArray * prhs[]){
 		mexErrMsgTxt("varargin{1} must be a query point\n");
 	if( !mxIsNumeric(prhs[2]) )
 		mexErrMsgTxt("varargin{2} must be a double (radius)\n");
+	if( nlhs > 2 )
+    	mexErrMsgTxt("provide either one or two output parameters.");
 	
 	// retrieve the tree pointer
-    KDTree* tree;
-    retrieve_tree( prhs[0], tree ); 
-    // retrieve the query point
-    vector<double> point(tree->ndims(),0);
-    retrieve_point(prhs[1], point);
+    KDTree* tree = kdtree_handle_get( prhs[0] ); 
+    // retrieve the query points
+    int ndims = tree->ndims();
+    double* query_data;
+    int nqueries;
+    bool batch;
+    retrieve_queries( prhs[1], ndims, query_data, nqueries, batch );
     // retrieve the radius
-    double radius = 0;
-    retrieve_radius(prhs[2], radius);
+    double* radius;
+    bool perquery;
+    retrieve_radius( prhs[2], nqueries, radius, perquery );
     
-    vector<int> idxsInRange;
-    vector<double> dists;
-    tree->ball_query( point, radius, idxsInRange, dists );
+    // execute the queries in parallel, results are kept until
+    // they can be handed to MATLAB (mx* calls are not thread safe)
+    vector< vector<int> > idxsInRange( nqueries );
+    vector< vector<double> > dists( nqueries );
+    #pragma omp parallel
+    {
+    	vector<double> point(ndims,0);
+    	KDTreeQuery query;
+    	#pragma omp for schedule(dynamic,64)
+    	for( int i=0; i<nqueries; i++ ){
+    		for( int j=0; j<ndims; j++ )
+    			point[j] = batch ? query_data[ i+j*nqueries ] : query_data[j];
+    		tree->ball_query( query, &point[0], radius[ perquery ? i : 0 ], idxsInRange[i], dists[i] );
+    	}
+    }
     
-    if( nlhs == 1 ){
-	    // convert vector<int> back in matlab format
-	    plhs[0] = mxCreateDoubleMatrix(idxsInRange.size(), 1, mxREAL);
-	    double* indexes = mxGetPr(plhs[0]);
-	    for (int i=0; i < idxsInRange.size(); i++)
-	    	indexes[ i ] = idxsInRange[i] + 1;
-    } else 
-    if( nlhs == 2 ){
-	    // convert vector<int> back in matlab format
-	    plhs[0] = mxCreateDoubleMatrix(idxsInRange.size(), 1, mxREAL);
-	    double* indexes = mxGetPr(plhs[0]);
-	    for (int i=0; i < idxsInRange.size(); i++)
-	    	indexes[ i ] = idxsInRange[i] + 1;
-	    
-	    // convert vector<double> back in matlab format
-	    plhs[1] = mxCreateDoubleMatrix(dists.size(), 1, mxREAL);
-	    double* distances = mxGetPr(plhs[1]);
-	    for (int i=0; i < dists.size(); i++)
-	    	distances[ i ] = dists[i];
-    	
+    // a single query gives column vectors, a batch [Mx1] cell arrays of them
+    if( !batch ){
+    	plhs[0] = create_column( idxsInRange[0] );
+    	if( nlhs == 2 )
+    		plhs[1] = create_column( dists[0] );
+    }
+    else{
+    	plhs[0] = mxCreateCellMatrix(nqueries, 1);
+    	for( int i=0; i<nqueries; i++ )
+    		mxSetCell( plhs[0], i, create_column(idxsInRange[i]) );
+    	if( nlhs == 2 ){
+    		plhs[1] = mxCreateCellMatrix(nqueries, 1);
+    		for( int i=0; i<nqueries; i++ )
+    			mxSetCell( plhs[1], i, create_column(dists[i]) );
+    	}
     }
-    else
-    	mexErrMsgTxt("provide either one or two output parameters.");
 }
 #endif
 int test1(){
@@ -156,7 +176,33 @@ int test1(){
 	
 	return 0;
 }
+int test2(){
+	// multi-scale Gaussian averages of a query far from the data: no weight, NaN averages
+	vector<double> A(2*30);
+	for( int i=0; i<30; i++ ){ A[i] = (i%6)/6.0; A[30+i] = (i/6)/5.0; }
+	KDTree* tree = new KDTree( &A[0], 30, 2 );
+	KDTreeQuery query;
+	double radius[2] = { .2, .5 };
+	double sigma2[2] = { .01, .04 };
+	double averages[2];
+	int counts[2];
+	double point[2] = { .5, .5 };
+	tree->gaussian_averages( query, point, 2, radius, sigma2, &A[0], 1, 1, averages, counts );
+	if( counts[0]==0 || counts[1]<counts[0] || averages[0]!=averages[0] || averages[1]!=averages[1] ){
+		cout << "gaussian_averages failed on a query inside the data" << endl;
+		return 1;
+	}
+	point[0] = 100; point[1] = 100;
+	tree->gaussian_averages( query, point, 2, radius, sigma2, &A[0], 1, 1, averages, counts );
+	delete tree;
+	if( counts[0]!=0 || counts[1]!=0 || averages[0]==averages[0] || averages[1]==averages[1] ){
+		cout << "gaussian_averages of a query far from the data should be NaN" << endl;
+		return 1;
+	}
+	cout << "far query gives NaN averages" << endl;
+	return 0;
+}
 int main(){
-	return test1();
+	return test1() || test2();
 }
 
@@ -3,19 +3,24 @@
 % SYNTAX
 % idxs = kdtree_ball_query(tree, qpoint, qradii)
 % [idxs, distances] = kdtree_ball_query(tree, qpoint, qradii);
+% [idxs, distances] = kdtree_ball_query(tree, Q, qradii);
 % 
 % INPUT PARAMETERS
 %   tree:   a pointer to a valid kdtree structure
 %   qpoint: a k-dimensional point speficying the center of the ball
-%   qradii: a scalar representing the radius of the ball
+%   Q:      a Mxk matrix of query points (one per row), answered
+%           in parallel
+%   qradii: a scalar representing the radius of the ball, or for Q
+%           a vector with one radius per query point
 % 
 % OUTPUT PARAMETERS
 %   idxs: a column vector of scalars that index the point database.
 %         All the index of points that satisfy the ball query are
 %         reported in idxs. No particular ordering is provided
+%         For a matrix Q, a Mx1 cell array of such vectors.
 % 
 % 	distances: the dinstances from the query result points 
-%              to the query point (optional) 
+%              to the query point (optional), a Mx1 cell array for Q
 %
 % DESCRIPTION
 % The ball query is implemented as simple generalization
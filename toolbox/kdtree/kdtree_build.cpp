@@ -6,11 +6,12 @@
 #define __STDC_UTF_16__
 #endif
 #include "mex.h"
+#include "KDTreeHandle.h"
 
 // matlab entry point
-void retrieve_data( const mxArray* matptr, vector< vector<double> >& dataV, int& npoints, int& ndims){
+void retrieve_data( const mxArray* matptr, double*& data, int& npoints, int& ndims){
     // retrieve pointer from the MX form
-    double* data = mxGetPr(matptr);
+    data = mxGetPr(matptr);
     // check that I actually received something
     if( data == NULL )
         mexErrMsgTxt("vararg{2} must be a [kxN] matrix of data\n");
@@ -18,42 +19,36 @@ void retrieve_data( const mxArray* matptr, vector< vector<double> >& dataV, int&
     // retrieve amount of points
     npoints = mxGetM(matptr);
     ndims   = mxGetN(matptr);
- 
-    // FILL THE DATA STRUCTURES
-	dataV.resize(npoints, vector<double>(ndims));
-	for( int i=0; i<npoints; i++ )
-		for( int j=0; j<ndims; j++ )
-			dataV[i][j] = data[ i + j*npoints ]; 
+    if( npoints <= 0 || ndims <= 0 )
+        mexErrMsgTxt("vararg{2} must be a non-empty [kxN] matrix of data\n");
+}
+void retrieve_bucketsize( const mxArray* matptr, int& bucketsize ){
+    if( 1 != mxGetM(matptr) || !mxIsNumeric(matptr) || 1 != mxGetN(matptr) )
+    	mexErrMsgTxt("vararg{2} must be a scalar (bucket size)\n");
+    bucketsize = (int) mxGetScalar(matptr);
+    if( bucketsize < 1 )
+    	mexErrMsgTxt("the bucket size must be at least 1\n");
 }
 void mexFunction(int nlhs, mxArray * plhs[], int nrhs, const mxArray * prhs[]){   
 	// check input
-	if( nrhs != 1 || !mxIsNumeric(prhs[0]) )
+	if( nrhs < 1 || nrhs > 2 || !mxIsNumeric(prhs[0]) )
 		mexErrMsgTxt("A unique [kxN] matrix of points should be passed.\n");
 	
-	// retrieve the data
-    vector< vector<double> > input_data;
+	// retrieve the data (read in place, the tree keeps its own flat copy)
+    double* input_data;
     int npoints;
     int ndims;
     retrieve_data( prhs[0], input_data, npoints, ndims );
     // printf("npoints %d ndims %d\n", npoints, ndims);
+    int bucketsize = KDTREE_BUCKETSIZE;
+    if( nrhs == 2 )
+    	retrieve_bucketsize( prhs[1], bucketsize );
     
     // fill the k-D tree
-	KDTree* tree = new KDTree( input_data );	
-	
-	// DEBUG
- 	//mexPrintf("npoint %d dimensions %d\n", (int)input_data.size(), (int)input_data[0].size());
-	
-	// DEBUG
-	//for (unsigned int i=0; i < input_data.size(); i++){
-	//	for (unsigned int j=0; j < input_data[i].size(); j++)
-	//		mexPrintf("%.2f ", input_data[i][j] );
-	//	mexPrintf("\n");
-	//}
+	KDTree* tree = new KDTree( input_data, npoints, ndims, bucketsize );	
 
-    // return the program a pointer to the created tree
-    plhs[0] = mxCreateDoubleMatrix(1,1,mxREAL);
-    double* pointer_to_tree = mxGetPr(plhs[0]);
-    pointer_to_tree[0] = (long) tree;
+    // return the program a handle to the created tree
+    plhs[0] = kdtree_handle_create( tree );
 }
 #endif
 
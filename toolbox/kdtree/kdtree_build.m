@@ -2,21 +2,26 @@
 %
 % SYNTAX
 % tree = kdtree_build(p)
+% tree = kdtree_build(p, bucketsize)
 %
 % INPUT PARAMETERS
 %   P: a set of N k-dimensional points stored in a 
 %      NxK matrix. (i.e. each row is a point)
+%   bucketsize: (optional) maximum number of points stored in 
+%      a leaf, default 8. Use 1 for one point per leaf.
 %
 % OUTPUT PARAMETERS
-%   tree: a pointer to the created data structure
+%   tree: a handle (uint64) to the created data structure
 %
 % DESCRIPTION
 % Given a point set p, builds a k-d tree as specified in [1] 
 % with a preprocessing time of O(d N logN), N number of points, 
-% d the dimensionality of a point
+% d the dimensionality of a point. Splits are found with linear time
+% median selection; points are stored in one contiguous buffer and
+% nodes in a single array, leaves hold up to "bucketsize" points.
 % 
 % See also:
-% KDTREE_BUILD_DEMO, KDTREE_NEAREST_NEIGHBOR, 
+% KDTREE_BUILD_DEMO, KDTREE_NEAREST_NEIGHBOR, KDTREE_SAVE, KDTREE_LOAD,
 % KDTREE_RANGE_QUERY, KDTREE_K_NEAREST_NEIGHBORS
 %
 % References:
@@ -6,32 +6,15 @@
 #define __STDC_UTF_16__
 #endif
 #include "mex.h"
+#include "KDTreeHandle.h"
 
-void retrieve_tree( const mxArray* matptr, KDTree* & tree){
-    // retrieve pointer from the MX form
-    double* pointer0 = mxGetPr(matptr);
-    // check that I actually received something
-    if( pointer0 == NULL )
-        mexErrMsgTxt("varargin{1} must be a valid kdtree pointer\n");
-    // convert it to "long" datatype (good for addresses)
-    long pointer1 = (long) pointer0[0];
-    // convert it to "KDTree"
-    tree = (KDTree*) pointer1;
-    // check that I actually received something
-    if( tree == NULL )
-        mexErrMsgTxt("varargin{1} must be a valid kdtree pointer\n");
-    if( tree -> ndims() <= 0 )
-        mexErrMsgTxt("the k-D tree must have k>0");
-}
 void mexFunction(int nlhs, mxArray * plhs[], int nrhs, const mxArray * prhs[]){   
 	// check the arguments
 	if( nrhs!=1 || !mxIsNumeric(prhs[0]) )
 		mexErrMsgTxt("varargin{1} must be a valid kdtree pointer\n");
 	
-	// retrieve the tree pointer
-    KDTree* tree;
-    retrieve_tree( prhs[0], tree );
-    tree -> ~KDTree();
+	// unregister and free the tree, the handle is invalid from now on
+    kdtree_handle_destroy( prhs[0] );
 }
 #endif
 
@@ -50,7 +33,7 @@ int test1(){
 	A[7][0] = 701; A[7][1] = 50;  A[7][2] = 305;
 	KDTree* tree = new KDTree( A );
 	tree -> print_tree();
-	tree -> ~KDTree();
+	delete tree;
 	cout << "terminated correctly" << endl;
 	return 0;
 }
@@ -6,37 +6,29 @@
 #define __STDC_UTF_16__
 #endif
 #include "mex.h"
+#include "KDTreeHandle.h"
 
-void retrieve_tree( const mxArray* matptr, KDTree* & tree){
-    // retrieve pointer from the MX form
-    double* pointer0 = mxGetPr(matptr);
-    // check that I actually received something
-    if( pointer0 == NULL )
-        mexErrMsgTxt("vararg{1} must be a valid k-D tree pointer\n");
-    // convert it to "long" datatype (good for addresses)
-    long pointer1 = (long) pointer0[0];
-    // convert it to "KDTree"
-    tree = (KDTree*) pointer1;
-    // check that I actually received something
-    if( tree == NULL )
-        mexErrMsgTxt("vararg{1} must be a valid k-D tree pointer\n");
-    if( tree -> ndims() <= 0 )
-        mexErrMsgTxt("the k-D tree must have k>0");
-}
-void retrieve_point( const mxArray* matptr, vector<double>& point ){
+void retrieve_queries( const mxArray* matptr, int ndims, double*& data, int& nqueries, bool& batch ){
     // check that I actually received something
     if( matptr == NULL )
         mexErrMsgTxt("vararg{2} must be a [kxN] matrix of data\n");
 
-    if( ( mxGetM(matptr)!=1 || mxGetN(matptr)!=point.size() ) &&
-    	( mxGetN(matptr)!=1 || mxGetM(matptr)!=point.size() ) )
-    	mexErrMsgTxt("vararg{2} must be a [kx1] or a [1xk] point\n");    	
-    
-    // retrieve point
-    double* data = mxGetPr(matptr);
-    
-    for(int dim=0; dim < point.size(); dim++)
-		point[dim] = data[dim];
+    int M = mxGetM(matptr);
+    int N = mxGetN(matptr);
+    // a single [kx1] or [1xk] point, as in the original interface
+    if( (M==1 || N==1) && M*N==ndims ){
+    	batch = false;
+    	nqueries = 1;
+    }
+    // a [Mxk] matrix of query points, one per row
+    else if( N==ndims ){
+    	batch = true;
+    	nqueries = M;
+    }
+    else
+    	mexErrMsgTxt("vararg{2} must be a [kx1] or a [1xk] point or a [Mxk] matrix of points\n");
+
+    data = mxGetPr(matptr);
 }
 void retrieve_k( const mxArray* matptr, int& k ){
     // check that I actually received something
@@ -51,43 +43,67 @@ void retrieve_k( const mxArray* matptr, int& k ){
 }
 void mexFunction(int nlhs, mxArray * plhs[], int nrhs, const mxArray * prhs[]){
 	// chec number of arguments
-	if( nrhs!=3 )
-		mexErrMsgTxt("This function requires 3 arguments\n");
+	if( nrhs!=3 && nrhs!=4 )
+		mexErrMsgTxt("This function requires 3 or 4 arguments\n");
 	if( !mxIsNumeric(prhs[0]) )
 		mexErrMsgTxt("varargin{0} must be a valid kdtree pointer\n");
 	if( !mxIsNumeric(prhs[1]) )
 		mexErrMsgTxt("varargin{1} must be a query point\n");
 	if( !mxIsNumeric(prhs[2]) )
 		mexErrMsgTxt("varargin{2} must be a scalar integer\n");
+	if( nrhs==4 && (!mxIsNumeric(prhs[3]) || mxGetNumberOfElements(prhs[3])!=1) )
+		mexErrMsgTxt("varargin{3} must be a scalar integer\n");
 		
 	// retrieve the tree pointer
-    KDTree* tree;
-    retrieve_tree( prhs[0], tree );
-    // retrieve the query point
-    vector<double> query(tree->ndims(),0);
-    retrieve_point( prhs[1], query );
+    KDTree* tree = kdtree_handle_get( prhs[0] );
+    // retrieve the query points
+    int ndims = tree->ndims();
+    double* query_data;
+    int nqueries;
+    bool batch;
+    retrieve_queries( prhs[1], ndims, query_data, nqueries, batch );
     // retrieve the query cardinality
     int k=0;
     retrieve_k( prhs[2], k );
 
     if( k<=0 || k>tree->size() )
     	mexErrMsgIdAndTxt("KDTree:knnoutbounds","k must be within possible range [1:%d] but it is %d\n", tree->size(), k );
+    // approximate search: maximum number of points compared per query (0, exact search)
+    int max_checks = nrhs==4 ? (int) mxGetScalar(prhs[3]) : 0;
 
-
-    // execute the query
-    vector<int> idxsInRange;
-    vector<double> distances;
-    tree->k_closest_points(query, k, idxsInRange, distances);
-        
-    // return the indexes
-    plhs[0] = mxCreateDoubleMatrix(idxsInRange.size(), 1, mxREAL);
-    plhs[1] = mxCreateDoubleMatrix(idxsInRange.size(), 1, mxREAL);  
+    // a single query gives [kx1] columns, a batch [Mxk] matrices (row i for query i)
+    plhs[0] = batch ? mxCreateDoubleMatrix(nqueries, k, mxREAL) : mxCreateDoubleMatrix(k, 1, mxREAL);
+    plhs[1] = batch ? mxCreateDoubleMatrix(nqueries, k, mxREAL) : mxCreateDoubleMatrix(k, 1, mxREAL);
     double* indexes = mxGetPr(plhs[0]);
     double* dists   = mxGetPr(plhs[1]);
-    for (int i=0; i < idxsInRange.size(); i++){
-    	indexes[ i ] = idxsInRange[i] + 1;
-        dists[i] = distances[i];
-    }   
+
+    // the mx API is not thread safe, its constants are read before the parallel region
+    const double nan = mxGetNaN();
+    const double inf = mxGetInf();
+
+    // execute the queries, every thread owns its search state and buffers
+    #pragma omp parallel
+    {
+    	KDTreeQuery context;
+    	vector<double> query(ndims,0);
+    	vector<int> idxs(k);
+    	vector<double> distances(k);
+    	#pragma omp for schedule(dynamic,64)
+    	for( int i=0; i<nqueries; i++ ){
+    		for( int j=0; j<ndims; j++ )
+    			query[j] = batch ? query_data[ i+j*nqueries ] : query_data[j];
+    		int n = tree->k_closest_points( context, &query[0], k, &idxs[0], &distances[0], max_checks );
+    		for( int j=0; j<n; j++ ){
+    			indexes[ i+j*nqueries ] = idxs[j] + 1;
+    			dists[ i+j*nqueries ] = distances[j];
+    		}
+    		// a budget below k compares fewer than k points, the others are not found
+    		for( int j=n; j<k; j++ ){
+    			indexes[ i+j*nqueries ] = nan;
+    			dists[ i+j*nqueries ] = inf;
+    		}
+    	}
+    }
 }
 #endif
 
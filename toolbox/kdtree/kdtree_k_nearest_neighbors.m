@@ -2,22 +2,36 @@
 %
 % SYNTAX
 % idxs = kdtree_k_nearest_neighbors( tree, P, k )
+% [idxs, dists] = kdtree_k_nearest_neighbors( tree, Q, k )
+% [idxs, dists] = kdtree_k_nearest_neighbors( tree, Q, k, max_checks )
 %
 % INPUT PARAMETERS
 %   tree: a pointer to the previously constructed k-d tree
 %   P: a K-dimensional points stored in a Kx1 vector (column)
+%   Q: a MxK matrix of query points (one per row), answered in parallel
 %   k: the number of closest neighbors to extract 
+%   max_checks: (optional) approximate search, at most max_checks points
+%         are compared to each query (best-bin-first order [3]). Default
+%         0 means exact search. With max_checks < k only max_checks
+%         neighbors are found, the others are NaN, at distance Inf
 %
 % OUTPUT PARAMETERS
 %   idxs: a column vector of scalars that index the point database.
 %         the k closest point to P are reported in increasing distance
-%         order.
+%         order. For a matrix Q, a Mxk matrix whose i-th row holds the
+%         neighbors of Q(i,:).
+%   dists: the corresponding distances, same size as idxs
 %
 % DESCRIPTION
 % Given a k-d tree as specified in [1] it computes a k-nearest neighbor
 % query (kNN) as specified in [2] with a preprocessing time of O(d N logN)
 % and an expected query time of (log N), N number of points, d dimensionality
 % of a point in the set.
+%
+% In high dimension (SIFT-like descriptors) the exact search ends up
+% comparing most of the points. With max_checks the cells are visited in
+% increasing distance to the query [3] and the search stops after
+% max_checks comparisons, trading recall for speed (see KDTREE_ANN_BENCHMARK).
 % 
 % See also:
 % KDTREE_K_NEAREST_NEIGHBORS_DEMO, KDTREE_BUILD
@@ -30,6 +44,9 @@
 %     for finding best matches in logarithmic expected time,
 %     1977, ACM Transactions Math. Softw. pag 209-226
 %     DOI: http://doi.acm.org/10.1145/355744.355745
+% [3] J.S. Beis, D.G. Lowe, "Shape indexing using approximate
+%     nearest-neighbour search in high-dimensional spaces",
+%     CVPR 1997, pag 1000-1006
 %
 
 % Copyright (c) 2008 Andrea Tagliasacchi
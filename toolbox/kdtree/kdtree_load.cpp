@@ -0,0 +1,57 @@
+#include "KDTree.h"
+
+#ifndef CPPONLY
+#include <yvals.h>
+#if (_MSC_VER >= 1600)
+#define __STDC_UTF_16__
+#endif
+#include "mex.h"
+#include "KDTreeHandle.h"
+
+void retrieve_filename( const mxArray* matptr, vector<char>& filename ){
+    // check that I actually received something
+    if( matptr == NULL || !mxIsChar(matptr) )
+        mexErrMsgTxt("vararg{1} must be a file name\n");
+    filename.resize( mxGetNumberOfElements(matptr)+1 );
+    mxGetString( matptr, &filename[0], filename.size() );
+}
+void mexFunction(int nlhs, mxArray * plhs[], int nrhs, const mxArray * prhs[]){
+	// check number of arguments
+	if( nrhs!=1 )
+		mexErrMsgTxt("This function requires 1 argument\n");
+
+	// retrieve the file name
+    vector<char> filename;
+    retrieve_filename( prhs[0], filename );
+
+    // map the tree, nothing is rebuilt
+    KDTree* tree = KDTree::load( &filename[0] );
+    if( tree == NULL )
+    	mexErrMsgIdAndTxt("KDTree:load","'%s' is not a readable k-D tree file\n", &filename[0] );
+
+    // return the program a handle to the loaded tree
+    plhs[0] = kdtree_handle_create( tree );
+}
+#endif
+
+using namespace std;
+#include <iostream>
+int test1(){
+	// a missing file is reported as NULL
+	KDTree* tree = KDTree::load( "this_file_does_not_exist.kdt" );
+	cout << "missing file: " << (tree == NULL ? "rejected" : "ACCEPTED") << endl;
+	return tree == NULL ? 0 : 1;
+}
+int test2(){
+	// a file which is not a tree is reported as NULL
+	FILE* fid = fopen( "kdtree_load_test.kdt", "wb" );
+	for (int i=0; i < 100; i++) fputc( i, fid );
+	fclose( fid );
+	KDTree* tree = KDTree::load( "kdtree_load_test.kdt" );
+	remove( "kdtree_load_test.kdt" );
+	cout << "corrupted file: " << (tree == NULL ? "rejected" : "ACCEPTED") << endl;
+	return tree == NULL ? 0 : 1;
+}
+int main (int argc, char * const argv[]) {
+	return test1() + test2();
+}
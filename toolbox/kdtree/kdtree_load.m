@@ -0,0 +1,21 @@
+% KDTREE_LOAD memory-map a kd-tree written by kdtree_save
+%
+% SYNTAX
+% tree = kdtree_load(filename)
+%
+% INPUT PARAMETERS
+%   filename: a file written by KDTREE_SAVE
+%
+% OUTPUT PARAMETERS
+%   tree: a pointer to the loaded tree, to be used as the one 
+%         returned by KDTREE_BUILD and freed with KDTREE_DELETE
+%
+% DESCRIPTION
+% The file is memory-mapped and queried in place: loading takes a
+% constant time whatever the size of the point set, pages are read
+% from disk only when the queries touch them. The file must not be
+% modified while the tree is in use.
+% 
+% See also:
+% KDTREE_SAVE, KDTREE_LOAD_DEMO, KDTREE_BUILD, KDTREE_DELETE
+%
@@ -0,0 +1,23 @@
+%% KDTREE_LOAD_DEMO: illustrates kdtree_save and kdtree_load
+clc, clear, close all;
+mex kdtree_build.cpp
+mex kdtree_save.cpp
+mex kdtree_load.cpp
+mex kdtree_k_nearest_neighbors.cpp
+mex kdtree_delete.cpp
+disp('compiled.');
+
+p = rand( 1000000, 3 );
+tic; tree = kdtree_build( p ); disp(sprintf('build: %.3fs', toc));
+filename = [tempname '.kdt'];
+kdtree_save( tree, filename );
+
+tic; loaded = kdtree_load( filename ); disp(sprintf('load: %.3fs', toc));
+q = rand( 1, 3 );
+idxs1 = kdtree_k_nearest_neighbors( tree, q, 10 );
+idxs2 = kdtree_k_nearest_neighbors( loaded, q, 10 );
+disp(sprintf('same neighbors: %d', isequal(idxs1, idxs2)));
+
+kdtree_delete( tree );
+kdtree_delete( loaded );
+delete( filename );
@@ -6,23 +6,8 @@
 #define __STDC_UTF_16__
 #endif
 #include "mex.h"
+#include "KDTreeHandle.h"
 
-void retrieve_tree( const mxArray* matptr, KDTree* & tree){
-    // retrieve pointer from the MX form
-    double* pointer0 = mxGetPr(matptr);
-    // check that I actually received something
-    if( pointer0 == NULL )
-        mexErrMsgTxt("vararg{1} must be a valid k-D tree pointer\n");
-    // convert it to "long" datatype (good for addresses)
-    long pointer1 = (long) pointer0[0];
-    // convert it to "KDTree"
-    tree = (KDTree*) pointer1;
-    // check that I actually received something
-    if( tree == NULL )
-        mexErrMsgTxt("vararg{1} must be a valid k-D tree pointer\n");
-    if( tree -> ndims() <= 0 )
-        mexErrMsgTxt("the k-D tree must have k>0"); 
-}
 void retrieve_data( const mxArray* matptr, double*& data, int& npoints, int& ndims){	
 	// retrieve pointer from the MX form
     data = mxGetPr(matptr);
@@ -43,8 +28,7 @@ void mexFunction(int nlhs, mxArray * plhs[], int nrhs, const mxArray * prhs[]){
 		mexErrMsgTxt("varargin{1} must be a query set of points\n");
 		
     // retrieve the tree pointer
-    KDTree* tree;
-    retrieve_tree( prhs[0], tree ); 
+    KDTree* tree = kdtree_handle_get( prhs[0] ); 
     // retrieve the query data
     double* query_data;
     int npoints, ndims;
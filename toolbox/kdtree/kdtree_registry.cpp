@@ -0,0 +1,65 @@
+#include "KDTree.h"
+
+#ifndef CPPONLY
+#include <yvals.h>
+#if (_MSC_VER >= 1600)
+#define __STDC_UTF_16__
+#endif
+#include "mex.h"
+#include <set>
+#include <stdint.h>
+
+// trees created by kdtree_build/kdtree_load, a handle is valid only if it is in this set
+static std::set<KDTree*> trees;
+
+static void delete_all_trees(){
+	for( std::set<KDTree*>::iterator it=trees.begin(); it!=trees.end(); ++it )
+		delete *it;
+	trees.clear();
+}
+
+void mexFunction(int nlhs, mxArray * plhs[], int nrhs, const mxArray * prhs[]){
+	// check the arguments
+	if( nrhs!=2 || !mxIsChar(prhs[0]) || mxGetClassID(prhs[1])!=mxUINT64_CLASS || mxGetNumberOfElements(prhs[1])!=1 )
+		mexErrMsgTxt("usage: kdtree_registry('add'|'contains'|'delete', tree)\n");
+	char cmd[16];
+	mxGetString( prhs[0], cmd, sizeof(cmd) );
+	KDTree* tree = (KDTree*) (uintptr_t) *((uint64_t*) mxGetData(prhs[1]));
+
+	if( strcmp(cmd, "add")==0 ){
+		if( trees.empty() ){
+			// keep the set (and the trees) alive through "clear all" until the last tree is deleted
+			mexLock();
+			mexAtExit( delete_all_trees );
+		}
+		trees.insert( tree );
+	}
+	else if( strcmp(cmd, "contains")==0 ){
+		plhs[0] = mxCreateLogicalScalar( trees.find(tree)!=trees.end() );
+	}
+	else if( strcmp(cmd, "delete")==0 ){
+		if( trees.erase(tree)==0 )
+			mexErrMsgTxt("vararg{1} is not a k-D tree or has already been deleted\n");
+		delete tree;
+		if( trees.empty() )
+			mexUnlock();
+	}
+	else
+		mexErrMsgTxt("unknown command, should be 'add', 'contains' or 'delete'\n");
+}
+#endif
+
+using namespace std;
+#include <iostream>
+int test1(){
+	// the registry only exists in MATLAB, a tree is simply created and freed
+	vector< Point > A(4, vector<double>(2,0));
+	A[1][0] = 1; A[2][1] = 1; A[3][0] = 1; A[3][1] = 1;
+	KDTree* tree = new KDTree( A );
+	delete tree;
+	cout << "terminated correctly" << endl;
+	return 0;
+}
+int main (int argc, char * const argv[]) {
+	return test1();
+}
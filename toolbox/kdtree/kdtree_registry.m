@@ -0,0 +1,17 @@
+% KDTREE_REGISTRY the live kd-trees, private to the kdtree mex files
+%
+% SYNTAX
+% kdtree_registry('add', tree)
+% live = kdtree_registry('contains', tree)
+% kdtree_registry('delete', tree)
+%
+% DESCRIPTION
+% Keeps the trees created by KDTREE_BUILD and KDTREE_LOAD: a handle is
+% used by the other mex files only if it is registered here, and
+% KDTREE_DELETE frees it through 'delete'. The registry stays loaded
+% through "clear all" while trees are alive, the remaining trees are
+% freed when MATLAB exits. Not meant to be called directly.
+% 
+% See also:
+% KDTREE_BUILD, KDTREE_LOAD, KDTREE_DELETE
+%
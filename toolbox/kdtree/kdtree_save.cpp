@@ -0,0 +1,79 @@
+#include "KDTree.h"
+
+#ifndef CPPONLY
+#include <yvals.h>
+#if (_MSC_VER >= 1600)
+#define __STDC_UTF_16__
+#endif
+#include "mex.h"
+#include "KDTreeHandle.h"
+
+void retrieve_filename( const mxArray* matptr, vector<char>& filename ){
+    // check that I actually received something
+    if( matptr == NULL || !mxIsChar(matptr) )
+        mexErrMsgTxt("vararg{2} must be a file name\n");
+    filename.resize( mxGetNumberOfElements(matptr)+1 );
+    mxGetString( matptr, &filename[0], filename.size() );
+}
+void mexFunction(int nlhs, mxArray * plhs[], int nrhs, const mxArray * prhs[]){
+	// check number of arguments
+	if( nrhs!=2 )
+		mexErrMsgTxt("This function requires 2 arguments\n");
+	if( !mxIsNumeric(prhs[0]) )
+		mexErrMsgTxt("varargin{0} must be a valid kdtree pointer\n");
+
+	// retrieve the tree pointer
+    KDTree* tree = kdtree_handle_get( prhs[0] );
+    // retrieve the file name
+    vector<char> filename;
+    retrieve_filename( prhs[1], filename );
+
+    if( !tree->save( &filename[0] ) )
+    	mexErrMsgIdAndTxt("KDTree:save","could not write the k-D tree to '%s'\n", &filename[0] );
+}
+#endif
+
+using namespace std;
+#include <iostream>
+int test1(){
+	int N = 1000;
+	vector< Point > A(N, vector<double>(3,0));
+	for (int n=0; n < N; n++) {
+		A[n][0] = double(rand()) / RAND_MAX;
+		A[n][1] = double(rand()) / RAND_MAX;
+		A[n][2] = double(rand()) / RAND_MAX;
+	}
+	KDTree* tree = new KDTree( A );
+	if( !tree->save( "kdtree_save_test.kdt" ) ){
+		cout << "could not save" << endl;
+		return 1;
+	}
+	KDTree* loaded = KDTree::load( "kdtree_save_test.kdt" );
+	if( loaded == NULL ){
+		cout << "could not load" << endl;
+		return 1;
+	}
+
+	// the loaded tree must answer as the built one
+	int errors = 0;
+	for (int q=0; q < 100; q++) {
+		Point p(3,0);
+		p[0] = double(rand()) / RAND_MAX;
+		p[1] = double(rand()) / RAND_MAX;
+		p[2] = double(rand()) / RAND_MAX;
+		vector<int> I1, I2;
+		vector<double> D1, D2;
+		tree->k_closest_points( p, 5, I1, D1 );
+		loaded->k_closest_points( p, 5, I2, D2 );
+		if( I1 != I2 || D1 != D2 )
+			errors++;
+	}
+	cout << "mismatching queries: " << errors << endl;
+	delete loaded;
+	delete tree;
+	remove( "kdtree_save_test.kdt" );
+	return errors;
+}
+int main (int argc, char * const argv[]) {
+	return test1(); // save and memory-mapped load round trip
+}
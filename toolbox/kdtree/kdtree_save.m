@@ -0,0 +1,19 @@
+% KDTREE_SAVE write a kd-tree to a binary file
+%
+% SYNTAX
+% kdtree_save(tree, filename)
+%
+% INPUT PARAMETERS
+%   tree: a pointer to a tree created by kdtree_build or kdtree_load
+%   filename: the file to (over)write
+%
+% DESCRIPTION
+% Stores the nodes, the points and the index permutation of the tree
+% as flat arrays in a compact binary file. The file is reloaded with
+% KDTREE_LOAD, which memory-maps it instead of rebuilding the tree.
+% The format uses the native byte order and is not portable across
+% machines of different endianness.
+% 
+% See also:
+% KDTREE_LOAD, KDTREE_LOAD_DEMO, KDTREE_BUILD
+%
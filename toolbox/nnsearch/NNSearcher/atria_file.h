@@ -0,0 +1,140 @@
+#ifndef ATRIA_FILE_H
+#define ATRIA_FILE_H
+
+// This header file is included from nearneigh_search.h
+// It should not be included from any other file.
+//
+// Binary file format of the ATRIA preprocessing data, written by ATRIA::save().
+// The file holds the flat tree exactly as it is searched, so ATRIA(points, filename)
+// only maps the file and checks it : nothing is parsed or copied. The node records and
+// the permutation are validated like the struct given by nn_prepare (see nn2matlab.h),
+// so that a damaged or mismatched file is rejected instead of being read out of bounds.
+//
+// Version 1, native endianness, all offsets in bytes :
+//      0  header (atria_file_header, padded to 128 bytes)
+//    128  nodes : total_clusters flat_cluster records (32 bytes each), root first
+//         permutation : Nused flat_neighbor records (16 bytes each)
+// Point indices are stored as int, so the point set may have at most 2^31-1 points.
+
+#include <cstdio>
+#include <cstring>
+
+#define ATRIA_FILE_VERSION 1
+#define ATRIA_FILE_HEADERSIZE 128
+
+struct atria_file_header {
+	char magic[8];			// "ATRIA\0\0\0"
+	int version;			// ATRIA_FILE_VERSION
+	int endian;				// 1 written as int, to detect foreign byte orders
+	int nodesize;			// sizeof(flat_cluster) of the writer
+	int neighborsize;		// sizeof(flat_neighbor) of the writer
+	int N;					// number of points of the point set the tree was built for
+	int dim;				// dimension of these points
+	int Nused;
+	int total_clusters;
+	int terminal_nodes;
+	int total_points_in_terminal_node;
+	int MINPOINTS;
+	int reserved;
+	char metric[32];		// name of the metric, zero terminated
+};
+
+// read and check the header of an ATRIA file, returns false if filename is not an ATRIA file
+inline bool read_atria_file_header(const char* filename, atria_file_header& header)
+{
+	FILE* fid = fopen(filename, "rb");
+	if (fid == 0) 
+		return false;
+	const bool ok = (fread(&header, sizeof(header), 1, fid) == 1);
+	fclose(fid);
+	
+	return ok && (!memcmp(header.magic, "ATRIA\0\0\0", 8)) && (header.version == ATRIA_FILE_VERSION) && (header.endian == 1)
+		&& (header.nodesize == (int) sizeof(flat_cluster)) && (header.neighborsize == (int) sizeof(flat_neighbor))
+		&& (header.Nused >= 2) && (header.Nused <= header.N) && (header.total_clusters >= 1)
+		&& (header.metric[sizeof(header.metric)-1] == 0);
+}
+
+template<class POINT_SET>
+bool ATRIA<POINT_SET>::save(const char* filename, const char* metric) const
+{
+	if (err || (strlen(metric) >= 32) || (points.size() > 2147483647L)) 
+		return false;
+	
+	char block[ATRIA_FILE_HEADERSIZE];
+	atria_file_header& header = *((atria_file_header*) block);
+	memset(block, 0, sizeof(block));
+	
+	memcpy(header.magic, "ATRIA\0\0\0", 8);
+	header.version = ATRIA_FILE_VERSION;
+	header.endian = 1;
+	header.nodesize = sizeof(flat_cluster);
+	header.neighborsize = sizeof(flat_neighbor);
+	header.N = points.size();
+	header.dim = points.dimension();
+	header.Nused = Nused;
+	header.total_clusters = total_clusters;
+	header.terminal_nodes = terminal_nodes;
+	header.total_points_in_terminal_node = total_points_in_terminal_node;
+	header.MINPOINTS = MINPOINTS;
+	strcpy(header.metric, metric);
+	
+	FILE* fid = fopen(filename, "wb");
+	if (fid == 0) 
+		return false;
+	const bool ok = (fwrite(block, 1, sizeof(block), fid) == sizeof(block))
+		&& (fwrite(nodes, sizeof(flat_cluster), total_clusters, fid) == (size_t) total_clusters)
+		&& (fwrite(permutation, sizeof(flat_neighbor), Nused, fid) == (size_t) Nused);
+	return (fclose(fid) == 0) && ok;
+}
+
+template<class POINT_SET>
+ATRIA<POINT_SET>::ATRIA(const POINT_SET& p, const char* filename)
+ : nearneigh_searcher<POINT_SET>(p, 0), root(0,0), MINPOINTS(0), permutation_table(0), nodes(0), permutation(0), total_clusters(1),
+ total_points_in_terminal_node(0), terminal_nodes(0)
+{
+	err = !map_file(filename);
+}
+
+template<class POINT_SET>
+bool ATRIA<POINT_SET>::map_file(const char* filename)
+{
+	atria_file_header header;
+	
+	if (!read_atria_file_header(filename, header) || (header.N != points.size()) || (header.dim != points.dimension())) 
+		return false;
+	
+	if (!mapping.open(filename) || (mapping.size() != ATRIA_FILE_HEADERSIZE + 
+		(size_t) header.total_clusters * sizeof(flat_cluster) + (size_t) header.Nused * sizeof(flat_neighbor))) 
+		return false;
+	
+	Nused = header.Nused;
+	total_clusters = header.total_clusters;
+	terminal_nodes = header.terminal_nodes;
+	total_points_in_terminal_node = header.total_points_in_terminal_node;
+	MINPOINTS = header.MINPOINTS;
+	
+	nodes = (const flat_cluster*) (mapping.data() + ATRIA_FILE_HEADERSIZE);
+	permutation = (const flat_neighbor*) (mapping.data() + ATRIA_FILE_HEADERSIZE + (size_t) total_clusters * sizeof(flat_cluster));
+	
+	for (long i=0; i < Nused; i++) {
+		if ((permutation[i].index() < 0) || (permutation[i].index() >= points.size())) 
+			return false;
+	}
+	for (long i=0; i < total_clusters; i++) {
+		const flat_cluster& c = nodes[i];
+		if ((c.center < 0) || (c.center >= Nused)) 
+			return false;
+		if (c.is_terminal()) {
+			if ((c.start < 0) || (c.length < 0) || ((long) c.start + c.length > Nused)) 
+				return false;
+		} else {
+			// children are stored after their parent, which also rules out cycles
+			if ((c.left <= i) || (c.left >= total_clusters) || (c.right <= i) || (c.right >= total_clusters)) 
+				return false;
+		}
+	}
+	
+	return true;
+}
+
+#endif
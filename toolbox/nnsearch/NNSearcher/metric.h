@@ -3,6 +3,127 @@
 
 #include "nn_aux.h"
 
+// Vectorized kernels for points whose coordinates are contiguous in memory (packed_point_set, C_point_set).
+// AVX is used when the compiler targets it (e.g. -mavx, /arch:AVX), otherwise SSE2 on x86/x64, otherwise plain loops.
+// With PARTIAL == true, the kernels stop after a block of 8 coordinates as soon as the partial value exceeds thresh
+// and return this partial value (INFINITY for the maximum). Both variants sum in the same order, so they return
+// the same full value.
+#if defined(__AVX__)
+	#include <immintrin.h>
+	#define NN_USE_AVX
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+	#include <emmintrin.h>
+	#define NN_USE_SSE2
+#endif
+
+template <bool PARTIAL>
+inline double packed_sum_of_squares(const double* a, const double* b, const long D, const double thresh)
+{
+	long d = 0;
+	double dist = 0;
+#if defined(NN_USE_AVX)
+	__m256d s0 = _mm256_setzero_pd();
+	__m256d s1 = _mm256_setzero_pd();
+	for (; d+8 <= D; d += 8) {
+		const __m256d x0 = _mm256_sub_pd(_mm256_loadu_pd(a+d), _mm256_loadu_pd(b+d));
+		const __m256d x1 = _mm256_sub_pd(_mm256_loadu_pd(a+d+4), _mm256_loadu_pd(b+d+4));
+		s0 = _mm256_add_pd(s0, _mm256_mul_pd(x0, x0));
+		s1 = _mm256_add_pd(s1, _mm256_mul_pd(x1, x1));
+		if (PARTIAL) {
+			const __m256d s = _mm256_add_pd(s0, s1);
+			const __m128d h = _mm_add_pd(_mm256_castpd256_pd128(s), _mm256_extractf128_pd(s, 1));
+			const double partial = _mm_cvtsd_f64(_mm_add_sd(h, _mm_unpackhi_pd(h, h)));
+			if (partial > thresh)
+				return partial;
+		}
+	}
+	for (; d+4 <= D; d += 4) {
+		const __m256d x0 = _mm256_sub_pd(_mm256_loadu_pd(a+d), _mm256_loadu_pd(b+d));
+		s0 = _mm256_add_pd(s0, _mm256_mul_pd(x0, x0));
+	}
+	const __m256d s = _mm256_add_pd(s0, s1);
+	const __m128d h = _mm_add_pd(_mm256_castpd256_pd128(s), _mm256_extractf128_pd(s, 1));
+	dist = _mm_cvtsd_f64(_mm_add_sd(h, _mm_unpackhi_pd(h, h)));
+#elif defined(NN_USE_SSE2)
+	__m128d s0 = _mm_setzero_pd();
+	__m128d s1 = _mm_setzero_pd();
+	for (; d+8 <= D; d += 8) {
+		const __m128d x0 = _mm_sub_pd(_mm_loadu_pd(a+d), _mm_loadu_pd(b+d));
+		const __m128d x1 = _mm_sub_pd(_mm_loadu_pd(a+d+2), _mm_loadu_pd(b+d+2));
+		const __m128d x2 = _mm_sub_pd(_mm_loadu_pd(a+d+4), _mm_loadu_pd(b+d+4));
+		const __m128d x3 = _mm_sub_pd(_mm_loadu_pd(a+d+6), _mm_loadu_pd(b+d+6));
+		s0 = _mm_add_pd(s0, _mm_add_pd(_mm_mul_pd(x0, x0), _mm_mul_pd(x2, x2)));
+		s1 = _mm_add_pd(s1, _mm_add_pd(_mm_mul_pd(x1, x1), _mm_mul_pd(x3, x3)));
+		if (PARTIAL) {
+			const __m128d h = _mm_add_pd(s0, s1);
+			const double partial = _mm_cvtsd_f64(_mm_add_sd(h, _mm_unpackhi_pd(h, h)));
+			if (partial > thresh)
+				return partial;
+		}
+	}
+	for (; d+2 <= D; d += 2) {
+		const __m128d x0 = _mm_sub_pd(_mm_loadu_pd(a+d), _mm_loadu_pd(b+d));
+		s0 = _mm_add_pd(s0, _mm_mul_pd(x0, x0));
+	}
+	const __m128d h = _mm_add_pd(s0, s1);
+	dist = _mm_cvtsd_f64(_mm_add_sd(h, _mm_unpackhi_pd(h, h)));
+#endif
+	for (; d < D; d++) {
+		const double x = a[d] - b[d];
+		dist += x * x;
+		if (PARTIAL && (dist > thresh))
+			return dist;
+	}
+	return dist;
+}
+
+template <bool PARTIAL>
+inline double packed_max_abs_difference(const double* a, const double* b, const long D, const double thresh)
+{
+	long d = 0;
+	double dist = 0;
+#if defined(NN_USE_AVX)
+	const __m256d sign = _mm256_set1_pd(-0.0);
+	__m256d m0 = _mm256_setzero_pd();
+	__m256d m1 = _mm256_setzero_pd();
+	for (; d+8 <= D; d += 8) {
+		m0 = _mm256_max_pd(m0, _mm256_andnot_pd(sign, _mm256_sub_pd(_mm256_loadu_pd(a+d), _mm256_loadu_pd(b+d))));
+		m1 = _mm256_max_pd(m1, _mm256_andnot_pd(sign, _mm256_sub_pd(_mm256_loadu_pd(a+d+4), _mm256_loadu_pd(b+d+4))));
+		if (PARTIAL && _mm256_movemask_pd(_mm256_cmp_pd(_mm256_max_pd(m0, m1), _mm256_set1_pd(thresh), _CMP_GT_OQ)))
+			return INFINITY;
+	}
+	for (; d+4 <= D; d += 4)
+		m0 = _mm256_max_pd(m0, _mm256_andnot_pd(sign, _mm256_sub_pd(_mm256_loadu_pd(a+d), _mm256_loadu_pd(b+d))));
+	const __m256d m = _mm256_max_pd(m0, m1);
+	const __m128d h = _mm_max_pd(_mm256_castpd256_pd128(m), _mm256_extractf128_pd(m, 1));
+	dist = _mm_cvtsd_f64(_mm_max_sd(h, _mm_unpackhi_pd(h, h)));
+#elif defined(NN_USE_SSE2)
+	const __m128d sign = _mm_set1_pd(-0.0);
+	__m128d m0 = _mm_setzero_pd();
+	__m128d m1 = _mm_setzero_pd();
+	for (; d+8 <= D; d += 8) {
+		m0 = _mm_max_pd(m0, _mm_andnot_pd(sign, _mm_sub_pd(_mm_loadu_pd(a+d), _mm_loadu_pd(b+d))));
+		m1 = _mm_max_pd(m1, _mm_andnot_pd(sign, _mm_sub_pd(_mm_loadu_pd(a+d+2), _mm_loadu_pd(b+d+2))));
+		m0 = _mm_max_pd(m0, _mm_andnot_pd(sign, _mm_sub_pd(_mm_loadu_pd(a+d+4), _mm_loadu_pd(b+d+4))));
+		m1 = _mm_max_pd(m1, _mm_andnot_pd(sign, _mm_sub_pd(_mm_loadu_pd(a+d+6), _mm_loadu_pd(b+d+6))));
+		if (PARTIAL && _mm_movemask_pd(_mm_cmpgt_pd(_mm_max_pd(m0, m1), _mm_set1_pd(thresh))))
+			return INFINITY;
+	}
+	for (; d+2 <= D; d += 2)
+		m0 = _mm_max_pd(m0, _mm_andnot_pd(sign, _mm_sub_pd(_mm_loadu_pd(a+d), _mm_loadu_pd(b+d))));
+	const __m128d h = _mm_max_pd(m0, m1);
+	dist = _mm_cvtsd_f64(_mm_max_sd(h, _mm_unpackhi_pd(h, h)));
+#endif
+	for (; d < D; d++) {
+		const double x = fabs(a[d] - b[d]);
+		if (x > dist)
+			dist = x;
+	}
+	if (PARTIAL && (dist > thresh))
+		return INFINITY;
+	return dist;
+}
+
 // This header file defines templated function objects (functors) for distance calculations. They work on any reasonable
 // container class by using forward iterators
 // For good performance, no bound checking is done, so it's the programmer's resposibility to have everything properly
@@ -49,6 +170,20 @@ class euclidian_distance {
 			}
   			return sqrt(dist);
 		}		
+
+		// contiguous coordinates : vectorized
+		double operator() (const double* first1, const double* last1, const double* first2) const 
+		{
+			return sqrt(packed_sum_of_squares<false>(first1, first2, last1-first1, 0));
+		}
+		double operator() (const double* first1, const double* last1, const double* first2, const double thresh) const 
+		{
+			const double t = thresh * thresh;
+			const double dist = packed_sum_of_squares<true>(first1, first2, last1-first1, t);
+			if (dist > t) 
+				return INFINITY;
+			return sqrt(dist);
+		}		
 };	
 
 // This distance may be used with brute force searcher (where no assumptions on the metric are done).
@@ -86,6 +221,19 @@ class squared_euclidian_distance {
 			}
   			return dist;
 		}		
+
+		// contiguous coordinates : vectorized
+		double operator() (const double* first1, const double* last1, const double* first2) const 
+		{
+			return packed_sum_of_squares<false>(first1, first2, last1-first1, 0);
+		}
+		double operator() (const double* first1, const double* last1, const double* first2, const double thresh) const 
+		{
+			const double dist = packed_sum_of_squares<true>(first1, first2, last1-first1, thresh);
+			if (dist > thresh) 
+				return INFINITY;
+			return dist;
+		}		
 };	
 
 class exp_weighted_euclidian_distance {
@@ -164,6 +312,16 @@ class maximum_distance {
 			}
   			return dist;
 		}					
+
+		// contiguous coordinates : vectorized
+		double operator() (const double* first1, const double* last1, const double* first2) const 
+		{
+			return packed_max_abs_difference<false>(first1, first2, last1-first1, 0);
+		}
+		double operator() (const double* first1, const double* last1, const double* first2, const double thresh) const 
+		{
+			return packed_max_abs_difference<true>(first1, first2, last1-first1, thresh);
+		}
 };	
 
 #endif
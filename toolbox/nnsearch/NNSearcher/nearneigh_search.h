@@ -37,9 +37,12 @@
 
 #define ATRIAMINPOINTS 64
 
+#include <climits>		// LONG_MAX, unlimited budget of distance computations
+
 // header files beloning to this package
 #include "mextools/Utilities.h"
 #include "nn_aux.h"
+#include "../../../include/MappedFile.h"
 
 // base class for the nearest neihbor search which defines a common interface
 template<class POINT_SET>
@@ -49,11 +52,7 @@ class nearneigh_searcher : protected My_Utilities
 		int err;  					// error state, == 0 means OK, every other value is a failure
 	
 		const POINT_SET& points;
-#ifdef MATLAB_MEX_FILE
-		long Nused;
-#else		
-		const long Nused; 			// number of points of the data set actually used
-#endif
+		long Nused; 			// number of points of the data set actually used (set when a stored tree is loaded)
 
 #ifdef PROFILE
 		long points_searched;
@@ -147,24 +146,47 @@ class ATRIA : public nearneigh_searcher<POINT_SET>
      using nearneigh_searcher<POINT_SET>::err;
 
 	protected :	
-#ifdef MATLAB_MEX_FILE	
 		long MINPOINTS;
-#else
-		const long MINPOINTS;
-#endif	
-		cluster root;
-
-#ifdef MATLAB_MEX_FILE	
-		neighbor* permutation_table;
-#else
-		neighbor* const permutation_table;
-#endif			
+		cluster root;				// tree and permutation table while the tree is built,
+		neighbor* permutation_table;	// both are released once the flat copy is made
+		
+		vector<flat_cluster> node_storage;			// flat tree owned by the searcher
+		vector<flat_neighbor> permutation_storage;
+		MappedFile mapping;							// or flat tree mapped from a file
+		
+		const flat_cluster* nodes;				// the tree that is searched : nodes[0] is the root
+		const flat_neighbor* permutation;
 	
 		typedef typename POINT_SET::Metric METRIC;
 		typedef searchitem SearchItem;
 			
-		priority_queue<SearchItem, vector<SearchItem>, searchitemCompare> search_queue;
-		stack<SearchItem, vector<SearchItem> > SearchStack;		// used for range searches/counts 
+	public:
+		// search state of one query : the same tree may be searched from several threads at once
+		// as long as each thread uses its own query_context
+		class query_context
+		{
+			friend class ATRIA<POINT_SET>;
+			protected:
+				SortedNeighborTable table;
+				priority_queue<SearchItem, vector<SearchItem>, searchitemCompare> search_queue;
+				stack<SearchItem, vector<SearchItem> > SearchStack;		// used for range searches/counts 
+				long checks;			// distances computed by the last k nearest neighbor search
+#ifdef PROFILE
+				long points_searched;
+				long number_of_queries;
+				unsigned long terminal_cluster_searched;
+#endif
+			public:
+#ifdef PROFILE
+				query_context() : checks(0), points_searched(0), number_of_queries(0), terminal_cluster_searched(0) {};
+#else
+				query_context() : checks(0) {};
+#endif
+				inline long distances_computed() const { return checks; };
+		};
+		
+	protected:
+		query_context context;		// used by the search functions without explicit context
 
 		long total_clusters;
 		long terminal_nodes;
@@ -175,13 +197,18 @@ class ATRIA : public nearneigh_searcher<POINT_SET>
 #endif 	
 		void create_tree();
 		void destroy_tree();
+		void flatten_tree();
+		bool map_file(const char* filename);
 				
 		pair<long, long> find_child_cluster_centers(const cluster* const c, neighbor* const Section, const long c_length);				
 				
 		long assign_points_to_centers(neighbor* const Section, const long c_length, pair<cluster*, cluster*> childs);	
 					
 		template<class ForwardIterator>		
-		void search(ForwardIterator query_point, const long first, const long last, const double epsilon);	
+		void search(query_context& ctx, ForwardIterator query_point, const long first, const long last, const double epsilon, const long max_checks) const;	
+		
+		template<class ForwardIterator>
+		inline void test(query_context& ctx, const long index, ForwardIterator qp, const double thresh) const;
 		
 	public:
 		ATRIA(const POINT_SET& p, const long excl = 0, const long minpts = ATRIAMINPOINTS);
@@ -191,8 +218,10 @@ class ATRIA : public nearneigh_searcher<POINT_SET>
 		// with indices between first and last from the search
 		// returns number of nearest neighbor found and a sorted vector of neighbors (by reference)
 		// an error in search_k_neighbors() will not result in an errorstate for the searcher ( see geterr() ) 
+		// approximate queries : with epsilon > 0 clusters are pruned earlier, with max_checks > 0 the search
+		// stops after max_checks distance computations, the neighbors found so far are returned
 		template<class ForwardIterator>
-		long search_k_neighbors(vector<neighbor>& v, const long k, ForwardIterator query_point, const long first = -1, const long last = -1, const double epsilon = 0);	
+		long search_k_neighbors(vector<neighbor>& v, const long k, ForwardIterator query_point, const long first = -1, const long last = -1, const double epsilon = 0, const long max_checks = 0);	
 						
 		// count number of points within distance 'radius' from the query point ("correlation sum")
 		template<class ForwardIterator>
@@ -202,15 +231,37 @@ class ATRIA : public nearneigh_searcher<POINT_SET>
 		// an unsorted vector v of neigbors is returned
 		template<class ForwardIterator>
 		long search_range(vector<neighbor>& v, const double radius, ForwardIterator query_point, const long first = -1, const long last = -1);
+
+		// the same searches with the search state held by ctx instead of the searcher : several
+		// threads may search concurrently, each one with its own query_context 
+		// (PROFILE counters are then kept in the contexts, see collect_profile)
+		template<class ForwardIterator>
+		long search_k_neighbors(query_context& ctx, vector<neighbor>& v, const long k, ForwardIterator query_point, const long first = -1, const long last = -1, const double epsilon = 0, const long max_checks = 0) const;	
+		template<class ForwardIterator>
+		long count_range(query_context& ctx, const double radius, ForwardIterator query_point, const long first = -1, const long last = -1) const;
+		template<class ForwardIterator>
+		long search_range(query_context& ctx, vector<neighbor>& v, const double radius, ForwardIterator query_point, const long first = -1, const long last = -1) const;
+#ifdef PROFILE
+		// add the counters of ctx to the ones of the searcher (and reset them), call it
+		// for each context once its thread is done so that search_efficiency() covers all queries
+		void collect_profile(query_context& ctx);
+#endif
 				
-		inline double data_set_radius() const { return root.Rmax; };
+		inline double data_set_radius() const { return nodes[0].Rmax; };
 		inline long total_tree_nodes() const { return total_clusters; };
 		
+		// write the tree to a binary file that can be searched in place (see atria_file.h),
+		// metric is stored as a name ("euclidian", "maximum") for the reader
+		bool save(const char* filename, const char* metric) const;
+		// memory-map a tree written by save(), for the same point set p
+		ATRIA(const POINT_SET& p, const char* filename);
+		
 #ifdef MATLAB_MEX_FILE
 		// In case we have a matlab mex-file, offer a pair of functions to
 		// store/retrieve an object of type ATRIA 
-		ATRIA(const POINT_SET& p, const mxArray* inStructArr);	// create an ATRIA object from data stored in struct array inStructArr
-		mxArray* store();		// store an ATRIA object into an MATLAB struct array
+		ATRIA(const POINT_SET& p, const mxArray* inStructArr);	// create an ATRIA object from data stored in struct array inStructArr,
+																// or from the file whose name is given by inStructArr
+		mxArray* store() const;		// store an ATRIA object into an MATLAB struct array
 #endif		
 };
 
@@ -279,7 +330,7 @@ long Brute<POINT_SET>::search_k_neighbors(vector<neighbor>& v, const long k, For
 	// FIXME : make shure table is empty 12.Okt.1998 cmerk
 	
 #ifdef PROFILE
-	number_of_queries++;
+	this->number_of_queries++;
 #endif
 
 	table.init_search(k);
@@ -295,7 +346,7 @@ long Brute<POINT_SET>::search_range(vector<neighbor>& v, const double radius, Fo
 	long count = 0;
 
 #ifdef PROFILE
-	number_of_queries++;
+	this->number_of_queries++;
 #endif
 
 	for (long j=0; j < Nused; j++)
@@ -307,7 +358,7 @@ long Brute<POINT_SET>::search_range(vector<neighbor>& v, const double radius, Fo
 				count++;	
 			}	
 #ifdef PROFILE
-			points_searched++;
+			this->points_searched++;
 #endif			
 		}
 	
@@ -320,14 +371,14 @@ long Brute<POINT_SET>::count_range(const double radius,ForwardIterator query_poi
 	long count = 0;
 
 #ifdef PROFILE
-	number_of_queries++;
+	this->number_of_queries++;
 #endif
 
 	for (register long j=0; j < Nused; j++)
 		if ((j < first) || (j > last)) {	
 			if (points.distance(j, query_point) <= radius) count++;	
 #ifdef PROFILE
-			points_searched++;
+			this->points_searched++;
 #endif			
 		}
 	
@@ -341,7 +392,7 @@ void Brute<POINT_SET>::count_range(long& count1, long& count2, const double radi
 	count2 = 0;
 	
 #ifdef PROFILE
-	number_of_queries++;
+	this->number_of_queries++;
 #endif
 
 	for (register long j=0; j < Nused; j++)
@@ -350,7 +401,7 @@ void Brute<POINT_SET>::count_range(long& count1, long& count2, const double radi
 			if (d <= radius1) count1++;
 			if (d <= radius2) count2++;	
 #ifdef PROFILE
-			points_searched++;
+			this->points_searched++;
 #endif			
 		}
 }
@@ -358,7 +409,7 @@ void Brute<POINT_SET>::count_range(long& count1, long& count2, const double radi
 template<class POINT_SET>
 ATRIA<POINT_SET>::ATRIA(const POINT_SET& p, const long excl, const long minpts) 
 	:	nearneigh_searcher<POINT_SET>(p, excl), root(1,Nused-1), MINPOINTS(minpts), 
-		permutation_table(new neighbor[Nused]), total_clusters(1),
+		permutation_table(new neighbor[Nused]), nodes(0), permutation(0), total_clusters(1),
 		total_points_in_terminal_node(0), terminal_nodes(0)
 {
 #ifdef VERBOSE
@@ -383,6 +434,7 @@ ATRIA<POINT_SET>::ATRIA(const POINT_SET& p, const long excl, const long minpts)
 	}
 				
 	create_tree();
+	flatten_tree();
 		
 #ifdef VERBOSE
 	cout << "Created tree structure for ATRIA searcher" << endl;
@@ -400,7 +452,7 @@ ATRIA<POINT_SET>::~ATRIA()
 	cout << "Total_clusters : " << total_clusters << endl;
 	cout << "Total number of points in terminal nodes : " << total_points_in_terminal_node << endl;
 	cout << "Average number of points in a terminal node : " << ((double)total_points_in_terminal_node)/terminal_nodes << endl;
-	cout << "Average number of terminal nodes visited : " << ((double)terminal_cluster_searched)/number_of_queries << endl;
+	cout << "Average number of terminal nodes visited : " << ((double)terminal_cluster_searched)/this->number_of_queries << endl;
 #endif	
 
 	destroy_tree();
@@ -579,7 +631,7 @@ void ATRIA<POINT_SET>::create_tree()
 
 	// select random center for root cluster, move this to first position of the indices array
 	
-	root.center = randindex(Nused);
+	root.center = this->randindex(Nused);
 	permutation_table[0] = neighbor(root.center, 0);
 
 #ifdef VERBOSE
@@ -680,51 +732,146 @@ void ATRIA<POINT_SET>::destroy_tree()
 			delete c;
 		}
 	}
+	
+	root.Rmax = 0;		// the children are gone, root is left as an empty terminal node
+	root.start = 0;
+	root.length = 0;
 }
 
+// copy the tree built by create_tree() into node_storage and permutation_storage, in preorder,
+// then release the tree
+template<class POINT_SET>
+void ATRIA<POINT_SET>::flatten_tree()
+{
+	if (err) return;
+	
+	node_storage.resize(total_clusters);
+	
+	stack<pair<const cluster*, long>, vector<pair<const cluster*, long> > > Stack;	// cluster and its position in node_storage
+	long next_free = 1;
+	
+	Stack.push(pair<const cluster*, long>(&root, 0));
+	
+	while (!Stack.empty()) {
+		const pair<const cluster*, long> x = Stack.top(); Stack.pop();
+		const cluster* const c = x.first;
+		flat_cluster& f = node_storage[x.second];
+		
+		f.center = c->center;
+		f.Rmax = c->Rmax;
+		f.g_min = c->g_min;
+		f.reserved = 0;
+		
+		if (c->is_terminal()) {
+			f.start = c->start;
+			f.length = c->length;
+		} else {
+			f.left = next_free++;
+			f.right = next_free++;
+			Stack.push(pair<const cluster*, long>(c->right, f.right));
+			Stack.push(pair<const cluster*, long>(c->left, f.left));
+		}
+	}
+	
+	permutation_storage.assign(permutation_table, permutation_table + Nused);
+	
+	nodes = &node_storage[0];
+	permutation = &permutation_storage[0];
+	
+	destroy_tree();
+	delete[] permutation_table;
+	permutation_table = 0;
+}
 
+
+// test point number #index of points, as nearneigh_searcher::test, in the table of ctx
 template<class POINT_SET> 
 template<class ForwardIterator>
-long ATRIA<POINT_SET>::search_k_neighbors(vector<neighbor>& v, const long k, ForwardIterator query_point, const long first, const long last, const double epsilon) 
+inline void ATRIA<POINT_SET>::test(query_context& ctx, const long index, ForwardIterator qp, const double thresh) const
 {
+#ifdef PARTIAL_SEARCH		
+	const double d = points.distance(index, qp, thresh);
+#else
+	const double d = points.distance(index, qp);
+#endif			
+	if (d < thresh) 
+		ctx.table.insert(neighbor(index,d));
+	ctx.checks++;
 #ifdef PROFILE
-	number_of_queries++;
+	ctx.points_searched++;
 #endif
+}
 
-	table.init_search(k);
+#ifdef PROFILE
+template<class POINT_SET>
+void ATRIA<POINT_SET>::collect_profile(query_context& ctx)
+{
+	this->points_searched += ctx.points_searched;
+	this->number_of_queries += ctx.number_of_queries;
+	terminal_cluster_searched += ctx.terminal_cluster_searched;
+	ctx.points_searched = 0;
+	ctx.number_of_queries = 0;
+	ctx.terminal_cluster_searched = 0;
+}
+#endif
 
-	search(query_point, first, last, epsilon);
+template<class POINT_SET> 
+template<class ForwardIterator>
+long ATRIA<POINT_SET>::search_k_neighbors(vector<neighbor>& v, const long k, ForwardIterator query_point, const long first, const long last, const double epsilon, const long max_checks) 
+{
+	const long count = search_k_neighbors(context, v, k, query_point, first, last, epsilon, max_checks);
+#ifdef PROFILE
+	collect_profile(context);
+#endif
+	return count;
+}
+
+template<class POINT_SET> 
+template<class ForwardIterator>
+long ATRIA<POINT_SET>::search_k_neighbors(query_context& ctx, vector<neighbor>& v, const long k, ForwardIterator query_point, const long first, const long last, const double epsilon, const long max_checks) const
+{
+#ifdef PROFILE
+	ctx.number_of_queries++;
+#endif
+
+	ctx.table.init_search(k);
+
+	search(ctx, query_point, first, last, epsilon, max_checks);
 	
-	return table.finish_search(v);	// append table items to v, v should be empty, afterwards table is empty
+	return ctx.table.finish_search(v);	// append table items to v, v should be empty, afterwards table is empty
 }
 
 template<class POINT_SET>
 template<class ForwardIterator>
-void ATRIA<POINT_SET>::search(ForwardIterator query_point, const long first, const long last, const double epsilon) 
+void ATRIA<POINT_SET>::search(query_context& ctx, ForwardIterator query_point, const long first, const long last, const double epsilon, const long max_checks) const
 {
+	SortedNeighborTable& table = ctx.table;
+	priority_queue<SearchItem, vector<SearchItem>, searchitemCompare>& search_queue = ctx.search_queue;
 #ifdef PROFILE
-	points_searched++;
+	ctx.points_searched++;
 #endif	
-	const double root_dist = points.distance(root.center, query_point);
-	
+	const double root_dist = points.distance(nodes[0].center, query_point);
+	ctx.checks = 1;
+	const long budget = (max_checks > 0) ? max_checks : LONG_MAX;	// the clusters are searched best first, so a
+																	// budget of distance computations gives approximate queries
 	while(!search_queue.empty()) search_queue.pop();	// clear search queue
 				
 	// push root cluster as search item into the PR-QUEUE
-	search_queue.push(SearchItem(&root, root_dist));
+	search_queue.push(SearchItem(nodes, root_dist));
 	
-	while(!search_queue.empty()) 
+	while(!search_queue.empty() && (ctx.checks < budget)) 
 	{	
 		const SearchItem si = search_queue.top(); search_queue.pop();
-		const cluster* const c = si.clusterp();
+		const flat_cluster* const c = si.clusterp();
 
 		if ((table.highdist() > si.dist()) && ((c->center < first) || (c->center > last)))
 			table.insert(neighbor(c->center, si.dist()));
 
 		if (table.highdist() >= si.d_min() * (1.0 + epsilon)) {	// approximative (epsilon > 0) queries are supported			
 			if (c->is_terminal())  {	
-				const neighbor* const Section = permutation_table + c->start;				
+				const flat_neighbor* const Section = permutation + c->start;				
 #ifdef PROFILE
-				terminal_cluster_searched++;
+				ctx.terminal_cluster_searched++;
 #endif
 
 				if (c->Rmax == 0.0) {
@@ -738,25 +885,28 @@ void ATRIA<POINT_SET>::search(ForwardIterator query_point, const long first, con
 							table.insert(neighbor(j,si.dist()));
 					}	
 				} else {
-					for (long i=0; i < c->length; i++) { 
+					for (long i=0; (i < c->length) && (ctx.checks < budget); i++) { 
 						const long j = Section[i].index();		
 
 						if ((j < first) || (j > last)) {
 							if (table.highdist() > fabs(si.dist() - Section[i].dist()))
-								test(j, query_point, table.highdist());	
+								test(ctx, j, query_point, table.highdist());	
 						}				
 					}
 				}
 			}
 			else {				// this is an internal node
-				const double dl = points.distance(c->left->center, query_point);
-				const double dr = points.distance(c->right->center, query_point);
+				const flat_cluster* const left = nodes + c->left;
+				const flat_cluster* const right = nodes + c->right;
+				const double dl = points.distance(left->center, query_point);
+				const double dr = points.distance(right->center, query_point);
+				ctx.checks += 2;
 #ifdef PROFILE
-				points_searched += 2;
+				ctx.points_searched += 2;
 #endif		
 				// create child cluster search items
-				SearchItem si_left = SearchItem(c->left, dl, dr, si);	
-				SearchItem si_right = SearchItem(c->right, dr, dl, si);  
+				SearchItem si_left = SearchItem(left, dl, dr, si);	
+				SearchItem si_right = SearchItem(right, dr, dl, si);  
 
 				// priority based search				
 				search_queue.push(si_right);		
@@ -769,16 +919,27 @@ void ATRIA<POINT_SET>::search(ForwardIterator query_point, const long first, con
 template<class POINT_SET> template<class ForwardIterator>
 long ATRIA<POINT_SET>::search_range(vector<neighbor>& v, const double radius, ForwardIterator query_point, const long first, const long last) 
 {
+	const long count = search_range(context, v, radius, query_point, first, last);
+#ifdef PROFILE
+	collect_profile(context);
+#endif
+	return count;
+}
+
+template<class POINT_SET> template<class ForwardIterator>
+long ATRIA<POINT_SET>::search_range(query_context& ctx, vector<neighbor>& v, const double radius, ForwardIterator query_point, const long first, const long last) const
+{
+	stack<SearchItem, vector<SearchItem> >& SearchStack = ctx.SearchStack;
 	long count = 0;
 
 #ifdef PROFILE
-	number_of_queries++;
-	points_searched++;
+	ctx.number_of_queries++;
+	ctx.points_searched++;
 #endif
 
 	while (!SearchStack.empty()) SearchStack.pop();	// make shure stack is empty
 
-	SearchStack.push(SearchItem(&root, points.distance(root.center, query_point)));
+	SearchStack.push(SearchItem(nodes, points.distance(nodes[0].center, query_point)));
 
 	while (!SearchStack.empty()) 
 	{
@@ -786,7 +947,7 @@ long ATRIA<POINT_SET>::search_range(vector<neighbor>& v, const double radius, Fo
 		SearchStack.pop();
 		
 		if (radius >= si.d_min()) {		
-			const cluster* const c = si.clusterp();
+			const flat_cluster* const c = si.clusterp();
 		
 			if (((c->center < first) || (c->center > last)) && (si.dist() <= radius)) {
 				v.push_back(neighbor(c->center, si.dist()));
@@ -794,7 +955,7 @@ long ATRIA<POINT_SET>::search_range(vector<neighbor>& v, const double radius, Fo
 			}
 			
 			if (c->is_terminal())  {	// this is a terminal node
-				const neighbor* const Section = permutation_table + c->start;
+				const flat_neighbor* const Section = permutation + c->start;
 				
 				if (c->Rmax == 0.0) {		// cluster has zero radius, so all points inside will have the same distance to q
 					if (radius >= si.dist()) {					
@@ -822,23 +983,25 @@ long ATRIA<POINT_SET>::search_range(vector<neighbor>& v, const double radius, Fo
 								count++;
 							}
 #ifdef PROFILE
-							points_searched++;
+							ctx.points_searched++;
 #endif					
 						}
 					}
 				}
 #ifdef PROFILE
-					terminal_cluster_searched++;
+					ctx.terminal_cluster_searched++;
 #endif				
 			}
 			else {				// this is an internal node
-				const double dl = points.distance(c->left->center, query_point);
-				const double dr = points.distance(c->right->center, query_point);			
+				const flat_cluster* const left = nodes + c->left;
+				const flat_cluster* const right = nodes + c->right;
+				const double dl = points.distance(left->center, query_point);
+				const double dr = points.distance(right->center, query_point);			
 #ifdef PROFILE
-				points_searched += 2;
+				ctx.points_searched += 2;
 #endif
-				const SearchItem x = SearchItem(c->left, dl, dr, si);
-				const SearchItem y = SearchItem(c->right, dr, dl, si);			
+				const SearchItem x = SearchItem(left, dl, dr, si);
+				const SearchItem y = SearchItem(right, dr, dl, si);			
 			
 				SearchStack.push(x);
 				SearchStack.push(y);				
@@ -852,16 +1015,27 @@ long ATRIA<POINT_SET>::search_range(vector<neighbor>& v, const double radius, Fo
 template<class POINT_SET> template<class ForwardIterator>
 long ATRIA<POINT_SET>::count_range(const double radius, ForwardIterator query_point, const long first, const long last) 
 {
+	const long count = count_range(context, radius, query_point, first, last);
+#ifdef PROFILE
+	collect_profile(context);
+#endif
+	return count;
+}
+
+template<class POINT_SET> template<class ForwardIterator>
+long ATRIA<POINT_SET>::count_range(query_context& ctx, const double radius, ForwardIterator query_point, const long first, const long last) const
+{
+	stack<SearchItem, vector<SearchItem> >& SearchStack = ctx.SearchStack;
 	long count = 0;
 
 #ifdef PROFILE
-	number_of_queries++;
-	points_searched++;
+	ctx.number_of_queries++;
+	ctx.points_searched++;
 #endif
 
 	while (!SearchStack.empty()) SearchStack.pop();	// make shure stack is empty
 
-	SearchStack.push(SearchItem(&root, points.distance(root.center, query_point)));
+	SearchStack.push(SearchItem(nodes, points.distance(nodes[0].center, query_point)));
 
 	while (!SearchStack.empty()) 
 	{
@@ -870,14 +1044,14 @@ long ATRIA<POINT_SET>::count_range(const double radius, ForwardIterator query_po
 		SearchStack.pop();
 		
 		if (radius >= si.d_min()) {		
-			const cluster* const c = si.clusterp();
+			const flat_cluster* const c = si.clusterp();
 
 			if (((c->center < first) || (c->center > last)) && (si.dist() <= radius)) {
 				count++;
 			}
 				
 			if (c->is_terminal())  {	// this is a terminal terminal node
-				const neighbor* const Section = permutation_table + c->start;
+				const flat_neighbor* const Section = permutation + c->start;
 
 				if (c->Rmax == 0.0) {		// cluster has zero radius, so all points inside will have the same distance to q
 					if (radius >= si.dist()) {					
@@ -903,23 +1077,25 @@ long ATRIA<POINT_SET>::count_range(const double radius, ForwardIterator query_po
 #endif		
 
 #ifdef PROFILE
-							points_searched++;
+							ctx.points_searched++;
 #endif					
 						}
 					}
 				}
 #ifdef PROFILE
-					terminal_cluster_searched++;
+					ctx.terminal_cluster_searched++;
 #endif				
 			}
 			else {				// this is an internal node
-				const double dl = points.distance(c->left->center, query_point);
-				const double dr = points.distance(c->right->center, query_point);			
+				const flat_cluster* const left = nodes + c->left;
+				const flat_cluster* const right = nodes + c->right;
+				const double dl = points.distance(left->center, query_point);
+				const double dr = points.distance(right->center, query_point);			
 #ifdef PROFILE
-				points_searched += 2;
+				ctx.points_searched += 2;
 #endif
-				const SearchItem x = SearchItem(c->left, dl, dr, si);
-				const SearchItem y = SearchItem(c->right, dr, dl, si);			
+				const SearchItem x = SearchItem(left, dl, dr, si);
+				const SearchItem y = SearchItem(right, dr, dl, si);			
 			
 				SearchStack.push(x);
 				SearchStack.push(y);				
@@ -930,6 +1106,8 @@ long ATRIA<POINT_SET>::count_range(const double radius, ForwardIterator query_po
 	return count;
 }
 
+#include "atria_file.h"
+
 #ifdef MATLAB_MEX_FILE
 #include "nn2matlab.h"
 #endif			// ifdef MATLAB_MEX_FILE
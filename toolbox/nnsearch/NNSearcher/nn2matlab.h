@@ -6,27 +6,23 @@
 //
 // This code enables to store/retrieve the preproccesing data (as object of type ATRIA)
 // to a matlab (version 5.0 - 5.x) structure variable (to avoid multiple preproccesing).
-
-class RetrieveItem	// this class is needed when retrieving the tree from an array-like structure
-{
-	public:
-		long index_of_node_needs_creation; 		// (array)index of the cluster that has to be created
-		cluster_pointer parent_needs_update;	// pointer to the parent node that needs an update
-		int left_or_right; 						// a flag which indicates if this child	is a left or right node to the parent						
-												// == 0 means : left child, == 1 means right child, == -1 means : there's no parent to update
-
-};
-
-typedef vector<RetrieveItem> RetrieveItem_vector; 
+// The preprocessing data may also be given as the name of a file written by ATRIA::save().
 
 template<class POINT_SET>
 ATRIA<POINT_SET>::ATRIA(const POINT_SET& p, const mxArray* inStructArr) // create an ATRIA object from data stored in struct array inStructArr
- : nearneigh_searcher<POINT_SET>(p, 0), root(0,Nused), MINPOINTS(0), permutation_table(0), total_clusters(1),
+ : nearneigh_searcher<POINT_SET>(p, 0), root(0,Nused), MINPOINTS(0), permutation_table(0), nodes(0), permutation(0), total_clusters(1),
  total_points_in_terminal_node(0), terminal_nodes(0)
 {	
 	long i;
 	 	
 	err = 0;
+	
+	if (mxIsChar(inStructArr)) {	// name of a file written by ATRIA::save()
+		char* filename = mxArrayToString(inStructArr);
+		err = (filename == NULL) || !map_file(filename);
+		mxFree(filename);
+		return;
+	}
 		
 	if (!mxIsStruct(inStructArr)) {
 		err = 1;
@@ -49,41 +45,41 @@ ATRIA<POINT_SET>::ATRIA(const POINT_SET& p, const mxArray* inStructArr) // creat
 	total_points_in_terminal_node = (long) tmpptr[3]; 
 	MINPOINTS = (long) tmpptr[4];
 
-	if ((Nused < 2) || ( Nused > p.size())) {
+	if ((Nused < 2) || ( Nused > p.size()) || (total_clusters < 1)) {
 		err = 1;
 		return;
 	}
 	
-	permutation_table = new neighbor[Nused];
-	if (permutation_table == 0) { 
-		cerr << "Out of memory" << endl; 
-		err = 1; 
-		return;
-	}
 	// distances
 	
-	tmparr = mxGetField(inStructArr, 0, "distances");
-	if ((tmparr == NULL) || (!mxIsDouble(tmparr)) || (mxGetM(tmparr) != Nused)) {
+	const mxArray* distances = mxGetField(inStructArr, 0, "distances");
+	if ((distances == NULL) || (!mxIsDouble(distances)) || (mxGetM(distances) != Nused)) {
 		err = 1;
 		return;
 	}
 	
-	tmpptr = mxGetPr(tmparr);
-	
-	for (i=0; i < Nused; i++) permutation_table[i].dist() = tmpptr[i];	
-
 	// indices
 	
-	tmparr = mxGetField(inStructArr, 0, "indices");
-	if ((tmparr == NULL) || (!mxIsDouble(tmparr)) || (mxGetM(tmparr) != Nused)) {
+	const mxArray* indices = mxGetField(inStructArr, 0, "indices");
+	if ((indices == NULL) || (!mxIsDouble(indices)) || (mxGetM(indices) != Nused)) {
 		err = 1;
 		return;
 	}
-	tmpptr = mxGetPr(tmparr);
 	
-	for (i=0; i < Nused; i++) permutation_table[i].index() = (long) tmpptr[i];	// warning : double to long conversion
+	const double* dist_arr = mxGetPr(distances);
+	const double* index_arr = mxGetPr(indices);
 	
-	// retrieve cluster tree
+	permutation_storage.resize(Nused);
+	for (i=0; i < Nused; i++) {
+		if ((index_arr[i] < 0) || (index_arr[i] >= p.size())) {
+			err = 1;
+			return;
+		}
+		permutation_storage[i] = flat_neighbor((long) index_arr[i], dist_arr[i]);	// warning : double to long conversion
+	}
+	
+	// retrieve cluster tree, the nodes are stored in an array with the root first and 
+	// the children given by their position in the array, which is the flat layout we search
 	
 	const mxArray* tree = mxGetField(inStructArr, 0, "tree");
 	
@@ -92,154 +88,87 @@ ATRIA<POINT_SET>::ATRIA(const POINT_SET& p, const mxArray* inStructArr) // creat
 		return;
 	}
 
-	tmparr = mxGetField(tree, 0, "center");
-	if ((tmparr == NULL) || (!mxIsDouble(tmparr)) || (mxGetM(tmparr) != total_clusters)) {
-		err = 1;
-		return;
-	}
-    double* center_arr = mxGetPr(tmparr);
-	
-	tmparr = mxGetField(tree, 0, "Rmax");
-	if ((tmparr == NULL) || (!mxIsDouble(tmparr)) || (mxGetM(tmparr) != total_clusters)) {
-		err = 1;
-		return;
-	}	
-    double* Rmax_arr = mxGetPr(tmparr);
-
-	tmparr = mxGetField(tree, 0, "start");
-	if ((tmparr == NULL) || (!mxIsDouble(tmparr)) || (mxGetM(tmparr) != total_clusters)) {
-		err = 1;
-		return;
-	}    
-	double* start_arr = mxGetPr(tmparr);
-	
-	tmparr = mxGetField(tree, 0, "length");
-	if ((tmparr == NULL) || (!mxIsDouble(tmparr)) || (mxGetM(tmparr) != total_clusters)) {
-		err = 1;
-		return;
-	}    
-    double* length_arr = mxGetPr(tmparr);
-	
-	tmparr = mxGetField(tree, 0, "leftchild");
-	if ((tmparr == NULL) || (!mxIsDouble(tmparr)) || (mxGetM(tmparr) != total_clusters)) {
-		err = 1;
-		return;
-	}    
-    double* leftchild_arr = mxGetPr(tmparr);
-	
-	tmparr = mxGetField(tree, 0, "rightchild");
-	if ((tmparr == NULL) || (!mxIsDouble(tmparr)) || (mxGetM(tmparr) != total_clusters)) {
-		err = 1;
-		return;
-	}    
-    double* rightchild_arr = mxGetPr(tmparr);
+	const char* tree_fieldnames[] = {"center", "Rmax", "g", "start", "length", "leftchild", "rightchild"};
+	const double* tree_arr[7];
 	
-	tmparr = mxGetField(tree, 0, "g");
-	if ((tmparr == NULL) || (!mxIsDouble(tmparr)) || (mxGetM(tmparr) != total_clusters)) {
-		err = 1;
-		return;
-	}    
-    double* g_arr = mxGetPr(tmparr);	
-	
-	stack<RetrieveItem, RetrieveItem_vector> s;
-	RetrieveItem y,z;
-	
-	root.center = (long) center_arr[0];
-	root.Rmax = Rmax_arr[0];
-	root.g_min = g_arr[0];
-	
-	if (root.is_terminal()) {
-		root.start = (long) start_arr[0];	
-		root.length = (long) length_arr[0];
-	} else {
-		y.index_of_node_needs_creation = (long) leftchild_arr[0];
-		y.parent_needs_update = &root;
-		y.left_or_right = 0;
-		
-		z.index_of_node_needs_creation = (long) rightchild_arr[0];
-		z.parent_needs_update = &root;
-		z.left_or_right = 1;
-		
-		s.push(y);
-		s.push(z);
-	}	
-	
-	while (!s.empty()) 
-	{
-		const RetrieveItem x = s.top(); s.pop();
-		const cluster_pointer c = new cluster();
-		
-		if ((x.index_of_node_needs_creation < 0) || (x.index_of_node_needs_creation >= total_clusters)) {
+	for (i=0; i < 7; i++) {
+		tmparr = mxGetField(tree, 0, tree_fieldnames[i]);
+		if ((tmparr == NULL) || (!mxIsDouble(tmparr)) || (mxGetM(tmparr) != total_clusters)) {
 			err = 1;
 			return;
 		}
+		tree_arr[i] = mxGetPr(tmparr);
+	}
+	
+	const double* center_arr = tree_arr[0];
+	const double* Rmax_arr = tree_arr[1];
+	const double* g_arr = tree_arr[2];
+	const double* start_arr = tree_arr[3];
+	const double* length_arr = tree_arr[4];
+	const double* leftchild_arr = tree_arr[5];
+	const double* rightchild_arr = tree_arr[6];
+	
+	node_storage.resize(total_clusters);
+	
+	for (i=0; i < total_clusters; i++) {
+		flat_cluster& c = node_storage[i];
 		
-		c->center = (long) center_arr[x.index_of_node_needs_creation];
+		c.center = (long) center_arr[i];
+		c.Rmax = Rmax_arr[i];
+		c.g_min = g_arr[i];
+		c.reserved = 0;
 		
-		if ((c->center < 0) || (c->center >= Nused)) {
+		if ((c.center < 0) || (c.center >= Nused)) {
 			err = 1;
 			return;
 		}
 		
-		c->Rmax = Rmax_arr[x.index_of_node_needs_creation];
-		c->g_min = g_arr[x.index_of_node_needs_creation];
-		
-		if (c->is_terminal()) {
-			c->start = (long) start_arr[x.index_of_node_needs_creation];
-			if ((c->start < 0) || (c->start >= Nused)) {
+		if (c.is_terminal()) {
+			c.start = (long) start_arr[i];
+			c.length = (long) length_arr[i];
+			if ((c.start < 0) || (c.length < 0) || (c.start + c.length > Nused)) {
 				err = 1;
 				return;
 			}
-			
-			c->length = (long) length_arr[x.index_of_node_needs_creation];
-			if ((c->length < 0) || (c->length >= Nused)) {
+		} else {
+			// children are stored after their parent, which also rules out cycles
+			c.left = (long) leftchild_arr[i];
+			c.right = (long) rightchild_arr[i];
+			if ((c.left <= i) || (c.left >= total_clusters) || (c.right <= i) || (c.right >= total_clusters)) {
 				err = 1;
 				return;
 			}
-		} else {
-			y.index_of_node_needs_creation = (long) leftchild_arr[x.index_of_node_needs_creation];
-			y.parent_needs_update = c;
-			y.left_or_right = 0;
-
-			z.index_of_node_needs_creation = (long) rightchild_arr[x.index_of_node_needs_creation];
-			z.parent_needs_update = c;
-			z.left_or_right = 1;
-
-			s.push(y);
-			s.push(z);
-		}	
-		
-		switch(x.left_or_right) {
-			case 0 :
-				x.parent_needs_update->left = c;
-				break;
-			case 1 :
-				x.parent_needs_update->right = c;
-				break;
-			default :
-				; 
-				break;
 		}
 	}
+	
+	nodes = &node_storage[0];
+	permutation = &permutation_storage[0];
 }
 
-class StoreItem	// this class is needed when storing tree into an array-like structure
+// name of the metric the preprocessing data atria (struct array or file name) was created with,
+// 0 if none is given. The string is to be freed by mxFree
+inline char* atria_metric(const mxArray* atria)
 {
-	public:
-		cluster_pointer child_to_store;		// a pointer to a cluster that still needs to be stored in the array
-		
-		unsigned long parent_index; 		// index (0,1,2...) of the parent cluster that is already stored, but needs
-											// an update because the array-index at which this child is stored
-											// in the array was not known at the time the parent was stored
-		
-		int left_or_right; 					// a flag which indicates if this child	is a left or right node to the parent						
-											// == 0 means : left child, == 1 means right child, == -1 means : there's no parent to update
-};
-		
-typedef vector<StoreItem> StoreItem_vector; 	// needed for SUN CC 4.1
+	if (mxIsChar(atria)) {
+		char* filename = mxArrayToString(atria);
+		atria_file_header header;
+		const bool ok = (filename != NULL) && read_atria_file_header(filename, header);
+		mxFree(filename);
+		if (!ok) 
+			return 0;
+		char* metric = (char*) mxMalloc(strlen(header.metric) + 1);
+		strcpy(metric, header.metric);
+		return metric;
+	}
+	
+	const mxArray* optional = mxIsStruct(atria) ? mxGetField(atria, 0, "optional") : NULL;
+	if ((optional == NULL) || !mxIsChar(optional)) 
+		return 0;
+	return mxArrayToString(optional);
+}
 
 template<class POINT_SET>
-mxArray* ATRIA<POINT_SET>::store()	// store an ATRIA object into an MATLAB struct array
+mxArray* ATRIA<POINT_SET>::store() const	// store an ATRIA object into an MATLAB struct array
 {
 	long i;
 	
@@ -280,7 +209,7 @@ mxArray* ATRIA<POINT_SET>::store()	// store an ATRIA object into an MATLAB struc
 	tmparr = mxCreateDoubleMatrix(Nused, 1, mxREAL);
 	tmpptr = (double *) mxGetPr(tmparr);
 	
-	for (i=0; i < Nused; i++) tmpptr[i] = permutation_table[i].dist();	
+	for (i=0; i < Nused; i++) tmpptr[i] = permutation[i].dist();	
 	
 	mxSetField(output, 0, "distances", tmparr);
 	
@@ -289,7 +218,7 @@ mxArray* ATRIA<POINT_SET>::store()	// store an ATRIA object into an MATLAB struc
 	tmparr = mxCreateDoubleMatrix(Nused, 1, mxREAL);
 	tmpptr = (double *) mxGetPr(tmparr);
 	
-	for (i=0; i < Nused; i++) tmpptr[i] = permutation_table[i].index();	// warning : long to double conversion
+	for (i=0; i < Nused; i++) tmpptr[i] = permutation[i].index();	// warning : long to double conversion
 	
 	mxSetField(output, 0, "indices", tmparr);
 	
@@ -327,65 +256,25 @@ mxArray* ATRIA<POINT_SET>::store()	// store an ATRIA object into an MATLAB struc
 	double* g_arr = mxGetPr(tmparr);
 	mxSetField(tree, 0, "g", tmparr);
 
-	stack<StoreItem, StoreItem_vector> s;
-	StoreItem x;
-	long next_free = 0;
-	
-	x.child_to_store = &root;
-	x.parent_index = 0;
-	x.left_or_right = -1;
-	
-	s.push(x);
-	
-	while (!s.empty()) 
-	{
-		x = s.top(); s.pop();
+	for (i=0; i < total_clusters; i++) {
+		const flat_cluster& c = nodes[i];
 		
-		center_arr[next_free] = x.child_to_store->center;
-		Rmax_arr[next_free] = x.child_to_store->Rmax;
-		g_arr[next_free] = x.child_to_store->g_min;
+		center_arr[i] = c.center;
+		Rmax_arr[i] = c.Rmax;
+		g_arr[i] = c.g_min;
 		
-		leftchild_arr[next_free] = -1;
-		rightchild_arr[next_free] = -1;
-		start_arr[next_free] = -1;
-		length_arr[next_free] = -1;
+		leftchild_arr[i] = -1;
+		rightchild_arr[i] = -1;
+		start_arr[i] = -1;
+		length_arr[i] = -1;
 		
-		if (x.child_to_store->is_terminal()) {
-			start_arr[next_free] = x.child_to_store->start;
-			length_arr[next_free] = x.child_to_store->length;
+		if (c.is_terminal()) {
+			start_arr[i] = c.start;
+			length_arr[i] = c.length;
 		} else {
-			StoreItem y,z;
-			
-			y.child_to_store = x.child_to_store->left;
-			y.parent_index = next_free;
-			y.left_or_right = 0;
-			
-			z.child_to_store = x.child_to_store->right;
-			z.parent_index = next_free;
-			z.left_or_right = 1;
-			
-			s.push(y);
-			s.push(z);
-		}
-		
-		switch(x.left_or_right) {
-			case 0 :
-				leftchild_arr[x.parent_index] = next_free;
-				break;
-			case 1 :
-				rightchild_arr[x.parent_index] = next_free;
-				break;
-			default :
-				; 
-				break;
+			leftchild_arr[i] = c.left;
+			rightchild_arr[i] = c.right;
 		}
-	
-		next_free++;
-	}
-	
-	if (next_free != total_clusters) {
-		mexErrMsgTxt("Error storing ATRIA object, number of tree nodes does not match expected value");
-		return output;
 	}
 	
 	return output;
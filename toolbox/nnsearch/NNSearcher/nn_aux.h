@@ -106,12 +106,50 @@ class cluster
 #endif		
 };
 
+// The search runs on a flat copy of the tree : an array of flat_cluster, root first, where children are
+// referred to by their position in the array instead of pointers, and an array of flat_neighbor for the
+// permutation table. Both have a fixed layout (32 and 16 bytes) so that they can be written to a file
+// and searched in place once memory-mapped (see atria_file.h)
+class flat_cluster
+{
+	public:
+		double Rmax;		// as in cluster, Rmax <= 0 marks a terminal node
+		double g_min;
+		int center;			// index of center point for this cluster
+		union {
+			int left;		// used in case of a non-terminal node (position in the array)
+			int start;		// used in case of a terminal node
+		};
+		union {
+			int right;		// used in case of a non-terminal node (position in the array)
+			int length;		// used in case of a terminal node
+		};
+		int reserved;		// padding, 0
+		
+		inline int is_terminal() const { return (Rmax <= 0); }; 
+		inline double R_max() const { return fabs(Rmax); };
+};
+
+class flat_neighbor
+{
+	protected:
+		double d;	  // distance of point to the center of its cluster
+		int i; 	  	  // index of point
+		int reserved; // padding, 0
+	public:
+		flat_neighbor() {};
+		flat_neighbor(const neighbor& x) : d(x.dist()), i(x.index()), reserved(0) {};
+		flat_neighbor(const long I, const double D) : d(D), i(I), reserved(0) {};
+		inline long index() const { return i; };
+		inline double dist() const { return d; };
+};
+
 // During k-nearest neighbor search, clusters are treated as searchitems
 // These searchitems are inserted into a priority queue
 class searchitem
 {
 	protected:	
-		const cluster* c; 	// pointer to cluster object
+		const flat_cluster* c; 	// pointer to cluster object
 		double d;			// distance from query point to the cluster's center
 		double dbrother;	// distance from query point to brother cluster's center
 		
@@ -120,15 +158,15 @@ class searchitem
 	public:
 		searchitem() {};
 			
-		inline searchitem(const cluster* C, const double D) 	
+		inline searchitem(const flat_cluster* C, const double D) 	
 		: c(C), d(D), dbrother(INFINITY), dmin(D - C->R_max()), dmax(D+C->R_max()) {};	
 			
-		inline searchitem(const cluster* C, const double D, const double Dbrother, const searchitem& parent)
+		inline searchitem(const flat_cluster* C, const double D, const double Dbrother, const searchitem& parent)
 		 :  c(C), d(D), dbrother(Dbrother),	 
 		 	dmin(std::max(std::max(0.0, 0.5*(D-Dbrother+c->g_min)), std::max(D - C->R_max(), parent.dmin))),
 			dmax(std::min(parent.dmax, D + C->R_max())) {}; 	
 	
-		inline const cluster* clusterp() const { return c; };
+		inline const flat_cluster* clusterp() const { return c; };
 		inline double dist() const { return d; };	
 		inline double dist_brother() const { return dbrother; };	
 		
@@ -112,6 +112,111 @@ class point_set : public point_set_base<METRIC> {			// this implementation is fo
 		}
 };
 
+// Same interface as point_set, but the points are copied once into a row major buffer, so the
+// coordinates of one point are contiguous and the distances use the vectorized kernels of "metric.h".
+// For D >= 4 each row starts on a 32 byte boundary (stride rounded up to a multiple of 4 doubles, zero
+// padded), smaller points are stored unpadded (stride D).
+// Costs N*D doubles of memory and one pass over the data set, pays off as soon as a few distances
+// per point are computed (see worth_packing)
+template <class METRIC>
+class packed_point_set : public point_set_base<METRIC> {
+     using point_set_base<METRIC>::N;
+	protected:
+		const long D;		// dimension
+		const long stride;	// distance in doubles between two consecutive points
+		
+		void* raw_ptr;		// as returned by malloc
+		double* matrix_ptr; 	// points are stored as aligned row vectors
+		const METRIC Distance;		// a function object that calculates distances
+		
+		void pack(const double* mat)
+		{
+			raw_ptr = malloc((N*stride + 4) * sizeof(double));
+			if (raw_ptr == 0) {
+				matrix_ptr = 0;
+				return;
+			}
+			matrix_ptr = (double*) (((size_t) raw_ptr + 31) & ~((size_t) 31));
+			for (long n=0; n < N; n++) {
+				double* const row = matrix_ptr + n*stride;
+				for (long d=0; d < D; d++) row[d] = mat[n + N*d];		// mat is a N by D fortran style matrix
+				for (long d=D; d < stride; d++) row[d] = 0;
+			}
+		}
+		
+	private:
+		packed_point_set(const packed_point_set&);			// not copyable, owns its buffer
+		packed_point_set& operator=(const packed_point_set&);
+		
+	public:
+		packed_point_set(const long n, const long d, const double* mat) : point_set_base<METRIC>(n), D(d), 
+			stride((d >= 4) ? ((d+3) & ~3L) : d), Distance() { pack(mat); };
+		packed_point_set(const long n, const long d, const double* mat, const METRIC& metr) : point_set_base<METRIC>(n), D(d), 
+			stride((d >= 4) ? ((d+3) & ~3L) : d), Distance(metr) { pack(mat); };
+		
+		~packed_point_set() { free(raw_ptr); };
+		inline long dimension() const { return D; }; 
+		inline bool geterr() const { return (matrix_ptr == 0); };	// true if the copy could not be allocated
+		
+		typedef const double* row_iterator; // pointer that iterates over the elements of one point in the packed_point_set
+		
+		row_iterator point_begin(const long n) const { return matrix_ptr + n*stride; }
+		row_iterator point_end(const long n) const { return matrix_ptr + n*stride + D; }	// past-the-end	
+
+		double coordinate(const long n, const long d) const { return matrix_ptr[n*stride + d]; };
+
+		template<class ForwardIterator>
+		inline double distance(const long index1, ForwardIterator vec2) const
+		{
+			return Distance(point_begin(index1), point_end(index1), vec2); 
+		}
+		// contiguous query vectors use the vectorized distances
+		inline double distance(const long index1, const double* vec2) const
+		{
+			return Distance(point_begin(index1), point_end(index1), vec2); 
+		}
+		inline double distance(const long index1, double* vec2) const
+		{
+			return Distance(point_begin(index1), point_end(index1), (const double*) vec2); 
+		}
+
+#ifdef PARTIAL_SEARCH
+		template<class ForwardIterator>
+		inline double distance(const long index1, ForwardIterator vec2, const double thresh) const
+		{
+			return Distance(point_begin(index1), point_end(index1), vec2, thresh); 
+		}
+		inline double distance(const long index1, const double* vec2, const double thresh) const
+		{
+			return Distance(point_begin(index1), point_end(index1), vec2, thresh); 
+		}
+		inline double distance(const long index1, double* vec2, const double thresh) const
+		{
+			return Distance(point_begin(index1), point_end(index1), (const double*) vec2, thresh); 
+		}
+#endif
+
+		inline double distance(const long index1, const long index2) const
+		{		
+			return Distance(point_begin(index1), point_end(index1), point_begin(index2)); 
+		}
+			
+		template<class ForwardIterator>
+		inline void add(ForwardIterator vec, const long index) const
+		{
+			const double* const row = point_begin(index);
+			for (register long d=0; d < D; d++) vec[d] += row[d];
+		}
+};
+
+// Decides between packed_point_set and point_set (the matrix searched in place) for nqueries queries
+// on N points : every query computes some tens of distances at least, so the copy is only repaid when
+// there are more than about N/32 queries. Fewer queries cost nothing up front, whatever N
+inline bool worth_packing(const long nqueries, const long N)
+{
+	return 32*nqueries >= N;
+}
+
 // The next class is a models a set of points which is given by the (time-delay) embedding of a
 // scalar time series. The time delay vectors are created "on the fly", they are not stored
 // in memory. This slow down things a little bit, but keeps memory consumption really low.
@@ -1,2 +1,8 @@
+if ispc
+    omp = {'COMPFLAGS="$COMPFLAGS /openmp"'};
+else
+    omp = {'CXXFLAGS="$CXXFLAGS -fopenmp"', 'LDFLAGS="$LDFLAGS -fopenmp"'};
+end
 mex nn_prepare.cpp
-mex nn_search.cpp
\ No newline at end of file
+mex('-largeArrayDims', omp{:}, 'nn_search.cpp')
+mex('-largeArrayDims', omp{:}, 'range_search.cpp')
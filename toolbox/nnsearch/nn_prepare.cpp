@@ -4,6 +4,12 @@
 // time-consuming preprocessing again (of course only when the input data set
 // has not changed)
 
+#include <cstring>
+// the SIMD intrinsics headers of the metrics and the file mapping include C library headers,
+// so like the STL they come before mextools.h
+#include <cstdio>
+#include "NNSearcher/metric.h"
+#include "../../include/MappedFile.h"
 #include "mex.h"
 #include "mextools/mextools.h"
 
@@ -11,20 +17,31 @@
 #include "NNSearcher/point_set.h"
 #include "include.mex"
 
+// returns the preprocessing data as a struct array, or, when a file name is given, writes them
+// to this file (searched in place by nn_search) and returns the file name
 template<class Searcher>
-mxArray* nn_prepare(Searcher& searcher)
+mxArray* nn_prepare(Searcher& searcher, const char* metric, const char* filename)
 {
 	if (searcher.geterr()) {
 		mexErrMsgTxt("Error preparing searcher");
 	}	 
 
-	return searcher.store();
+	if (filename) {
+		if (!searcher.save(filename, metric)) 
+			mexErrMsgTxt("Could not write the preprocessing data to the file");
+		return mxCreateString(filename);
+	}
+	
+	mxArray* atria = searcher.store();
+	mxSetField(atria, 0, "optional", mxCreateString(metric));
+	return atria;
 }	
 
 void mexFunction(int nlhs, mxArray  *plhs[], int nrhs, const mxArray  *prhs[])
 {		
 	long minpoints = 64;
 	char* metric = 0;
+	char* filename = 0;
 	
 	/* check input args */
 	if (nrhs < 1)
@@ -50,11 +67,14 @@ void mexFunction(int nlhs, mxArray  *plhs[], int nrhs, const mxArray  *prhs[])
 	}	
 	
 	for (long i=1; i<nrhs; i++) {
-		if (mxIsChar(prhs[i])) {
+		if (mxIsChar(prhs[i]) && (metric == 0)) {
     		long buflen = (mxGetM(prhs[i]) * mxGetN(prhs[i])) + 1;
  			metric = (char*) mxMalloc(buflen);
         	mxGetString(prhs[i], metric, buflen); 
 		}
+		else if (mxIsChar(prhs[i])) {		// second string : file name
+			filename = mxArrayToString(prhs[i]);
+		}
 		else if (mxIsDouble(prhs[i])) {
 			minpoints = (long) *((double *)mxGetPr(prhs[i]));
 		}
@@ -66,21 +86,22 @@ void mexFunction(int nlhs, mxArray  *plhs[], int nrhs, const mxArray  *prhs[])
 	}
 	
 	if ((metric == 0) || (!strncmp("euclidian", metric, strlen(metric)))) {
-		point_set<euclidian_distance> points(N,dim, p);	
-		ATRIA<point_set<euclidian_distance> > searcher(points, 0, minpoints);	
-		plhs[0] = nn_prepare(searcher);
-		mxSetField(plhs[0], 0, "optional", mxCreateString("euclidian"));
+		packed_point_set<euclidian_distance> points(N,dim, p);
+		if (points.geterr()) mexErrMsgTxt("Not enough memory for the copy of the data set");	
+		ATRIA<packed_point_set<euclidian_distance> > searcher(points, 0, minpoints);	
+		plhs[0] = nn_prepare(searcher, "euclidian", filename);
 	}
 	else if (!strncmp("maximum", metric, strlen(metric))){
-		point_set<maximum_distance> points(N,dim, p);	
-		ATRIA<point_set<maximum_distance> > searcher(points, 0, minpoints);	
-		plhs[0] = nn_prepare(searcher);
-		mxSetField(plhs[0], 0, "optional", mxCreateString("maximum"));
+		packed_point_set<maximum_distance> points(N,dim, p);
+		if (points.geterr()) mexErrMsgTxt("Not enough memory for the copy of the data set");	
+		ATRIA<packed_point_set<maximum_distance> > searcher(points, 0, minpoints);	
+		plhs[0] = nn_prepare(searcher, "maximum", filename);
 	}
 	else {
 		mexErrMsgTxt("Unknown type of metric");
 	}
 	
 	mxFree(metric);
+	mxFree(filename);
 }	
 
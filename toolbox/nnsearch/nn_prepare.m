@@ -17,6 +17,7 @@
 %     * atria = nn_prepare(pointset)
 %     * atria = nn_prepare(pointset, metric)
 %     * atria = nn_prepare(pointset, metric, clustersize)
+%     * atria = nn_prepare(pointset, metric, clustersize, filename)
 %
 %   Input arguments:
 %
@@ -26,6 +27,15 @@
 %       'euclidian')
 %     * clustersize - (optional) threshold for clustering algorithm,
 %       defaults to 64
+%     * filename - (optional) the preprocessing data are written to this
+%       binary file instead of being returned in a struct, and atria is
+%       the file name. nn_search and range_search memory-map the file and
+%       search it in place, so passing the file name costs nothing
+%       whatever the size of the point set. The point set itself is
+%       searched in place too, unless there are many queries (more than
+%       about N/32), which are faster on a packed copy of the point set
+%       made once per call. The file is only valid for
+%       the same pointset, on a machine with the same byte order
 %
 %   Example:
 %
@@ -9,48 +9,89 @@
 // returned
 
 #include <cmath>
+#include <cstring>
 
 // C++ Standard Template Library
 // this files have to be located before(!!!) the #ifdef MATLAB_MEX_FILE sequence,
 // otherwise the defines will break the STL
 #include <vector>
 
+// the SIMD intrinsics headers of the metrics and the file mapping include C library headers,
+// so like the STL they come before mextools.h
+#include <cstdio>
+#include "NNSearcher/metric.h"
+#include "../../include/MappedFile.h"
 #include "mextools/mextools.h"
 
 // this includes the code for the nearest neighbor searcher and the prediction routines
 #include "NNSearcher/point_set.h"
 #include "include.mex"
 
+// The reference points are searched in parallel when compiled with OpenMP,
+// each thread with its own query context on the shared ATRIA tree
 template<class Searcher>
 void nn_search(Searcher& searcher, double* const nn, double* const dists, const long R, const long N,
 				const long dim, const double* p, const double* ref, const long NNR, const long past, const double epsilon,
-				const int ref_or_direct)
+				const long max_checks, const int ref_or_direct)
 {	
 	if (searcher.geterr()) {
 		mexErrMsgTxt("Error preparing searcher, maybe wrong preprocessing data were given or the point set has changed");
 	}	 
+	const double nan = mxGetNaN();
+	const double inf = mxGetInf();
 	
-	double*	const coord = (double*) malloc(dim * sizeof(double)); 	
-	
-	for (long n=0; n < R; n++) { /* iterate over all reference points */ 
+	#pragma omp parallel
+	{
+		typename Searcher::query_context ctx;
+		vector<double> coord(dim);
 		vector<neighbor> v;
+		v.reserve(NNR);
 		
-		if (ref_or_direct) {
-                  const long actual = (long) ref[n]-1;		/* Matlab to C means indices change from 1 to 0, 2 to 1, 3 to 2 ...*/
-			for (long k=0; k < dim; k++) coord[k] = p[actual+k*N];
-			searcher.search_k_neighbors(v, NNR, coord, actual-past, actual+past, epsilon);
-		} else {
-			for (long k=0; k < dim; k++) coord[k] = ref[n+k*R];
-			searcher.search_k_neighbors(v, NNR, coord, -1, -1, epsilon);
-		}	
-		
-		for (long k = 0; k < v.size(); k++) { 	// v is the sorted vector of neighbors
+		#pragma omp for schedule(dynamic,64)
+		for (long n=0; n < R; n++) { /* iterate over all reference points */ 
+			v.clear();
+			
+			if (ref_or_direct) {
+				const long actual = (long) ref[n]-1;		/* Matlab to C means indices change from 1 to 0, 2 to 1, 3 to 2 ...*/
+				for (long k=0; k < dim; k++) coord[k] = p[actual+k*N];
+				searcher.search_k_neighbors(ctx, v, NNR, &coord[0], actual-past, actual+past, epsilon, max_checks);
+			} else {
+				for (long k=0; k < dim; k++) coord[k] = ref[n+k*R];
+				searcher.search_k_neighbors(ctx, v, NNR, &coord[0], -1, -1, epsilon, max_checks);
+			}	
+			
+			for (long k = 0; k < v.size(); k++) { 	// v is the sorted vector of neighbors
 				nn[n+k*R] = v[k].index() +1;	// convert indices back to Matlab (1..N) style 
 				dists[n+k*R] = v[k].dist();
+			}
+			for (long k = v.size(); k < NNR; k++) { 	// a small budget of distance computations may leave neighbors unfound
+				nn[n+k*R] = nan;
+				dists[n+k*R] = inf;
+			}
 		}
+#ifdef PROFILE
+		#pragma omp critical
+		searcher.collect_profile(ctx);
+#endif
 	}
-	
-	free(coord);
+}
+
+// Searches the ATRIA tree given by atria (struct or file name) on the point set points.
+// The data set is either searched in place or copied to a packed_point_set, see worth_packing
+template<class POINT_SET>
+void atria_nn_search(const POINT_SET& points, const mxArray* atria, int nlhs, mxArray* plhs[], double* const nn, double* const dists,
+				const long R, const long N, const long dim, const double* p, const double* ref, const long NNR, const long past,
+				const double epsilon, const long max_checks, const int ref_or_direct)
+{
+	ATRIA<POINT_SET> searcher(points, atria);	// this constructor used the data from the preprocessing that are given by the second input argument
+#ifdef PROFILE
+	cout << "read in atria structure" << endl;
+#endif	
+	nn_search(searcher, nn, dists, R, N, dim, p, ref, NNR, past, epsilon, max_checks, ref_or_direct);
+	if (nlhs > 2) {
+		plhs[2] = mxCreateDoubleMatrix(1, 1, mxREAL);
+		*((double *) mxGetPr(plhs[2])) = searcher.search_efficiency();
+	}	
 }
 
 void mexFunction(int nlhs, mxArray  *plhs[], int nrhs, const mxArray  *prhs[])
@@ -60,6 +101,7 @@ void mexFunction(int nlhs, mxArray  *plhs[], int nrhs, const mxArray  *prhs[])
 	
 	long past = 0;
 	double epsilon = 0;
+	long max_checks = 0;			// > 0 : maximum number of distances computed for each query point
 	
 	/* check input args */
 	
@@ -147,9 +189,13 @@ void mexFunction(int nlhs, mxArray  *plhs[], int nrhs, const mxArray  *prhs[])
 		}
 		if (nrhs > 5) 
 			epsilon = (double) *((double *)mxGetPr(prhs[5]));		// support approximative queries		
+		if (nrhs > 6) 
+			max_checks = (long) *((double *)mxGetPr(prhs[6]));
 	}  else {
 		if (nrhs > 4) 
 			epsilon = (double) *((double *)mxGetPr(prhs[4]));		// support approximative queries	
+		if (nrhs > 5) 
+			max_checks = (long) *((double *)mxGetPr(prhs[5]));
 	}
 	
 	plhs[0] = mxCreateDoubleMatrix(R, NNR, mxREAL);
@@ -163,37 +209,27 @@ void mexFunction(int nlhs, mxArray  *plhs[], int nrhs, const mxArray  *prhs[])
 	} else
 		dists = (double *) malloc(R*NNR * sizeof(double));
 	
-	char* metric = 0;
-	
-	if (mxIsChar(mxGetField(prhs[1], 0, "optional"))) {	
-    	long buflen = (mxGetM(mxGetField(prhs[1], 0, "optional")) * mxGetN(mxGetField(prhs[1], 0, "optional"))) + 1;
- 		metric = (char*) mxMalloc(buflen);
-        mxGetString(mxGetField(prhs[1], 0, "optional"), metric, buflen); 
-	}
+	char* metric = atria_metric(prhs[1]);		// atria is the struct returned by nn_prepare or the name of the file it wrote
 	
 	if ((metric == 0) || (!strncmp("euclidian", metric, strlen(metric)))) {
-		point_set<euclidian_distance> points(N,dim, p);	
-		ATRIA< point_set<euclidian_distance> > searcher(points, prhs[1]);	// this constructor used the data from the preprocessing that are given by the second input argument
-#ifdef PROFILE
-		cout << "read in atria structure" << endl;
-#endif	
-		nn_search(searcher, nn, dists, R, N, dim, p, ref, NNR, past, epsilon, ref_or_direct);
-		if (nlhs > 2) {
-			plhs[2] = mxCreateDoubleMatrix(1, 1, mxREAL);
-			*((double *) mxGetPr(plhs[2])) = searcher.search_efficiency();
-		}	
+		if (worth_packing(R, N)) {
+			packed_point_set<euclidian_distance> points(N,dim, p);
+			if (points.geterr()) mexErrMsgTxt("Not enough memory for the copy of the data set");	
+			atria_nn_search(points, prhs[1], nlhs, plhs, nn, dists, R, N, dim, p, ref, NNR, past, epsilon, max_checks, ref_or_direct);
+		} else {
+			point_set<euclidian_distance> points(N,dim, p);
+			atria_nn_search(points, prhs[1], nlhs, plhs, nn, dists, R, N, dim, p, ref, NNR, past, epsilon, max_checks, ref_or_direct);
+		}
 	}
 	else if (!strncmp("maximum", metric, strlen(metric))){
-		point_set<maximum_distance> points(N,dim, p);	
-		ATRIA< point_set<maximum_distance> > searcher(points, prhs[1]);
-#ifdef PROFILE
-		cout << "read in atria structure" << endl;
-#endif		
-		nn_search(searcher, nn, dists, R, N, dim, p, ref, NNR, past, epsilon, ref_or_direct);
-		if (nlhs > 2) {
-			plhs[2] = mxCreateDoubleMatrix(1, 1, mxREAL);
-			*((double *) mxGetPr(plhs[2])) = searcher.search_efficiency();
-		}		
+		if (worth_packing(R, N)) {
+			packed_point_set<maximum_distance> points(N,dim, p);
+			if (points.geterr()) mexErrMsgTxt("Not enough memory for the copy of the data set");	
+			atria_nn_search(points, prhs[1], nlhs, plhs, nn, dists, R, N, dim, p, ref, NNR, past, epsilon, max_checks, ref_or_direct);
+		} else {
+			point_set<maximum_distance> points(N,dim, p);
+			atria_nn_search(points, prhs[1], nlhs, plhs, nn, dists, R, N, dim, p, ref, NNR, past, epsilon, max_checks, ref_or_direct);
+		}
 	}
 	else {
 		mexErrMsgTxt("Unknown type of metric used to create ATRIA structure");
@@ -8,12 +8,17 @@
 %       exclude)
 %     * [index, distance] = nn_search(pointset, atria, query_indices, k,
 %       exclude, epsilon)
+%     * [index, distance] = nn_search(pointset, atria, query_points, k,
+%       epsilon, max_checks)
+%     * [index, distance] = nn_search(pointset, atria, query_indices, k,
+%       exclude, epsilon, max_checks)
 %
 %   Input arguments:
 %
 %     * pointset - a N by D double matrix containing the coordinates of
 %       the point set, organized as N points of dimension D
-%     * atria - output of (cf. Section ) nn_prepare for pointset
+%     * atria - output of (cf. Section ) nn_prepare for pointset, either
+%       the struct or the name of the file written by nn_prepare
 %     * query_points - a R by D double matrix containing the coordinates
 %       of the query points, organized as R points of dimension D
 %     * query_indices - query points are taken out of the pointset,
@@ -22,6 +27,12 @@
 %     * k - number of nearest neighbors to be determined
 %     * epsilon - (optional) relative error for approximate nearest
 %       neighbors queries, defaults to 0 (= exact search)
+%     * max_checks - (optional) maximum number of distances computed for
+%       each query point, defaults to 0 (= no limit). Clusters are
+%       searched closest first, so the search stopped after max_checks
+%       distances returns approximate neighbors; a smaller max_checks is
+%       faster but less accurate. Neighbors not found have index NaN and
+%       distance Inf
 %     * exclude - in case the query points are taken out of the pointset,
 %       exclude specifies a range of indices which are omitted from
 %       search. For example if the index of the query point is 124 and
@@ -0,0 +1,215 @@
+// Fast range searcher
+//
+// Like nn_search, this mex-function takes the preprocessing from the mex-function
+// nn_prepare and searches all points within distance r of each query point.
+
+// Output of this program is the number of points found for each query point.
+// If a second output argument is specified, the indices and distances of the points
+// found are returned in a cell array (unsorted). With only one output argument the
+// points are just counted, which is what correlation sums need.
+
+#include <cmath>
+#include <cstring>
+
+// C++ Standard Template Library
+// this files have to be located before(!!!) the #ifdef MATLAB_MEX_FILE sequence,
+// otherwise the defines will break the STL
+#include <vector>
+
+// the SIMD intrinsics headers of the metrics and the file mapping include C library headers,
+// so like the STL they come before mextools.h
+#include <cstdio>
+#include "NNSearcher/metric.h"
+#include "../../include/MappedFile.h"
+#include "mextools/mextools.h"
+
+// this includes the code for the nearest neighbor searcher and the prediction routines
+#include "NNSearcher/point_set.h"
+#include "include.mex"
+
+// The query points are searched in parallel when compiled with OpenMP,
+// each thread with its own query context on the shared ATRIA tree.
+// count gets the number of points found for query n at count[n]; when neighbors
+// is not 0, the points found are stored in neighbors[n]
+template<class Searcher>
+void range_search(Searcher& searcher, double* const count, vector<vector<neighbor> >* const neighbors, const long R, const long N,
+				const long dim, const double* p, const double* ref, const double radius, const long past,
+				const int ref_or_direct)
+{
+	if (searcher.geterr()) {
+		mexErrMsgTxt("Error preparing searcher, maybe wrong preprocessing data were given or the point set has changed");
+	}
+
+	#pragma omp parallel
+	{
+		typename Searcher::query_context ctx;
+		vector<double> coord(dim);
+
+		#pragma omp for schedule(dynamic,64)
+		for (long n=0; n < R; n++) { /* iterate over all reference points */
+			long first = -1, last = -1;
+
+			if (ref_or_direct) {
+				const long actual = (long) ref[n]-1;		/* Matlab to C means indices change from 1 to 0, 2 to 1, 3 to 2 ...*/
+				for (long k=0; k < dim; k++) coord[k] = p[actual+k*N];
+				first = actual-past;
+				last = actual+past;
+			} else {
+				for (long k=0; k < dim; k++) coord[k] = ref[n+k*R];
+			}
+
+			if (neighbors)
+				count[n] = searcher.search_range(ctx, (*neighbors)[n], radius, &coord[0], first, last);
+			else
+				count[n] = searcher.count_range(ctx, radius, &coord[0], first, last);
+		}
+#ifdef PROFILE
+		#pragma omp critical
+		searcher.collect_profile(ctx);
+#endif
+	}
+}
+
+// Searches the ATRIA tree given by atria (struct or file name) on the point set points.
+// The data set is either searched in place or copied to a packed_point_set, see worth_packing
+template<class POINT_SET>
+void atria_range_search(const POINT_SET& points, const mxArray* atria, double* const count, vector<vector<neighbor> >* const neighbors,
+				const long R, const long N, const long dim, const double* p, const double* ref, const double radius,
+				const long past, const int ref_or_direct)
+{
+	ATRIA<POINT_SET> searcher(points, atria);	// this constructor used the data from the preprocessing that are given by the second input argument
+	range_search(searcher, count, neighbors, R, N, dim, p, ref, radius, past, ref_or_direct);
+}
+
+void mexFunction(int nlhs, mxArray  *plhs[], int nrhs, const mxArray  *prhs[])
+{
+	int ref_or_direct = 1;			// ref_or_direct = 1 means interpret third input argument as reference indices
+									// = 0 means interpret third input argument as reference vectors
+
+	long past = 0;
+
+	/* check input args */
+
+	if (nrhs < 4)
+	{
+		mexErrMsgTxt("Fast range searcher : Data set of points (row vectors), preprocessing data, reference indices or reference points \nand search radius must be given");
+		return;
+	}
+
+	/* handle matrix I/O */
+
+	const long N 		= mxGetM(prhs[0]);
+	const long dim  	= mxGetN(prhs[0]);
+	const double* p 	= (double *)mxGetPr(prhs[0]);
+
+	double* ref 	= (double *)mxGetPr(prhs[2]);
+	long R; 										// number of query (reference) points
+
+	const double radius = (double) *((double *)mxGetPr(prhs[3]));
+
+	if (N < 1) {
+		mexErrMsgTxt("Data set must consist of at least two points (row vectors)");
+		return;
+	}
+	if (dim < 1) {
+		mexErrMsgTxt("Data points must be at least of dimension one");
+		return;
+	}
+	if (radius < 0) {
+		mexErrMsgTxt("Search radius must be nonnegative");
+		return;
+	}
+	if (mxGetN(prhs[2]) == 0) {
+		mexErrMsgTxt("Wrong reference indices or reference points given");
+		return;
+	}
+
+	if ((mxGetN(prhs[2]) == dim) && (nrhs < 5)) {
+		R = mxGetM(prhs[2]);
+		ref_or_direct = 0;
+	}
+	else if (mxGetN(prhs[2]) == 1) {
+		R = mxGetM(prhs[2]);
+		ref_or_direct = 1;
+	}
+	else if (mxGetM(prhs[2]) == 1) {
+		R = mxGetN(prhs[2]);
+		ref_or_direct = 1;
+	} else  {
+		mexErrMsgTxt("Cannot determine if third argument are reference indices or reference points");
+		return;
+	}
+
+	if (R < 1) {
+		mexErrMsgTxt("At least one reference index or point must be given");
+		return;
+	}
+
+	if (ref_or_direct) {		// interpret third argument as list of indices into the data set given as first argument
+		if (nrhs < 5)
+		{
+			mexErrMsgTxt("Fast range searcher : Data set of points (row vectors), preprocessing data, reference indices,\nsearch radius and past must be given");
+			return;
+		}
+		past	= (long) *((double *)mxGetPr(prhs[4]));
+		for (long i=0; i < R; i++) {
+			if ((ref[i] < 1) || (ref[i]>N)) {
+				mexErrMsgTxt("Reference indices out of range");
+				return;
+			}
+		}
+	}
+
+	plhs[0] = mxCreateDoubleMatrix(R, 1, mxREAL);
+	double* count = (double *) mxGetPr(plhs[0]);
+
+	vector<vector<neighbor> > neighbors;
+	if (nlhs > 1)
+		neighbors.resize(R);
+
+	char* metric = atria_metric(prhs[1]);		// atria is the struct returned by nn_prepare or the name of the file it wrote
+	
+	if ((metric == 0) || (!strncmp("euclidian", metric, strlen(metric)))) {
+		if (worth_packing(R, N)) {
+			packed_point_set<euclidian_distance> points(N,dim, p);
+			if (points.geterr()) mexErrMsgTxt("Not enough memory for the copy of the data set");
+			atria_range_search(points, prhs[1], count, (nlhs > 1) ? &neighbors : 0, R, N, dim, p, ref, radius, past, ref_or_direct);
+		} else {
+			point_set<euclidian_distance> points(N,dim, p);
+			atria_range_search(points, prhs[1], count, (nlhs > 1) ? &neighbors : 0, R, N, dim, p, ref, radius, past, ref_or_direct);
+		}
+	}
+	else if (!strncmp("maximum", metric, strlen(metric))){
+		if (worth_packing(R, N)) {
+			packed_point_set<maximum_distance> points(N,dim, p);
+			if (points.geterr()) mexErrMsgTxt("Not enough memory for the copy of the data set");
+			atria_range_search(points, prhs[1], count, (nlhs > 1) ? &neighbors : 0, R, N, dim, p, ref, radius, past, ref_or_direct);
+		} else {
+			point_set<maximum_distance> points(N,dim, p);
+			atria_range_search(points, prhs[1], count, (nlhs > 1) ? &neighbors : 0, R, N, dim, p, ref, radius, past, ref_or_direct);
+		}
+	}
+	else {
+		mexErrMsgTxt("Unknown type of metric used to create ATRIA structure");
+	}
+
+	mxFree(metric);
+
+	if (nlhs > 1) {		// the mx API is not thread safe, so the cell array is filled afterwards
+		plhs[1] = mxCreateCellMatrix(R, 2);
+		for (long n=0; n < R; n++) {
+			const vector<neighbor>& v = neighbors[n];
+			mxArray* indices = mxCreateDoubleMatrix(1, v.size(), mxREAL);
+			mxArray* distances = mxCreateDoubleMatrix(1, v.size(), mxREAL);
+			double* const ip = (double *) mxGetPr(indices);
+			double* const dp = (double *) mxGetPr(distances);
+			for (long k = 0; k < v.size(); k++) {
+				ip[k] = v[k].index() + 1;	// convert indices back to Matlab (1..N) style
+				dp[k] = v[k].dist();
+			}
+			mxSetCell(plhs[1], n, indices);
+			mxSetCell(plhs[1], n+R, distances);
+			vector<neighbor>().swap(neighbors[n]);		// free memory as we go
+		}
+	}
+}
@@ -0,0 +1,45 @@
+%tstoolbox/mex/range_search
+%   Syntax:
+%
+%     * [count, neighbors] = range_search(pointset, atria, query_points, r)
+%     * [count, neighbors] = range_search(pointset, atria, query_indices,
+%       r, exclude)
+%
+%   Input arguments:
+%
+%     * pointset - a N by D double matrix containing the coordinates of
+%       the point set, organized as N points of dimension D
+%     * atria - output of (cf. Section ) nn_prepare for pointset, either
+%       the struct or the name of the file written by nn_prepare
+%     * query_points - a R by D double matrix containing the coordinates
+%       of the query points, organized as R points of dimension D
+%     * query_indices - query points are taken out of the pointset,
+%       query_indices is a vector of length R which contains the indices
+%       of the query points (indices may vary from 1 to N)
+%     * r - search radius, all points within distance r of a query point
+%       are searched (r >= 0)
+%     * exclude - in case the query points are taken out of the pointset,
+%       exclude specifies a range of indices which are omitted from
+%       search. For example if the index of the query point is 124 and
+%       exclude is set to 3, points with indices 121 to 127 are omitted
+%       from search. Using exclude = 0 means: exclude self-matches
+%
+%   Output arguments:
+%
+%     * count - a vector of length R which contains the number of points
+%       within distance r of each query point. With count as only output
+%       argument the points are just counted, which is faster (e.g. for
+%       correlation sums)
+%     * neighbors - a R by 2 cell array. neighbors{n,1} contains the
+%       indices and neighbors{n,2} the distances of the points found for
+%       the n-th query point (not sorted)
+%
+%   The query points are searched on all cores when compiled with OpenMP.
+%
+%   Example:
+%
+%     pointset = rand(10000,3);
+%     atria = nn_prepare(pointset, 'euclidian');
+%     [count, neighbors] = range_search(pointset, atria, 1:100, 0.1, 0);
+%     count2 = range_search(pointset, atria, 1:100, 0.1, 0);
+%     isequal(count, count2)